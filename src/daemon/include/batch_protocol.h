@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "material_registry.h"
+#include "shared_material_table.h"
+
+namespace CFD_MaterialDB {
+
+// 批量求值请求的列式二进制格式, 供 Python/Fortran 等外部代码直接拼装. 整数与 double 均为小端序,
+// 字段之间没有隐式填充, "对齐到 8" 指从消息起点算起补零到 8 的倍数.
+//
+// 请求:
+//   char     magic[4]        "MDBQ"
+//   uint32   version         1
+//   uint32   flags           bit 0: 同时返回 dv/dT 与 dv/dp
+//   uint32   keyCount
+//   uint64   pointCount
+//   keyCount 个 {uint32 coefficient, uint32 materialLength, uint32 propertyLength}
+//   各键的材料名与物性名 (UTF-8, 不以 0 结尾), 按键的顺序依次相接; 对齐到 8
+//   uint32   key[pointCount]  每个点所属的键; 对齐到 8
+//   double   T[pointCount]    K
+//   double   p[pointCount]    Pa
+//
+// 应答:
+//   char     magic[4]        "MDBR"
+//   uint32   version, flags, keyCount
+//   uint64   pointCount
+//   uint8    status[keyCount] BatchKeyStatus; 对齐到 8
+//   double   value[pointCount]
+//   double   dvdT[pointCount], dvdp[pointCount]   (仅当 flags bit 0)
+//
+// 键为 (材料, 物性, 系数序号), 同一键的点共用一次查找; 状态不为 Ok 的键, 其点的结果为 NaN
+constexpr uint32_t kBatchProtocolVersion = 1;
+constexpr uint32_t kBatchDerivatives = 1;
+
+// 单个批量消息的上限
+constexpr size_t kMaxBatchBytes = size_t(256) << 20;
+
+struct BatchKey {
+    std::string material;
+    std::string property;
+    uint32_t coefficient = 0;
+};
+
+struct BatchRequest {
+    bool derivatives = false;
+    std::vector<BatchKey> keys;
+    std::vector<uint32_t> key;
+    std::vector<double> T;
+    std::vector<double> p;
+
+    // 追加一个点, keyIndex 为 keys 中的序号
+    void add(uint32_t keyIndex, double temperature, double pressure = kReferencePressure) {
+        key.push_back(keyIndex);
+        T.push_back(temperature);
+        p.push_back(pressure);
+    }
+};
+
+enum class BatchKeyStatus : uint8_t {
+    Ok = 0,
+    UnknownMaterial = 1,
+    UnknownProperty = 2,
+    UnknownCoefficient = 3
+};
+
+struct BatchResponse {
+    bool derivatives = false;
+    std::vector<BatchKeyStatus> status;
+    std::vector<double> value;
+    std::vector<double> dvdT;
+    std::vector<double> dvdp;
+};
+
+// 编码/解码; 格式不符 (长度, 魔数, 版本, 键序号越界, 未知的键状态) 时抛出
+std::string encodeBatchRequest(const BatchRequest &request);
+BatchRequest decodeBatchRequest(std::string_view bytes);
+std::string encodeBatchResponse(const BatchResponse &response);
+BatchResponse decodeBatchResponse(std::string_view bytes);
+
+// 在共享表上求值: 先解析每个键, 再按键把点归组 (计数排序), 同一系数类型的组相邻执行,
+// 每组收集成连续的 T/p 数组后调用一次批量内核, 最后按原顺序写回
+BatchResponse evaluateBatch(const SharedMaterialTable &table, const BatchRequest &request);
+
+// 在材料库快照上求值, 归组方式相同; 与压力有关的类型 (可压缩液体, user-defined) 使用每个点自己的 p
+BatchResponse evaluateBatch(const MaterialSnapshot &snapshot, const BatchRequest &request);
+
+} // namespace CFD_MaterialDB
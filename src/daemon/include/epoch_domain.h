@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace CFD_MaterialDB {
+
+// 同时处于读临界区的线程数上限. 槽位在线程第一次进入任一 EpochDomain 时分配, 线程退出时归还
+constexpr size_t kMaxEpochReaders = 256;
+
+constexpr size_t kUnassignedEpochReader = ~size_t(0);
+
+// 为当前线程分配读者槽位; 槽位用尽时抛出
+size_t assignEpochReaderSlot(size_t *cache);
+
+inline size_t epochReaderSlot() {
+    thread_local size_t slot = kUnassignedEpochReader;
+    if (slot == kUnassignedEpochReader) {
+        slot = assignEpochReaderSlot(&slot);
+    }
+    return slot;
+}
+
+// 基于 epoch 的延迟回收 (RCU 风格). 读者进入临界区时在自己的槽位里记下当前 epoch, 离开时清零,
+// 只有本线程写自己的槽位, 不加锁. 写者把对象从共享指针上摘下后 retire, 并把全局 epoch 加一;
+// 所有槽位都为空或已晚于该对象的退休 epoch 时, 再没有读者可能持有它, 此时才真正释放
+class EpochDomain {
+public:
+    EpochDomain() = default;
+
+    // 释放所有待回收的对象; 调用时不能再有读者
+    ~EpochDomain();
+
+    // 进入/离开读临界区, 可以嵌套
+    void enter() {
+        ReaderSlot &slot = slots_[epochReaderSlot()];
+        if (slot.depth++ == 0) {
+            slot.epoch.store(epoch_.load(std::memory_order_acquire), std::memory_order_relaxed);
+            // 槽位的写入必须先于之后对共享指针的读取被写者看到
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    void leave() {
+        ReaderSlot &slot = slots_[epochReaderSlot()];
+        if (--slot.depth == 0) {
+            slot.epoch.store(0, std::memory_order_release);
+        }
+    }
+
+    // 写者在对象已不可从共享指针到达之后调用; deleter 在没有读者能访问该对象时执行. 不阻塞
+    void retire(std::function<void()> deleter);
+
+    // 执行所有已经安全的 deleter, 返回执行的个数
+    size_t reclaim();
+
+    // 等到 retire 过的对象全部回收. 调用线程自身不能处于读临界区
+    void synchronize();
+
+    size_t pending() const;
+
+    EpochDomain(const EpochDomain &) = delete;
+    EpochDomain &operator=(const EpochDomain &) = delete;
+
+private:
+    // epoch 为 0 表示空闲; depth 只有所属线程访问
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{0};
+        uint32_t depth = 0;
+    };
+
+    std::atomic<uint64_t> epoch_{1};
+    ReaderSlot slots_[kMaxEpochReaders];
+    mutable std::mutex retiredMutex_;
+    std::vector<std::pair<uint64_t, std::function<void()>>> retired_;
+};
+
+// 读临界区的作用域守卫
+class EpochGuard {
+public:
+    explicit EpochGuard(EpochDomain &domain) : domain_(&domain) { domain_->enter(); }
+
+    ~EpochGuard() {
+        if (domain_ != nullptr) {
+            domain_->leave();
+        }
+    }
+
+    EpochGuard(EpochGuard &&other) noexcept : domain_(std::exchange(other.domain_, nullptr)) {}
+
+    EpochGuard(const EpochGuard &) = delete;
+    EpochGuard &operator=(const EpochGuard &) = delete;
+    EpochGuard &operator=(EpochGuard &&) = delete;
+
+private:
+    EpochDomain *domain_;
+};
+
+} // namespace CFD_MaterialDB
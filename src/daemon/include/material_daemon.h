@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "batch_protocol.h"
+#include "material.h"
+#include "material_registry.h"
+#include "shared_material_table.h"
+
+namespace CFD_MaterialDB {
+
+// 常驻的材料服务: 启动时载入一次材料库, 编译成只读表发布到 POSIX 共享内存, 求解器进程用
+// SharedMaterialTable 直接映射求值; 同时在 Unix domain socket 上接受控制请求.
+// 材料库由 MaterialRegistry 持有, query 与 batch 在当前快照上求值; load/reload 在后台线程载入,
+// 载入期间照常处理其他请求, 完成后发布新的共享表并应答发起请求的连接.
+//
+// 请求与应答各占一行, 应答以 "ok" 或 "error <原因>" 开头:
+//   status                              ok generation=G materials=N coefficients=C bytes=B shm=名称 source=来源
+//   load <文件>                         改从另一个 .scm 文件或数据库载入并发布, ok generation=G materials=N
+//   reload                              从当前来源重新载入并发布
+//   query <材料> <物性> <T> [p]          ok v1 v2 ..., 每个系数一个值
+//   shutdown                            ok, 然后守护进程退出
+//   batch <N>                           其后紧跟 N 字节的批量请求 (batch_protocol.h); 应答行为 "ok <M>",
+//                                       其后紧跟 M 字节的批量应答
+// 载入失败时继续提供原来的表. socket 文件和共享表的权限都是 0600, 只有与守护进程同一用户的进程可以连接或映射.
+// 连接为非阻塞, 应答在 socket 可写时发出, 不读应答的客户端不会拖住其他连接
+struct MaterialDaemonOptions {
+    std::string source = "materials.db";           // .scm 文件 (按扩展名判断) 或材料数据库
+    std::string sharedTableName = kDefaultSharedTableName;
+    std::string socketPath = "material_db.sock";
+};
+
+// 读出 .scm 文件或数据库中的全部材料; 文件不存在或没有材料时抛出
+std::vector<Material> loadMaterialSource(const std::string &source);
+
+class MaterialDaemon {
+public:
+    // 载入并发布材料表, 然后开始监听; 同一 socket 上已有守护进程在运行时抛出
+    explicit MaterialDaemon(MaterialDaemonOptions options);
+
+    // 关闭 socket, 删除 socket 文件和共享内存名
+    ~MaterialDaemon();
+
+    // 处理请求直到收到 shutdown 或调用 stop()
+    void run();
+
+    // 让 run() 返回; 只写一个管道, 可以在信号处理函数中调用
+    void stop();
+
+    // 处理一行请求并返回应答 (不含换行)
+    std::string handleCommand(const std::string &line);
+
+    // 处理一个批量请求, 返回完整的应答 (含应答行)
+    std::string handleBatch(std::string_view payload);
+
+    MaterialDaemon(const MaterialDaemon &) = delete;
+    MaterialDaemon &operator=(const MaterialDaemon &) = delete;
+
+private:
+    // 同步载入并发布, 返回应答行; source 为空时重新载入当前来源. run() 中的 load/reload 改走 reloadAsync
+    std::string load(const std::string &source);
+    // 把快照编译成共享表映像并写入暂存的共享内存. 作为 reload 的 prepare 在载入线程上调用, 抛出时注册表不发布新快照
+    void stageSnapshot(const MaterialSnapshot &snapshot);
+    // 换上暂存的共享表, 返回应答行; 只有改名和解除映射, 在 poll 线程上调用不会阻塞其他连接
+    std::string commitStaged();
+    std::string status() const;
+    std::string query(const std::vector<std::string> &words) const;
+
+    MaterialDaemonOptions options_;
+    SharedTablePublisher publisher_;
+    std::unique_ptr<MaterialRegistry> registry_;
+    uint64_t generation_ = 0;                       // 已发布到共享内存的快照代号
+    // 已暂存, 尚未换上的共享表; 由载入线程写入, reloadAsync 的 future 就绪后 poll 线程才读取
+    struct StagedTable {
+        uint64_t generation = 0;
+        size_t materials = 0;
+        std::string source;
+    } staged_;
+    int listenFd_ = -1;
+    int wakeFds_[2] = {-1, -1};
+    bool stopping_ = false;
+};
+
+// 向守护进程发送一行请求并返回应答行; 连接失败或超时抛出
+std::string sendDaemonCommand(const std::string &socketPath, const std::string &command, int timeoutMs = 30000);
+
+// 发送批量请求; 守护进程返回 error 时抛出
+BatchResponse sendDaemonBatch(const std::string &socketPath, const BatchRequest &request, int timeoutMs = 30000);
+
+} // namespace CFD_MaterialDB
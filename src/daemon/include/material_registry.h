@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "epoch_domain.h"
+#include "material.h"
+
+namespace CFD_MaterialDB {
+
+// 某一时刻材料库的不可变快照; user-defined 物性在构造时已编译
+class MaterialSnapshot {
+public:
+    MaterialSnapshot(std::vector<Material> materials, std::string source);
+
+    // 未找到时返回 nullptr; 同名材料取最后一个
+    const Material *find(const std::string &name) const;
+
+    const std::vector<Material> &materials() const { return materials_; }
+
+    const std::string &source() const { return source_; }
+
+    uint64_t generation() const { return generation_; }
+
+private:
+    friend class MaterialRegistry;
+
+    std::vector<Material> materials_;
+    std::unordered_map<std::string, size_t> index_;
+    std::string source_;
+    uint64_t generation_ = 0;       // 发布时由 MaterialRegistry 设置
+};
+
+// 可在运行中热替换的材料库. 读者通过 read() 取得当前快照, 全程不加锁; reload 在后台构建新快照,
+// 以一次原子指针交换发布, 旧快照等所有可能仍在读取它的读者离开后再释放 (EpochDomain).
+// 载入失败时保持原快照不变
+class MaterialRegistry {
+public:
+    // 当前快照的只读访问; 持有期间快照不会被释放. 应尽快释放, 不要跨越耗时操作长期持有
+    class Reader {
+    public:
+        const MaterialSnapshot &operator*() const { return *snapshot_; }
+        const MaterialSnapshot *operator->() const { return snapshot_; }
+
+    private:
+        friend class MaterialRegistry;
+
+        Reader(EpochDomain &domain, const std::atomic<const MaterialSnapshot *> &current)
+                : guard_(domain), snapshot_(current.load(std::memory_order_acquire)) {}
+
+        EpochGuard guard_;
+        const MaterialSnapshot *snapshot_;
+    };
+
+    // 发布前对新快照 (代号已确定) 的处理, 在发布它的线程上调用; 抛出时放弃这次发布, 原快照不变
+    using Prepare = std::function<void(const MaterialSnapshot &)>;
+
+    // 同步载入 source (.scm 文件或材料数据库), 失败时抛出
+    explicit MaterialRegistry(const std::string &source);
+
+    // 等待后台载入结束并释放所有快照; 调用时不能再有读者
+    ~MaterialRegistry();
+
+    Reader read() const { return Reader(domain_, current_); }
+
+    // 载入并发布新快照, 返回新的代号; source 为空时重新载入当前来源. 失败时抛出, 原快照不变
+    uint64_t reload(const std::string &source = std::string(), const Prepare &prepare = Prepare());
+
+    // 在后台线程执行 reload, prepare 也在后台线程上调用; 上一次后台载入尚未结束时先等待它
+    std::future<uint64_t> reloadAsync(const std::string &source = std::string(), Prepare prepare = Prepare());
+
+    // 直接发布一组材料
+    uint64_t publish(std::vector<Material> materials, const std::string &source, const Prepare &prepare = Prepare());
+
+    // 释放已经没有读者的旧快照, 返回释放的个数. 发布时只回收当时已经安全的快照, 长期运行的调用方应定期调用
+    size_t reclaim() { return domain_.reclaim(); }
+
+    // 等待回收的旧快照个数
+    size_t pendingReclamation() const { return domain_.pending(); }
+
+    // 阻塞到所有旧快照都已释放; 调用线程不能持有 Reader
+    void synchronize() { domain_.synchronize(); }
+
+    MaterialRegistry(const MaterialRegistry &) = delete;
+    MaterialRegistry &operator=(const MaterialRegistry &) = delete;
+
+private:
+    mutable EpochDomain domain_;
+    std::atomic<const MaterialSnapshot *> current_{nullptr};
+    std::mutex writerMutex_;            // 串行化发布
+    uint64_t generation_ = 0;           // 受 writerMutex_ 保护
+    std::string source_;                // 受 writerMutex_ 保护
+    std::mutex loaderMutex_;
+    std::thread loader_;
+};
+
+} // namespace CFD_MaterialDB
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "material.h"
+#include "polynomial_kernels.h"
+#include "property_evaluator.h"
+
+namespace CFD_MaterialDB {
+
+class ExpressionProgram;
+
+// 编译好的只读材料表, 由守护进程写入 POSIX 共享内存, 客户端进程只读映射后直接求值, 不复制数据.
+// 映像布局 (偏移均相对映像起点, 以字节计):
+//   SharedTableHeader
+//   SharedMaterialRecord[materialCount]        按名称排序
+//   SharedPropertyRecord[propertyCount]        每个材料的物性连续存放, 按名称排序
+//   SharedCoefficientRecord[coefficientCount]  每个物性的系数连续存放, 保持原顺序
+//   字符串区                                    名称, 单位, user-defined 的 lambda 源码 (不以 0 结尾)
+//   数据区                                      系数数组, 每块按 64 字节对齐
+
+constexpr char kSharedTableMagic[8] = {'M', 'A', 'T', 'D', 'B', 'S', 'H', 'M'};
+constexpr uint32_t kSharedTableVersion = 1;
+
+// 守护进程使用的默认共享内存名
+constexpr const char *kDefaultSharedTableName = "/material_db";
+
+enum class SharedTableState : uint32_t {
+    Building = 0,
+    Ready = 1,
+    Superseded = 2     // 守护进程已发布新表, 此表不再更新; 已映射的客户端仍可继续使用
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "跨进程共享的状态字必须是无锁原子量");
+
+struct SharedString {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct SharedTableHeader {
+    char magic[8];
+    uint32_t version;
+    std::atomic<uint32_t> state;
+    uint64_t generation;           // 每次发布加一
+    uint64_t totalBytes;
+    uint32_t materialCount;
+    uint32_t propertyCount;
+    uint32_t coefficientCount;
+    uint32_t userDefinedCount;
+    uint64_t materialsOffset;
+    uint64_t propertiesOffset;
+    uint64_t coefficientsOffset;
+    uint64_t stringsOffset;
+    uint64_t dataOffset;
+};
+
+struct SharedMaterialRecord {
+    SharedString name;
+    uint32_t firstProperty;
+    uint32_t propertyCount;
+};
+
+struct SharedPropertyRecord {
+    SharedString name;
+    uint32_t firstCoefficient;
+    uint32_t coefficientCount;
+};
+
+// 各类型的数据:
+//   CONSTCOEFF         params[0]
+//   polynomialT        data: count 个系数 (低次在前)
+//   piecewise-linear   data: count 个温度, count 个值, count - 1 个斜率; aux: bucketCount 个 uint32 分桶,
+//                      params[0] 为 bucketScale; 数据无效时 count 为 0
+//   piecewise-poly     data: count + 1 个边界; aux: count 个 kPiecewisePolyStride 系数块; 无效时 count 为 0
+//   NASA-9             同上, 系数块为 kNasa9Stride
+//   sutherland         params = {C1, S}; power-law {B, n}; blottner {A, B, C, present}
+//   compressible       params = {p0, rho0, K0, n, maxRatio, minRatio}
+//   user-defined       source 为 lambda 源码, 客户端映射时各自编译一次
+// 早期数据库中存放在 polydata 里的粘度/可压缩液体参数在编译时已换算好
+struct SharedCoefficientRecord {
+    uint32_t type;                 // coefficientType
+    uint32_t count;
+    uint64_t dataOffset;
+    uint64_t auxOffset;
+    uint32_t bucketCount;
+    uint32_t userDefinedIndex;     // user-defined 系数的序号
+    double params[6];
+    SharedString unit;
+    SharedString source;
+};
+
+// 把材料编译成共享表映像, 同名材料只保留最后一个; 映像大小超过 4 GiB (字符串偏移溢出) 时抛出
+std::string buildSharedTableImage(const std::vector<Material> &materials, uint64_t generation);
+
+// 守护进程一侧: 创建并持有共享内存段. 权限为 0600, 与守护进程的 socket 一致: 材料表只对同一用户的进程可读,
+// 其他用户既不能连接守护进程也不能直接映射共享表
+class SharedTablePublisher {
+public:
+    explicit SharedTablePublisher(std::string name = kDefaultSharedTableName);
+
+    // 把当前表标记为 Superseded 并删除共享内存名
+    ~SharedTablePublisher();
+
+    // 以新映像替换当前表: 在临时名 (名称 + ".new") 下写完映像并标为 Ready 后原子地改名为正式名, 再把旧表标为
+    // Superseded. 失败时抛出, 旧表仍在正式名下; 替换过程中正式名始终存在.
+    // 已映射旧表的客户端不受影响, 解除映射后旧表的内存才释放. 依赖 Linux 的 /dev/shm. 等同于 stage 后 commit
+    void publish(const std::string &image);
+
+    // publish 的前半: 在临时名下写好映像并标为 Ready, 正式名不变. 写入整个映像, 耗时与映像大小成正比,
+    // 可以在后台线程调用, 但不能与 commit 并发. 已有未提交的暂存表时先丢弃它; 失败时抛出
+    void stage(const std::string &image);
+
+    // publish 的后半: 把暂存表改名为正式名并换下旧表, 只有改名和解除映射, 不复制数据. 没有暂存表时抛出
+    void commit();
+
+    const std::string &name() const { return name_; }
+
+    size_t bytes() const { return size_; }
+
+    SharedTablePublisher(const SharedTablePublisher &) = delete;
+    SharedTablePublisher &operator=(const SharedTablePublisher &) = delete;
+
+private:
+    void release();
+    void discardStaged();
+
+    std::string name_;
+    std::string stagingName_;
+    void *mapping_ = nullptr;
+    size_t size_ = 0;
+    void *stagedMapping_ = nullptr;
+    size_t stagedSize_ = 0;
+};
+
+// 客户端一侧: 只读映射共享表, 查找与求值都直接访问映射的内存. 可以在多个线程中并发使用
+class SharedMaterialTable {
+public:
+    // 守护进程正在替换表时共享内存名可能短暂不存在或尚未就绪, 最多等待 timeoutMs 毫秒; 仍不可用或格式不符时抛出
+    explicit SharedMaterialTable(const std::string &name = kDefaultSharedTableName, int timeoutMs = 1000);
+
+    ~SharedMaterialTable();
+
+    SharedMaterialTable(const SharedMaterialTable &) = delete;
+    SharedMaterialTable &operator=(const SharedMaterialTable &) = delete;
+
+    uint64_t generation() const { return header_->generation; }
+
+    // 守护进程已发布新表 (reload). 新构造一个 SharedMaterialTable 即可映射新表
+    bool superseded() const {
+        return header_->state.load(std::memory_order_acquire) == static_cast<uint32_t>(SharedTableState::Superseded);
+    }
+
+    size_t bytes() const { return size_; }
+
+    size_t materialCount() const { return header_->materialCount; }
+
+    const SharedMaterialRecord &material(size_t i) const { return materials_[i]; }
+
+    // 按名称二分查找, 未找到时返回 nullptr
+    const SharedMaterialRecord *findMaterial(std::string_view name) const;
+
+    const SharedPropertyRecord *findProperty(const SharedMaterialRecord &material, std::string_view property) const;
+
+    const SharedPropertyRecord &property(const SharedMaterialRecord &material, size_t i) const {
+        return properties_[material.firstProperty + i];
+    }
+
+    const SharedCoefficientRecord &coefficient(const SharedPropertyRecord &property, size_t i) const {
+        return coefficients_[property.firstCoefficient + i];
+    }
+
+    std::string_view text(SharedString s) const { return {strings_ + s.offset, s.length}; }
+
+    // 与 evaluateProperty 结果相同; 无法求值时返回 NaN
+    double evaluate(const SharedCoefficientRecord &coefficient, double T, double p = kReferencePressure) const;
+
+    void evaluate(const SharedCoefficientRecord &coefficient, const double *T, double *out, size_t count,
+                  double p = kReferencePressure) const;
+
+    // 每个点各自给出压力
+    void evaluate(const SharedCoefficientRecord &coefficient, const double *T, const double *p, double *out,
+                  size_t count) const;
+
+    // 与 evaluatePropertyDerivatives 结果相同
+    Dual evaluateDerivatives(const SharedCoefficientRecord &coefficient, double T,
+                             double p = kReferencePressure) const;
+
+    void evaluateDerivatives(const SharedCoefficientRecord &coefficient, const double *T, double *value,
+                             double *dvdT, double *dvdp, size_t count, double p = kReferencePressure) const;
+
+    void evaluateDerivatives(const SharedCoefficientRecord &coefficient, const double *T, const double *p,
+                             double *value, double *dvdT, double *dvdp, size_t count) const;
+
+private:
+    const double *doubles(uint64_t offset) const {
+        return reinterpret_cast<const double *>(base_ + offset);
+    }
+
+    PiecewiseLinearView linearView(const SharedCoefficientRecord &c) const;
+    SegmentedView segmentedView(const SharedCoefficientRecord &c) const;
+    const ExpressionProgram *program(const SharedCoefficientRecord &c) const;
+
+    // p 为空时所有点使用 pressure
+    void evaluateBatch(const SharedCoefficientRecord &c, const double *T, const double *p, double pressure,
+                       double *out, size_t count) const;
+    void evaluateDerivativesBatch(const SharedCoefficientRecord &c, const double *T, const double *p,
+                                  double pressure, double *value, double *dvdT, double *dvdp, size_t count) const;
+
+    const char *base_ = nullptr;
+    size_t size_ = 0;
+    const SharedTableHeader *header_ = nullptr;
+    const SharedMaterialRecord *materials_ = nullptr;
+    const SharedPropertyRecord *properties_ = nullptr;
+    const SharedCoefficientRecord *coefficients_ = nullptr;
+    const char *strings_ = nullptr;
+    // user-defined 的字节码属于本进程, 映射时编译; 编译失败的为空, 求值得到 NaN
+    std::vector<std::shared_ptr<const ExpressionProgram>> programs_;
+};
+
+} // namespace CFD_MaterialDB
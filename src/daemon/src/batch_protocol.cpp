@@ -0,0 +1,413 @@
+#include "batch_protocol.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include "metrics.h"
+#include "property_evaluator.h"
+#include "property_expression.h"
+#include "trace.h"
+
+namespace CFD_MaterialDB {
+
+namespace {
+
+constexpr char kRequestMagic[4] = {'M', 'D', 'B', 'Q'};
+constexpr char kResponseMagic[4] = {'M', 'D', 'B', 'R'};
+
+static_assert(sizeof(double) == 8 && std::numeric_limits<double>::is_iec559, "协议要求 IEEE 754 double");
+
+// 只支持小端机器, 数值直接按内存布局拷贝
+bool littleEndian() {
+    uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+void requireLittleEndian() {
+    if (!littleEndian()) {
+        throw std::runtime_error("批量协议只支持小端机器");
+    }
+}
+
+class Writer {
+public:
+    explicit Writer(size_t reserve) { bytes_.reserve(reserve); }
+
+    template<typename T>
+    void put(T value) {
+        bytes_.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    void putArray(const std::vector<T> &values) {
+        bytes_.append(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+    }
+
+    void putBytes(const char *data, size_t size) { bytes_.append(data, size); }
+
+    void align() { bytes_.resize((bytes_.size() + 7) & ~size_t(7), '\0'); }
+
+    std::string take() { return std::move(bytes_); }
+
+private:
+    std::string bytes_;
+};
+
+class Reader {
+public:
+    explicit Reader(std::string_view bytes) : bytes_(bytes) {}
+
+    template<typename T>
+    T get() {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    template<typename T>
+    void getArray(std::vector<T> &values, uint64_t count) {
+        if (count > bytes_.size() / sizeof(T)) {
+            throw std::runtime_error("批量消息被截断");
+        }
+        values.resize(count);
+        std::memcpy(values.data(), take(count * sizeof(T)), count * sizeof(T));
+    }
+
+    std::string getString(size_t size) { return std::string(take(size), size); }
+
+    void align() { take(((offset_ + 7) & ~size_t(7)) - offset_); }
+
+    void expectEnd() const {
+        if (offset_ != bytes_.size()) {
+            throw std::runtime_error("批量消息末尾有多余的数据");
+        }
+    }
+
+private:
+    const char *take(size_t size) {
+        if (size > bytes_.size() - offset_) {
+            throw std::runtime_error("批量消息被截断");
+        }
+        const char *data = bytes_.data() + offset_;
+        offset_ += size;
+        return data;
+    }
+
+    std::string_view bytes_;
+    size_t offset_ = 0;
+};
+
+void checkMagic(Reader &in, const char *magic, const char *what) {
+    char actual[4];
+    for (char &c: actual) {
+        c = in.get<char>();
+    }
+    if (std::memcmp(actual, magic, 4) != 0) {
+        throw std::runtime_error(std::string("不是批量") + what);
+    }
+    if (in.get<uint32_t>() != kBatchProtocolVersion) {
+        throw std::runtime_error("不支持的批量协议版本");
+    }
+}
+
+Histogram &batchPoints() {
+    static Histogram &points = MetricsRegistry::global().histogram(
+            "material_db_batch_points", "Points per batch evaluation request", {},
+            {1, 16, 256, 4096, 65536, 1048576, 16777216});
+    return points;
+}
+
+} // namespace
+
+std::string encodeBatchRequest(const BatchRequest &request) {
+    requireLittleEndian();
+    size_t points = request.key.size();
+    if (request.T.size() != points || request.p.size() != points) {
+        throw std::runtime_error("批量请求的 key/T/p 长度不一致");
+    }
+    Writer out(64 + request.keys.size() * 48 + points * 20);
+    out.putBytes(kRequestMagic, 4);
+    out.put<uint32_t>(kBatchProtocolVersion);
+    out.put<uint32_t>(request.derivatives ? kBatchDerivatives : 0);
+    out.put<uint32_t>(static_cast<uint32_t>(request.keys.size()));
+    out.put<uint64_t>(points);
+    for (const auto &key: request.keys) {
+        out.put<uint32_t>(key.coefficient);
+        out.put<uint32_t>(static_cast<uint32_t>(key.material.size()));
+        out.put<uint32_t>(static_cast<uint32_t>(key.property.size()));
+    }
+    for (const auto &key: request.keys) {
+        out.putBytes(key.material.data(), key.material.size());
+        out.putBytes(key.property.data(), key.property.size());
+    }
+    out.align();
+    out.putArray(request.key);
+    out.align();
+    out.putArray(request.T);
+    out.putArray(request.p);
+    return out.take();
+}
+
+BatchRequest decodeBatchRequest(std::string_view bytes) {
+    requireLittleEndian();
+    Reader in(bytes);
+    checkMagic(in, kRequestMagic, "请求");
+    BatchRequest request;
+    request.derivatives = (in.get<uint32_t>() & kBatchDerivatives) != 0;
+    uint32_t keyCount = in.get<uint32_t>();
+    uint64_t points = in.get<uint64_t>();
+    if (keyCount > bytes.size() / 12) {
+        throw std::runtime_error("批量消息被截断");
+    }
+    std::vector<uint32_t> lengths(size_t(keyCount) * 2);
+    request.keys.resize(keyCount);
+    for (uint32_t i = 0; i < keyCount; ++i) {
+        request.keys[i].coefficient = in.get<uint32_t>();
+        lengths[2 * i] = in.get<uint32_t>();
+        lengths[2 * i + 1] = in.get<uint32_t>();
+    }
+    for (uint32_t i = 0; i < keyCount; ++i) {
+        request.keys[i].material = in.getString(lengths[2 * i]);
+        request.keys[i].property = in.getString(lengths[2 * i + 1]);
+    }
+    in.align();
+    in.getArray(request.key, points);
+    in.align();
+    in.getArray(request.T, points);
+    in.getArray(request.p, points);
+    in.expectEnd();
+    for (uint32_t key: request.key) {
+        if (key >= keyCount) {
+            throw std::runtime_error("批量请求的键序号越界: " + std::to_string(key));
+        }
+    }
+    return request;
+}
+
+std::string encodeBatchResponse(const BatchResponse &response) {
+    requireLittleEndian();
+    size_t points = response.value.size();
+    if (response.derivatives && (response.dvdT.size() != points || response.dvdp.size() != points)) {
+        throw std::runtime_error("批量应答的导数长度不一致");
+    }
+    Writer out(32 + response.status.size() + points * (response.derivatives ? 24 : 8));
+    out.putBytes(kResponseMagic, 4);
+    out.put<uint32_t>(kBatchProtocolVersion);
+    out.put<uint32_t>(response.derivatives ? kBatchDerivatives : 0);
+    out.put<uint32_t>(static_cast<uint32_t>(response.status.size()));
+    out.put<uint64_t>(points);
+    out.putArray(response.status);
+    out.align();
+    out.putArray(response.value);
+    if (response.derivatives) {
+        out.putArray(response.dvdT);
+        out.putArray(response.dvdp);
+    }
+    return out.take();
+}
+
+BatchResponse decodeBatchResponse(std::string_view bytes) {
+    requireLittleEndian();
+    Reader in(bytes);
+    checkMagic(in, kResponseMagic, "应答");
+    BatchResponse response;
+    response.derivatives = (in.get<uint32_t>() & kBatchDerivatives) != 0;
+    uint32_t keyCount = in.get<uint32_t>();
+    uint64_t points = in.get<uint64_t>();
+    in.getArray(response.status, keyCount);
+    for (BatchKeyStatus status: response.status) {
+        if (static_cast<uint8_t>(status) > static_cast<uint8_t>(BatchKeyStatus::UnknownCoefficient)) {
+            throw std::runtime_error("批量应答的键状态无效: " + std::to_string(static_cast<unsigned>(status)));
+        }
+    }
+    in.align();
+    in.getArray(response.value, points);
+    if (response.derivatives) {
+        in.getArray(response.dvdT, points);
+        in.getArray(response.dvdp, points);
+    }
+    in.expectEnd();
+    return response;
+}
+
+namespace {
+
+// 解析每个键, 再按键把点归组 (计数排序), 同一系数类型的组相邻执行; 每组收集成连续的 T/p 数组后调用一次
+// evaluate(record, T, p, value, dvdT, dvdp, count) (不求导数时 dvdT/dvdp 为 nullptr), 最后按原顺序写回.
+// resolve(key, status) 返回键对应的系数, 找不到时设置 status 并返回 nullptr; typeOf 给出系数类型
+template<typename Record, typename Resolve, typename TypeOf, typename Evaluate>
+BatchResponse evaluateGrouped(const BatchRequest &request, Resolve resolve, TypeOf typeOf, Evaluate evaluate) {
+    size_t points = request.key.size();
+    if (request.T.size() != points || request.p.size() != points) {
+        throw std::runtime_error("批量请求的 key/T/p 长度不一致");
+    }
+    size_t keyCount = request.keys.size();
+    TraceSpan span("batch", "daemon", [&] {
+        return std::to_string(points) + " points, " + std::to_string(keyCount) + " keys";
+    });
+    batchPoints().observe(static_cast<double>(points));
+
+    BatchResponse response;
+    response.derivatives = request.derivatives;
+    response.status.assign(keyCount, BatchKeyStatus::Ok);
+    std::vector<const Record *> records(keyCount, nullptr);
+    for (size_t k = 0; k < keyCount; ++k) {
+        records[k] = resolve(request.keys[k], response.status[k]);
+    }
+
+    // 计数排序: 按系数类型排列键, 再按键把点的下标归组, 组内保持原顺序
+    std::vector<size_t> start(keyCount + 1, 0);
+    for (uint32_t key: request.key) {
+        if (key >= keyCount) {
+            throw std::runtime_error("批量请求的键序号越界: " + std::to_string(key));
+        }
+        ++start[key + 1];
+    }
+    std::vector<uint32_t> keyOrder(keyCount);
+    for (size_t k = 0; k < keyCount; ++k) {
+        keyOrder[k] = static_cast<uint32_t>(k);
+    }
+    std::stable_sort(keyOrder.begin(), keyOrder.end(), [&](uint32_t a, uint32_t b) {
+        uint32_t typeA = records[a] ? static_cast<uint32_t>(typeOf(*records[a])) : UINT32_MAX;
+        uint32_t typeB = records[b] ? static_cast<uint32_t>(typeOf(*records[b])) : UINT32_MAX;
+        return typeA < typeB;
+    });
+    std::vector<size_t> offset(keyCount);
+    size_t position = 0;
+    for (uint32_t k: keyOrder) {
+        offset[k] = position;
+        position += start[k + 1];
+    }
+    std::vector<size_t> order(points);
+    for (size_t i = 0; i < points; ++i) {
+        order[offset[request.key[i]]++] = i;
+    }
+
+    // 各组收集成连续数组后调用一次批量求值
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> T(points), p(points), value(points), dvdT, dvdp;
+    if (request.derivatives) {
+        dvdT.resize(points);
+        dvdp.resize(points);
+    }
+    for (size_t i = 0; i < points; ++i) {
+        T[i] = request.T[order[i]];
+        p[i] = request.p[order[i]];
+    }
+    size_t begin = 0;
+    for (uint32_t k: keyOrder) {
+        size_t count = start[k + 1];
+        if (count == 0) {
+            continue;
+        }
+        if (records[k] == nullptr) {
+            std::fill_n(value.begin() + begin, count, nan);
+            if (request.derivatives) {
+                std::fill_n(dvdT.begin() + begin, count, nan);
+                std::fill_n(dvdp.begin() + begin, count, nan);
+            }
+        } else {
+            evaluate(*records[k], T.data() + begin, p.data() + begin, value.data() + begin,
+                     request.derivatives ? dvdT.data() + begin : nullptr,
+                     request.derivatives ? dvdp.data() + begin : nullptr, count);
+        }
+        begin += count;
+    }
+
+    response.value.resize(points);
+    for (size_t i = 0; i < points; ++i) {
+        response.value[order[i]] = value[i];
+    }
+    if (request.derivatives) {
+        response.dvdT.resize(points);
+        response.dvdp.resize(points);
+        for (size_t i = 0; i < points; ++i) {
+            response.dvdT[order[i]] = dvdT[i];
+            response.dvdp[order[i]] = dvdp[i];
+        }
+    }
+    return response;
+}
+
+// 单个 MaterialProperty 上的一组点. 与压力无关的类型整组调用批量接口; 可压缩液体逐点求值,
+// 已编译的 user-defined 物性用字节码的批量接口, 两者都使用每个点自己的压力
+void evaluatePropertyGroup(const MaterialProperty &prop, const double *T, const double *p, double *value,
+                           double *dvdT, double *dvdp, size_t count) {
+    if (prop.coeffType == userDefinedT && prop.userdata.program) {
+        if (dvdT != nullptr) {
+            prop.userdata.program->evaluateDual(T, p, kReferencePressure, value, dvdT, dvdp, count);
+        } else {
+            prop.userdata.program->evaluate(T, p, kReferencePressure, value, count);
+        }
+    } else if (prop.coeffType == compressibleT || prop.coeffType == userDefinedT) {
+        for (size_t i = 0; i < count; ++i) {
+            if (dvdT != nullptr) {
+                Dual result = evaluatePropertyDerivatives(prop, T[i], p[i]);
+                value[i] = result.value;
+                dvdT[i] = result.dT;
+                dvdp[i] = result.dp;
+            } else {
+                value[i] = evaluateProperty(prop, T[i], p[i]);
+            }
+        }
+    } else if (dvdT != nullptr) {
+        evaluatePropertyDerivatives(prop, T, value, dvdT, dvdp, count);
+    } else {
+        evaluateProperty(prop, T, value, count);
+    }
+}
+
+} // namespace
+
+BatchResponse evaluateBatch(const SharedMaterialTable &table, const BatchRequest &request) {
+    auto resolve = [&table](const BatchKey &key, BatchKeyStatus &status) -> const SharedCoefficientRecord * {
+        const SharedMaterialRecord *material = table.findMaterial(key.material);
+        const SharedPropertyRecord *property = material ? table.findProperty(*material, key.property) : nullptr;
+        if (material == nullptr) {
+            status = BatchKeyStatus::UnknownMaterial;
+        } else if (property == nullptr) {
+            status = BatchKeyStatus::UnknownProperty;
+        } else if (key.coefficient >= property->coefficientCount) {
+            status = BatchKeyStatus::UnknownCoefficient;
+        } else {
+            return &table.coefficient(*property, key.coefficient);
+        }
+        return nullptr;
+    };
+    return evaluateGrouped<SharedCoefficientRecord>(
+            request, resolve, [](const SharedCoefficientRecord &c) { return c.type; },
+            [&table](const SharedCoefficientRecord &c, const double *T, const double *p, double *value,
+                     double *dvdT, double *dvdp, size_t count) {
+                if (dvdT != nullptr) {
+                    table.evaluateDerivatives(c, T, p, value, dvdT, dvdp, count);
+                } else {
+                    table.evaluate(c, T, p, value, count);
+                }
+            });
+}
+
+BatchResponse evaluateBatch(const MaterialSnapshot &snapshot, const BatchRequest &request) {
+    auto resolve = [&snapshot](const BatchKey &key, BatchKeyStatus &status) -> const MaterialProperty * {
+        const Material *material = snapshot.find(key.material);
+        if (material == nullptr) {
+            status = BatchKeyStatus::UnknownMaterial;
+            return nullptr;
+        }
+        auto property = material->properties.find(key.property);
+        if (property == material->properties.end()) {
+            status = BatchKeyStatus::UnknownProperty;
+            return nullptr;
+        }
+        if (key.coefficient >= property->second.size()) {
+            status = BatchKeyStatus::UnknownCoefficient;
+            return nullptr;
+        }
+        return &property->second[key.coefficient];
+    };
+    return evaluateGrouped<MaterialProperty>(
+            request, resolve, [](const MaterialProperty &prop) { return prop.coeffType; }, evaluatePropertyGroup);
+}
+
+} // namespace CFD_MaterialDB
@@ -0,0 +1,124 @@
+#include "epoch_domain.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace CFD_MaterialDB {
+
+namespace {
+
+std::mutex &slotMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::vector<size_t> &freeSlots() {
+    static std::vector<size_t> slots = [] {
+        std::vector<size_t> list;
+        for (size_t i = kMaxEpochReaders; i > 0; --i) {
+            list.push_back(i - 1);
+        }
+        return list;
+    }();
+    return slots;
+}
+
+// 常量初始化, 线程退出阶段仍可访问
+thread_local bool slotReleased = false;
+
+// 线程退出时归还槽位
+struct SlotOwner {
+    ~SlotOwner() {
+        slotReleased = true;
+        if (cache == nullptr) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(slotMutex());
+        freeSlots().push_back(slot);
+        *cache = kUnassignedEpochReader;
+    }
+
+    size_t slot = 0;
+    size_t *cache = nullptr;
+};
+
+} // namespace
+
+size_t assignEpochReaderSlot(size_t *cache) {
+    if (slotReleased) {
+        throw std::runtime_error("线程退出阶段不能再进入读临界区");
+    }
+    thread_local SlotOwner owner;
+    std::lock_guard<std::mutex> lock(slotMutex());
+    auto &slots = freeSlots();
+    if (slots.empty()) {
+        throw std::runtime_error("同时读取的线程超过 " + std::to_string(kMaxEpochReaders) + " 个");
+    }
+    owner.slot = slots.back();
+    owner.cache = cache;
+    slots.pop_back();
+    return owner.slot;
+}
+
+EpochDomain::~EpochDomain() {
+    for (auto &item: retired_) {
+        item.second();
+    }
+}
+
+void EpochDomain::retire(std::function<void()> deleter) {
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex_);
+        // 此后进入的读者读到的 epoch 大于 retiredAt, 它们只能看到替换后的指针
+        uint64_t retiredAt = epoch_.fetch_add(1, std::memory_order_acq_rel);
+        retired_.emplace_back(retiredAt, std::move(deleter));
+    }
+    reclaim();
+}
+
+size_t EpochDomain::reclaim() {
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex_);
+        if (retired_.empty()) {
+            return 0;
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t oldest = UINT64_MAX;
+        for (const auto &slot: slots_) {
+            uint64_t epoch = slot.epoch.load(std::memory_order_acquire);
+            if (epoch != 0) {
+                oldest = std::min(oldest, epoch);
+            }
+        }
+        // 退休 epoch 小于所有活动读者的 epoch 时, 这些读者都是在替换之后进入的
+        auto safe = std::stable_partition(retired_.begin(), retired_.end(),
+                                          [oldest](const auto &item) { return item.first < oldest; });
+        for (auto it = retired_.begin(); it != safe; ++it) {
+            ready.push_back(std::move(it->second));
+        }
+        retired_.erase(retired_.begin(), safe);
+    }
+    // 在锁外释放, deleter 可能很慢 (析构整个材料表)
+    for (auto &deleter: ready) {
+        deleter();
+    }
+    return ready.size();
+}
+
+void EpochDomain::synchronize() {
+    reclaim();
+    while (pending() > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        reclaim();
+    }
+}
+
+size_t EpochDomain::pending() const {
+    std::lock_guard<std::mutex> lock(retiredMutex_);
+    return retired_.size();
+}
+
+} // namespace CFD_MaterialDB
@@ -0,0 +1,607 @@
+#include "material_daemon.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "database_manager.h"
+#include "metrics.h"
+#include "scm_parser.h"
+#include "trace.h"
+
+namespace CFD_MaterialDB {
+
+namespace {
+
+// 单个请求行的上限; 超过时断开连接
+constexpr size_t kMaxRequestBytes = 64 * 1024;
+
+constexpr size_t kReadBufferBytes = 64 * 1024;
+
+// 后台载入期间 poll 的超时, 到时检查载入是否完成
+constexpr int kLoadPollMs = 5;
+
+// 还有旧快照等待回收时 poll 的超时
+constexpr int kReclaimPollMs = 100;
+
+std::string systemError(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+sockaddr_un socketAddress(const std::string &path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("socket 路径为空或过长: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+int connectSocket(const std::string &path) {
+    sockaddr_un address = socketAddress(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error(systemError("无法创建 socket"));
+    }
+    if (connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int listenSocket(const std::string &path) {
+    struct stat info{};
+    if (lstat(path.c_str(), &info) == 0) {
+        if (!S_ISSOCK(info.st_mode)) {
+            throw std::runtime_error("socket 路径已被其他文件占用: " + path);
+        }
+        // 能连上说明已有守护进程在运行; 连接被拒绝则是上次异常退出留下的 socket 文件
+        int existing = connectSocket(path);
+        if (existing >= 0) {
+            close(existing);
+            throw std::runtime_error("已有守护进程在监听 " + path);
+        }
+        unlink(path.c_str());
+    }
+    sockaddr_un address = socketAddress(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error(systemError("无法创建 socket"));
+    }
+    // load 可以让守护进程读取任意路径, 只允许同一用户连接
+    if (bind(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+        chmod(path.c_str(), S_IRUSR | S_IWUSR) != 0 || listen(fd, 128) != 0) {
+        std::string message = systemError("无法监听 " + path);
+        close(fd);
+        throw std::runtime_error(message);
+    }
+    return fd;
+}
+
+bool sendAll(int fd, const std::string &data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// 守护进程一侧的连接: 套接字为非阻塞, 应答先放进 output, 可写时再发出, 不读应答的客户端不会阻塞其他连接
+struct ClientConnection {
+    std::string input;      // 尚未凑成完整请求的输入
+    std::string output;     // 尚未发出的应答
+    bool closing = false;   // 发完 output 后断开
+    bool loading = false;   // 正在等待该连接发起的 load/reload 完成
+};
+
+// 尽量发出 output; 对端已关闭或出错时返回 false
+bool flushOutput(int fd, std::string &output) {
+    size_t sent = 0;
+    while (sent < output.size()) {
+        ssize_t n = send(fd, output.data() + sent, output.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    output.erase(0, sent);
+    return true;
+}
+
+std::vector<std::string> splitWords(const std::string &line) {
+    std::istringstream in(line);
+    std::vector<std::string> words;
+    for (std::string word; in >> word;) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+double parseNumber(const std::string &text) {
+    size_t used = 0;
+    double value = std::stod(text, &used);
+    if (used != text.size()) {
+        throw std::invalid_argument(text);
+    }
+    return value;
+}
+
+std::string formatValue(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    return buffer;
+}
+
+Histogram &loadSeconds() {
+    static Histogram &seconds = MetricsRegistry::global().histogram(
+            "material_db_daemon_load_seconds", "Time to load, compile and publish the shared material table");
+    return seconds;
+}
+
+Counter &requestCounter(const std::string &command) {
+    return MetricsRegistry::global().counter("material_db_daemon_requests_total",
+                                             "Control requests handled by the material daemon",
+                                             {{"command", command}});
+}
+
+// 每种控制请求的计数器只在第一次使用时向注册表查找一次, 之后处理请求时不再构造标签或加锁
+struct RequestCounters {
+    Counter &status = requestCounter("status");
+    Counter &load = requestCounter("load");
+    Counter &reload = requestCounter("reload");
+    Counter &query = requestCounter("query");
+    Counter &shutdown = requestCounter("shutdown");
+    Counter &batch = requestCounter("batch");
+};
+
+RequestCounters &requestCounters() {
+    static RequestCounters counters;
+    return counters;
+}
+
+} // namespace
+
+std::vector<Material> loadMaterialSource(const std::string &source) {
+    if (!std::filesystem::exists(source)) {
+        throw std::runtime_error("材料来源不存在: " + source);
+    }
+    std::vector<Material> materials;
+    if (std::filesystem::path(source).extension() == ".scm") {
+        ScmParser parser;
+        materials = parser.parse(source);
+    } else {
+        DatabaseManager database(source);
+        database.createTables();
+        for (const auto &name: database.getMaterialNames()) {
+            materials.push_back(database.getMaterialByName(name));
+        }
+    }
+    if (materials.empty()) {
+        throw std::runtime_error("没有从 " + source + " 读到任何材料");
+    }
+    return materials;
+}
+
+MaterialDaemon::MaterialDaemon(MaterialDaemonOptions options)
+        : options_(std::move(options)), publisher_(options_.sharedTableName) {
+    // 先占用 socket, 已有守护进程在运行时不必等载入完成才报错
+    listenFd_ = listenSocket(options_.socketPath);
+    try {
+        if (pipe2(wakeFds_, O_CLOEXEC | O_NONBLOCK) != 0) {
+            throw std::runtime_error(systemError("无法创建管道"));
+        }
+        ScopedTimer timer(loadSeconds());
+        registry_ = std::make_unique<MaterialRegistry>(options_.source);
+        stageSnapshot(*registry_->read());
+        commitStaged();
+    } catch (...) {
+        close(listenFd_);
+        unlink(options_.socketPath.c_str());
+        close(wakeFds_[0]);
+        close(wakeFds_[1]);
+        throw;
+    }
+}
+
+MaterialDaemon::~MaterialDaemon() {
+    close(listenFd_);
+    unlink(options_.socketPath.c_str());
+    close(wakeFds_[0]);
+    close(wakeFds_[1]);
+}
+
+std::string MaterialDaemon::load(const std::string &source) {
+    ScopedTimer timer(loadSeconds());
+    registry_->reload(source, [this](const MaterialSnapshot &snapshot) { stageSnapshot(snapshot); });
+    return commitStaged();
+}
+
+void MaterialDaemon::stageSnapshot(const MaterialSnapshot &snapshot) {
+    TraceSpan span("stage", "daemon", snapshot.source());
+    publisher_.stage(buildSharedTableImage(snapshot.materials(), snapshot.generation()));
+    staged_.generation = snapshot.generation();
+    staged_.materials = snapshot.materials().size();
+    staged_.source = snapshot.source();
+}
+
+std::string MaterialDaemon::commitStaged() {
+    TraceSpan span("publish", "daemon", staged_.source);
+    publisher_.commit();
+    generation_ = staged_.generation;
+    options_.source = staged_.source;
+    return "ok generation=" + std::to_string(generation_) + " materials=" + std::to_string(staged_.materials);
+}
+
+void MaterialDaemon::run() {
+    // 排队的 load/reload 请求, 队首正在后台载入; fd 为 -1 表示发起请求的连接已断开
+    struct PendingLoad {
+        int fd;
+        std::string source;
+    };
+    std::deque<PendingLoad> loads;
+    std::future<uint64_t> loading;
+    std::chrono::steady_clock::time_point loadStart;
+    // 同一时刻只有一个后台载入, reloadAsync 不会在 poll 线程上等待上一次载入
+    auto startLoad = [&] {
+        if (!loads.empty() && !loading.valid()) {
+            loadStart = std::chrono::steady_clock::now();
+            // 共享表映像在载入线程上编译并写入暂存名, 完成后 poll 线程只需换上它
+            loading = registry_->reloadAsync(loads.front().source,
+                                             [this](const MaterialSnapshot &snapshot) { stageSnapshot(snapshot); });
+        }
+    };
+
+    std::map<int, ClientConnection> clients;
+    std::vector<char> buffer(kReadBufferBytes);
+    auto disconnect = [&](int fd) {
+        close(fd);
+        clients.erase(fd);
+        for (auto &pending: loads) {
+            if (pending.fd == fd) {
+                pending.fd = -1;
+            }
+        }
+    };
+    // 发出 output, 出错或应答完毕且需要断开时关闭连接
+    auto flush = [&](int fd, ClientConnection &client) {
+        if (!flushOutput(fd, client.output) || (client.output.empty() && client.closing)) {
+            disconnect(fd);
+        }
+    };
+    // 处理 input 中已经完整的请求; 遇到 load/reload 时停下, 等载入完成应答后再继续
+    auto process = [&](int fd, ClientConnection &client) {
+        std::string &pending = client.input;
+        for (size_t newline; !client.closing && !client.loading && !stopping_
+                             && (newline = pending.find('\n')) != std::string::npos;) {
+            std::string line = pending.substr(0, newline);
+            if (line.compare(0, 6, "batch ") != 0) {
+                pending.erase(0, newline + 1);
+                std::vector<std::string> words = splitWords(line);
+                if (!words.empty() && ((words[0] == "reload" && words.size() == 1) ||
+                                       (words[0] == "load" && words.size() == 2))) {
+                    (words[0] == "load" ? requestCounters().load : requestCounters().reload).add();
+                    loads.push_back({fd, words.size() == 2 ? words[1] : std::string()});
+                    client.loading = true;
+                    startLoad();
+                    break;
+                }
+                client.output += handleCommand(line) + "\n";
+                continue;
+            }
+            // 批量请求: 请求行之后是定长的二进制负载, 收齐之前留在 pending 中
+            size_t size = 0;
+            try {
+                size = std::stoull(line.substr(6));
+            } catch (const std::exception &) {
+                size = kMaxBatchBytes + 1;
+            }
+            if (size > kMaxBatchBytes) {
+                client.output += "error 批量请求长度无效或超过上限\n";
+                client.closing = true;
+                break;
+            }
+            if (pending.size() - newline - 1 < size) {
+                break;
+            }
+            client.output += handleBatch(std::string_view(pending).substr(newline + 1, size));
+            pending.erase(0, newline + 1 + size);
+        }
+        // 未收齐的批量负载不受单行长度的限制
+        if (pending.size() > kMaxRequestBytes && pending.find('\n') == std::string::npos) {
+            disconnect(fd);
+            return;
+        }
+        flush(fd, client);
+    };
+
+    while (!stopping_) {
+        std::vector<pollfd> fds = {{listenFd_, POLLIN, 0}, {wakeFds_[0], POLLIN, 0}};
+        for (const auto &client: clients) {
+            // 上一个应答发完之前不再读新请求, 每个连接最多积压一个应答; 等待载入时只关心断开
+            short events = client.second.loading ? 0 : client.second.output.empty() ? POLLIN : POLLOUT;
+            fds.push_back({client.first, events, 0});
+        }
+        // 旧快照要等最后一个读者离开才能释放, 发布时未能释放的在这里回收, 不必等到下一次发布
+        registry_->reclaim();
+        // 后台载入期间定期检查是否完成; 还有旧快照未回收时也定期醒来
+        int timeout = loading.valid() ? kLoadPollMs : registry_->pendingReclamation() > 0 ? kReclaimPollMs : -1;
+        if (poll(fds.data(), fds.size(), timeout) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(systemError("poll 失败"));
+        }
+        if (fds[1].revents != 0) {
+            break;
+        }
+        if (loading.valid() && loading.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            std::string reply;
+            try {
+                loading.get();
+                reply = commitStaged();
+                loadSeconds().observe(
+                        std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count());
+            } catch (const std::exception &e) {
+                reply = std::string("error ") + e.what();
+            }
+            loading = {};
+            int fd = loads.front().fd;
+            loads.pop_front();
+            startLoad();
+            auto it = clients.find(fd);
+            if (it != clients.end()) {
+                it->second.loading = false;
+                it->second.output += reply + "\n";
+                process(fd, it->second);
+            }
+        }
+        if (fds[0].revents & POLLIN) {
+            int fd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (fd >= 0) {
+                clients[fd];
+            }
+        }
+        for (size_t i = 2; i < fds.size() && !stopping_; ++i) {
+            int fd = fds[i].fd;
+            auto it = clients.find(fd);
+            if (fds[i].revents == 0 || it == clients.end()) {
+                continue;
+            }
+            ClientConnection &client = it->second;
+            if (client.loading) {
+                // 等待载入期间对端断开
+                disconnect(fd);
+                continue;
+            }
+            if (!client.output.empty()) {
+                flush(fd, client);
+                continue;
+            }
+            ssize_t n = read(fd, buffer.data(), buffer.size());
+            if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+                continue;
+            }
+            if (n <= 0) {
+                disconnect(fd);
+                continue;
+            }
+            client.input.append(buffer.data(), static_cast<size_t>(n));
+            process(fd, client);
+        }
+    }
+    // shutdown 的应答通常还在各连接的 output 中, 退出前再尝试发送一次
+    for (auto &client: clients) {
+        flushOutput(client.first, client.second.output);
+        close(client.first);
+    }
+    // 等后台载入结束, 其结果不再发布
+    if (loading.valid()) {
+        loading.wait();
+    }
+}
+
+void MaterialDaemon::stop() {
+    char byte = 1;
+    ssize_t ignored = write(wakeFds_[1], &byte, 1);
+    (void) ignored;
+}
+
+std::string MaterialDaemon::handleCommand(const std::string &line) {
+    std::vector<std::string> words = splitWords(line);
+    if (words.empty()) {
+        return "error 空请求";
+    }
+    const std::string &command = words[0];
+    TraceSpan span("request", "daemon", line);
+    try {
+        if (command == "status" && words.size() == 1) {
+            requestCounters().status.add();
+            return status();
+        }
+        if (command == "load" && words.size() == 2) {
+            requestCounters().load.add();
+            return load(words[1]);
+        }
+        if (command == "reload" && words.size() == 1) {
+            requestCounters().reload.add();
+            return load(std::string());
+        }
+        if (command == "query" && (words.size() == 4 || words.size() == 5)) {
+            requestCounters().query.add();
+            return query(words);
+        }
+        if (command == "shutdown" && words.size() == 1) {
+            requestCounters().shutdown.add();
+            stopping_ = true;
+            return "ok";
+        }
+    } catch (const std::exception &e) {
+        return std::string("error ") + e.what();
+    }
+    return "error 无法识别的请求: " + line;
+}
+
+std::string MaterialDaemon::handleBatch(std::string_view payload) {
+    requestCounters().batch.add();
+    std::string response;
+    try {
+        BatchRequest request = decodeBatchRequest(payload);
+        MaterialRegistry::Reader snapshot = registry_->read();
+        response = encodeBatchResponse(evaluateBatch(*snapshot, request));
+    } catch (const std::exception &e) {
+        return std::string("error ") + e.what() + "\n";
+    }
+    return "ok " + std::to_string(response.size()) + "\n" + response;
+}
+
+std::string MaterialDaemon::status() const {
+    MaterialRegistry::Reader snapshot = registry_->read();
+    size_t coefficients = 0;
+    for (const auto &material: snapshot->materials()) {
+        for (const auto &property: material.properties) {
+            coefficients += property.second.size();
+        }
+    }
+    return "ok generation=" + std::to_string(generation_) + " materials=" +
+           std::to_string(snapshot->materials().size()) + " coefficients=" + std::to_string(coefficients) +
+           " bytes=" + std::to_string(publisher_.bytes()) + " shm=" + publisher_.name() + " source=" +
+           options_.source;
+}
+
+std::string MaterialDaemon::query(const std::vector<std::string> &words) const {
+    double T, p = kReferencePressure;
+    try {
+        T = parseNumber(words[3]);
+        if (words.size() == 5) {
+            p = parseNumber(words[4]);
+        }
+    } catch (const std::exception &) {
+        return "error 温度和压力应为数值";
+    }
+    MaterialRegistry::Reader snapshot = registry_->read();
+    const Material *material = snapshot->find(words[1]);
+    if (material == nullptr) {
+        return "error 材料不存在: " + words[1];
+    }
+    auto property = material->properties.find(words[2]);
+    if (property == material->properties.end()) {
+        return "error " + words[1] + " 没有物性 " + words[2];
+    }
+    std::string reply = "ok";
+    for (const auto &coefficient: property->second) {
+        reply += " " + formatValue(evaluateProperty(coefficient, T, p));
+    }
+    return reply;
+}
+
+namespace {
+
+// 客户端一侧的连接: 析构时关闭, 读超时或出错时抛出
+class DaemonConnection {
+public:
+    DaemonConnection(const std::string &socketPath, int timeoutMs) : fd_(connectSocket(socketPath)) {
+        if (fd_ < 0) {
+            throw std::runtime_error(systemError("无法连接守护进程 " + socketPath));
+        }
+        timeval timeout{timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+
+    ~DaemonConnection() { close(fd_); }
+
+    void send(const std::string &data) {
+        if (!sendAll(fd_, data)) {
+            throw std::runtime_error(systemError("发送请求失败"));
+        }
+    }
+
+    std::string receiveLine() {
+        size_t newline;
+        while ((newline = buffer_.find('\n')) == std::string::npos) {
+            receive();
+        }
+        std::string line = buffer_.substr(0, newline);
+        buffer_.erase(0, newline + 1);
+        return line;
+    }
+
+    std::string receiveBytes(size_t size) {
+        while (buffer_.size() < size) {
+            receive();
+        }
+        std::string bytes = buffer_.substr(0, size);
+        buffer_.erase(0, size);
+        return bytes;
+    }
+
+    DaemonConnection(const DaemonConnection &) = delete;
+    DaemonConnection &operator=(const DaemonConnection &) = delete;
+
+private:
+    void receive() {
+        char chunk[kReadBufferBytes];
+        ssize_t n;
+        do {
+            n = read(fd_, chunk, sizeof(chunk));
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) {
+            throw std::runtime_error(n < 0 ? systemError("等待应答失败") : "守护进程关闭了连接");
+        }
+        buffer_.append(chunk, static_cast<size_t>(n));
+    }
+
+    int fd_;
+    std::string buffer_;
+};
+
+} // namespace
+
+std::string sendDaemonCommand(const std::string &socketPath, const std::string &command, int timeoutMs) {
+    DaemonConnection connection(socketPath, timeoutMs);
+    connection.send(command + "\n");
+    return connection.receiveLine();
+}
+
+BatchResponse sendDaemonBatch(const std::string &socketPath, const BatchRequest &request, int timeoutMs) {
+    std::string payload = encodeBatchRequest(request);
+    DaemonConnection connection(socketPath, timeoutMs);
+    connection.send("batch " + std::to_string(payload.size()) + "\n" + payload);
+    std::string line = connection.receiveLine();
+    std::vector<std::string> words = splitWords(line);
+    if (words.size() != 2 || words[0] != "ok") {
+        throw std::runtime_error("守护进程拒绝了批量请求: " + line);
+    }
+    size_t size = std::stoull(words[1]);
+    if (size > kMaxBatchBytes) {
+        throw std::runtime_error("批量应答过大: " + words[1]);
+    }
+    return decodeBatchResponse(connection.receiveBytes(size));
+}
+
+} // namespace CFD_MaterialDB
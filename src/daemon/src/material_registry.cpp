@@ -0,0 +1,100 @@
+#include "material_registry.h"
+#include <memory>
+#include <stdexcept>
+#include "material_daemon.h"
+#include "metrics.h"
+#include "property_evaluator.h"
+#include "trace.h"
+
+namespace CFD_MaterialDB {
+
+namespace {
+
+Counter &reloadCounter(const char *result) {
+    return MetricsRegistry::global().counter("material_db_registry_reloads_total",
+                                             "Material registry reloads by result", {{"result", result}});
+}
+
+} // namespace
+
+MaterialSnapshot::MaterialSnapshot(std::vector<Material> materials, std::string source)
+        : materials_(std::move(materials)), source_(std::move(source)) {
+    for (size_t i = 0; i < materials_.size(); ++i) {
+        compileUserDefinedProperties(materials_[i]);
+        index_[materials_[i].name] = i;
+    }
+}
+
+const Material *MaterialSnapshot::find(const std::string &name) const {
+    auto it = index_.find(name);
+    return it == index_.end() ? nullptr : &materials_[it->second];
+}
+
+MaterialRegistry::MaterialRegistry(const std::string &source) {
+    reload(source);
+}
+
+MaterialRegistry::~MaterialRegistry() {
+    {
+        std::lock_guard<std::mutex> lock(loaderMutex_);
+        if (loader_.joinable()) {
+            loader_.join();
+        }
+    }
+    delete current_.load(std::memory_order_relaxed);
+}
+
+uint64_t MaterialRegistry::reload(const std::string &source, const Prepare &prepare) {
+    std::string target;
+    {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        target = source.empty() ? source_ : source;
+    }
+    TraceSpan span("registry.reload", "registry", target);
+    try {
+        // 载入和编译不持有写者锁, 读者和其他写者都不受影响
+        uint64_t generation = publish(loadMaterialSource(target), target, prepare);
+        reloadCounter("ok").add();
+        return generation;
+    } catch (...) {
+        reloadCounter("failed").add();
+        throw;
+    }
+}
+
+std::future<uint64_t> MaterialRegistry::reloadAsync(const std::string &source, Prepare prepare) {
+    std::packaged_task<uint64_t()> task([this, source, prepare = std::move(prepare)] {
+        return reload(source, prepare);
+    });
+    std::future<uint64_t> result = task.get_future();
+    std::lock_guard<std::mutex> lock(loaderMutex_);
+    if (loader_.joinable()) {
+        loader_.join();
+    }
+    loader_ = std::thread([task = std::move(task)]() mutable {
+        setTraceThreadName("registry-loader");
+        task();
+    });
+    return result;
+}
+
+uint64_t MaterialRegistry::publish(std::vector<Material> materials, const std::string &source,
+                                   const Prepare &prepare) {
+    // 快照在锁外构建 (编译 user-defined 物性可能较慢); 代号在发布时才确定
+    auto snapshot = std::make_unique<MaterialSnapshot>(std::move(materials), source);
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    uint64_t generation = generation_ + 1;
+    snapshot->generation_ = generation;
+    if (prepare) {
+        prepare(*snapshot);
+    }
+    generation_ = generation;
+    const MaterialSnapshot *old = current_.exchange(snapshot.release(), std::memory_order_acq_rel);
+    source_ = source;
+    if (old != nullptr) {
+        domain_.retire([old] { delete old; });
+    }
+    return generation;
+}
+
+} // namespace CFD_MaterialDB
@@ -0,0 +1,645 @@
+#include "shared_material_table.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "property_expression.h"
+#include "viscosity_kernels.h"
+
+namespace CFD_MaterialDB {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+constexpr size_t kDataAlignment = 64;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+std::string systemError(const std::string &what, const std::string &name) {
+    return what + " " + name + ": " + std::strerror(errno);
+}
+
+// Linux 上 POSIX 共享内存对象即 /dev/shm 下的文件, 可以用 rename 原子地替换
+std::string shmPath(const std::string &name) {
+    return "/dev/shm" + name;
+}
+
+// 映像的字符串区和数据区; 偏移先相对各自区域起点记录, 拼接映像时再加上区域的起点
+class ImageBuilder {
+public:
+    SharedString addString(const std::string &text) {
+        if (strings_.size() + text.size() > std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("共享表的字符串区超过 4 GiB");
+        }
+        SharedString s{static_cast<uint32_t>(strings_.size()), static_cast<uint32_t>(text.size())};
+        strings_ += text;
+        return s;
+    }
+
+    // 追加一块按 64 字节对齐的数据, 返回相对数据区起点的偏移
+    uint64_t addData(const void *data, size_t bytes) {
+        data_.resize(alignUp(data_.size(), kDataAlignment), '\0');
+        uint64_t offset = data_.size();
+        data_.append(static_cast<const char *>(data), bytes);
+        return offset;
+    }
+
+    // 依次追加多个 double 数组, 作为同一块连续存放
+    uint64_t addDoubles(std::initializer_list<std::pair<const double *, size_t>> arrays) {
+        data_.resize(alignUp(data_.size(), kDataAlignment), '\0');
+        uint64_t offset = data_.size();
+        for (const auto &array: arrays) {
+            data_.append(reinterpret_cast<const char *>(array.first), array.second * sizeof(double));
+        }
+        return offset;
+    }
+
+    void addCoefficient(const MaterialProperty &prop, uint32_t &userDefinedCount) {
+        SharedCoefficientRecord c{};
+        c.type = static_cast<uint32_t>(prop.coeffType);
+        c.unit = addString(prop.unit);
+        // 早期版本写入数据库的粘度/可压缩液体参数存放在 polydata 中, 与 evaluateProperty 同样换算
+        const auto &legacy = prop.polydata.coefficients;
+        switch (prop.coeffType) {
+            case CONSTCOEFF:
+                c.params[0] = prop.constData;
+                break;
+            case polynomialT:
+                c.count = static_cast<uint32_t>(legacy.size());
+                c.dataOffset = addDoubles({{legacy.data(), legacy.size()}});
+                break;
+            case polynomialTPieceLinearT: {
+                PiecewiseLinearView view = piecewiseLinearView(prop.ppldata);
+                if (view.points < 2) {
+                    break;
+                }
+                c.count = static_cast<uint32_t>(view.points);
+                c.dataOffset = addDoubles({{view.temps, view.points}, {view.values, view.points},
+                                           {view.slopes, view.points - 1}});
+                if (view.bucketCount > 0) {
+                    c.bucketCount = static_cast<uint32_t>(view.bucketCount);
+                    c.auxOffset = addData(view.buckets, view.bucketCount * sizeof(uint32_t));
+                    c.params[0] = view.bucketScale;
+                }
+                break;
+            }
+            case polynomialTPiecePolyT:
+            case nasa9PiecePolyT: {
+                bool nasa = prop.coeffType == nasa9PiecePolyT;
+                SegmentedView view = nasa ? nasa9View(prop.nasapolydata) : piecewisePolynomialView(prop.pwpolydata);
+                if (view.segments == 0) {
+                    break;
+                }
+                size_t stride = nasa ? kNasa9Stride : kPiecewisePolyStride;
+                c.count = static_cast<uint32_t>(view.segments);
+                c.dataOffset = addDoubles({{view.bounds, view.segments + 1}});
+                c.auxOffset = addDoubles({{view.blocks, view.segments * stride}});
+                break;
+            }
+            case compressibleT: {
+                compressibleLiquidData data = prop.compLiquidData.valid()
+                                              ? prop.compLiquidData
+                                              : compressibleLiquidData::fromCoefficients(legacy);
+                double params[6] = {data.referencePressure, data.referenceDensity, data.bulkModulus,
+                                    data.densityExponent, data.maxDensityRatio, data.minDensityRatio};
+                std::copy(params, params + 6, c.params);
+                break;
+            }
+            case sutherlandT: {
+                sutherlandData data = legacy.empty() ? prop.sutherlanddata : sutherlandData::fromCoefficients(legacy);
+                c.params[0] = data.C1;
+                c.params[1] = data.S;
+                break;
+            }
+            case powerLawT: {
+                powerLawData data = legacy.empty() ? prop.powerlawdata : powerLawData::fromCoefficients(legacy);
+                c.params[0] = data.B;
+                c.params[1] = data.n;
+                break;
+            }
+            case blottnerT: {
+                blottnerData data = legacy.empty() ? prop.blottnerdata : blottnerData::fromCoefficients(legacy);
+                c.params[0] = data.A;
+                c.params[1] = data.B;
+                c.params[2] = data.C;
+                c.params[3] = data.present ? 1.0 : 0.0;
+                break;
+            }
+            case userDefinedT:
+                c.source = addString(prop.userdata.source);
+                c.userDefinedIndex = userDefinedCount++;
+                break;
+            default:
+                break;
+        }
+        coefficients.push_back(c);
+    }
+
+    std::vector<SharedMaterialRecord> materials;
+    std::vector<SharedPropertyRecord> properties;
+    std::vector<SharedCoefficientRecord> coefficients;
+
+    const std::string &strings() const { return strings_; }
+    const std::string &data() const { return data_; }
+
+private:
+    std::string strings_;
+    std::string data_;
+};
+
+template<typename Record>
+void appendRecords(std::string &image, const std::vector<Record> &records) {
+    image.append(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(Record));
+}
+
+} // namespace
+
+std::string buildSharedTableImage(const std::vector<Material> &materials, uint64_t generation) {
+    std::map<std::string, const Material *> sorted;
+    for (const auto &material: materials) {
+        sorted[material.name] = &material;
+    }
+
+    ImageBuilder builder;
+    uint32_t userDefinedCount = 0;
+    for (const auto &item: sorted) {
+        SharedMaterialRecord m{};
+        m.name = builder.addString(item.first);
+        m.firstProperty = static_cast<uint32_t>(builder.properties.size());
+        std::map<std::string, const std::vector<MaterialProperty> *> properties;
+        for (const auto &property: item.second->properties) {
+            properties[property.first] = &property.second;
+        }
+        for (const auto &property: properties) {
+            SharedPropertyRecord p{};
+            p.name = builder.addString(property.first);
+            p.firstCoefficient = static_cast<uint32_t>(builder.coefficients.size());
+            p.coefficientCount = static_cast<uint32_t>(property.second->size());
+            for (const auto &coefficient: *property.second) {
+                builder.addCoefficient(coefficient, userDefinedCount);
+            }
+            builder.properties.push_back(p);
+        }
+        m.propertyCount = static_cast<uint32_t>(builder.properties.size() - m.firstProperty);
+        builder.materials.push_back(m);
+    }
+
+    SharedTableHeader header{};
+    std::memcpy(header.magic, kSharedTableMagic, sizeof(header.magic));
+    header.version = kSharedTableVersion;
+    header.state.store(static_cast<uint32_t>(SharedTableState::Building), std::memory_order_relaxed);
+    header.generation = generation;
+    header.materialCount = static_cast<uint32_t>(builder.materials.size());
+    header.propertyCount = static_cast<uint32_t>(builder.properties.size());
+    header.coefficientCount = static_cast<uint32_t>(builder.coefficients.size());
+    header.userDefinedCount = userDefinedCount;
+    header.materialsOffset = alignUp(sizeof(SharedTableHeader), 8);
+    header.propertiesOffset = header.materialsOffset + builder.materials.size() * sizeof(SharedMaterialRecord);
+    header.coefficientsOffset = alignUp(header.propertiesOffset +
+                                        builder.properties.size() * sizeof(SharedPropertyRecord), 8);
+    header.stringsOffset = header.coefficientsOffset + builder.coefficients.size() * sizeof(SharedCoefficientRecord);
+    header.dataOffset = alignUp(header.stringsOffset + builder.strings().size(), kDataAlignment);
+    header.totalBytes = header.dataOffset + builder.data().size();
+
+    // 数据区偏移改为相对映像起点
+    for (auto &c: builder.coefficients) {
+        c.dataOffset += header.dataOffset;
+        c.auxOffset += header.dataOffset;
+    }
+
+    std::string image(reinterpret_cast<const char *>(static_cast<const void *>(&header)), sizeof(header));
+    image.resize(header.materialsOffset, '\0');
+    appendRecords(image, builder.materials);
+    appendRecords(image, builder.properties);
+    image.resize(header.coefficientsOffset, '\0');
+    appendRecords(image, builder.coefficients);
+    image += builder.strings();
+    image.resize(header.dataOffset, '\0');
+    image += builder.data();
+    return image;
+}
+
+SharedTablePublisher::SharedTablePublisher(std::string name) : name_(std::move(name)), stagingName_(name_ + ".new") {
+    if (name_.size() < 2 || name_[0] != '/' || name_.find('/', 1) != std::string::npos) {
+        throw std::runtime_error("共享内存名应为 /名称 形式: " + name_);
+    }
+}
+
+SharedTablePublisher::~SharedTablePublisher() {
+    release();
+}
+
+void SharedTablePublisher::discardStaged() {
+    if (stagedMapping_ == nullptr) {
+        return;
+    }
+    munmap(stagedMapping_, stagedSize_);
+    shm_unlink(stagingName_.c_str());
+    stagedMapping_ = nullptr;
+    stagedSize_ = 0;
+}
+
+void SharedTablePublisher::release() {
+    discardStaged();
+    if (mapping_ == nullptr) {
+        return;
+    }
+    auto *header = static_cast<SharedTableHeader *>(mapping_);
+    header->state.store(static_cast<uint32_t>(SharedTableState::Superseded), std::memory_order_release);
+    munmap(mapping_, size_);
+    shm_unlink(name_.c_str());
+    mapping_ = nullptr;
+    size_ = 0;
+}
+
+void SharedTablePublisher::publish(const std::string &image) {
+    stage(image);
+    commit();
+}
+
+void SharedTablePublisher::stage(const std::string &image) {
+    if (image.size() < sizeof(SharedTableHeader)) {
+        throw std::runtime_error("共享表映像不完整");
+    }
+    // 新表先在临时名下建好并标为 Ready, commit 时再改名覆盖正式名; 任何一步失败时旧表仍在原名下继续服务
+    discardStaged();
+    const std::string &staging = stagingName_;
+    shm_unlink(staging.c_str());
+    int fd = shm_open(staging.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        throw std::runtime_error(systemError("无法创建共享内存", staging));
+    }
+    if (ftruncate(fd, static_cast<off_t>(image.size())) != 0) {
+        std::string message = systemError("无法设置共享内存大小", staging);
+        close(fd);
+        shm_unlink(staging.c_str());
+        throw std::runtime_error(message);
+    }
+    void *mapping = mmap(nullptr, image.size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::string message = systemError("无法映射共享内存", staging);
+        shm_unlink(staging.c_str());
+        throw std::runtime_error(message);
+    }
+    // 映像中的状态为 Building; 全部写完后再以 release 标为 Ready, 客户端以 acquire 读到 Ready 后才访问其余部分
+    std::memcpy(mapping, image.data(), image.size());
+    static_cast<SharedTableHeader *>(mapping)->state.store(static_cast<uint32_t>(SharedTableState::Ready),
+                                                           std::memory_order_release);
+    stagedMapping_ = mapping;
+    stagedSize_ = image.size();
+}
+
+void SharedTablePublisher::commit() {
+    if (stagedMapping_ == nullptr) {
+        throw std::runtime_error("没有待发布的共享表");
+    }
+    // 改名是原子的, 客户端在任何时刻都能打开正式名
+    if (std::rename(shmPath(stagingName_).c_str(), shmPath(name_).c_str()) != 0) {
+        std::string message = systemError("无法发布共享内存", name_);
+        discardStaged();
+        throw std::runtime_error(message);
+    }
+    // 正式名已指向新表, 旧表只需标为 Superseded 并解除映射, 不能再删除名称
+    if (mapping_ != nullptr) {
+        static_cast<SharedTableHeader *>(mapping_)->state.store(static_cast<uint32_t>(SharedTableState::Superseded),
+                                                                std::memory_order_release);
+        munmap(mapping_, size_);
+    }
+    mapping_ = std::exchange(stagedMapping_, nullptr);
+    size_ = std::exchange(stagedSize_, 0);
+}
+
+SharedMaterialTable::SharedMaterialTable(const std::string &name, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    auto retry = [&](const std::string &reason) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            throw std::runtime_error(reason);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    };
+    while (true) {
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            if (errno != ENOENT) {
+                throw std::runtime_error(systemError("无法打开共享内存", name));
+            }
+            retry("共享内存不存在, 守护进程是否已启动: " + name);
+            continue;
+        }
+        struct stat info{};
+        if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(SharedTableHeader))) {
+            close(fd);
+            retry("共享表尚未写入: " + name);
+            continue;
+        }
+        size_t size = static_cast<size_t>(info.st_size);
+        void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error(systemError("无法映射共享内存", name));
+        }
+        const auto *header = static_cast<const SharedTableHeader *>(mapping);
+        if (header->state.load(std::memory_order_acquire) != static_cast<uint32_t>(SharedTableState::Ready)) {
+            // 正在写入, 或者刚被取代而新表还没有建立
+            munmap(mapping, size);
+            retry("共享表未就绪: " + name);
+            continue;
+        }
+        if (std::memcmp(header->magic, kSharedTableMagic, sizeof(header->magic)) != 0 ||
+            header->version != kSharedTableVersion || header->totalBytes != size ||
+            header->dataOffset > size || header->stringsOffset > header->dataOffset) {
+            munmap(mapping, size);
+            throw std::runtime_error("共享内存不是可识别的材料表: " + name);
+        }
+        base_ = static_cast<const char *>(mapping);
+        size_ = size;
+        header_ = header;
+        break;
+    }
+    materials_ = reinterpret_cast<const SharedMaterialRecord *>(base_ + header_->materialsOffset);
+    properties_ = reinterpret_cast<const SharedPropertyRecord *>(base_ + header_->propertiesOffset);
+    coefficients_ = reinterpret_cast<const SharedCoefficientRecord *>(base_ + header_->coefficientsOffset);
+    strings_ = base_ + header_->stringsOffset;
+
+    programs_.resize(header_->userDefinedCount);
+    for (uint32_t i = 0; i < header_->coefficientCount; ++i) {
+        const SharedCoefficientRecord &c = coefficients_[i];
+        if (c.type != userDefinedT || c.userDefinedIndex >= programs_.size()) {
+            continue;
+        }
+        try {
+            programs_[c.userDefinedIndex] = std::make_shared<ExpressionProgram>(
+                    compileSchemeLambda(std::string(text(c.source))));
+        } catch (const std::exception &) {
+        }
+    }
+}
+
+SharedMaterialTable::~SharedMaterialTable() {
+    munmap(const_cast<char *>(base_), size_);
+}
+
+const SharedMaterialRecord *SharedMaterialTable::findMaterial(std::string_view name) const {
+    const SharedMaterialRecord *begin = materials_;
+    const SharedMaterialRecord *end = materials_ + header_->materialCount;
+    auto it = std::lower_bound(begin, end, name, [this](const SharedMaterialRecord &m, std::string_view key) {
+        return text(m.name) < key;
+    });
+    return it != end && text(it->name) == name ? it : nullptr;
+}
+
+const SharedPropertyRecord *SharedMaterialTable::findProperty(const SharedMaterialRecord &material,
+                                                              std::string_view property) const {
+    const SharedPropertyRecord *begin = properties_ + material.firstProperty;
+    const SharedPropertyRecord *end = begin + material.propertyCount;
+    auto it = std::lower_bound(begin, end, property, [this](const SharedPropertyRecord &p, std::string_view key) {
+        return text(p.name) < key;
+    });
+    return it != end && text(it->name) == property ? it : nullptr;
+}
+
+PiecewiseLinearView SharedMaterialTable::linearView(const SharedCoefficientRecord &c) const {
+    PiecewiseLinearView view;
+    if (c.count >= 2) {
+        const double *data = doubles(c.dataOffset);
+        view.temps = data;
+        view.values = data + c.count;
+        view.slopes = data + 2 * size_t(c.count);
+        view.points = c.count;
+        view.buckets = reinterpret_cast<const uint32_t *>(base_ + c.auxOffset);
+        view.bucketCount = c.bucketCount;
+        view.bucketScale = c.params[0];
+    }
+    return view;
+}
+
+SegmentedView SharedMaterialTable::segmentedView(const SharedCoefficientRecord &c) const {
+    SegmentedView view;
+    if (c.count > 0) {
+        view.bounds = doubles(c.dataOffset);
+        view.blocks = doubles(c.auxOffset);
+        view.segments = c.count;
+    }
+    return view;
+}
+
+const ExpressionProgram *SharedMaterialTable::program(const SharedCoefficientRecord &c) const {
+    return c.userDefinedIndex < programs_.size() ? programs_[c.userDefinedIndex].get() : nullptr;
+}
+
+namespace {
+
+sutherlandData sutherlandParams(const SharedCoefficientRecord &c) {
+    return {c.params[0], c.params[1]};
+}
+
+powerLawData powerLawParams(const SharedCoefficientRecord &c) {
+    return {c.params[0], c.params[1]};
+}
+
+blottnerData blottnerParams(const SharedCoefficientRecord &c) {
+    return {c.params[0], c.params[1], c.params[2], c.params[3] != 0.0};
+}
+
+compressibleLiquidData compressibleParams(const SharedCoefficientRecord &c) {
+    return {c.params[0], c.params[1], c.params[2], c.params[3], c.params[4], c.params[5]};
+}
+
+} // namespace
+
+double SharedMaterialTable::evaluate(const SharedCoefficientRecord &c, double T, double p) const {
+    switch (c.type) {
+        case CONSTCOEFF:
+            return c.params[0];
+        case polynomialT: {
+            const double *a = doubles(c.dataOffset);
+            double value = 0.0;
+            for (size_t j = c.count; j-- > 0;) {
+                value = value * T + a[j];
+            }
+            return value;
+        }
+        case polynomialTPieceLinearT:
+            return evaluatePiecewiseLinear(linearView(c), T);
+        case polynomialTPiecePolyT:
+            return evaluatePiecewisePolynomial(segmentedView(c), T);
+        case nasa9PiecePolyT:
+            return evaluateNasa9(segmentedView(c), T);
+        case compressibleT:
+            return evaluateCompressibleLiquid(compressibleParams(c), p);
+        case sutherlandT:
+            return evaluateSutherland(sutherlandParams(c), T);
+        case powerLawT:
+            return evaluatePowerLaw(powerLawParams(c), T);
+        case blottnerT:
+            return evaluateBlottner(blottnerParams(c), T);
+        case userDefinedT: {
+            const ExpressionProgram *code = program(c);
+            return code ? code->evaluate(T, p) : kNaN;
+        }
+        default:
+            return kNaN;
+    }
+}
+
+void SharedMaterialTable::evaluate(const SharedCoefficientRecord &c, const double *T, double *out, size_t count,
+                                   double p) const {
+    evaluateBatch(c, T, nullptr, p, out, count);
+}
+
+void SharedMaterialTable::evaluate(const SharedCoefficientRecord &c, const double *T, const double *p, double *out,
+                                   size_t count) const {
+    evaluateBatch(c, T, p, kReferencePressure, out, count);
+}
+
+void SharedMaterialTable::evaluateBatch(const SharedCoefficientRecord &c, const double *T, const double *p,
+                                        double pressure, double *out, size_t count) const {
+    switch (c.type) {
+        case polynomialTPieceLinearT:
+            evaluatePiecewiseLinear(linearView(c), T, out, count);
+            return;
+        case polynomialTPiecePolyT:
+            evaluatePiecewisePolynomial(segmentedView(c), T, out, count);
+            return;
+        case nasa9PiecePolyT:
+            evaluateNasa9(segmentedView(c), T, out, count);
+            return;
+        case sutherlandT:
+            evaluateSutherland(sutherlandParams(c), T, out, count);
+            return;
+        case powerLawT:
+            evaluatePowerLaw(powerLawParams(c), T, out, count);
+            return;
+        case blottnerT:
+            evaluateBlottner(blottnerParams(c), T, out, count);
+            return;
+        case compressibleT:
+            if (p != nullptr) {
+                evaluateCompressibleLiquid(compressibleParams(c), p, out, nullptr, count);
+                return;
+            }
+            break;
+        case userDefinedT:
+            if (const ExpressionProgram *code = program(c)) {
+                code->evaluate(T, p, pressure, out, count);
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = evaluate(c, T[i], p ? p[i] : pressure);
+    }
+}
+
+Dual SharedMaterialTable::evaluateDerivatives(const SharedCoefficientRecord &c, double T, double p) const {
+    Dual result;
+    switch (c.type) {
+        case CONSTCOEFF:
+            return dualConstant(c.params[0]);
+        case polynomialT: {
+            const double *a = doubles(c.dataOffset);
+            for (size_t j = c.count; j-- > 0;) {
+                result.dT = result.dT * T + result.value;
+                result.value = result.value * T + a[j];
+            }
+            return result;
+        }
+        case polynomialTPieceLinearT:
+            result.value = evaluatePiecewiseLinear(linearView(c), T, &result.dT);
+            return result;
+        case polynomialTPiecePolyT:
+            result.value = evaluatePiecewisePolynomial(segmentedView(c), T, &result.dT);
+            return result;
+        case nasa9PiecePolyT:
+            result.value = evaluateNasa9(segmentedView(c), T, &result.dT);
+            return result;
+        case compressibleT:
+            result.value = evaluateCompressibleLiquid(compressibleParams(c), p, &result.dp);
+            return result;
+        case sutherlandT:
+            result.value = evaluateSutherland(sutherlandParams(c), T, &result.dT);
+            return result;
+        case powerLawT:
+            result.value = evaluatePowerLaw(powerLawParams(c), T, &result.dT);
+            return result;
+        case blottnerT:
+            result.value = evaluateBlottner(blottnerParams(c), T, &result.dT);
+            return result;
+        case userDefinedT: {
+            const ExpressionProgram *code = program(c);
+            return code ? code->evaluateDual(T, p) : Dual{kNaN, kNaN, kNaN};
+        }
+        default:
+            return {kNaN, kNaN, kNaN};
+    }
+}
+
+void SharedMaterialTable::evaluateDerivatives(const SharedCoefficientRecord &c, const double *T, double *value,
+                                              double *dvdT, double *dvdp, size_t count, double p) const {
+    evaluateDerivativesBatch(c, T, nullptr, p, value, dvdT, dvdp, count);
+}
+
+void SharedMaterialTable::evaluateDerivatives(const SharedCoefficientRecord &c, const double *T, const double *p,
+                                              double *value, double *dvdT, double *dvdp, size_t count) const {
+    evaluateDerivativesBatch(c, T, p, kReferencePressure, value, dvdT, dvdp, count);
+}
+
+void SharedMaterialTable::evaluateDerivativesBatch(const SharedCoefficientRecord &c, const double *T,
+                                                   const double *p, double pressure, double *value, double *dvdT,
+                                                   double *dvdp, size_t count) const {
+    // 有批量内核的类型都与压力无关, dv/dp 为 0
+    switch (c.type) {
+        case polynomialTPieceLinearT:
+            evaluatePiecewiseLinear(linearView(c), T, value, dvdT, count);
+            break;
+        case polynomialTPiecePolyT:
+            evaluatePiecewisePolynomial(segmentedView(c), T, value, dvdT, count);
+            break;
+        case nasa9PiecePolyT:
+            evaluateNasa9(segmentedView(c), T, value, dvdT, count);
+            break;
+        case sutherlandT:
+            evaluateSutherland(sutherlandParams(c), T, value, dvdT, count);
+            break;
+        case powerLawT:
+            evaluatePowerLaw(powerLawParams(c), T, value, dvdT, count);
+            break;
+        case blottnerT:
+            evaluateBlottner(blottnerParams(c), T, value, dvdT, count);
+            break;
+        default:
+            if (const ExpressionProgram *code = c.type == userDefinedT ? program(c) : nullptr) {
+                code->evaluateDual(T, p, pressure, value, dvdT, dvdp, count);
+                return;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                Dual result = evaluateDerivatives(c, T[i], p ? p[i] : pressure);
+                value[i] = result.value;
+                dvdT[i] = result.dT;
+                if (dvdp) {
+                    dvdp[i] = result.dp;
+                }
+            }
+            return;
+    }
+    if (dvdp) {
+        std::fill(dvdp, dvdp + count, 0.0);
+    }
+}
+
+} // namespace CFD_MaterialDB
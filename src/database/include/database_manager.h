@@ -1,39 +1,92 @@
 #pragma once
 #define SQLITE_INTEGER  1
 #include <string>
+#include <vector>
+#include <optional>
+#include <limits>
 //#include <sqlite3.h>
 
 #include "material.h"
 
 #include "sqlcipher/sqlite3.h"
-#include <openssl/md5.h>
-#include <curl/curl.h>
 #include <sstream>
 #include <iomanip>
 namespace CFD_MaterialDB {
 
+// 全文检索结果, rank 越小越相关
+struct MaterialSearchResult {
+    std::string name;
+    std::string chinese_name;
+    std::string chemical_formula;
+    double rank = 0.0;
+};
+
+// 物性范围查询, 例如 "400 K 时粘度在 1e-5 ~ 2e-5 之间的材料";
+// 不给温度时按系数在整个有效温度范围内的取值判断
+struct PropertyRangeQuery {
+    std::string property;
+    std::optional<double> temperature;
+    double min_value = -std::numeric_limits<double>::infinity();
+    double max_value = std::numeric_limits<double>::infinity();
+    int limit = 100;
+};
+
+// value 为查询温度下的物性值; 不给温度且系数不是常数时为 NaN
+struct PropertyRangeResult {
+    std::string name;
+    std::string property;
+    coefficientType coeffType;
+    double value;
+};
+
 class DatabaseManager {
 public:
-    DatabaseManager(const std::string& dbPath);
+    // readOnly 为 true 时以 SQLITE_OPEN_READONLY 打开, 文件不存在时抛出而不是创建空库
+    DatabaseManager(const std::string& dbPath, bool readOnly = false);
     ~DatabaseManager();
 
     void createTables();
     void insertMaterial(const Material& material);
+    // 在一个事务内批量插入, 单个材料失败只回滚该材料; 返回成功写入的数量.
+    // replaceExisting 为 true 时已存在的材料改为 updateMaterial (增量导入)
+    size_t insertMaterials(const std::vector<Material>& materials, bool replaceExisting = false);
     Material getMaterialByName(const std::string& name);
+    bool materialExists(const std::string& name);
+    // 只查询中文名, 不解码物性 JSON; 未找到时返回空
+    std::optional<std::string> getChineseName(const std::string& name);
+    // 读取全部 (名称, 中文名), 用于预加载字典
+    std::vector<std::pair<std::string, std::string>> getChineseNames();
+    // 全部材料名, 按名称排序
+    std::vector<std::string> getMaterialNames();
+    // 按名称更新中文名, 状态和物性, 并重建该材料的物性范围索引; 失败时回滚该材料的全部修改
     void updateMaterial(const Material& material);
+    // 删除材料及其物性范围索引; 失败时两者都不修改
     void deleteMaterial(const std::string& name);
+    // 按名称/中文名/化学式前缀检索, 不足 limit 条时用 trigram 子串匹配补充
+    std::vector<MaterialSearchResult> searchMaterials(const std::string& query, int limit = 20);
+    // 通过 property_rtree 索引筛选候选系数, 再在查询温度下精确求值.
+    // 索引中光滑函数的取值界来自采样 (见 summarizePropertyRange), 是近似的: 真实值只在采样点之间
+    // 越过查询边界的系数会被粗筛漏掉, 结果可能不完整
+    std::vector<PropertyRangeResult> findMaterialsByProperty(const PropertyRangeQuery& query);
+    void rebuildPropertyIndex();
+    // SQLite 页缓存大小 (KiB), 对应 PRAGMA cache_size = -kib
+    void setCacheSize(int kib);
+    // 用 SQLite 在线备份接口把整个数据库复制到 path (覆盖), 得到一致的快照
+    void backupTo(const std::string& path);
+    // 在线翻译单条文本; 未配置百度翻译凭据或翻译失败时返回空
     static std::string TranslateText(const std::string &text);
 
 private:
     sqlite3* db;
     
     void executeSQL(const std::string& sql);
-    static int callback(void *contents, size_t size, size_t nmemb, std::string *s);
-
-
-
-    static std::string md5(const std::string &text);
-
+    void createSearchIndex();
+    void createPropertyIndex();
+    void indexMaterialProperties(const Material& material);
+    void removeMaterialProperties(const std::string& name);
+    sqlite3_int64 propertyNameId(const std::string& property, bool create);
+    void querySearchIndex(const char *sql, const std::string &match, int limit,
+                          std::vector<MaterialSearchResult> &results);
 };
 
 } // namespace CFD_MaterialDB
\ No newline at end of file
@@ -1,14 +1,122 @@
 #include "database_manager.h"
 #include "material.h"
+#include "property_evaluator.h"
+#include "translation_service.h"
+#include "metrics.h"
+#include "trace.h"
 #include <iostream>
 #include <nlohmann/json.hpp>
+#include <unordered_set>
+#include <cctype>
+#include <cmath>
 
 using namespace CFD_MaterialDB;
 
-DatabaseManager::DatabaseManager(const std::string &dbPath) {
-    if (sqlite3_open(dbPath.c_str(), &db) != SQLITE_OK) {
-        throw std::runtime_error("无法打开数据库: " + std::string(sqlite3_errmsg(db)));
+namespace {
+
+// 与 unicode61 分词器保持一致: ASCII 字母数字和所有非 ASCII 字节(中文)属于词, 其余为分隔符
+std::vector<std::string> splitSearchTokens(const std::string &query) {
+    std::vector<std::string> tokens;
+    std::string current;
+    for (unsigned char c: query) {
+        if (std::isalnum(c) || c >= 0x80) {
+            current.push_back(static_cast<char>(c));
+        } else if (!current.empty()) {
+            tokens.push_back(current);
+            current.clear();
+        }
+    }
+    if (!current.empty()) {
+        tokens.push_back(current);
+    }
+    return tokens;
+}
+
+std::string quoteFtsString(const std::string &text) {
+    std::string quoted = "\"";
+    for (char c: text) {
+        if (c == '"') {
+            quoted.push_back('"');
+        }
+        quoted.push_back(c);
+    }
+    quoted.push_back('"');
+    return quoted;
+}
+
+size_t utf8Length(const std::string &text) {
+    size_t count = 0;
+    for (unsigned char c: text) {
+        if ((c & 0xC0) != 0x80) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// 公共操作按 op 标签计数和计时
+struct OperationMetrics {
+    Counter &calls;
+    Histogram &seconds;
+};
+
+OperationMetrics operationMetrics(const std::string &op) {
+    auto &registry = MetricsRegistry::global();
+    return {registry.counter("material_db_database_operations_total", "DatabaseManager 公共操作调用次数",
+                             {{"op", op}}),
+            registry.histogram("material_db_database_operation_seconds", "DatabaseManager 公共操作耗时 (秒)",
+                               {{"op", op}})};
+}
+
+Counter &statementCounter() {
+    static Counter &counter = MetricsRegistry::global().counter(
+            "material_db_sqlite_statements_total", "SQLite 执行的语句数 (含触发器内的语句)");
+    return counter;
+}
+
+// SQLITE_TRACE_STMT 在每条语句开始执行时回调
+int countStatement(unsigned, void *, void *, void *) {
+    statementCounter().add();
+    return 0;
+}
+
+// 操作结束时记录耗时, 并把本连接自上次记录以来的页缓存命中/未命中数累加到计数器
+class OperationTimer {
+public:
+    OperationTimer(sqlite3 *db, const OperationMetrics &metrics) : db_(db), timer_(metrics.seconds) {
+        metrics.calls.add();
+    }
+
+    ~OperationTimer() {
+        static Counter &hits = MetricsRegistry::global().counter(
+                "material_db_sqlite_cache_hits_total", "SQLite 页缓存命中数");
+        static Counter &misses = MetricsRegistry::global().counter(
+                "material_db_sqlite_cache_misses_total", "SQLite 页缓存未命中数");
+        int current = 0;
+        int highwater = 0;
+        if (sqlite3_db_status(db_, SQLITE_DBSTATUS_CACHE_HIT, &current, &highwater, 1) == SQLITE_OK) {
+            hits.add(static_cast<uint64_t>(current));
+        }
+        if (sqlite3_db_status(db_, SQLITE_DBSTATUS_CACHE_MISS, &current, &highwater, 1) == SQLITE_OK) {
+            misses.add(static_cast<uint64_t>(current));
+        }
     }
+
+private:
+    sqlite3 *db_;
+    ScopedTimer timer_;
+};
+
+} // namespace
+
+DatabaseManager::DatabaseManager(const std::string &dbPath, bool readOnly) {
+    int flags = readOnly ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+    if (sqlite3_open_v2(dbPath.c_str(), &db, flags, nullptr) != SQLITE_OK) {
+        std::string error = db ? sqlite3_errmsg(db) : "out of memory";
+        sqlite3_close(db);
+        throw std::runtime_error("无法打开数据库: " + error);
+    }
+    sqlite3_trace_v2(db, SQLITE_TRACE_STMT, countStatement, nullptr);
 }
 
 DatabaseManager::~DatabaseManager() {
@@ -17,6 +125,8 @@ DatabaseManager::~DatabaseManager() {
 
 void DatabaseManager::createTables()
 {
+    static const OperationMetrics metrics = operationMetrics("create_tables");
+    OperationTimer timer(db, metrics);
     // 检查表是否存在
     const char *checkTableSql = "SELECT name FROM sqlite_master WHERE type='table' AND name='materials';";
     // 创建表SQL
@@ -39,14 +149,62 @@ void DatabaseManager::createTables()
 
         // 验证表结构
         executeSQL(checkSchemaSql);
+
+        createSearchIndex();
+        createPropertyIndex();
     } catch (const std::exception &e) {
         throw std::runtime_error("初始化数据库表失败: " + std::string(e.what()));
     }
 }
 
+// materials_fts 用于逐键前缀检索, materials_trigram 用于子串/模糊匹配; 两者均由触发器与 materials 表同步.
+// 使用 rowid 而不是 id, 因为 materialsDict.db 的 materials 表没有 id 列.
+void DatabaseManager::createSearchIndex() {
+    const char *createSearchSql =
+            "CREATE VIRTUAL TABLE IF NOT EXISTS materials_fts USING fts5("
+            "name, chinese_name, chemical_formula, tokenize='unicode61', prefix='1 2 3');"
+            "CREATE VIRTUAL TABLE IF NOT EXISTS materials_trigram USING fts5("
+            "name, chinese_name, chemical_formula, tokenize='trigram');"
+            "CREATE TRIGGER IF NOT EXISTS materials_search_ai AFTER INSERT ON materials BEGIN "
+            "INSERT INTO materials_fts(rowid, name, chinese_name, chemical_formula) "
+            "VALUES (new.rowid, new.name, new.chinese_name, json_extract(new.properties, '$.chemical_formula'));"
+            "INSERT INTO materials_trigram(rowid, name, chinese_name, chemical_formula) "
+            "VALUES (new.rowid, new.name, new.chinese_name, json_extract(new.properties, '$.chemical_formula'));"
+            "END;"
+            "CREATE TRIGGER IF NOT EXISTS materials_search_ad AFTER DELETE ON materials BEGIN "
+            "DELETE FROM materials_fts WHERE rowid = old.rowid;"
+            "DELETE FROM materials_trigram WHERE rowid = old.rowid;"
+            "END;"
+            "CREATE TRIGGER IF NOT EXISTS materials_search_au AFTER UPDATE ON materials BEGIN "
+            "DELETE FROM materials_fts WHERE rowid = old.rowid;"
+            "DELETE FROM materials_trigram WHERE rowid = old.rowid;"
+            "INSERT INTO materials_fts(rowid, name, chinese_name, chemical_formula) "
+            "VALUES (new.rowid, new.name, new.chinese_name, json_extract(new.properties, '$.chemical_formula'));"
+            "INSERT INTO materials_trigram(rowid, name, chinese_name, chemical_formula) "
+            "VALUES (new.rowid, new.name, new.chinese_name, json_extract(new.properties, '$.chemical_formula'));"
+            "END;";
+
+    // 为建索引之前已存在的行补建索引
+    const char *backfillSql =
+            "INSERT INTO materials_fts(rowid, name, chinese_name, chemical_formula) "
+            "SELECT rowid, name, chinese_name, json_extract(properties, '$.chemical_formula') FROM materials "
+            "WHERE rowid NOT IN (SELECT rowid FROM materials_fts);"
+            "INSERT INTO materials_trigram(rowid, name, chinese_name, chemical_formula) "
+            "SELECT rowid, name, chinese_name, json_extract(properties, '$.chemical_formula') FROM materials "
+            "WHERE rowid NOT IN (SELECT rowid FROM materials_trigram);";
+
+    executeSQL(createSearchSql);
+    executeSQL(backfillSql);
+}
+
 void DatabaseManager::insertMaterial(const Material &material) {
+    static const OperationMetrics metrics = operationMetrics("insert");
+    OperationTimer timer(db, metrics);
+    TraceSpan span("insertMaterial", "database", material.name);
     sqlite3_stmt *stmt;
     const char *sql = "INSERT INTO materials (name, chinese_name, type, properties) VALUES (?, ?, ?, ?);";
+    // 材料行和物性范围索引在同一个保存点内写入
+    executeSQL("SAVEPOINT insert_material;");
     try {
         if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
             throw std::runtime_error("SQL preparation failed : " + std::string(sqlite3_errmsg(db)));
@@ -61,12 +219,45 @@ void DatabaseManager::insertMaterial(const Material &material) {
             sqlite3_finalize(stmt);
             throw std::runtime_error("Material inserted failed: " + std::string(sqlite3_errmsg(db)));
         }
+        sqlite3_finalize(stmt);
+
+        indexMaterialProperties(material);
     }
     catch (const std::exception &e) {
+        executeSQL("ROLLBACK TO insert_material; RELEASE insert_material;");
         throw std::runtime_error("Material inserted failed : " + std::string(e.what()));
     }
 
-    sqlite3_finalize(stmt);
+    executeSQL("RELEASE insert_material;");
+}
+
+size_t DatabaseManager::insertMaterials(const std::vector<Material> &materials, bool replaceExisting) {
+    static const OperationMetrics metrics = operationMetrics("insert_batch");
+    OperationTimer timer(db, metrics);
+    TraceSpan span("insertMaterials", "database", [&] { return std::to_string(materials.size()) + " materials"; });
+    size_t inserted = 0;
+    executeSQL("BEGIN;");
+    for (const auto &material: materials) {
+        try {
+            if (replaceExisting && materialExists(material.name)) {
+                updateMaterial(material);
+            } else {
+                insertMaterial(material);
+            }
+            ++inserted;
+        } catch (const std::exception &e) {
+            std::cerr << material.name << ": " << e.what() << std::endl;
+        }
+    }
+    try {
+        // 提交时落盘 (fsync), 单独记录
+        TraceSpan commitSpan("COMMIT", "database");
+        executeSQL("COMMIT;");
+    } catch (const std::exception &e) {
+        executeSQL("ROLLBACK;");
+        throw std::runtime_error("批量插入提交失败: " + std::string(e.what()));
+    }
+    return inserted;
 }
 
 void DatabaseManager::executeSQL(const std::string &sql) {
@@ -79,9 +270,12 @@ void DatabaseManager::executeSQL(const std::string &sql) {
 }
 
 Material DatabaseManager::getMaterialByName(const std::string &name) {
+    static const OperationMetrics metrics = operationMetrics("get");
+    OperationTimer timer(db, metrics);
     Material material;
     sqlite3_stmt *stmt;
-    const char *sql = "SELECT * FROM materials WHERE name = ?;";
+    // 按列名选取: materials.db 有 id 列, materialsDict.db 没有, SELECT * 的列序号在两者间不一致
+    const char *sql = "SELECT chinese_name, properties FROM materials WHERE name = ?;";
 
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
         throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
@@ -89,15 +283,15 @@ Material DatabaseManager::getMaterialByName(const std::string &name) {
     sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_TRANSIENT);
 
     if (sqlite3_step(stmt) == SQLITE_ROW) {
-        if (sqlite3_column_type(stmt, 3) == SQLITE_TEXT)
+        if (sqlite3_column_type(stmt, 1) == SQLITE_TEXT)
         {
-            std::string value = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3));
+            std::string value = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
             material = nlohmann::json::parse(value);
-            material.chinese_name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+            material.chinese_name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+            compileUserDefinedProperties(material);
         }
     } else {
-        sqlite3_finalize(stmt);
-        std::cout << "Material not found with name : " << name << std::endl;
+        std::cerr << "Material not found with name : " << name << std::endl;
         material.name = name;
         material.chinese_name = name; // 默认使用英文名作为中文名
     }
@@ -105,159 +299,517 @@ Material DatabaseManager::getMaterialByName(const std::string &name) {
     return material;
 }
 
-void DatabaseManager::updateMaterial(const Material &material) {
+std::optional<std::string> DatabaseManager::getChineseName(const std::string &name) {
+    static const OperationMetrics metrics = operationMetrics("get_chinese_name");
+    OperationTimer timer(db, metrics);
+    sqlite3_stmt *stmt;
+    const char *sql = "SELECT chinese_name FROM materials WHERE name = ?;";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
+    }
+    sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_TRANSIENT);
+    std::optional<std::string> chineseName;
+    if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) == SQLITE_TEXT) {
+        chineseName = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+    return chineseName;
+}
+
+std::vector<std::pair<std::string, std::string>> DatabaseManager::getChineseNames() {
+    static const OperationMetrics metrics = operationMetrics("get_chinese_names");
+    OperationTimer timer(db, metrics);
     sqlite3_stmt *stmt;
-    const char *sql = "UPDATE materials SET type = ?, properties = ? WHERE name = ?;";
+    const char *sql = "SELECT name, chinese_name FROM materials WHERE chinese_name IS NOT NULL;";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
+    }
+    std::vector<std::pair<std::string, std::string>> names;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        names.emplace_back(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)),
+                           reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1)));
+    }
+    sqlite3_finalize(stmt);
+    return names;
+}
 
+std::vector<std::string> DatabaseManager::getMaterialNames() {
+    sqlite3_stmt *stmt;
+    const char *sql = "SELECT name FROM materials ORDER BY name;";
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
         throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
     }
+    std::vector<std::string> names;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        names.emplace_back(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)));
+    }
+    sqlite3_finalize(stmt);
+    return names;
+}
 
-    sqlite3_bind_int(stmt, 1, static_cast<int>(material.type.state));
-    std::string json = nlohmann::json(material).dump();
-    sqlite3_bind_text(stmt, 2, json.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, material.name.c_str(), -1, SQLITE_TRANSIENT);
+void DatabaseManager::updateMaterial(const Material &material) {
+    static const OperationMetrics metrics = operationMetrics("update");
+    OperationTimer timer(db, metrics);
+    TraceSpan span("updateMaterial", "database", material.name);
+    sqlite3_stmt *stmt;
+    const char *sql = "UPDATE materials SET chinese_name = ?, type = ?, properties = ? WHERE name = ?;";
+    // 与 insertMaterial 相同, 材料行和物性范围索引在同一个保存点内更新
+    executeSQL("SAVEPOINT update_material;");
+    try {
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
+        }
+
+        sqlite3_bind_text(stmt, 1, material.chinese_name.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int(stmt, 2, static_cast<int>(material.type.state));
+        std::string json = nlohmann::json(material).dump();
+        sqlite3_bind_text(stmt, 3, json.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 4, material.name.c_str(), -1, SQLITE_TRANSIENT);
+
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            sqlite3_finalize(stmt);
+            throw std::runtime_error("更新数据失败: " + std::string(sqlite3_errmsg(db)));
+        }
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
         sqlite3_finalize(stmt);
-        throw std::runtime_error("更新数据失败: " + std::string(sqlite3_errmsg(db)));
+
+        removeMaterialProperties(material.name);
+        indexMaterialProperties(material);
+    }
+    catch (...) {
+        executeSQL("ROLLBACK TO update_material; RELEASE update_material;");
+        throw;
     }
 
+    executeSQL("RELEASE update_material;");
+}
+
+bool DatabaseManager::materialExists(const std::string &name) {
+    sqlite3_stmt *stmt;
+    const char *sql = "SELECT 1 FROM materials WHERE name = ?;";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
+    }
+    sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_TRANSIENT);
+    bool exists = sqlite3_step(stmt) == SQLITE_ROW;
     sqlite3_finalize(stmt);
+    return exists;
 }
 
 void DatabaseManager::deleteMaterial(const std::string &name) {
+    static const OperationMetrics metrics = operationMetrics("delete");
+    OperationTimer timer(db, metrics);
     sqlite3_stmt *stmt;
     const char *sql = "DELETE FROM materials WHERE name = ?;";
+    // 材料行和物性范围索引在同一个保存点内删除, 避免留下孤立的范围行
+    executeSQL("SAVEPOINT delete_material;");
+    try {
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
+        }
+
+        sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_TRANSIENT);
+
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            sqlite3_finalize(stmt);
+            throw std::runtime_error("删除数据失败: " + std::string(sqlite3_errmsg(db)));
+        }
+
+        sqlite3_finalize(stmt);
+
+        removeMaterialProperties(name);
+    }
+    catch (...) {
+        executeSQL("ROLLBACK TO delete_material; RELEASE delete_material;");
+        throw;
+    }
+
+    executeSQL("RELEASE delete_material;");
+}
+
+std::vector<MaterialSearchResult> DatabaseManager::searchMaterials(const std::string &query, int limit) {
+    static const OperationMetrics metrics = operationMetrics("search");
+    OperationTimer timer(db, metrics);
+    std::vector<MaterialSearchResult> results;
+    if (limit <= 0) {
+        return results;
+    }
+
+    // 每个词按前缀匹配, 词之间为 AND; 名称权重最高, 其次中文名, 最后化学式
+    const char *prefixSql =
+            "SELECT name, chinese_name, chemical_formula, bm25(materials_fts, 10.0, 5.0, 1.0) AS score "
+            "FROM materials_fts WHERE materials_fts MATCH ? ORDER BY score, length(name) LIMIT ?;";
+    std::vector<std::string> tokens = splitSearchTokens(query);
+    if (!tokens.empty()) {
+        std::string match;
+        for (const auto &token: tokens) {
+            if (!match.empty()) {
+                match += " ";
+            }
+            match += quoteFtsString(token) + "*";
+        }
+        querySearchIndex(prefixSql, match, limit, results);
+    }
+
+    // trigram 分词器要求至少三个字符
+    const char *trigramSql =
+            "SELECT name, chinese_name, chemical_formula, bm25(materials_trigram, 10.0, 5.0, 1.0) AS score "
+            "FROM materials_trigram WHERE materials_trigram MATCH ? ORDER BY score, length(name) LIMIT ?;";
+    if (static_cast<int>(results.size()) < limit && utf8Length(query) >= 3) {
+        querySearchIndex(trigramSql, quoteFtsString(query), limit, results);
+    }
+    return results;
+}
 
+void DatabaseManager::querySearchIndex(const char *sql, const std::string &match, int limit,
+                                       std::vector<MaterialSearchResult> &results) {
+    sqlite3_stmt *stmt;
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
         throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
     }
+    sqlite3_bind_text(stmt, 1, match.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, limit);
 
-    sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_TRANSIENT);
+    std::unordered_set<std::string> seen;
+    for (const auto &result: results) {
+        seen.insert(result.name);
+    }
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
+    int rc = SQLITE_DONE;
+    while (static_cast<int>(results.size()) < limit && (rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        MaterialSearchResult result;
+        result.name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+        if (!seen.insert(result.name).second) {
+            continue;
+        }
+        if (sqlite3_column_type(stmt, 1) == SQLITE_TEXT) {
+            result.chinese_name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+        }
+        if (sqlite3_column_type(stmt, 2) == SQLITE_TEXT) {
+            result.chemical_formula = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2));
+        }
+        result.rank = sqlite3_column_double(stmt, 3);
+        results.push_back(result);
+    }
+    if (static_cast<int>(results.size()) < limit && rc != SQLITE_DONE) {
         sqlite3_finalize(stmt);
-        throw std::runtime_error("删除数据失败: " + std::string(sqlite3_errmsg(db)));
+        throw std::runtime_error("检索失败: " + std::string(sqlite3_errmsg(db)));
     }
+    sqlite3_finalize(stmt);
+}
 
+// property_ranges 每行对应一个物性系数 (保存系数 JSON 用于精确求值),
+// property_rtree 每行对应该系数的一段温度区间, 三个维度为 (物性编号, 温度, 物性值).
+// rtree 行号 = property_ranges.id * kMaxRangeTiles + 段号.
+void DatabaseManager::createPropertyIndex() {
+    const char *createIndexSql =
+            "CREATE TABLE IF NOT EXISTS property_names ("
+            "id INTEGER PRIMARY KEY,"
+            "name TEXT UNIQUE NOT NULL);"
+            "CREATE TABLE IF NOT EXISTS property_ranges ("
+            "id INTEGER PRIMARY KEY,"
+            "material TEXT NOT NULL,"
+            "property_id INTEGER NOT NULL,"
+            "coeff_index INTEGER NOT NULL,"
+            "coeff_type INTEGER NOT NULL,"
+            "tile_count INTEGER NOT NULL,"
+            "coefficient TEXT NOT NULL);"
+            "CREATE INDEX IF NOT EXISTS property_ranges_material ON property_ranges(material);"
+            "CREATE VIRTUAL TABLE IF NOT EXISTS property_rtree USING rtree("
+            "id, p_min, p_max, t_min, t_max, v_min, v_max);";
+    executeSQL(createIndexSql);
+
+    // 旧数据库第一次打开时补建索引
+    sqlite3_stmt *stmt;
+    const char *countSql = "SELECT (SELECT count(*) FROM property_ranges), (SELECT count(*) FROM materials);";
+    if (sqlite3_prepare_v2(db, countSql, -1, &stmt, nullptr) != SQLITE_OK) {
+        throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
+    }
+    bool needsRebuild = sqlite3_step(stmt) == SQLITE_ROW
+                        && sqlite3_column_int64(stmt, 0) == 0 && sqlite3_column_int64(stmt, 1) > 0;
     sqlite3_finalize(stmt);
+    if (needsRebuild) {
+        rebuildPropertyIndex();
+    }
 }
 
-int DatabaseManager::callback(void *contents, size_t size, size_t nmemb, std::string *s) {
-    size_t newLength = size * nmemb;
-    s->append((char *) contents, newLength);
-    return newLength;
+void DatabaseManager::rebuildPropertyIndex() {
+    static const OperationMetrics metrics = operationMetrics("rebuild_property_index");
+    OperationTimer timer(db, metrics);
+    executeSQL("SAVEPOINT rebuild_property_index;");
+    try {
+        executeSQL("DELETE FROM property_rtree; DELETE FROM property_ranges;");
+
+        sqlite3_stmt *stmt;
+        const char *sql = "SELECT name, properties FROM materials;";
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
+        }
+        std::vector<Material> materials;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            if (sqlite3_column_type(stmt, 1) != SQLITE_TEXT) {
+                continue;
+            }
+            try {
+                Material material = nlohmann::json::parse(
+                        reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1)));
+                material.name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+                compileUserDefinedProperties(material);
+                materials.push_back(std::move(material));
+            } catch (const std::exception &e) {
+                std::cerr << "跳过无法解析的材料: " << sqlite3_column_text(stmt, 0) << " (" << e.what() << ")"
+                          << std::endl;
+            }
+        }
+        sqlite3_finalize(stmt);
+
+        for (const auto &material: materials) {
+            indexMaterialProperties(material);
+        }
+    } catch (const std::exception &e) {
+        executeSQL("ROLLBACK TO rebuild_property_index; RELEASE rebuild_property_index;");
+        throw std::runtime_error("重建物性索引失败: " + std::string(e.what()));
+    }
+    executeSQL("RELEASE rebuild_property_index;");
 }
 
-std::string DatabaseManager::TranslateText(const std::string &text) {
-    CURL *curl = curl_easy_init();
-    std::string result;
-    std::string BAIDU_APPID = "20250422002339827";
-    std::string BAIDU_KEY = "2hEn69vKVRn_L9bhH2jw";
-    std::string TRANSLATE_URL = "https://fanyi-api.baidu.com/api/trans/vip/translate";
-
-    if (!curl) {
-        throw std::runtime_error("CURL failed");
-    }
-
-#if(0)
-    // 初始化随机数种子
-    srand(static_cast<unsigned int>(time(nullptr)));
-    
-    // 生成随机盐和签名
-    std::string salt = std::to_string(rand());
-    std::string sign = BAIDU_APPID + text + salt + BAIDU_KEY;
-    std::string sign_md5 = md5(sign);
-
-    // 构造POST参数
-    std::string postFields = "q=" + std::string(curl_easy_escape(curl, text.c_str(), text.length())) +
-                             "&from=en&to=zh&appid=" + BAIDU_APPID +
-                             "&salt=" + salt + "&sign=" + sign_md5;
-
-    // 设置CURL选项
-    curl_easy_setopt(curl, CURLOPT_URL, TRANSLATE_URL.c_str());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postFields.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &result);
-    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L); // 禁用SSL验证
-    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-    CURLcode res = curl_easy_perform(curl);
-
-#endif
-#if(1)
-    {
-        CURLcode res;
-        char myurl[1000] = "http://api.fanyi.baidu.com/api/trans/vip/translate?";
-        char *appid = "20250422002339827";    //replace myAppid with your own appid
-        char *q = const_cast<char *>(text.c_str());          //replace apple with your own text to be translate, ensure that the input text is encoded with UTF-8!
-        char *from = "en";          //replace en with your own language type of input text
-        char *to = "zh";            //replace zh with your own language type of output text
-        char salt[60];
-        int a = rand();
-        sprintf(salt, "%d", a);
-        char *secret_key = "2hEn69vKVRn_L9bhH2jw";   //replace mySecretKey with your own mySecretKey
-        char sign[120] = "";
-        strcat(sign, appid);
-        strcat(sign, q);
-        strcat(sign, salt);
-        strcat(sign, secret_key);
-        printf("%s\n", sign);
-        unsigned char md[16];
-        int i;
-        char tmp[3] = {'\0'}, buf[33] = {'\0'};
-        MD5((unsigned char *) sign, strlen(reinterpret_cast<const char *>((unsigned char *) sign)), md);
-        for (i = 0; i < 16; i++) {
-            sprintf(tmp, "%2.2x", md[i]);
-            strcat(buf, tmp);
+sqlite3_int64 DatabaseManager::propertyNameId(const std::string &property, bool create) {
+    sqlite3_stmt *stmt;
+    if (create) {
+        const char *insertSql = "INSERT OR IGNORE INTO property_names (name) VALUES (?);";
+        if (sqlite3_prepare_v2(db, insertSql, -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
         }
-        printf("%s\n", buf);
-        strcat(myurl, "appid=");
-        strcat(myurl, appid);
-        strcat(myurl, "&q=");
-        strcat(myurl, q);
-        strcat(myurl, "&from=");
-        strcat(myurl, from);
-        strcat(myurl, "&to=");
-        strcat(myurl, to);
-        strcat(myurl, "&salt=");
-        strcat(myurl, salt);
-        strcat(myurl, "&sign=");
-        strcat(myurl, buf);
-        printf("%s\n", myurl);
-        curl_easy_setopt(curl, CURLOPT_URL, myurl);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, callback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &result);
-        res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            curl_easy_cleanup(curl);
-            //throw std::runtime_error("Translation request failed: " + std::string(curl_easy_strerror(res)));
+        sqlite3_bind_text(stmt, 1, property.c_str(), -1, SQLITE_TRANSIENT);
+        int rc = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE) {
+            throw std::runtime_error("插入物性名称失败: " + std::string(sqlite3_errmsg(db)));
         }
+    }
+
+    const char *selectSql = "SELECT id FROM property_names WHERE name = ?;";
+    if (sqlite3_prepare_v2(db, selectSql, -1, &stmt, nullptr) != SQLITE_OK) {
+        throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
+    }
+    sqlite3_bind_text(stmt, 1, property.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_int64 id = -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        id = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return id;
+}
 
-        curl_easy_cleanup(curl);
+void DatabaseManager::indexMaterialProperties(const Material &material) {
+    sqlite3_stmt *rangeStmt;
+    sqlite3_stmt *tileStmt;
+    const char *rangeSql = "INSERT INTO property_ranges (material, property_id, coeff_index, coeff_type, tile_count, "
+                           "coefficient) VALUES (?, ?, ?, ?, ?, ?);";
+    const char *tileSql = "INSERT INTO property_rtree (id, p_min, p_max, t_min, t_max, v_min, v_max) "
+                          "VALUES (?, ?, ?, ?, ?, ?, ?);";
+    if (sqlite3_prepare_v2(db, rangeSql, -1, &rangeStmt, nullptr) != SQLITE_OK) {
+        throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
+    }
+    if (sqlite3_prepare_v2(db, tileSql, -1, &tileStmt, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(rangeStmt);
+        throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
     }
-#endif
-    // 解析JSON结果
+
     try {
-        auto json = nlohmann::json::parse(result);
-        if (json.contains("trans_result")) {
-            result = json["trans_result"][0]["dst"];
+        for (const auto &entry: material.properties) {
+            sqlite3_int64 propertyId = -1;
+            for (size_t index = 0; index < entry.second.size(); ++index) {
+                const MaterialProperty &prop = entry.second[index];
+                std::vector<PropertyRangeTile> tiles = summarizePropertyRange(prop);
+                if (tiles.empty()) {
+                    continue;
+                }
+                if (propertyId < 0) {
+                    propertyId = propertyNameId(entry.first, true);
+                }
+
+                std::string json = nlohmann::json(prop).dump();
+                sqlite3_reset(rangeStmt);
+                sqlite3_bind_text(rangeStmt, 1, material.name.c_str(), -1, SQLITE_TRANSIENT);
+                sqlite3_bind_int64(rangeStmt, 2, propertyId);
+                sqlite3_bind_int(rangeStmt, 3, static_cast<int>(index));
+                sqlite3_bind_int(rangeStmt, 4, static_cast<int>(prop.coeffType));
+                sqlite3_bind_int(rangeStmt, 5, static_cast<int>(tiles.size()));
+                sqlite3_bind_text(rangeStmt, 6, json.c_str(), -1, SQLITE_TRANSIENT);
+                if (sqlite3_step(rangeStmt) != SQLITE_DONE) {
+                    throw std::runtime_error(sqlite3_errmsg(db));
+                }
+                sqlite3_int64 rangeId = sqlite3_last_insert_rowid(db);
+
+                for (size_t t = 0; t < tiles.size(); ++t) {
+                    const auto &tile = tiles[t];
+                    sqlite3_reset(tileStmt);
+                    sqlite3_bind_int64(tileStmt, 1, rangeId * kMaxRangeTiles + static_cast<sqlite3_int64>(t));
+                    sqlite3_bind_double(tileStmt, 2, static_cast<double>(propertyId));
+                    sqlite3_bind_double(tileStmt, 3, static_cast<double>(propertyId));
+                    sqlite3_bind_double(tileStmt, 4, tile.t_min);
+                    sqlite3_bind_double(tileStmt, 5, tile.t_max);
+                    sqlite3_bind_double(tileStmt, 6, tile.v_min);
+                    sqlite3_bind_double(tileStmt, 7, tile.v_max);
+                    if (sqlite3_step(tileStmt) != SQLITE_DONE) {
+                        throw std::runtime_error(sqlite3_errmsg(db));
+                    }
+                }
+            }
         }
+    } catch (const std::exception &e) {
+        sqlite3_finalize(rangeStmt);
+        sqlite3_finalize(tileStmt);
+        throw std::runtime_error("写入物性范围索引失败: " + std::string(e.what()));
     }
-    catch (const std::exception &e) {
-        std::cout << "Translation failed: " << e.what() << "\n";
+    sqlite3_finalize(rangeStmt);
+    sqlite3_finalize(tileStmt);
+}
+
+void DatabaseManager::removeMaterialProperties(const std::string &name) {
+    sqlite3_stmt *stmt;
+    const char *selectSql = "SELECT id, tile_count FROM property_ranges WHERE material = ?;";
+    if (sqlite3_prepare_v2(db, selectSql, -1, &stmt, nullptr) != SQLITE_OK) {
+        throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
+    }
+    sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_TRANSIENT);
+    std::vector<std::pair<sqlite3_int64, int>> ranges;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        ranges.emplace_back(sqlite3_column_int64(stmt, 0), sqlite3_column_int(stmt, 1));
+    }
+    sqlite3_finalize(stmt);
+
+    const char *deleteTileSql = "DELETE FROM property_rtree WHERE id = ?;";
+    if (sqlite3_prepare_v2(db, deleteTileSql, -1, &stmt, nullptr) != SQLITE_OK) {
+        throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
+    }
+    for (const auto &range: ranges) {
+        for (int t = 0; t < range.second; ++t) {
+            sqlite3_reset(stmt);
+            sqlite3_bind_int64(stmt, 1, range.first * kMaxRangeTiles + t);
+            sqlite3_step(stmt);
+        }
+    }
+    sqlite3_finalize(stmt);
+
+    const char *deleteRangeSql = "DELETE FROM property_ranges WHERE material = ?;";
+    if (sqlite3_prepare_v2(db, deleteRangeSql, -1, &stmt, nullptr) != SQLITE_OK) {
+        throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
+    }
+    sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        sqlite3_finalize(stmt);
+        throw std::runtime_error("删除物性范围索引失败: " + std::string(sqlite3_errmsg(db)));
     }
-    return result;
+    sqlite3_finalize(stmt);
 }
 
-std::string DatabaseManager::md5(const std::string &text) {
-    uint8_t digest[MD5_DIGEST_LENGTH];
-    MD5((const uint8_t *) text.c_str(), text.size(), digest);
+std::vector<PropertyRangeResult> DatabaseManager::findMaterialsByProperty(const PropertyRangeQuery &query) {
+    static const OperationMetrics metrics = operationMetrics("find_by_property");
+    OperationTimer timer(db, metrics);
+    std::vector<PropertyRangeResult> results;
+    sqlite3_int64 propertyId = propertyNameId(query.property, false);
+    if (propertyId < 0 || query.limit <= 0) {
+        return results;
+    }
 
-    std::ostringstream oss;
-    for (int i = 0; i < MD5_DIGEST_LENGTH; ++i)
-        oss << std::hex << std::setw(2) << std::setfill('0') << (int) digest[i];
-    return oss.str();
+    // rtree 只做粗筛, 候选系数按材料名和系数顺序返回
+    std::string sql =
+            "SELECT material, coeff_type, coefficient FROM property_ranges WHERE id IN ("
+            "SELECT id / " + std::to_string(kMaxRangeTiles) + " FROM property_rtree "
+            "WHERE p_min <= ?1 AND p_max >= ?1 AND t_min <= ?2 AND t_max >= ?3 AND v_min <= ?5 AND v_max >= ?4) "
+            "ORDER BY material, coeff_index;";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
+    }
+    double tLow = query.temperature ? *query.temperature : std::numeric_limits<double>::infinity();
+    double tHigh = query.temperature ? *query.temperature : -std::numeric_limits<double>::infinity();
+    sqlite3_bind_double(stmt, 1, static_cast<double>(propertyId));
+    sqlite3_bind_double(stmt, 2, tLow);
+    sqlite3_bind_double(stmt, 3, tHigh);
+    sqlite3_bind_double(stmt, 4, query.min_value);
+    sqlite3_bind_double(stmt, 5, query.max_value);
+
+    std::string lastMatched;
+    while (static_cast<int>(results.size()) < query.limit && sqlite3_step(stmt) == SQLITE_ROW) {
+        std::string name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+        if (name == lastMatched) {
+            continue;
+        }
+        auto type = static_cast<coefficientType>(sqlite3_column_int(stmt, 1));
+        double value = std::numeric_limits<double>::quiet_NaN();
+        if (query.temperature || type == CONSTCOEFF) {
+            MaterialProperty prop = nlohmann::json::parse(
+                    reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2)));
+            value = evaluateProperty(prop, query.temperature.value_or(kDefaultMinTemperature));
+            if (!(value >= query.min_value && value <= query.max_value)) {
+                continue;
+            }
+        }
+        results.push_back({name, query.property, type, value});
+        lastMatched = name;
+    }
+    sqlite3_finalize(stmt);
+    return results;
 }
 
+void DatabaseManager::setCacheSize(int kib) {
+    executeSQL("PRAGMA cache_size = -" + std::to_string(kib) + ";");
+}
+
+void DatabaseManager::backupTo(const std::string &path) {
+    static const OperationMetrics metrics = operationMetrics("backup");
+    OperationTimer timer(db, metrics);
+    sqlite3 *target;
+    if (sqlite3_open(path.c_str(), &target) != SQLITE_OK) {
+        std::string error = sqlite3_errmsg(target);
+        sqlite3_close(target);
+        throw std::runtime_error("无法打开快照文件: " + error);
+    }
+    sqlite3_backup *backup = sqlite3_backup_init(target, "main", db, "main");
+    if (backup == nullptr) {
+        std::string error = sqlite3_errmsg(target);
+        sqlite3_close(target);
+        throw std::runtime_error("创建快照失败: " + error);
+    }
+    // 一次复制全部页
+    sqlite3_backup_step(backup, -1);
+    int result = sqlite3_backup_finish(backup);
+    std::string error = sqlite3_errmsg(target);
+    sqlite3_close(target);
+    if (result != SQLITE_OK) {
+        throw std::runtime_error("创建快照失败: " + error);
+    }
+}
 
+std::string DatabaseManager::TranslateText(const std::string &text) {
+    // 进程内共享一个翻译服务, 复用连接和持久缓存; 需要批量翻译时直接使用 TranslationService.
+    // 凭据来自环境变量 MATDB_BAIDU_APPID / MATDB_BAIDU_KEY, 未设置时不发送请求, 一律返回空
+    static const std::unique_ptr<TranslationService> service = [] {
+        BaiduCredentials credentials = BaiduCredentials::fromEnvironment();
+        if (!credentials.valid()) {
+            std::cerr << "警告: 未设置 MATDB_BAIDU_APPID / MATDB_BAIDU_KEY, 在线翻译已禁用" << std::endl;
+            return std::unique_ptr<TranslationService>();
+        }
+        return std::make_unique<TranslationService>(
+                std::make_unique<BaiduTranslateBackend>(credentials.appid, credentials.key));
+    }();
+    static Counter &requests = MetricsRegistry::global().counter(
+            "material_db_translate_requests_total", "TranslateText 调用次数");
+    static Counter &failures = MetricsRegistry::global().counter(
+            "material_db_translate_failures_total", "TranslateText 未取得译文的次数");
+    static Histogram &seconds = MetricsRegistry::global().histogram(
+            "material_db_translate_seconds", "TranslateText 耗时 (秒), 含缓存命中");
+    requests.add();
+    std::optional<std::string> translated;
+    if (service) {
+        ScopedTimer timer(seconds);
+        translated = service->translate(text);
+    }
+    if (!translated) {
+        failures.add();
+    }
+    return translated.value_or("");
+}
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "coefficient_laws.h"
+#include "property_evaluator.h"
+
+namespace CFD_MaterialDB {
+
+// 编译期嵌入的材料表. 构建时 material_db_embed 把 propdb.scm 生成为 embedded_propdb.h, 其中
+//   每个系数是一个 constexpr EmbeddedLaw 常量, 放在以材料名命名的命名空间中 (非字母数字的字符换成 _,
+//   同一物性的第 i 个系数 (i > 0) 加后缀 _i), 例如 embedded::air::viscosity_1 为 air 的 sutherland 粘度;
+//   kEmbeddedMaterialDatabase 为按名称排序的查找表.
+// 只需要标准材料库的求解器包含生成的头文件即可求值, 启动时不读文件, 不解析, 也不打开数据库.
+// 直接使用 EmbeddedLaw 常量时类型和段数都是编译期已知的, 编译器可以内联并展开求值.
+//
+// 每个系数的数据按类型以固定布局存放在一个 double 数组中, N 为多项式系数个数, 分段线性点数或分段数:
+//   CONSTCOEFF        {value}
+//   polynomialT       c0..c(N-1)
+//   piecewise-linear  N 个温度, N 个值, N - 1 个斜率
+//   piecewise-poly    N 个 kPiecewisePolyStride 系数块, N + 1 个边界
+//   NASA-9            N 个 kNasa9Stride 系数块, N + 1 个边界
+//   sutherland {C1, S}; power-law {B, n}; blottner {A, B, C}; compressible {p0, rho0, K0, n, maxRatio, minRatio}
+//   NONET             求值为 NaN; 原系数无效或类型不能嵌入 (user-defined) 时使用
+template<coefficientType Type>
+struct EmbeddedLayout;
+
+template<>
+struct EmbeddedLayout<NONET> {
+    static constexpr size_t size(size_t) { return 0; }
+
+    static constexpr CoefficientLaw<NONET>::Data view(const double *, size_t) { return {}; }
+};
+
+template<>
+struct EmbeddedLayout<CONSTCOEFF> {
+    static constexpr size_t size(size_t) { return 1; }
+
+    static constexpr double view(const double *data, size_t) { return data[0]; }
+};
+
+template<>
+struct EmbeddedLayout<polynomialT> {
+    static constexpr size_t size(size_t n) { return n; }
+
+    static constexpr PolynomialView view(const double *data, size_t n) { return {data, n}; }
+};
+
+template<>
+struct EmbeddedLayout<polynomialTPieceLinearT> {
+    static constexpr size_t size(size_t n) { return n == 0 ? 0 : 3 * n - 1; }
+
+    static constexpr PiecewiseLinearView view(const double *data, size_t n) {
+        return {data, data + n, data + 2 * n, n, nullptr, 0, 0.0};
+    }
+};
+
+template<>
+struct EmbeddedLayout<polynomialTPiecePolyT> {
+    static constexpr size_t size(size_t n) { return n * kPiecewisePolyStride + n + 1; }
+
+    static constexpr SegmentedView view(const double *data, size_t n) {
+        return {data + n * kPiecewisePolyStride, data, n};
+    }
+};
+
+template<>
+struct EmbeddedLayout<nasa9PiecePolyT> {
+    static constexpr size_t size(size_t n) { return n * kNasa9Stride + n + 1; }
+
+    static constexpr SegmentedView view(const double *data, size_t n) { return {data + n * kNasa9Stride, data, n}; }
+};
+
+template<>
+struct EmbeddedLayout<sutherlandT> {
+    static constexpr size_t size(size_t) { return 2; }
+
+    static constexpr sutherlandData view(const double *data, size_t) { return {data[0], data[1]}; }
+};
+
+template<>
+struct EmbeddedLayout<powerLawT> {
+    static constexpr size_t size(size_t) { return 2; }
+
+    static constexpr powerLawData view(const double *data, size_t) { return {data[0], data[1]}; }
+};
+
+template<>
+struct EmbeddedLayout<blottnerT> {
+    static constexpr size_t size(size_t) { return 3; }
+
+    static constexpr blottnerData view(const double *data, size_t) { return {data[0], data[1], data[2], true}; }
+};
+
+template<>
+struct EmbeddedLayout<compressibleT> {
+    static constexpr size_t size(size_t) { return 6; }
+
+    static constexpr compressibleLiquidData view(const double *data, size_t) {
+        return {data[0], data[1], data[2], data[3], data[4], data[5]};
+    }
+};
+
+// 类型与规模都在编译期确定的系数
+template<coefficientType Type, size_t N = 0>
+struct EmbeddedLaw {
+    static constexpr coefficientType type = Type;
+    static constexpr size_t count = N;
+
+    double data[std::max<size_t>(EmbeddedLayout<Type>::size(N), 1)];
+
+    constexpr typename CoefficientLaw<Type>::Data view() const { return EmbeddedLayout<Type>::view(data, N); }
+
+    constexpr double operator()(double T, double p = kReferencePressure) const {
+        return CoefficientLaw<Type>::value(view(), T, p);
+    }
+
+    constexpr Dual derivatives(double T, double p = kReferencePressure) const {
+        return CoefficientLaw<Type>::derivatives(view(), T, p);
+    }
+};
+
+// 查找表中的系数, 类型在运行时分派
+struct EmbeddedCoefficient {
+    coefficientType type;
+    uint32_t count;
+    const double *data;
+    std::string_view unit;
+};
+
+struct EmbeddedProperty {
+    std::string_view name;
+    uint32_t firstCoefficient;
+    uint32_t coefficientCount;
+};
+
+struct EmbeddedMaterial {
+    std::string_view name;
+    uint32_t firstProperty;
+    uint32_t propertyCount;
+};
+
+namespace embedded_detail {
+
+template<coefficientType Type>
+constexpr double value(const EmbeddedCoefficient &c, double T, double p) {
+    return CoefficientLaw<Type>::value(EmbeddedLayout<Type>::view(c.data, c.count), T, p);
+}
+
+template<coefficientType Type>
+constexpr Dual derivatives(const EmbeddedCoefficient &c, double T, double p) {
+    return CoefficientLaw<Type>::derivatives(EmbeddedLayout<Type>::view(c.data, c.count), T, p);
+}
+
+// 按名称二分查找, records 按 name 升序
+template<typename Record>
+constexpr const Record *findByName(const Record *records, size_t count, std::string_view name) {
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (records[middle].name < name) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < count && records[low].name == name ? &records[low] : nullptr;
+}
+
+} // namespace embedded_detail
+
+constexpr double evaluateEmbedded(const EmbeddedCoefficient &c, double T, double p = kReferencePressure) {
+    switch (c.type) {
+        case CONSTCOEFF:
+            return embedded_detail::value<CONSTCOEFF>(c, T, p);
+        case polynomialT:
+            return embedded_detail::value<polynomialT>(c, T, p);
+        case polynomialTPieceLinearT:
+            return embedded_detail::value<polynomialTPieceLinearT>(c, T, p);
+        case polynomialTPiecePolyT:
+            return embedded_detail::value<polynomialTPiecePolyT>(c, T, p);
+        case nasa9PiecePolyT:
+            return embedded_detail::value<nasa9PiecePolyT>(c, T, p);
+        case sutherlandT:
+            return embedded_detail::value<sutherlandT>(c, T, p);
+        case powerLawT:
+            return embedded_detail::value<powerLawT>(c, T, p);
+        case blottnerT:
+            return embedded_detail::value<blottnerT>(c, T, p);
+        case compressibleT:
+            return embedded_detail::value<compressibleT>(c, T, p);
+        default:
+            return kLawNaN;
+    }
+}
+
+constexpr Dual evaluateEmbeddedDerivatives(const EmbeddedCoefficient &c, double T, double p = kReferencePressure) {
+    switch (c.type) {
+        case CONSTCOEFF:
+            return embedded_detail::derivatives<CONSTCOEFF>(c, T, p);
+        case polynomialT:
+            return embedded_detail::derivatives<polynomialT>(c, T, p);
+        case polynomialTPieceLinearT:
+            return embedded_detail::derivatives<polynomialTPieceLinearT>(c, T, p);
+        case polynomialTPiecePolyT:
+            return embedded_detail::derivatives<polynomialTPiecePolyT>(c, T, p);
+        case nasa9PiecePolyT:
+            return embedded_detail::derivatives<nasa9PiecePolyT>(c, T, p);
+        case sutherlandT:
+            return embedded_detail::derivatives<sutherlandT>(c, T, p);
+        case powerLawT:
+            return embedded_detail::derivatives<powerLawT>(c, T, p);
+        case blottnerT:
+            return embedded_detail::derivatives<blottnerT>(c, T, p);
+        case compressibleT:
+            return embedded_detail::derivatives<compressibleT>(c, T, p);
+        default:
+            return {kLawNaN, kLawNaN, kLawNaN};
+    }
+}
+
+// 生成的查找表: 材料按名称排序, 每个材料的物性连续存放并按名称排序, 每个物性的系数连续存放并保持原顺序
+struct EmbeddedMaterialDatabase {
+    const EmbeddedMaterial *materials;
+    size_t materialCount;
+    const EmbeddedProperty *properties;
+    const EmbeddedCoefficient *coefficients;
+
+    // 未找到时返回 nullptr
+    constexpr const EmbeddedMaterial *findMaterial(std::string_view name) const {
+        return embedded_detail::findByName(materials, materialCount, name);
+    }
+
+    constexpr const EmbeddedProperty *findProperty(const EmbeddedMaterial &material, std::string_view name) const {
+        return embedded_detail::findByName(properties + material.firstProperty, material.propertyCount, name);
+    }
+
+    constexpr const EmbeddedCoefficient *find(std::string_view material, std::string_view property,
+                                              size_t index = 0) const {
+        const EmbeddedMaterial *m = findMaterial(material);
+        const EmbeddedProperty *prop = m ? findProperty(*m, property) : nullptr;
+        return prop && index < prop->coefficientCount ? &coefficients[prop->firstCoefficient + index] : nullptr;
+    }
+};
+
+} // namespace CFD_MaterialDB
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include "dual_number.h"
+#include "material.h"
+#include "polynomial_kernels.h"
+#include "viscosity_kernels.h"
+
+namespace CFD_MaterialDB {
+
+// 按系数类型特化的单点求值公式, 全部内联. Data 为该类型所需数据 (视图或参数结构, 不拥有数组);
+// value/derivatives 与 evaluateProperty/evaluatePropertyDerivatives 的标量路径是同一套公式.
+// 常数, 多项式, 分段与 NASA-9 的 value 为 constexpr, 系数是编译期常量时整个求值可以常量折叠.
+// 数据无效时返回 NaN. user-defined 需要运行时编译的字节码, 不在此列
+template<coefficientType Type>
+struct CoefficientLaw;
+
+constexpr double kLawNaN = std::numeric_limits<double>::quiet_NaN();
+
+// 多项式系数 c0..c(count-1), 低次在前
+struct PolynomialView {
+    const double *coefficients = nullptr;
+    size_t count = 0;
+};
+
+// 可压缩液体在 p 下的密度 (限幅后) 与 d(rho)/dp = rho / K, 被限幅时导数为 0; data 须有效
+inline double compressibleLiquidDensity(const compressibleLiquidData &data, double p, double &drhodp) {
+    const double rho0 = data.referenceDensity;
+    const double upper = data.maxDensityRatio > 0.0 ? rho0 * data.maxDensityRatio
+                                                    : std::numeric_limits<double>::infinity();
+    const double lower = rho0 * data.minDensityRatio;
+    // ratio = K / K0
+    double ratio = 1.0 + data.densityExponent / data.bulkModulus * (p - data.referencePressure);
+    double value = ratio > 0.0 ? rho0 * std::pow(ratio, 1.0 / data.densityExponent) : 0.0;
+    double limited = std::min(std::max(value, lower), upper);
+    drhodp = limited == value && ratio > 0.0 ? value / (data.bulkModulus * ratio) : 0.0;
+    return limited;
+}
+
+// 无效或不支持的系数
+template<>
+struct CoefficientLaw<NONET> {
+    struct Data {};
+
+    static constexpr double value(const Data &, double, double) { return kLawNaN; }
+
+    static constexpr Dual derivatives(const Data &, double, double) { return {kLawNaN, kLawNaN, kLawNaN}; }
+};
+
+template<>
+struct CoefficientLaw<CONSTCOEFF> {
+    using Data = double;
+
+    static constexpr double value(const Data &data, double, double) { return data; }
+
+    static constexpr Dual derivatives(const Data &data, double, double) { return {data, 0.0, 0.0}; }
+};
+
+template<>
+struct CoefficientLaw<polynomialT> {
+    using Data = PolynomialView;
+
+    static constexpr double value(const Data &data, double T, double) {
+        double value = 0.0;
+        for (size_t j = data.count; j-- > 0;) {
+            value = value * T + data.coefficients[j];
+        }
+        return value;
+    }
+
+    // 值与导数在同一遍 Horner 中累积
+    static constexpr Dual derivatives(const Data &data, double T, double) {
+        double value = 0.0;
+        double derivative = 0.0;
+        for (size_t j = data.count; j-- > 0;) {
+            derivative = derivative * T + value;
+            value = value * T + data.coefficients[j];
+        }
+        return {value, derivative, 0.0};
+    }
+};
+
+// 编译期求值不使用分桶索引, 顺序比较定位区间, 结果与分桶查找相同
+template<>
+struct CoefficientLaw<polynomialTPieceLinearT> {
+    using Data = PiecewiseLinearView;
+
+    static constexpr double value(const Data &data, double T, double) {
+        return data.points < 2 ? kLawNaN : linearValue(data, findSegment(data.temps, data.points - 1, T), T);
+    }
+
+    static constexpr Dual derivatives(const Data &data, double T, double) {
+        if (data.points < 2) {
+            return {kLawNaN, kLawNaN, kLawNaN};
+        }
+        size_t i = findSegment(data.temps, data.points - 1, T);
+        return {linearValue(data, i, T), linearDerivative(data, i, T), 0.0};
+    }
+};
+
+template<>
+struct CoefficientLaw<polynomialTPiecePolyT> {
+    using Data = SegmentedView;
+
+    static constexpr double value(const Data &data, double T, double) {
+        return data.segments == 0 ? kLawNaN : piecewiseSegment(
+                data.blocks + findSegment(data.bounds, data.segments, T) * kPiecewisePolyStride, T);
+    }
+
+    static constexpr Dual derivatives(const Data &data, double T, double) {
+        if (data.segments == 0) {
+            return {kLawNaN, kLawNaN, kLawNaN};
+        }
+        double derivative = 0.0;
+        double value = piecewiseSegment(data.blocks + findSegment(data.bounds, data.segments, T) * kPiecewisePolyStride,
+                                        T, derivative);
+        return {value, derivative, 0.0};
+    }
+};
+
+template<>
+struct CoefficientLaw<nasa9PiecePolyT> {
+    using Data = SegmentedView;
+
+    static constexpr double value(const Data &data, double T, double) {
+        return data.segments == 0 ? kLawNaN : nasa9Segment(
+                data.blocks + findSegment(data.bounds, data.segments, T) * kNasa9Stride, T);
+    }
+
+    static constexpr Dual derivatives(const Data &data, double T, double) {
+        if (data.segments == 0) {
+            return {kLawNaN, kLawNaN, kLawNaN};
+        }
+        double derivative = 0.0;
+        double value = nasa9Segment(data.blocks + findSegment(data.bounds, data.segments, T) * kNasa9Stride, T,
+                                    derivative);
+        return {value, derivative, 0.0};
+    }
+};
+
+template<>
+struct CoefficientLaw<sutherlandT> {
+    using Data = sutherlandData;
+
+    static double value(const Data &data, double T, double) { return evaluateSutherland(data, T); }
+
+    static Dual derivatives(const Data &data, double T, double) {
+        Dual result;
+        result.value = evaluateSutherland(data, T, &result.dT);
+        return result;
+    }
+};
+
+template<>
+struct CoefficientLaw<powerLawT> {
+    using Data = powerLawData;
+
+    static double value(const Data &data, double T, double) { return evaluatePowerLaw(data, T); }
+
+    static Dual derivatives(const Data &data, double T, double) {
+        Dual result;
+        result.value = evaluatePowerLaw(data, T, &result.dT);
+        return result;
+    }
+};
+
+template<>
+struct CoefficientLaw<blottnerT> {
+    using Data = blottnerData;
+
+    static double value(const Data &data, double T, double) { return evaluateBlottner(data, T); }
+
+    static Dual derivatives(const Data &data, double T, double) {
+        Dual result;
+        result.value = evaluateBlottner(data, T, &result.dT);
+        return result;
+    }
+};
+
+template<>
+struct CoefficientLaw<compressibleT> {
+    using Data = compressibleLiquidData;
+
+    static double value(const Data &data, double, double p) {
+        double drhodp = 0.0;
+        return data.valid() ? compressibleLiquidDensity(data, p, drhodp) : kLawNaN;
+    }
+
+    static Dual derivatives(const Data &data, double, double p) {
+        if (!data.valid()) {
+            return {kLawNaN, kLawNaN, kLawNaN};
+        }
+        Dual result;
+        result.value = compressibleLiquidDensity(data, p, result.dp);
+        return result;
+    }
+};
+
+} // namespace CFD_MaterialDB
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "material.h"
+
+namespace CFD_MaterialDB {
+
+// 通用气体常数, J/(kmol·K); 与 molecular-weight 的 kg/kmol 配套
+constexpr double kUniversalGasConstant = 8314.46261815324;
+
+enum class CubicEosModel {
+    PengRobinson,
+    SoaveRedlichKwong,
+    RedlichKwong
+};
+
+// 三次方程有三个实根时取哪一个: 气相取最大根, 液相取大于 B 的最小根, Stable 取两者中 Gibbs 自由能较低的
+enum class CubicRoot {
+    Vapor,
+    Liquid,
+    Stable
+};
+
+// 单组分常数, 载入时由临界性质算出. a(T) = ac * alpha(T), sqrt(alpha) = 1 + kappa (1 - sqrt(T/Tc));
+// Redlich-Kwong 模型的 sqrt(alpha) = (T/Tc)^(-1/4), 不使用 kappa
+struct CubicEosSpecies {
+    std::string name;
+    double criticalTemperature = 0.0;  // K
+    double criticalPressure = 0.0;     // Pa
+    double acentricFactor = 0.0;
+    double molecularWeight = 0.0;      // kg/kmol
+    double ac = 0.0;                   // Pa·m^6/kmol^2
+    double b = 0.0;                    // m^3/kmol
+    double kappa = 0.0;
+};
+
+CubicEosSpecies makeCubicEosSpecies(CubicEosModel model, const std::string &name, double criticalTemperature,
+                                    double criticalPressure, double acentricFactor, double molecularWeight);
+
+// 读取材料的 critical-temperature, critical-pressure, acentric-factor, molecular-weight; 缺少任一项时抛出
+CubicEosSpecies cubicEosSpeciesFromMaterial(CubicEosModel model, const Material &material);
+
+// 材料是否带有构造立方型状态方程所需的全部临界性质
+bool hasCubicEosProperties(const Material &material);
+
+// 对无量纲参数 A = a p / (RT)^2, B = b p / (RT) 闭式求解压缩因子 Z; 没有大于 B 的实根时返回 NaN
+double solveCubicCompressibility(CubicEosModel model, double A, double B, CubicRoot root = CubicRoot::Stable);
+
+// 立方型状态方程, 多组分按 van der Waals 单流体混合规则:
+// a = sum_ij x_i x_j sqrt(ac_i ac_j) (1 - k_ij) sqrt(alpha_i alpha_j), b = sum_i x_i b_i.
+// 交叉项 sqrt(ac_i ac_j) (1 - k_ij) 在构造时算好, 求值时只剩 sqrt(alpha_i) 与二次型
+class CubicEos {
+public:
+    // kij 为 n*n 行优先的二元交互系数, 为空时全部取 0
+    CubicEos(CubicEosModel model, std::vector<CubicEosSpecies> species, const std::vector<double> &kij = {});
+
+    CubicEosModel model() const { return model_; }
+
+    size_t speciesCount() const { return species_.size(); }
+
+    const CubicEosSpecies &species(size_t i) const { return species_[i]; }
+
+    // x 为 speciesCount() 个摩尔分数; 纯组分时可传 nullptr
+    double compressibility(double T, double p, const double *x = nullptr, CubicRoot root = CubicRoot::Stable) const;
+
+    // 密度, kg/m^3
+    double density(double T, double p, const double *x = nullptr, CubicRoot root = CubicRoot::Stable) const;
+
+    // 批量求密度. 第 i 点的组成为 x + i * xStride; xStride 为 0 时所有点组成相同, 纯组分时 x 可为 nullptr
+    void density(const double *T, const double *p, const double *x, size_t xStride, double *rho, size_t count,
+                 CubicRoot root = CubicRoot::Stable) const;
+
+private:
+    double sqrtAlpha(const CubicEosSpecies &species, double T) const;
+
+    // 温度 T 下的混合物 a, b 与平均分子量; x 为 nullptr 时视为纯组分 0. scratch 至少 speciesCount() 个
+    void mixture(const double *x, double T, double *scratch, double &a, double &b, double &molecularWeight) const;
+
+    CubicEosModel model_;
+    std::vector<CubicEosSpecies> species_;
+    std::vector<double> cross_;   // sqrt(ac_i ac_j) (1 - k_ij), n*n
+};
+
+} // namespace CFD_MaterialDB
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+namespace CFD_MaterialDB {
+
+// 前向模式自动微分的对偶数: 函数值及其对温度 T 和压力 p 的偏导数
+struct Dual {
+    double value = 0.0;
+    double dT = 0.0;
+    double dp = 0.0;
+};
+
+inline Dual dualConstant(double value) {
+    return {value, 0.0, 0.0};
+}
+
+// 链式法则 f(a) 的导数为 derivative * a'. a' 为 0 的分量直接取 0,
+// 避免 derivative 为 inf 时 (例如 sqrt 在 0 处) 得到 0 * inf = NaN
+inline Dual chainRule(const Dual &a, double value, double derivative) {
+    return {value, a.dT == 0.0 ? 0.0 : derivative * a.dT, a.dp == 0.0 ? 0.0 : derivative * a.dp};
+}
+
+inline Dual operator+(const Dual &a, const Dual &b) {
+    return {a.value + b.value, a.dT + b.dT, a.dp + b.dp};
+}
+
+inline Dual operator-(const Dual &a, const Dual &b) {
+    return {a.value - b.value, a.dT - b.dT, a.dp - b.dp};
+}
+
+inline Dual operator-(const Dual &a) {
+    return {-a.value, -a.dT, -a.dp};
+}
+
+inline Dual operator*(const Dual &a, const Dual &b) {
+    return {a.value * b.value, a.dT * b.value + a.value * b.dT, a.dp * b.value + a.value * b.dp};
+}
+
+inline Dual operator/(const Dual &a, const Dual &b) {
+    double q = a.value / b.value;
+    return {q, (a.dT - q * b.dT) / b.value, (a.dp - q * b.dp) / b.value};
+}
+
+inline Dual exp(const Dual &a) {
+    double e = std::exp(a.value);
+    return chainRule(a, e, e);
+}
+
+inline Dual log(const Dual &a) {
+    return chainRule(a, std::log(a.value), 1.0 / a.value);
+}
+
+inline Dual sqrt(const Dual &a) {
+    double s = std::sqrt(a.value);
+    return chainRule(a, s, 0.5 / s);
+}
+
+// 指数为常数时按 b a^(b-1) a' 求导, 底数可以为负
+inline Dual pow(const Dual &a, const Dual &b) {
+    double value = std::pow(a.value, b.value);
+    Dual result = chainRule(a, value, b.value * std::pow(a.value, b.value - 1.0));
+    if (b.dT != 0.0 || b.dp != 0.0) {
+        double logA = std::log(a.value);
+        result.dT += b.dT == 0.0 ? 0.0 : value * logA * b.dT;
+        result.dp += b.dp == 0.0 ? 0.0 : value * logA * b.dp;
+    }
+    return result;
+}
+
+inline Dual sin(const Dual &a) {
+    return chainRule(a, std::sin(a.value), std::cos(a.value));
+}
+
+inline Dual cos(const Dual &a) {
+    return chainRule(a, std::cos(a.value), -std::sin(a.value));
+}
+
+inline Dual tan(const Dual &a) {
+    double t = std::tan(a.value);
+    return chainRule(a, t, 1.0 + t * t);
+}
+
+inline Dual asin(const Dual &a) {
+    return chainRule(a, std::asin(a.value), 1.0 / std::sqrt(1.0 - a.value * a.value));
+}
+
+inline Dual acos(const Dual &a) {
+    return chainRule(a, std::acos(a.value), -1.0 / std::sqrt(1.0 - a.value * a.value));
+}
+
+inline Dual atan(const Dual &a) {
+    return chainRule(a, std::atan(a.value), 1.0 / (1.0 + a.value * a.value));
+}
+
+inline Dual atan2(const Dual &y, const Dual &x) {
+    double r2 = x.value * x.value + y.value * y.value;
+    return {std::atan2(y.value, x.value), (x.value * y.dT - y.value * x.dT) / r2,
+            (x.value * y.dp - y.value * x.dp) / r2};
+}
+
+inline Dual sinh(const Dual &a) {
+    return chainRule(a, std::sinh(a.value), std::cosh(a.value));
+}
+
+inline Dual cosh(const Dual &a) {
+    return chainRule(a, std::cosh(a.value), std::sinh(a.value));
+}
+
+inline Dual tanh(const Dual &a) {
+    double t = std::tanh(a.value);
+    return chainRule(a, t, 1.0 - t * t);
+}
+
+// 在 0 处取右导数
+inline Dual abs(const Dual &a) {
+    return a.value < 0.0 ? -a : a;
+}
+
+// 分段常数, 导数为 0
+inline Dual floor(const Dual &a) {
+    return dualConstant(std::floor(a.value));
+}
+
+inline Dual ceil(const Dual &a) {
+    return dualConstant(std::ceil(a.value));
+}
+
+// 与 std::min/std::max 一致: 相等时取第一个参数
+inline Dual min(const Dual &a, const Dual &b) {
+    return b.value < a.value ? b : a;
+}
+
+inline Dual max(const Dual &a, const Dual &b) {
+    return a.value < b.value ? b : a;
+}
+
+} // namespace CFD_MaterialDB
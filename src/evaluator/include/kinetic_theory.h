@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "material.h"
+
+namespace CFD_MaterialDB {
+
+// Lennard-Jones 势参数, 对应 SCM 中的 lennard-jones-length 与 lennard-jones-energy
+struct LennardJonesSpecies {
+    std::string name;
+    double sigma = 0.0;            // Å
+    double epsilonOverK = 0.0;     // K
+    double molecularWeight = 0.0;  // kg/kmol
+};
+
+// 材料是否带有可用的 (大于 0 的) Lennard-Jones 参数与分子量
+bool hasLennardJonesProperties(const Material &material);
+
+// 读取 lennard-jones-length, lennard-jones-energy, molecular-weight; 缺少或无效时抛出
+LennardJonesSpecies lennardJonesSpeciesFromMaterial(const Material &material);
+
+// 约化碰撞积分 Omega(2,2)* 与 Omega(1,1)*, 自变量为 T* = T / (epsilon/k).
+// 由 Neufeld 关联式在 ln T* 等距网格上预先制表, 查表为 O(1) 线性插值; 超出 [0.3, 100] 时取端点值
+double collisionIntegral22(double reducedTemperature);
+double collisionIntegral11(double reducedTemperature);
+
+// Chapman-Enskog 纯组分粘度, Pa·s
+double chapmanEnskogViscosity(const LennardJonesSpecies &species, double T);
+
+// Eucken 关系: k = mu (cp + 5/4 R/M); cp 为 J/(kg·K), 返回 W/(m·K)
+double euckenConductivity(double viscosity, double cp, double molecularWeight);
+
+// Chapman-Enskog 二元扩散系数, m^2/s; 组合规则 sigma_ij = (sigma_i + sigma_j)/2, eps_ij = sqrt(eps_i eps_j)
+double binaryDiffusionCoefficient(const LennardJonesSpecies &a, const LennardJonesSpecies &b, double T, double p);
+
+// 多组分输运. 组分对的常数 (ln eps_ij 及扩散系数前因子) 构造时算好, 以 n*n 行优先连续存放
+class KineticTransport {
+public:
+    explicit KineticTransport(std::vector<LennardJonesSpecies> species);
+
+    size_t speciesCount() const { return species_.size(); }
+
+    const LennardJonesSpecies &species(size_t i) const { return species_[i]; }
+
+    // 各组分纯组分粘度, mu 长度为 speciesCount()
+    void viscosities(double T, double *mu) const;
+
+    double binaryDiffusion(size_t i, size_t j, double T, double p) const;
+
+    // 混合平均扩散系数 D_im = (1 - Y_i) / sum_{j != i} x_j / D_ij; x 为摩尔分数.
+    // 单组分或 x_j 全为 0 时取自扩散系数
+    void mixtureAveragedDiffusivities(double T, double p, const double *x, double *Dm) const;
+
+    // 批量: 第 c 个单元的组成为 x + c * speciesCount(), 结果写入 Dm + c * speciesCount()
+    void mixtureAveragedDiffusivities(const double *T, const double *p, const double *x, double *Dm,
+                                      size_t cells) const;
+
+private:
+    struct PairCoefficients {
+        double logEpsilon;        // ln(eps_ij / k)
+        double inverseFactor;     // 1/D_ij = inverseFactor * p * Omega11 / T^1.5
+    };
+
+    void accumulate(double T, double p, const double *x, double *Dm, double *sums) const;
+
+    std::vector<LennardJonesSpecies> species_;
+    std::vector<double> viscosityFactor_;
+    std::vector<PairCoefficients> pairs_;
+};
+
+} // namespace CFD_MaterialDB
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "material.h"
+
+namespace CFD_MaterialDB {
+
+// 无分支的分段查找: 统计 T 超过了多少个内部分界点. bounds 为 segments + 1 个递增边界,
+// 超出范围时落在首/末段, 即用端部分段外推
+constexpr size_t findSegment(const double *bounds, size_t segments, double T) {
+    size_t index = 0;
+    for (size_t i = 1; i < segments; ++i) {
+        index += T >= bounds[i];
+    }
+    return index;
+}
+
+// 系数数据的只读视图, 内核只通过视图访问数据. 视图可以指向 MaterialProperty 中的 vector,
+// 也可以直接指向共享内存中的材料表 (shared_material_table.h), 不需要复制
+
+// 分段线性表; points 为 0 表示数据无效 (未调用 buildIndex 或数据不合法), bucketCount 为 0 表示没有分桶
+struct PiecewiseLinearView {
+    const double *temps = nullptr;
+    const double *values = nullptr;
+    const double *slopes = nullptr;
+    size_t points = 0;
+    const uint32_t *buckets = nullptr;
+    size_t bucketCount = 0;
+    double bucketScale = 0.0;
+};
+
+// 分段多项式与 NASA-9: segments + 1 个边界, 各段系数块按 kPiecewisePolyStride / kNasa9Stride 连续存放;
+// segments 为 0 表示数据无效
+struct SegmentedView {
+    const double *bounds = nullptr;
+    const double *blocks = nullptr;
+    size_t segments = 0;
+};
+
+// 以下为单个温度的求值公式, 标量内核与编译期嵌入的材料表 (embedded_material.h) 共用, 可在编译期求值
+
+// 第 i 个区间上的线性插值; 超出范围时夹到端点, 首/末区间的插值即为端点值
+constexpr double linearValue(const PiecewiseLinearView &data, size_t i, double T) {
+    const double *t = data.temps;
+    T = std::min(std::max(T, t[0]), t[data.points - 1]);
+    return data.values[i] + data.slopes[i] * (T - t[i]);
+}
+
+// 夹到端点之外导数为 0
+constexpr double linearDerivative(const PiecewiseLinearView &data, size_t i, double T) {
+    return T < data.temps[0] || T > data.temps[data.points - 1] ? 0.0 : data.slopes[i];
+}
+
+// 段内 [Tmin, Tmax, c0..c7], 系数定长, 循环完全展开
+constexpr double piecewiseSegment(const double *segment, double T) {
+    const double *c = segment + 2;
+    double value = c[kPiecewisePolyMaxCoefficients - 1];
+    for (size_t j = kPiecewisePolyMaxCoefficients - 1; j-- > 0;) {
+        value = value * T + c[j];
+    }
+    return value;
+}
+
+// Horner 的同时累积导数
+constexpr double piecewiseSegment(const double *segment, double T, double &derivative) {
+    const double *c = segment + 2;
+    double value = c[kPiecewisePolyMaxCoefficients - 1];
+    derivative = 0.0;
+    for (size_t j = kPiecewisePolyMaxCoefficients - 1; j-- > 0;) {
+        derivative = derivative * T + value;
+        value = value * T + c[j];
+    }
+    return value;
+}
+
+// a1 T^-2 + a2 T^-1 按 (a1/T + a2)/T 计算, 其余项用 Horner
+constexpr double nasa9Segment(const double *a, double T) {
+    double inv = 1.0 / T;
+    double poly = (((a[6] * T + a[5]) * T + a[4]) * T + a[3]) * T + a[2];
+    return poly + (a[0] * inv + a[1]) * inv;
+}
+
+// 同时给出 dcp/dT = -(2 a1 T^-1 + a2) T^-2 + a4 + 2 a5 T + 3 a6 T^2 + 4 a7 T^3
+constexpr double nasa9Segment(const double *a, double T, double &derivative) {
+    double inv = 1.0 / T;
+    double poly = a[6];
+    double dpoly = 0.0;
+    for (int j = 5; j >= 2; --j) {
+        dpoly = dpoly * T + poly;
+        poly = poly * T + a[j];
+    }
+    derivative = dpoly - (2.0 * a[0] * inv + a[1]) * inv * inv;
+    return poly + (a[0] * inv + a[1]) * inv;
+}
+
+inline PiecewiseLinearView piecewiseLinearView(const polyPiecewiseLinearData &data) {
+    PiecewiseLinearView view;
+    if (data.indexed()) {
+        view.temps = data.temp_ranges.data();
+        view.values = data.coefficients.data();
+        view.slopes = data.slopes.data();
+        view.points = data.temp_ranges.size();
+        view.buckets = data.buckets.data();
+        view.bucketCount = data.buckets.size();
+        view.bucketScale = data.bucketScale;
+    }
+    return view;
+}
+
+inline SegmentedView piecewisePolynomialView(const PiecewisePolynomialData &data) {
+    SegmentedView view;
+    if (data.segmentCount() > 0 && data.temp_ranges.size() == data.segmentCount() + 1) {
+        view.bounds = data.temp_ranges.data();
+        view.blocks = data.segments.data();
+        view.segments = data.segmentCount();
+    }
+    return view;
+}
+
+inline SegmentedView nasa9View(const NASAPolynomialData &data) {
+    SegmentedView view;
+    if (data.segmentCount() > 0 && data.temp_ranges.size() == data.segmentCount() + 1) {
+        view.bounds = data.temp_ranges.data();
+        view.blocks = data.coefficients.data();
+        view.segments = data.segmentCount();
+    }
+    return view;
+}
+
+// 分段线性插值, 超出范围时取端点值; 数据无效时返回 NaN
+double evaluatePiecewiseLinear(const PiecewiseLinearView &data, double T);
+
+// 批量插值, 温度可以乱序. 以上一个点所在区间为起点, 有序输入时每点一两次比较即可定位, 跳跃时退回分桶查找
+void evaluatePiecewiseLinear(const PiecewiseLinearView &data, const double *T, double *out, size_t count);
+
+// 同时给出 dv/dT (所在区间的斜率, 超出范围时为 0); 批量版本的 dvdT 可为 nullptr
+double evaluatePiecewiseLinear(const PiecewiseLinearView &data, double T, double *dvdT);
+
+void evaluatePiecewiseLinear(const PiecewiseLinearView &data, const double *T, double *out, double *dvdT,
+                             size_t count);
+
+// 分段多项式, 每段固定按 8 个系数做 Horner (高次项为零), 超出范围时用端部分段外推
+double evaluatePiecewisePolynomial(const SegmentedView &data, double T);
+
+void evaluatePiecewisePolynomial(const SegmentedView &data, const double *T, double *out, size_t count);
+
+// 同时给出 dv/dT, 与值在同一遍 Horner 中累积
+double evaluatePiecewisePolynomial(const SegmentedView &data, double T, double *dvdT);
+
+void evaluatePiecewisePolynomial(const SegmentedView &data, const double *T, double *out, double *dvdT,
+                                 size_t count);
+
+// NASA-9 分段多项式
+double evaluateNasa9(const SegmentedView &data, double T);
+
+// 批量求值; 编译时启用 AVX2/FMA 时每次处理 4 个温度, 否则退回标量循环
+void evaluateNasa9(const SegmentedView &data, const double *T, double *out, size_t count);
+
+// 同时给出 dcp/dT
+double evaluateNasa9(const SegmentedView &data, double T, double *dvdT);
+
+void evaluateNasa9(const SegmentedView &data, const double *T, double *out, double *dvdT, size_t count);
+
+// 以下按 MaterialProperty 中的数据求值, 与对应的视图版本相同
+inline double evaluatePiecewiseLinear(const polyPiecewiseLinearData &data, double T) {
+    return evaluatePiecewiseLinear(piecewiseLinearView(data), T);
+}
+
+inline void evaluatePiecewiseLinear(const polyPiecewiseLinearData &data, const double *T, double *out, size_t count) {
+    evaluatePiecewiseLinear(piecewiseLinearView(data), T, out, count);
+}
+
+inline double evaluatePiecewiseLinear(const polyPiecewiseLinearData &data, double T, double *dvdT) {
+    return evaluatePiecewiseLinear(piecewiseLinearView(data), T, dvdT);
+}
+
+inline void evaluatePiecewiseLinear(const polyPiecewiseLinearData &data, const double *T, double *out, double *dvdT,
+                                    size_t count) {
+    evaluatePiecewiseLinear(piecewiseLinearView(data), T, out, dvdT, count);
+}
+
+inline double evaluatePiecewisePolynomial(const PiecewisePolynomialData &data, double T) {
+    return evaluatePiecewisePolynomial(piecewisePolynomialView(data), T);
+}
+
+inline void evaluatePiecewisePolynomial(const PiecewisePolynomialData &data, const double *T, double *out,
+                                        size_t count) {
+    evaluatePiecewisePolynomial(piecewisePolynomialView(data), T, out, count);
+}
+
+inline double evaluatePiecewisePolynomial(const PiecewisePolynomialData &data, double T, double *dvdT) {
+    return evaluatePiecewisePolynomial(piecewisePolynomialView(data), T, dvdT);
+}
+
+inline void evaluatePiecewisePolynomial(const PiecewisePolynomialData &data, const double *T, double *out,
+                                        double *dvdT, size_t count) {
+    evaluatePiecewisePolynomial(piecewisePolynomialView(data), T, out, dvdT, count);
+}
+
+inline double evaluateNasa9(const NASAPolynomialData &data, double T) {
+    return evaluateNasa9(nasa9View(data), T);
+}
+
+inline void evaluateNasa9(const NASAPolynomialData &data, const double *T, double *out, size_t count) {
+    evaluateNasa9(nasa9View(data), T, out, count);
+}
+
+inline double evaluateNasa9(const NASAPolynomialData &data, double T, double *dvdT) {
+    return evaluateNasa9(nasa9View(data), T, dvdT);
+}
+
+inline void evaluateNasa9(const NASAPolynomialData &data, const double *T, double *out, double *dvdT, size_t count) {
+    evaluateNasa9(nasa9View(data), T, out, dvdT, count);
+}
+
+} // namespace CFD_MaterialDB
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+#include "dual_number.h"
+#include "material.h"
+
+namespace CFD_MaterialDB {
+
+// 标准大气压, 作为不依赖压力的求值默认值
+constexpr double kReferencePressure = 101325.0;
+
+// 没有给出温度范围的物性 (常数, 多项式, sutherland 等) 按此范围统计
+constexpr double kDefaultMinTemperature = 1.0;
+constexpr double kDefaultMaxTemperature = 10000.0;
+
+// 每个系数最多切分的温度段数
+constexpr int kMaxRangeTiles = 64;
+
+// 单个系数在一段温度区间上的近似取值包络, 用于 R*-tree 索引
+struct PropertyRangeTile {
+    double t_min;
+    double t_max;
+    double v_min;
+    double v_max;
+};
+
+// 在温度 T (K) 和压力 p (Pa) 下对单个系数求值; 无法求值时返回 NaN
+double evaluateProperty(const MaterialProperty &prop, double T, double p = kReferencePressure);
+
+// 在同一压力下对 count 个温度批量求值; 有批量内核的系数类型 (NASA-9 等) 不逐点分派
+void evaluateProperty(const MaterialProperty &prop, const double *T, double *out, size_t count,
+                      double p = kReferencePressure);
+
+// 在 (T, p) 处同时求值及对 T, p 的偏导数. 多项式, 分段, NASA-9, 粘度公式和可压缩液体按解析式求导,
+// user-defined 在字节码上用对偶数做前向自动微分; 无法求值时三者均为 NaN
+Dual evaluatePropertyDerivatives(const MaterialProperty &prop, double T, double p = kReferencePressure);
+
+// 批量版本, 在同一遍循环中写出值与 dv/dT, dvdp 可为 nullptr
+void evaluatePropertyDerivatives(const MaterialProperty &prop, const double *T, double *value, double *dvdT,
+                                 double *dvdp, size_t count, double p = kReferencePressure);
+
+// 可压缩液体在压力 p (Pa) 下的密度; drhodp 非空时同时给出 d(rho)/dp = rho / K, 密度被限幅时为 0
+double evaluateCompressibleLiquid(const compressibleLiquidData &data, double p, double *drhodp = nullptr);
+
+// 对 count 个压力批量求密度及其导数, drhodp 可为 nullptr
+void evaluateCompressibleLiquid(const compressibleLiquidData &data, const double *p, double *rho, double *drhodp,
+                                size_t count);
+
+// 材料中某个常数物性 (临界性质, Lennard-Jones 参数等) 的值, 取第一个系数在 298.15 K 下求值;
+// 缺少该物性或无法求值时抛出
+double constantPropertyValue(const Material &material, const std::string &key);
+
+// 编译材料中所有 user-defined 物性的 lambda; 从 JSON 读出的材料在求值前应调用一次.
+// 编译失败的物性保持未编译状态, 求值结果为 NaN
+void compileUserDefinedProperties(Material &material);
+
+// 系数的有效温度范围; 没有范围信息的系数返回默认范围
+void propertyTemperatureRange(const MaterialProperty &prop, double &t_min, double &t_max);
+
+// 把有效温度范围切分成若干段, 每段给出取值上下界; 无法求值的系数返回空.
+// 常数与分段线性的界是精确的; 其余类型按段内等距采样再放宽 5% 的跨度, 是近似值,
+// 段内陡峭的极值 (高次拟合, user-defined) 可能越出界限, 依赖这些界的范围查询可能漏掉材料
+std::vector<PropertyRangeTile> summarizePropertyRange(const MaterialProperty &prop);
+
+} // namespace CFD_MaterialDB
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "dual_number.h"
+
+namespace CFD_MaterialDB {
+
+// 用户自定义物性 (user-defined (lambda (T p) ...)) 编译后的扁平字节码.
+// 载入时用 tinyscheme 读取 lambda 并编译一次, 之后求值只是在小数组上的栈机循环.
+enum class ExpressionOp : uint8_t {
+    PushConstant,   // 压入 value
+    LoadArgument,   // 压入第 operand 个参数 (0 = T, 1 = p)
+    LoadLocal,      // 压入 let 绑定的第 operand 个局部变量
+    StoreLocal,     // 弹出栈顶存入第 operand 个局部变量
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Negate,
+    Power,
+    Exp,
+    Log,
+    Sqrt,
+    Sin,
+    Cos,
+    Tan,
+    Asin,
+    Acos,
+    Atan,
+    Atan2,
+    Sinh,
+    Cosh,
+    Tanh,
+    Abs,
+    Floor,
+    Ceiling,
+    Min,
+    Max,
+    Less,           // 比较结果以 1.0 / 0.0 表示
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Equal,
+    Not,
+    Jump,           // 相对跳转 operand 条指令
+    JumpIfFalse     // 弹出栈顶, 为 0 时相对跳转
+};
+
+struct ExpressionInstruction {
+    ExpressionOp op;
+    int32_t operand = 0;
+    double value = 0.0;
+};
+
+class ExpressionProgram {
+public:
+    // 栈和局部变量都放在定长数组里, 编译时超出则报错
+    static constexpr int kMaxStack = 64;
+    static constexpr int kMaxLocals = 32;
+    static constexpr int kMaxArguments = 2;
+
+    double evaluate(double T, double p) const;
+    double operator()(double T, double p) const { return evaluate(T, p); }
+
+    // 批量求值, p 为空时所有点使用同一压力 pressure
+    void evaluate(const double *T, const double *p, double pressure, double *out, size_t count) const;
+
+    // 前向模式自动微分: 同一遍栈机循环给出值及对 T, p 的偏导数. 比较和 floor/ceiling 的导数为 0,
+    // 条件分支只对实际走到的分支求导
+    Dual evaluateDual(double T, double p) const;
+
+    // 批量版本, dp 可为 nullptr
+    void evaluateDual(const double *T, const double *p, double pressure, double *out, double *dT, double *dp,
+                      size_t count) const;
+
+    const std::string &source() const { return source_; }
+    const std::vector<std::string> &parameters() const { return parameters_; }
+    const std::vector<ExpressionInstruction> &code() const { return code_; }
+    int maxStack() const { return maxStack_; }
+    int localCount() const { return localCount_; }
+
+    // 不依赖参数的表达式在编译时已折叠成一个常数
+    bool isConstant() const { return code_.size() == 1 && code_[0].op == ExpressionOp::PushConstant; }
+
+private:
+    friend ExpressionProgram compileSchemeLambda(const std::string &source);
+
+    std::string source_;
+    std::vector<std::string> parameters_;
+    std::vector<ExpressionInstruction> code_;
+    int maxStack_ = 0;
+    int localCount_ = 0;
+};
+
+// 编译 (lambda (T [p]) body) 形式的 Scheme 表达式. 支持:
+//   数字, #t/#f, 参数, + - * / expt exp log sqrt sin cos tan asin acos atan sinh cosh tanh
+//   abs floor ceiling min max, < <= > >= =, and or not, if cond let let*
+// 不支持的形式, 未绑定的变量或类型错误 (例如把数字用作条件) 抛出 std::runtime_error
+ExpressionProgram compileSchemeLambda(const std::string &source);
+
+} // namespace CFD_MaterialDB
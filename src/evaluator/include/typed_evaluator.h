@@ -0,0 +1,281 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "coefficient_laws.h"
+#include "polynomial_kernels.h"
+#include "property_evaluator.h"
+#include "property_expression.h"
+#include "viscosity_kernels.h"
+
+namespace CFD_MaterialDB {
+
+// 按系数类型特化的求值器. 求解器选定材料后可以针对具体公式写内核, 例如
+//   withEvaluator(prop, [&](const auto &mu) { for (...) nu[i] = mu(T[i]) / rho[i]; });
+// 内层循环中不再按 coeffType 分派, 编译期给定阶数的多项式 (Evaluator<polynomialT, N>) 循环可以完全展开.
+// 结果与 evaluateProperty / evaluatePropertyDerivatives 相同, 但不计入求值计数.
+// Evaluator 持有指向 MaterialProperty 中数据的视图, 不能比 prop 活得更久.
+// 与 evaluateProperty 不同, user-defined 的 lambda 无法编译时构造 Evaluator 会抛出, 而不是返回 NaN
+
+// 多项式系数个数不超过此值时, withEvaluator 使用编译期阶数
+constexpr size_t kMaxFixedPolynomialTerms = 8;
+
+// user-defined: 持有编译好的字节码; 为空时求值为 NaN
+template<>
+struct CoefficientLaw<userDefinedT> {
+    using Data = std::shared_ptr<const ExpressionProgram>;
+
+    static double value(const Data &data, double T, double p) { return data ? data->evaluate(T, p) : kLawNaN; }
+
+    static Dual derivatives(const Data &data, double T, double p) {
+        return data ? data->evaluateDual(T, p) : Dual{kLawNaN, kLawNaN, kLawNaN};
+    }
+};
+
+// N 个系数的多项式, 循环次数编译期已知; 运算顺序与 CoefficientLaw<polynomialT> 相同
+template<size_t N>
+struct FixedPolynomialLaw {
+    using Data = const double *;
+
+    static constexpr double value(const Data &c, double T, double) {
+        double value = 0.0;
+        for (size_t j = N; j-- > 0;) {
+            value = value * T + c[j];
+        }
+        return value;
+    }
+
+    static constexpr Dual derivatives(const Data &c, double T, double) {
+        double value = 0.0;
+        double derivative = 0.0;
+        for (size_t j = N; j-- > 0;) {
+            derivative = derivative * T + value;
+            value = value * T + c[j];
+        }
+        return {value, derivative, 0.0};
+    }
+};
+
+namespace evaluator_detail {
+
+template<coefficientType Type, size_t N>
+struct LawFor {
+    using type = CoefficientLaw<Type>;
+};
+
+template<size_t N>
+struct LawFor<polynomialT, N> {
+    using type = std::conditional_t<N == 0, CoefficientLaw<polynomialT>, FixedPolynomialLaw<N>>;
+};
+
+// 从 MaterialProperty 取出公式所需的数据; 早期数据库存放在 polydata 中的参数与 evaluateProperty 一样换算
+template<coefficientType Type, size_t N>
+typename LawFor<Type, N>::type::Data lawData(const MaterialProperty &prop) {
+    const std::vector<double> &legacy = prop.polydata.coefficients;
+    if constexpr (Type == CONSTCOEFF) {
+        return prop.constData;
+    } else if constexpr (Type == polynomialT && N > 0) {
+        return legacy.data();
+    } else if constexpr (Type == polynomialT) {
+        return {legacy.data(), legacy.size()};
+    } else if constexpr (Type == polynomialTPieceLinearT) {
+        return piecewiseLinearView(prop.ppldata);
+    } else if constexpr (Type == polynomialTPiecePolyT) {
+        return piecewisePolynomialView(prop.pwpolydata);
+    } else if constexpr (Type == nasa9PiecePolyT) {
+        return nasa9View(prop.nasapolydata);
+    } else if constexpr (Type == sutherlandT) {
+        return legacy.empty() ? prop.sutherlanddata : sutherlandData::fromCoefficients(legacy);
+    } else if constexpr (Type == powerLawT) {
+        return legacy.empty() ? prop.powerlawdata : powerLawData::fromCoefficients(legacy);
+    } else if constexpr (Type == blottnerT) {
+        return legacy.empty() ? prop.blottnerdata : blottnerData::fromCoefficients(legacy);
+    } else if constexpr (Type == compressibleT) {
+        return prop.compLiquidData.valid() ? prop.compLiquidData : compressibleLiquidData::fromCoefficients(legacy);
+    } else if constexpr (Type == userDefinedT) {
+        if (prop.userdata.program) {
+            return prop.userdata.program;
+        }
+        // 未预先编译时在构造时编译一次, 而不是像 evaluateProperty 那样每次调用都编译; 编译错误直接抛出
+        return std::make_shared<const ExpressionProgram>(compileSchemeLambda(prop.userdata.source));
+    } else {
+        return {};
+    }
+}
+
+template<size_t N, typename F>
+decltype(auto) dispatchPolynomialTerms(const MaterialProperty &prop, F &&f);
+
+} // namespace evaluator_detail
+
+template<coefficientType Type, size_t N = 0>
+class Evaluator {
+    static_assert(N == 0 || Type == polynomialT, "只有多项式可以指定编译期阶数");
+
+public:
+    using Law = typename evaluator_detail::LawFor<Type, N>::type;
+
+    static constexpr coefficientType type = Type;
+
+    // prop 的类型 (以及 N > 0 时的多项式系数个数) 必须与模板参数一致; Evaluator<NONET> 接受任何系数, 求值为 NaN
+    explicit Evaluator(const MaterialProperty &prop) : data_(evaluator_detail::lawData<Type, N>(checked(prop))) {}
+
+    double operator()(double T, double p = kReferencePressure) const { return Law::value(data_, T, p); }
+
+    Dual derivatives(double T, double p = kReferencePressure) const { return Law::derivatives(data_, T, p); }
+
+    // 批量求值; 有批量内核的类型 (分段, NASA-9, 粘度公式, user-defined) 调用同一内核, 其余逐点内联求值
+    void operator()(const double *T, double *out, size_t count, double p = kReferencePressure) const {
+        if constexpr (Type == polynomialTPieceLinearT) {
+            evaluatePiecewiseLinear(data_, T, out, count);
+        } else if constexpr (Type == polynomialTPiecePolyT) {
+            evaluatePiecewisePolynomial(data_, T, out, count);
+        } else if constexpr (Type == nasa9PiecePolyT) {
+            evaluateNasa9(data_, T, out, count);
+        } else if constexpr (Type == sutherlandT) {
+            evaluateSutherland(data_, T, out, count);
+        } else if constexpr (Type == powerLawT) {
+            evaluatePowerLaw(data_, T, out, count);
+        } else if constexpr (Type == blottnerT) {
+            evaluateBlottner(data_, T, out, count);
+        } else if constexpr (Type == userDefinedT) {
+            if (data_) {
+                data_->evaluate(T, nullptr, p, out, count);
+            } else {
+                std::fill(out, out + count, kLawNaN);
+            }
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = Law::value(data_, T[i], p);
+            }
+        }
+    }
+
+    // 批量求值与导数, dvdp 可为 nullptr
+    void derivatives(const double *T, double *value, double *dvdT, double *dvdp, size_t count,
+                     double p = kReferencePressure) const {
+        if constexpr (Type == polynomialTPieceLinearT || Type == polynomialTPiecePolyT || Type == nasa9PiecePolyT
+                      || Type == sutherlandT || Type == powerLawT || Type == blottnerT) {
+            if constexpr (Type == polynomialTPieceLinearT) {
+                evaluatePiecewiseLinear(data_, T, value, dvdT, count);
+            } else if constexpr (Type == polynomialTPiecePolyT) {
+                evaluatePiecewisePolynomial(data_, T, value, dvdT, count);
+            } else if constexpr (Type == nasa9PiecePolyT) {
+                evaluateNasa9(data_, T, value, dvdT, count);
+            } else if constexpr (Type == sutherlandT) {
+                evaluateSutherland(data_, T, value, dvdT, count);
+            } else if constexpr (Type == powerLawT) {
+                evaluatePowerLaw(data_, T, value, dvdT, count);
+            } else {
+                evaluateBlottner(data_, T, value, dvdT, count);
+            }
+            // 这些类型与压力无关
+            if (dvdp) {
+                std::fill(dvdp, dvdp + count, 0.0);
+            }
+        } else if constexpr (Type == userDefinedT) {
+            if (data_) {
+                data_->evaluateDual(T, nullptr, p, value, dvdT, dvdp, count);
+                return;
+            }
+            std::fill(value, value + count, kLawNaN);
+            std::fill(dvdT, dvdT + count, kLawNaN);
+            if (dvdp) {
+                std::fill(dvdp, dvdp + count, kLawNaN);
+            }
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                Dual result = Law::derivatives(data_, T[i], p);
+                value[i] = result.value;
+                dvdT[i] = result.dT;
+                if (dvdp) {
+                    dvdp[i] = result.dp;
+                }
+            }
+        }
+    }
+
+    const typename Law::Data &data() const { return data_; }
+
+private:
+    // 在取数据 (以及编译 user-defined 的 lambda) 之前校验, 避免按错误的类型读取 prop
+    static const MaterialProperty &checked(const MaterialProperty &prop) {
+        if (Type != NONET && prop.coeffType != Type) {
+            throw std::runtime_error("系数类型与求值器不一致: " + std::to_string(prop.coeffType) + " / "
+                                     + std::to_string(Type));
+        }
+        if (N > 0 && prop.polydata.coefficients.size() != N) {
+            throw std::runtime_error("多项式系数个数与求值器不一致: " + std::to_string(prop.polydata.coefficients.size())
+                                     + " / " + std::to_string(N));
+        }
+        return prop;
+    }
+
+    typename Law::Data data_;
+};
+
+// 运行时类型到编译期类型的分派: 以 std::integral_constant<coefficientType, X> 调用 f,
+// 未知类型按 NONET 处理. f 对每个类型实例化一次, 各分支的返回类型必须相同
+template<typename F>
+decltype(auto) dispatchCoefficientType(coefficientType type, F &&f) {
+    switch (type) {
+        case CONSTCOEFF:
+            return f(std::integral_constant<coefficientType, CONSTCOEFF>{});
+        case polynomialT:
+            return f(std::integral_constant<coefficientType, polynomialT>{});
+        case polynomialTPieceLinearT:
+            return f(std::integral_constant<coefficientType, polynomialTPieceLinearT>{});
+        case polynomialTPiecePolyT:
+            return f(std::integral_constant<coefficientType, polynomialTPiecePolyT>{});
+        case nasa9PiecePolyT:
+            return f(std::integral_constant<coefficientType, nasa9PiecePolyT>{});
+        case sutherlandT:
+            return f(std::integral_constant<coefficientType, sutherlandT>{});
+        case powerLawT:
+            return f(std::integral_constant<coefficientType, powerLawT>{});
+        case blottnerT:
+            return f(std::integral_constant<coefficientType, blottnerT>{});
+        case compressibleT:
+            return f(std::integral_constant<coefficientType, compressibleT>{});
+        case userDefinedT:
+            return f(std::integral_constant<coefficientType, userDefinedT>{});
+        default:
+            return f(std::integral_constant<coefficientType, NONET>{});
+    }
+}
+
+// 按 prop 的类型构造对应的 Evaluator 并以它调用 f; 分派只发生一次, f 内的循环直接使用具体公式.
+// 多项式系数为 1..kMaxFixedPolynomialTerms 个时使用 Evaluator<polynomialT, N>
+template<typename F>
+decltype(auto) withEvaluator(const MaterialProperty &prop, F &&f) {
+    return dispatchCoefficientType(prop.coeffType, [&](auto type) -> decltype(auto) {
+        if constexpr (decltype(type)::value == polynomialT) {
+            return evaluator_detail::dispatchPolynomialTerms<1>(prop, f);
+        } else {
+            return f(Evaluator<decltype(type)::value>(prop));
+        }
+    });
+}
+
+namespace evaluator_detail {
+
+template<size_t N, typename F>
+decltype(auto) dispatchPolynomialTerms(const MaterialProperty &prop, F &&f) {
+    if (prop.polydata.coefficients.size() == N) {
+        return f(Evaluator<polynomialT, N>(prop));
+    }
+    if constexpr (N < kMaxFixedPolynomialTerms) {
+        return dispatchPolynomialTerms<N + 1>(prop, f);
+    } else {
+        return f(Evaluator<polynomialT>(prop));
+    }
+}
+
+} // namespace evaluator_detail
+
+} // namespace CFD_MaterialDB
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include "material.h"
+
+namespace CFD_MaterialDB {
+
+// power-law 批量求值的精度. Exact 逐点调用 std::pow; Fast 在启用 AVX2/FMA 时改用低阶多项式近似的
+// log/exp, 在 1-10000 K 内相对误差不超过 kFastPowRelativeError. 未启用 AVX2 时两者相同
+enum class PowAccuracy {
+    Exact,
+    Fast
+};
+
+constexpr double kFastPowRelativeError = 1e-9;
+
+// 标量版本内联在头文件中, 供编译期嵌入的材料表 (embedded_material.h) 直接展开
+
+// mu = C1 T^1.5 / (T + S)
+inline double evaluateSutherland(const sutherlandData &data, double T) {
+    return data.C1 * T * std::sqrt(T) / (T + data.S);
+}
+
+void evaluateSutherland(const sutherlandData &data, const double *T, double *out, size_t count);
+
+// 由已求出的粘度得到 dmu/dT, 避免重复计算 pow/log/exp
+inline double sutherlandDerivative(const sutherlandData &data, double T, double mu) {
+    return mu * (1.5 / T - 1.0 / (T + data.S));
+}
+
+inline double powerLawDerivative(const powerLawData &data, double T, double mu) {
+    return data.n * mu / T;
+}
+
+// 带 dmu/dT 的版本, 导数由已算出的粘度解析得到
+inline double evaluateSutherland(const sutherlandData &data, double T, double *dmudT) {
+    double mu = evaluateSutherland(data, T);
+    *dmudT = sutherlandDerivative(data, T, mu);
+    return mu;
+}
+
+void evaluateSutherland(const sutherlandData &data, const double *T, double *out, double *dmudT, size_t count);
+
+// mu = B T^n
+inline double evaluatePowerLaw(const powerLawData &data, double T) {
+    return data.B * std::pow(T, data.n);
+}
+
+void evaluatePowerLaw(const powerLawData &data, const double *T, double *out, size_t count,
+                      PowAccuracy accuracy = PowAccuracy::Exact);
+
+inline double evaluatePowerLaw(const powerLawData &data, double T, double *dmudT) {
+    double mu = evaluatePowerLaw(data, T);
+    *dmudT = powerLawDerivative(data, T, mu);
+    return mu;
+}
+
+void evaluatePowerLaw(const powerLawData &data, const double *T, double *out, double *dmudT, size_t count,
+                      PowAccuracy accuracy = PowAccuracy::Exact);
+
+// mu = 0.1 exp((A ln T + B) ln T + C); 批量求值在启用 AVX2/FMA 时使用向量化的 log/exp, 精度接近 std::log/exp
+inline double evaluateBlottner(const blottnerData &data, double T) {
+    double lnT = std::log(T);
+    return 0.1 * std::exp((data.A * lnT + data.B) * lnT + data.C);
+}
+
+void evaluateBlottner(const blottnerData &data, const double *T, double *out, size_t count);
+
+// dmu/dT = mu (2 A ln T + B) / T; 批量版本的 dmudT 可为 nullptr, 导数与值共用同一个 ln T
+inline double evaluateBlottner(const blottnerData &data, double T, double *dmudT) {
+    double lnT = std::log(T);
+    double mu = 0.1 * std::exp((data.A * lnT + data.B) * lnT + data.C);
+    *dmudT = mu * (2.0 * data.A * lnT + data.B) / T;
+    return mu;
+}
+
+void evaluateBlottner(const blottnerData &data, const double *T, double *out, double *dmudT, size_t count);
+
+} // namespace CFD_MaterialDB
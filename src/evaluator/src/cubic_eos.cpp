@@ -0,0 +1,255 @@
+#include "cubic_eos.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "property_evaluator.h"
+
+namespace CFD_MaterialDB {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+constexpr double kSqrt2 = 1.41421356237309504880;
+constexpr double kTwoPiOverThree = 2.09439510239319549231;
+
+// 批量求值时每块的点数; 第一遍算 A, B, 第二遍逐点求根
+constexpr size_t kEosBlock = 64;
+
+// Z^3 + c2 Z^2 + c1 Z + c0 = 0 的通用形式: p = RT/(v-b) - a/(v^2 + u b v + w b^2)
+struct CubicForm {
+    double u;
+    double w;
+    double delta1;  // Z + delta1 B, Z + delta2 B 为吸引项分母的两个因子
+    double delta2;
+};
+
+CubicForm cubicForm(CubicEosModel model) {
+    if (model == CubicEosModel::PengRobinson) {
+        return {2.0, -1.0, 1.0 + kSqrt2, 1.0 - kSqrt2};
+    }
+    return {1.0, 0.0, 1.0, 0.0};
+}
+
+// 相对理想气体的 Gibbs 自由能偏差 G/RT (略去与根无关的项)
+double gibbsDeparture(const CubicForm &form, double A, double B, double Z) {
+    return Z - 1.0 - std::log(Z - B)
+           - A / (B * (form.delta1 - form.delta2)) * std::log((Z + form.delta1 * B) / (Z + form.delta2 * B));
+}
+
+} // namespace
+
+CubicEosSpecies makeCubicEosSpecies(CubicEosModel model, const std::string &name, double criticalTemperature,
+                                    double criticalPressure, double acentricFactor, double molecularWeight) {
+    if (!(criticalTemperature > 0.0) || !(criticalPressure > 0.0) || !(molecularWeight > 0.0)) {
+        throw std::runtime_error("临界性质无效: " + name);
+    }
+    CubicEosSpecies species;
+    species.name = name;
+    species.criticalTemperature = criticalTemperature;
+    species.criticalPressure = criticalPressure;
+    species.acentricFactor = acentricFactor;
+    species.molecularWeight = molecularWeight;
+
+    double RTc = kUniversalGasConstant * criticalTemperature;
+    double w = acentricFactor;
+    switch (model) {
+        case CubicEosModel::PengRobinson:
+            species.ac = 0.45723553 * RTc * RTc / criticalPressure;
+            species.b = 0.07779607 * RTc / criticalPressure;
+            // 重组分 (w > 0.49) 使用 1978 年修正式
+            species.kappa = w <= 0.49 ? 0.37464 + (1.54226 - 0.26992 * w) * w
+                                      : 0.379642 + (1.48503 + (-0.164423 + 0.016666 * w) * w) * w;
+            break;
+        case CubicEosModel::SoaveRedlichKwong:
+            species.ac = 0.42748023 * RTc * RTc / criticalPressure;
+            species.b = 0.08664035 * RTc / criticalPressure;
+            species.kappa = 0.480 + (1.574 - 0.176 * w) * w;
+            break;
+        case CubicEosModel::RedlichKwong:
+            species.ac = 0.42748023 * RTc * RTc / criticalPressure;
+            species.b = 0.08664035 * RTc / criticalPressure;
+            break;
+    }
+    return species;
+}
+
+bool hasCubicEosProperties(const Material &material) {
+    return material.hasProperty("critical-temperature") && material.hasProperty("critical-pressure")
+           && material.hasProperty("acentric-factor") && material.hasProperty("molecular-weight");
+}
+
+CubicEosSpecies cubicEosSpeciesFromMaterial(CubicEosModel model, const Material &material) {
+    return makeCubicEosSpecies(model, material.name, constantPropertyValue(material, "critical-temperature"),
+                               constantPropertyValue(material, "critical-pressure"),
+                               constantPropertyValue(material, "acentric-factor"),
+                               constantPropertyValue(material, "molecular-weight"));
+}
+
+double solveCubicCompressibility(CubicEosModel model, double A, double B, CubicRoot root) {
+    CubicForm form = cubicForm(model);
+    double c2 = -(1.0 + B - form.u * B);
+    double c1 = A + form.w * B * B - form.u * B - form.u * B * B;
+    double c0 = -(A * B + form.w * B * B + form.w * B * B * B);
+
+    // Z = y - shift 消去二次项: y^3 + P y + Q = 0
+    double shift = c2 / 3.0;
+    double P = c1 - c2 * shift;
+    double Q = (2.0 * shift * shift - c1) * shift + c0;
+    double discriminant = 0.25 * Q * Q + P * P * P / 27.0;
+
+    double Z;
+    if (discriminant > 0.0) {
+        // 一个实根 (Cardano). 取模较大的立方根, 另一个由 u v = -P/3 得到, 避免相消且只开一次立方
+        double s = std::sqrt(discriminant);
+        double u = std::cbrt(Q > 0.0 ? -0.5 * Q - s : -0.5 * Q + s);
+        Z = (u != 0.0 ? u - P / (3.0 * u) : 0.0) - shift;
+    } else {
+        // 三个实根 (三角解), 最大根为气相, 最小根为液相; 中间根无物理意义.
+        // 最小根不大于 B 时没有液相解
+        double m = 2.0 * std::sqrt(std::max(-P / 3.0, 0.0));
+        double c = m > 0.0 ? std::min(std::max(3.0 * Q / (P * m), -1.0), 1.0) : 0.0;
+        double theta = std::acos(c) / 3.0;
+        double zMax = m * std::cos(theta) - shift;
+        double zLiquid = m * std::cos(theta + kTwoPiOverThree) - shift;
+        if (root == CubicRoot::Vapor || !(zLiquid > B) || zLiquid >= zMax) {
+            Z = zMax;
+        } else if (root == CubicRoot::Liquid) {
+            Z = zLiquid;
+        } else {
+            Z = gibbsDeparture(form, A, B, zLiquid) < gibbsDeparture(form, A, B, zMax) ? zLiquid : zMax;
+        }
+    }
+
+    // 一步 Newton 修正闭式解的舍入误差 (临界点附近误差较大)
+    double f = ((Z + c2) * Z + c1) * Z + c0;
+    double df = (3.0 * Z + 2.0 * c2) * Z + c1;
+    if (df != 0.0) {
+        Z -= f / df;
+    }
+    return Z > B ? Z : kNaN;
+}
+
+CubicEos::CubicEos(CubicEosModel model, std::vector<CubicEosSpecies> species, const std::vector<double> &kij)
+        : model_(model), species_(std::move(species)) {
+    size_t n = species_.size();
+    if (n == 0) {
+        throw std::runtime_error("立方型状态方程至少需要一个组分");
+    }
+    if (!kij.empty() && kij.size() != n * n) {
+        throw std::runtime_error("二元交互系数应为 " + std::to_string(n * n) + " 个");
+    }
+    cross_.resize(n * n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            double k = kij.empty() ? 0.0 : kij[i * n + j];
+            cross_[i * n + j] = std::sqrt(species_[i].ac * species_[j].ac) * (1.0 - k);
+        }
+    }
+}
+
+double CubicEos::sqrtAlpha(const CubicEosSpecies &species, double T) const {
+    double tr = std::sqrt(T / species.criticalTemperature);
+    if (model_ == CubicEosModel::RedlichKwong) {
+        return 1.0 / std::sqrt(tr);
+    }
+    return 1.0 + species.kappa * (1.0 - tr);
+}
+
+void CubicEos::mixture(const double *x, double T, double *scratch, double &a, double &b,
+                       double &molecularWeight) const {
+    size_t n = species_.size();
+    if (x == nullptr || n == 1) {
+        double s = sqrtAlpha(species_[0], T);
+        a = species_[0].ac * s * s;
+        b = species_[0].b;
+        molecularWeight = species_[0].molecularWeight;
+        return;
+    }
+    // scratch[i] = x_i sqrt(alpha_i), a = scratch^T C scratch
+    b = 0.0;
+    molecularWeight = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        scratch[i] = x[i] * sqrtAlpha(species_[i], T);
+        b += x[i] * species_[i].b;
+        molecularWeight += x[i] * species_[i].molecularWeight;
+    }
+    a = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        const double *row = cross_.data() + i * n;
+        double sum = 0.0;
+        for (size_t j = 0; j < n; ++j) {
+            sum += row[j] * scratch[j];
+        }
+        a += scratch[i] * sum;
+    }
+}
+
+double CubicEos::compressibility(double T, double p, const double *x, CubicRoot root) const {
+    std::vector<double> scratch(species_.size());
+    double a, b, mw;
+    mixture(x, T, scratch.data(), a, b, mw);
+    double RT = kUniversalGasConstant * T;
+    return solveCubicCompressibility(model_, a * p / (RT * RT), b * p / RT, root);
+}
+
+double CubicEos::density(double T, double p, const double *x, CubicRoot root) const {
+    std::vector<double> scratch(species_.size());
+    double a, b, mw;
+    mixture(x, T, scratch.data(), a, b, mw);
+    double RT = kUniversalGasConstant * T;
+    double Z = solveCubicCompressibility(model_, a * p / (RT * RT), b * p / RT, root);
+    return p * mw / (Z * RT);
+}
+
+void CubicEos::density(const double *T, const double *p, const double *x, size_t xStride, double *rho,
+                       size_t count, CubicRoot root) const {
+    std::vector<double> scratch(species_.size());
+    double A[kEosBlock];
+    double B[kEosBlock];
+    double rhoScale[kEosBlock];
+    bool pure = x == nullptr || species_.size() == 1;
+
+    for (size_t begin = 0; begin < count; begin += kEosBlock) {
+        size_t m = std::min(kEosBlock, count - begin);
+        const double *t = T + begin;
+        const double *pressure = p + begin;
+        if (pure) {
+            // 纯组分: 只有开方和乘加, 编译器可以向量化
+            const CubicEosSpecies &s = species_[0];
+            double R = kUniversalGasConstant;
+            if (model_ == CubicEosModel::RedlichKwong) {
+                for (size_t k = 0; k < m; ++k) {
+                    double RT = R * t[k];
+                    double alpha = std::sqrt(s.criticalTemperature / t[k]);
+                    A[k] = s.ac * alpha * pressure[k] / (RT * RT);
+                    B[k] = s.b * pressure[k] / RT;
+                    rhoScale[k] = pressure[k] * s.molecularWeight / RT;
+                }
+            } else {
+                double inverseTc = 1.0 / s.criticalTemperature;
+                for (size_t k = 0; k < m; ++k) {
+                    double RT = R * t[k];
+                    double sa = 1.0 + s.kappa * (1.0 - std::sqrt(t[k] * inverseTc));
+                    A[k] = s.ac * sa * sa * pressure[k] / (RT * RT);
+                    B[k] = s.b * pressure[k] / RT;
+                    rhoScale[k] = pressure[k] * s.molecularWeight / RT;
+                }
+            }
+        } else {
+            for (size_t k = 0; k < m; ++k) {
+                double a, b, mw;
+                mixture(x + (begin + k) * xStride, t[k], scratch.data(), a, b, mw);
+                double RT = kUniversalGasConstant * t[k];
+                A[k] = a * pressure[k] / (RT * RT);
+                B[k] = b * pressure[k] / RT;
+                rhoScale[k] = pressure[k] * mw / RT;
+            }
+        }
+        for (size_t k = 0; k < m; ++k) {
+            rho[begin + k] = rhoScale[k] / solveCubicCompressibility(model_, A[k], B[k], root);
+        }
+    }
+}
+
+} // namespace CFD_MaterialDB
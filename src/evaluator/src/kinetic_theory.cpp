@@ -0,0 +1,210 @@
+#include "kinetic_theory.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "cubic_eos.h"
+#include "property_evaluator.h"
+
+namespace CFD_MaterialDB {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// mu = 2.6693e-6 sqrt(M T) / (sigma^2 Omega22), M 为 kg/kmol, sigma 为 Å
+constexpr double kViscosityConstant = 2.6693e-6;
+
+// D = 1.8583e-7 * 101325 sqrt(T^3 (1/Ma + 1/Mb)) / (p sigma^2 Omega11), p 为 Pa
+constexpr double kDiffusionConstant = 1.8583e-7 * 101325.0;
+
+// Neufeld 关联式的适用范围
+constexpr double kMinReducedTemperature = 0.3;
+constexpr double kMaxReducedTemperature = 100.0;
+
+double neufeldOmega22(double t) {
+    return 1.16145 * std::pow(t, -0.14874) + 0.52487 * std::exp(-0.77320 * t) + 2.16178 * std::exp(-2.43787 * t);
+}
+
+double neufeldOmega11(double t) {
+    return 1.06036 * std::pow(t, -0.15610) + 0.19300 * std::exp(-0.47635 * t) + 1.03587 * std::exp(-1.52996 * t)
+           + 1.76474 * std::exp(-3.89411 * t);
+}
+
+// 以 ln T* 为自变量的等距表; 组分对查表时 ln T* = ln T - ln eps_ij, 每个单元只需算一次 ln T
+struct CollisionTable {
+    static constexpr size_t kPoints = 1024;
+
+    double logMin;
+    double inverseStep;
+    std::array<double, kPoints> omega22;
+    std::array<double, kPoints> omega11;
+
+    CollisionTable() {
+        logMin = std::log(kMinReducedTemperature);
+        double step = (std::log(kMaxReducedTemperature) - logMin) / (kPoints - 1);
+        inverseStep = 1.0 / step;
+        for (size_t i = 0; i < kPoints; ++i) {
+            double t = std::exp(logMin + i * step);
+            omega22[i] = neufeldOmega22(t);
+            omega11[i] = neufeldOmega11(t);
+        }
+    }
+
+    static double lookup(const std::array<double, kPoints> &table, double position) {
+        if (std::isnan(position)) {
+            return kNaN;
+        }
+        position = std::min(std::max(position, 0.0), double(kPoints - 1));
+        size_t i = std::min(static_cast<size_t>(position), kPoints - 2);
+        double w = position - i;
+        return table[i] + w * (table[i + 1] - table[i]);
+    }
+
+    double position(double logReducedTemperature) const {
+        return (logReducedTemperature - logMin) * inverseStep;
+    }
+};
+
+const CollisionTable &collisionTable() {
+    static const CollisionTable table;
+    return table;
+}
+
+} // namespace
+
+bool hasLennardJonesProperties(const Material &material) {
+    if (!material.hasProperty("lennard-jones-length") || !material.hasProperty("lennard-jones-energy")
+        || !material.hasProperty("molecular-weight")) {
+        return false;
+    }
+    // 部分组分的 SCM 数据以 0 占位
+    try {
+        lennardJonesSpeciesFromMaterial(material);
+        return true;
+    } catch (const std::exception &) {
+        return false;
+    }
+}
+
+LennardJonesSpecies lennardJonesSpeciesFromMaterial(const Material &material) {
+    LennardJonesSpecies species;
+    species.name = material.name;
+    species.sigma = constantPropertyValue(material, "lennard-jones-length");
+    species.epsilonOverK = constantPropertyValue(material, "lennard-jones-energy");
+    species.molecularWeight = constantPropertyValue(material, "molecular-weight");
+    if (!(species.sigma > 0.0) || !(species.epsilonOverK > 0.0) || !(species.molecularWeight > 0.0)) {
+        throw std::runtime_error("Lennard-Jones 参数无效: " + material.name);
+    }
+    return species;
+}
+
+double collisionIntegral22(double reducedTemperature) {
+    const auto &table = collisionTable();
+    return CollisionTable::lookup(table.omega22, table.position(std::log(reducedTemperature)));
+}
+
+double collisionIntegral11(double reducedTemperature) {
+    const auto &table = collisionTable();
+    return CollisionTable::lookup(table.omega11, table.position(std::log(reducedTemperature)));
+}
+
+double chapmanEnskogViscosity(const LennardJonesSpecies &species, double T) {
+    return kViscosityConstant * std::sqrt(species.molecularWeight * T)
+           / (species.sigma * species.sigma * collisionIntegral22(T / species.epsilonOverK));
+}
+
+double euckenConductivity(double viscosity, double cp, double molecularWeight) {
+    return viscosity * (cp + 1.25 * kUniversalGasConstant / molecularWeight);
+}
+
+double binaryDiffusionCoefficient(const LennardJonesSpecies &a, const LennardJonesSpecies &b, double T, double p) {
+    double sigma = 0.5 * (a.sigma + b.sigma);
+    double epsilon = std::sqrt(a.epsilonOverK * b.epsilonOverK);
+    return kDiffusionConstant * std::sqrt(T * T * T * (1.0 / a.molecularWeight + 1.0 / b.molecularWeight))
+           / (p * sigma * sigma * collisionIntegral11(T / epsilon));
+}
+
+KineticTransport::KineticTransport(std::vector<LennardJonesSpecies> species) : species_(std::move(species)) {
+    size_t n = species_.size();
+    if (n == 0) {
+        throw std::runtime_error("输运计算至少需要一个组分");
+    }
+    viscosityFactor_.resize(n);
+    pairs_.resize(n * n);
+    for (size_t i = 0; i < n; ++i) {
+        const auto &a = species_[i];
+        if (!(a.sigma > 0.0) || !(a.epsilonOverK > 0.0) || !(a.molecularWeight > 0.0)) {
+            throw std::runtime_error("Lennard-Jones 参数无效: " + a.name);
+        }
+        viscosityFactor_[i] = kViscosityConstant * std::sqrt(a.molecularWeight) / (a.sigma * a.sigma);
+        for (size_t j = 0; j < n; ++j) {
+            const auto &b = species_[j];
+            double sigma = 0.5 * (a.sigma + b.sigma);
+            double factor = kDiffusionConstant * std::sqrt(1.0 / a.molecularWeight + 1.0 / b.molecularWeight)
+                            / (sigma * sigma);
+            pairs_[i * n + j] = {std::log(std::sqrt(a.epsilonOverK * b.epsilonOverK)), 1.0 / factor};
+        }
+    }
+}
+
+void KineticTransport::viscosities(double T, double *mu) const {
+    const auto &table = collisionTable();
+    double logT = std::log(T);
+    double sqrtT = std::sqrt(T);
+    size_t n = species_.size();
+    for (size_t i = 0; i < n; ++i) {
+        double omega = CollisionTable::lookup(table.omega22, table.position(logT - pairs_[i * n + i].logEpsilon));
+        mu[i] = viscosityFactor_[i] * sqrtT / omega;
+    }
+}
+
+double KineticTransport::binaryDiffusion(size_t i, size_t j, double T, double p) const {
+    const auto &table = collisionTable();
+    const auto &pair = pairs_[i * species_.size() + j];
+    double omega = CollisionTable::lookup(table.omega11, table.position(std::log(T) - pair.logEpsilon));
+    return T * std::sqrt(T) / (pair.inverseFactor * p * omega);
+}
+
+void KineticTransport::accumulate(double T, double p, const double *x, double *Dm, double *sums) const {
+    const auto &table = collisionTable();
+    size_t n = species_.size();
+    double logT = std::log(T);
+    double scale = p / (T * std::sqrt(T));
+    double massTotal = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        sums[i] = 0.0;
+        massTotal += x[i] * species_[i].molecularWeight;
+    }
+    // 只遍历上三角, 每个组分对的 1/D_ij 同时累加到两侧
+    for (size_t i = 0; i < n; ++i) {
+        const PairCoefficients *row = pairs_.data() + i * n;
+        for (size_t j = i + 1; j < n; ++j) {
+            double omega = CollisionTable::lookup(table.omega11, table.position(logT - row[j].logEpsilon));
+            double inverseD = row[j].inverseFactor * scale * omega;
+            sums[i] += x[j] * inverseD;
+            sums[j] += x[i] * inverseD;
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        double massFraction = massTotal > 0.0 ? x[i] * species_[i].molecularWeight / massTotal : 0.0;
+        Dm[i] = sums[i] > 0.0 ? (1.0 - massFraction) / sums[i] : binaryDiffusion(i, i, T, p);
+    }
+}
+
+void KineticTransport::mixtureAveragedDiffusivities(double T, double p, const double *x, double *Dm) const {
+    std::vector<double> sums(species_.size());
+    accumulate(T, p, x, Dm, sums.data());
+}
+
+void KineticTransport::mixtureAveragedDiffusivities(const double *T, const double *p, const double *x, double *Dm,
+                                                    size_t cells) const {
+    size_t n = species_.size();
+    std::vector<double> sums(n);
+    for (size_t c = 0; c < cells; ++c) {
+        accumulate(T[c], p[c], x + c * n, Dm + c * n, sums.data());
+    }
+}
+
+} // namespace CFD_MaterialDB
@@ -0,0 +1,322 @@
+#include "polynomial_kernels.h"
+#include <algorithm>
+#include <limits>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define MATERIALDB_AVX2 1
+#endif
+
+namespace CFD_MaterialDB {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+inline size_t bucketOf(const PiecewiseLinearView &data, double T) {
+    double offset = (T - data.temps[0]) * data.bucketScale;
+    return std::min(static_cast<size_t>(offset > 0.0 ? offset : 0.0), data.bucketCount - 1);
+}
+
+// 点数少于 kPiecewiseLinearIndexPoints 时没有分桶, 直接顺序比较
+inline size_t linearSegment(const PiecewiseLinearView &data, double T) {
+    const double *t = data.temps;
+    size_t last = data.points - 2;
+    if (data.bucketCount == 0) {
+        return findSegment(t, data.points - 1, T);
+    }
+    size_t i = data.buckets[bucketOf(data, T)];
+    while (i < last && T >= t[i + 1]) {
+        ++i;
+    }
+    return i;
+}
+
+#ifdef MATERIALDB_AVX2
+static_assert(kNasa9Stride == 8, "段偏移按左移 3 位计算");
+static_assert(kPiecewisePolyStride == 16, "段偏移按左移 4 位计算");
+
+inline __m256i segmentIndices(const double *bounds, size_t segments, __m256d t) {
+    __m256i index = _mm256_setzero_si256();
+    for (size_t k = 1; k < segments; ++k) {
+        // 比较结果为全 1 (即 -1), 相减等于计数加一
+        __m256d ge = _mm256_cmp_pd(t, _mm256_set1_pd(bounds[k]), _CMP_GE_OQ);
+        index = _mm256_sub_epi64(index, _mm256_castpd_si256(ge));
+    }
+    return index;
+}
+
+// 4 个温度所在段的系数偏移 (以 double 计)
+inline __m256i nasa9Offsets(const double *bounds, size_t segments, __m256d t) {
+    return _mm256_slli_epi64(segmentIndices(bounds, segments, t), 3);
+}
+
+inline bool sameLane(__m256i offsets) {
+    __m256i first = _mm256_permute4x64_epi64(offsets, 0);
+    return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(offsets, first))) == 0xF;
+}
+
+template<typename Load>
+inline __m256d piecewiseKernel(__m256d t, Load coefficient) {
+    __m256d value = coefficient(2 + kPiecewisePolyMaxCoefficients - 1);
+    for (int j = kPiecewisePolyMaxCoefficients - 2; j >= 0; --j) {
+        value = _mm256_fmadd_pd(value, t, coefficient(2 + j));
+    }
+    return value;
+}
+
+template<typename Load>
+inline __m256d piecewiseKernel(__m256d t, Load coefficient, __m256d &derivative) {
+    __m256d value = coefficient(2 + kPiecewisePolyMaxCoefficients - 1);
+    derivative = _mm256_setzero_pd();
+    for (int j = kPiecewisePolyMaxCoefficients - 2; j >= 0; --j) {
+        derivative = _mm256_fmadd_pd(derivative, t, value);
+        value = _mm256_fmadd_pd(value, t, coefficient(2 + j));
+    }
+    return value;
+}
+
+template<typename Load>
+inline __m256d nasa9Kernel(__m256d t, Load coefficient) {
+    __m256d inv = _mm256_div_pd(_mm256_set1_pd(1.0), t);
+    __m256d poly = coefficient(6);
+    poly = _mm256_fmadd_pd(poly, t, coefficient(5));
+    poly = _mm256_fmadd_pd(poly, t, coefficient(4));
+    poly = _mm256_fmadd_pd(poly, t, coefficient(3));
+    poly = _mm256_fmadd_pd(poly, t, coefficient(2));
+    __m256d low = _mm256_fmadd_pd(coefficient(0), inv, coefficient(1));
+    return _mm256_fmadd_pd(low, inv, poly);
+}
+
+template<typename Load>
+inline __m256d nasa9Kernel(__m256d t, Load coefficient, __m256d &derivative) {
+    __m256d inv = _mm256_div_pd(_mm256_set1_pd(1.0), t);
+    __m256d poly = coefficient(6);
+    __m256d dpoly = _mm256_setzero_pd();
+    for (int j = 5; j >= 2; --j) {
+        dpoly = _mm256_fmadd_pd(dpoly, t, poly);
+        poly = _mm256_fmadd_pd(poly, t, coefficient(j));
+    }
+    __m256d a0 = coefficient(0);
+    __m256d a1 = coefficient(1);
+    __m256d dlow = _mm256_fmadd_pd(_mm256_add_pd(a0, a0), inv, a1);
+    derivative = _mm256_fnmadd_pd(dlow, _mm256_mul_pd(inv, inv), dpoly);
+    return _mm256_fmadd_pd(_mm256_fmadd_pd(a0, inv, a1), inv, poly);
+}
+#endif
+
+} // namespace
+
+double evaluatePiecewiseLinear(const PiecewiseLinearView &data, double T) {
+    if (data.points < 2) {
+        return kNaN;
+    }
+    return linearValue(data, linearSegment(data, T), T);
+}
+
+double evaluatePiecewiseLinear(const PiecewiseLinearView &data, double T, double *dvdT) {
+    if (data.points < 2) {
+        *dvdT = kNaN;
+        return kNaN;
+    }
+    size_t i = linearSegment(data, T);
+    *dvdT = linearDerivative(data, i, T);
+    return linearValue(data, i, T);
+}
+
+void evaluatePiecewiseLinear(const PiecewiseLinearView &data, const double *T, double *out, size_t count) {
+    evaluatePiecewiseLinear(data, T, out, nullptr, count);
+}
+
+void evaluatePiecewiseLinear(const PiecewiseLinearView &data, const double *T, double *out, double *dvdT,
+                             size_t count) {
+    if (data.points < 2) {
+        for (size_t k = 0; k < count; ++k) {
+            out[k] = kNaN;
+            if (dvdT) {
+                dvdT[k] = kNaN;
+            }
+        }
+        return;
+    }
+    const double *t = data.temps;
+    size_t last = data.points - 2;
+    size_t i = 0;
+    for (size_t k = 0; k < count; ++k) {
+        double x = T[k];
+        if (x < t[i] || (i + 1 < last && x >= t[i + 2])) {
+            i = linearSegment(data, x);
+        } else if (i < last && x >= t[i + 1]) {
+            ++i;
+        }
+        out[k] = linearValue(data, i, x);
+        if (dvdT) {
+            dvdT[k] = linearDerivative(data, i, x);
+        }
+    }
+}
+
+double evaluatePiecewisePolynomial(const SegmentedView &data, double T) {
+    size_t segments = data.segments;
+    if (segments == 0) {
+        return kNaN;
+    }
+    return piecewiseSegment(data.blocks + findSegment(data.bounds, segments, T) * kPiecewisePolyStride, T);
+}
+
+void evaluatePiecewisePolynomial(const SegmentedView &data, const double *T, double *out, size_t count) {
+    size_t segments = data.segments;
+    if (segments == 0) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = kNaN;
+        }
+        return;
+    }
+    const double *bounds = data.bounds;
+    size_t i = 0;
+#ifdef MATERIALDB_AVX2
+    const double *c = data.blocks;
+    for (; i + 4 <= count; i += 4) {
+        __m256d t = _mm256_loadu_pd(T + i);
+        __m256i offsets = _mm256_slli_epi64(segmentIndices(bounds, segments, t), 4);
+        __m256d value;
+        if (sameLane(offsets)) {
+            const double *segment = c + _mm256_extract_epi64(offsets, 0);
+            value = piecewiseKernel(t, [segment](int j) { return _mm256_broadcast_sd(segment + j); });
+        } else {
+            value = piecewiseKernel(t, [c, offsets](int j) { return _mm256_i64gather_pd(c + j, offsets, 8); });
+        }
+        _mm256_storeu_pd(out + i, value);
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = piecewiseSegment(data.blocks + findSegment(bounds, segments, T[i]) * kPiecewisePolyStride, T[i]);
+    }
+}
+
+double evaluatePiecewisePolynomial(const SegmentedView &data, double T, double *dvdT) {
+    size_t segments = data.segments;
+    if (segments == 0) {
+        *dvdT = kNaN;
+        return kNaN;
+    }
+    return piecewiseSegment(data.blocks + findSegment(data.bounds, segments, T) * kPiecewisePolyStride, T, *dvdT);
+}
+
+void evaluatePiecewisePolynomial(const SegmentedView &data, const double *T, double *out, double *dvdT,
+                                 size_t count) {
+    size_t segments = data.segments;
+    if (segments == 0) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = kNaN;
+            dvdT[i] = kNaN;
+        }
+        return;
+    }
+    const double *bounds = data.bounds;
+    size_t i = 0;
+#ifdef MATERIALDB_AVX2
+    const double *c = data.blocks;
+    for (; i + 4 <= count; i += 4) {
+        __m256d t = _mm256_loadu_pd(T + i);
+        __m256i offsets = _mm256_slli_epi64(segmentIndices(bounds, segments, t), 4);
+        __m256d value, derivative;
+        if (sameLane(offsets)) {
+            const double *segment = c + _mm256_extract_epi64(offsets, 0);
+            value = piecewiseKernel(t, [segment](int j) { return _mm256_broadcast_sd(segment + j); }, derivative);
+        } else {
+            value = piecewiseKernel(t, [c, offsets](int j) { return _mm256_i64gather_pd(c + j, offsets, 8); },
+                                    derivative);
+        }
+        _mm256_storeu_pd(out + i, value);
+        _mm256_storeu_pd(dvdT + i, derivative);
+    }
+#endif
+    for (; i < count; ++i) {
+        const double *segment = data.blocks + findSegment(bounds, segments, T[i]) * kPiecewisePolyStride;
+        out[i] = piecewiseSegment(segment, T[i], dvdT[i]);
+    }
+}
+
+double evaluateNasa9(const SegmentedView &data, double T) {
+    size_t segments = data.segments;
+    if (segments == 0) {
+        return kNaN;
+    }
+    return nasa9Segment(data.blocks + findSegment(data.bounds, segments, T) * kNasa9Stride, T);
+}
+
+void evaluateNasa9(const SegmentedView &data, const double *T, double *out, size_t count) {
+    size_t segments = data.segments;
+    if (segments == 0) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = kNaN;
+        }
+        return;
+    }
+    const double *bounds = data.bounds;
+    size_t i = 0;
+#ifdef MATERIALDB_AVX2
+    const double *c = data.blocks;
+    for (; i + 4 <= count; i += 4) {
+        __m256d t = _mm256_loadu_pd(T + i);
+        __m256i offsets = nasa9Offsets(bounds, segments, t);
+        __m256d value;
+        if (sameLane(offsets)) {
+            // 温度通常按顺序给出, 4 个值落在同一段时直接广播系数, 避免 gather
+            const double *a = c + _mm256_extract_epi64(offsets, 0);
+            value = nasa9Kernel(t, [a](int j) { return _mm256_broadcast_sd(a + j); });
+        } else {
+            value = nasa9Kernel(t, [c, offsets](int j) { return _mm256_i64gather_pd(c + j, offsets, 8); });
+        }
+        _mm256_storeu_pd(out + i, value);
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = nasa9Segment(data.blocks + findSegment(bounds, segments, T[i]) * kNasa9Stride, T[i]);
+    }
+}
+
+double evaluateNasa9(const SegmentedView &data, double T, double *dvdT) {
+    size_t segments = data.segments;
+    if (segments == 0) {
+        *dvdT = kNaN;
+        return kNaN;
+    }
+    return nasa9Segment(data.blocks + findSegment(data.bounds, segments, T) * kNasa9Stride, T, *dvdT);
+}
+
+void evaluateNasa9(const SegmentedView &data, const double *T, double *out, double *dvdT, size_t count) {
+    size_t segments = data.segments;
+    if (segments == 0) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = kNaN;
+            dvdT[i] = kNaN;
+        }
+        return;
+    }
+    const double *bounds = data.bounds;
+    size_t i = 0;
+#ifdef MATERIALDB_AVX2
+    const double *c = data.blocks;
+    for (; i + 4 <= count; i += 4) {
+        __m256d t = _mm256_loadu_pd(T + i);
+        __m256i offsets = nasa9Offsets(bounds, segments, t);
+        __m256d value, derivative;
+        if (sameLane(offsets)) {
+            const double *a = c + _mm256_extract_epi64(offsets, 0);
+            value = nasa9Kernel(t, [a](int j) { return _mm256_broadcast_sd(a + j); }, derivative);
+        } else {
+            value = nasa9Kernel(t, [c, offsets](int j) { return _mm256_i64gather_pd(c + j, offsets, 8); },
+                                derivative);
+        }
+        _mm256_storeu_pd(out + i, value);
+        _mm256_storeu_pd(dvdT + i, derivative);
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = nasa9Segment(data.blocks + findSegment(bounds, segments, T[i]) * kNasa9Stride, T[i], dvdT[i]);
+    }
+}
+
+} // namespace CFD_MaterialDB
@@ -0,0 +1,435 @@
+#include "property_evaluator.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include "coefficient_laws.h"
+#include "metrics.h"
+#include "polynomial_kernels.h"
+#include "property_expression.h"
+#include "viscosity_kernels.h"
+
+namespace CFD_MaterialDB {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// 每段温度区间内的采样点数 (含两个端点)
+constexpr int kSamplesPerTile = 17;
+
+double horner(const std::vector<double> &c, double T) {
+    double value = 0.0;
+    for (auto it = c.rbegin(); it != c.rend(); ++it) {
+        value = value * T + *it;
+    }
+    return value;
+}
+
+double evaluateUserDefined(const UserDefinedData &data, double T, double p) {
+    if (data.program) {
+        return data.program->evaluate(T, p);
+    }
+    // 未预先编译 (例如刚从 JSON 读出) 时临时编译, 每次调用都要付出编译开销
+    try {
+        return compileSchemeLambda(data.source).evaluate(T, p);
+    } catch (const std::exception &) {
+        return kNaN;
+    }
+}
+
+Dual evaluateUserDefinedDual(const UserDefinedData &data, double T, double p) {
+    if (data.program) {
+        return data.program->evaluateDual(T, p);
+    }
+    try {
+        return compileSchemeLambda(data.source).evaluateDual(T, p);
+    } catch (const std::exception &) {
+        return {kNaN, kNaN, kNaN};
+    }
+}
+
+// 多项式的值与导数在同一遍 Horner 中累积
+Dual hornerDual(const std::vector<double> &c, double T) {
+    double value = 0.0;
+    double derivative = 0.0;
+    for (auto it = c.rbegin(); it != c.rend(); ++it) {
+        derivative = derivative * T + value;
+        value = value * T + *it;
+    }
+    return {value, derivative, 0.0};
+}
+
+bool sampleTile(const MaterialProperty &prop, double t_min, double t_max, PropertyRangeTile &tile) {
+    tile.t_min = t_min;
+    tile.t_max = t_max;
+    tile.v_min = std::numeric_limits<double>::infinity();
+    tile.v_max = -std::numeric_limits<double>::infinity();
+    for (int i = 0; i < kSamplesPerTile; ++i) {
+        double T = t_min + (t_max - t_min) * i / (kSamplesPerTile - 1);
+        double value = evaluateProperty(prop, T);
+        if (!std::isfinite(value)) {
+            return false;
+        }
+        tile.v_min = std::min(tile.v_min, value);
+        tile.v_max = std::max(tile.v_max, value);
+    }
+    // 采样可能漏掉段内极值, 按跨度留出余量; 余量是经验值, 不保证包住真实极值
+    double pad = 0.05 * (tile.v_max - tile.v_min)
+                 + 1e-9 * std::max(std::abs(tile.v_min), std::abs(tile.v_max));
+    tile.v_min -= pad;
+    tile.v_max += pad;
+    return true;
+}
+
+// 按系数类型统计求值点数, mode 区分只求值 (value) 与连同导数求值 (derivatives); 批量接口按点数累加
+Counter &evaluationCounter(coefficientType type, bool derivatives) {
+    static const auto counters = [] {
+        std::vector<Counter *> list[2];
+        for (int mode = 0; mode < 2; ++mode) {
+            for (int t = NONET; t <= userDefinedT; ++t) {
+                nlohmann::json name = static_cast<coefficientType>(t);
+                list[mode].push_back(&MetricsRegistry::global().counter(
+                        "material_db_property_evaluations_total", "按系数类型统计的物性求值点数",
+                        {{"type", name.is_string() ? name.get<std::string>() : "none"},
+                         {"mode", mode ? "derivatives" : "value"}}));
+            }
+        }
+        return std::make_pair(list[0], list[1]);
+    }();
+    const auto &list = derivatives ? counters.second : counters.first;
+    return *list[static_cast<size_t>(type) < list.size() ? type : NONET];
+}
+
+} // namespace
+
+double evaluateCompressibleLiquid(const compressibleLiquidData &data, double p, double *drhodp) {
+    double rho;
+    evaluateCompressibleLiquid(data, &p, &rho, drhodp, 1);
+    return rho;
+}
+
+void evaluateCompressibleLiquid(const compressibleLiquidData &data, const double *p, double *rho, double *drhodp,
+                                size_t count) {
+    if (!data.valid()) {
+        std::fill(rho, rho + count, kNaN);
+        if (drhodp != nullptr) {
+            std::fill(drhodp, drhodp + count, kNaN);
+        }
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        double derivative;
+        rho[i] = compressibleLiquidDensity(data, p[i], derivative);
+        if (drhodp != nullptr) {
+            drhodp[i] = derivative;
+        }
+    }
+}
+
+namespace {
+
+double evaluateUncounted(const MaterialProperty &prop, double T, double p) {
+    switch (prop.coeffType) {
+        case CONSTCOEFF:
+            return prop.constData;
+        case polynomialT:
+            return horner(prop.polydata.coefficients, T);
+        case polynomialTPieceLinearT:
+            return evaluatePiecewiseLinear(prop.ppldata, T);
+        case polynomialTPiecePolyT:
+            return evaluatePiecewisePolynomial(prop.pwpolydata, T);
+        case compressibleT:
+            // 早期版本写入数据库的参数存放在 polydata 中
+            return evaluateCompressibleLiquid(prop.compLiquidData.valid()
+                                              ? prop.compLiquidData
+                                              : compressibleLiquidData::fromCoefficients(prop.polydata.coefficients),
+                                              p);
+        // 早期版本写入数据库的 sutherland/power-law/blottner 参数存放在 polydata 中
+        case sutherlandT:
+            return evaluateSutherland(prop.polydata.coefficients.empty()
+                                      ? prop.sutherlanddata
+                                      : sutherlandData::fromCoefficients(prop.polydata.coefficients), T);
+        case powerLawT:
+            return evaluatePowerLaw(prop.polydata.coefficients.empty()
+                                    ? prop.powerlawdata
+                                    : powerLawData::fromCoefficients(prop.polydata.coefficients), T);
+        case blottnerT:
+            return evaluateBlottner(prop.polydata.coefficients.empty()
+                                    ? prop.blottnerdata
+                                    : blottnerData::fromCoefficients(prop.polydata.coefficients), T);
+        case nasa9PiecePolyT:
+            return evaluateNasa9(prop.nasapolydata, T);
+        case userDefinedT:
+            return evaluateUserDefined(prop.userdata, T, p);
+        default:
+            return kNaN;
+    }
+}
+
+Dual evaluateDerivativesUncounted(const MaterialProperty &prop, double T, double p) {
+    Dual result;
+    switch (prop.coeffType) {
+        case CONSTCOEFF:
+            return dualConstant(prop.constData);
+        case polynomialT:
+            return hornerDual(prop.polydata.coefficients, T);
+        case polynomialTPieceLinearT:
+            result.value = evaluatePiecewiseLinear(prop.ppldata, T, &result.dT);
+            return result;
+        case polynomialTPiecePolyT:
+            result.value = evaluatePiecewisePolynomial(prop.pwpolydata, T, &result.dT);
+            return result;
+        case compressibleT:
+            result.value = evaluateCompressibleLiquid(prop.compLiquidData.valid()
+                                                      ? prop.compLiquidData
+                                                      : compressibleLiquidData::fromCoefficients(
+                                                              prop.polydata.coefficients),
+                                                      p, &result.dp);
+            return result;
+        case sutherlandT:
+            result.value = evaluateSutherland(prop.polydata.coefficients.empty()
+                                              ? prop.sutherlanddata
+                                              : sutherlandData::fromCoefficients(prop.polydata.coefficients),
+                                              T, &result.dT);
+            return result;
+        case powerLawT:
+            result.value = evaluatePowerLaw(prop.polydata.coefficients.empty()
+                                            ? prop.powerlawdata
+                                            : powerLawData::fromCoefficients(prop.polydata.coefficients),
+                                            T, &result.dT);
+            return result;
+        case blottnerT:
+            result.value = evaluateBlottner(prop.polydata.coefficients.empty()
+                                            ? prop.blottnerdata
+                                            : blottnerData::fromCoefficients(prop.polydata.coefficients),
+                                            T, &result.dT);
+            return result;
+        case nasa9PiecePolyT:
+            result.value = evaluateNasa9(prop.nasapolydata, T, &result.dT);
+            return result;
+        case userDefinedT:
+            return evaluateUserDefinedDual(prop.userdata, T, p);
+        default:
+            return {kNaN, kNaN, kNaN};
+    }
+}
+
+} // namespace
+
+double evaluateProperty(const MaterialProperty &prop, double T, double p) {
+    evaluationCounter(prop.coeffType, false).add();
+    return evaluateUncounted(prop, T, p);
+}
+
+void evaluateProperty(const MaterialProperty &prop, const double *T, double *out, size_t count, double p) {
+    evaluationCounter(prop.coeffType, false).add(count);
+    switch (prop.coeffType) {
+        case polynomialTPieceLinearT:
+            evaluatePiecewiseLinear(prop.ppldata, T, out, count);
+            return;
+        case polynomialTPiecePolyT:
+            evaluatePiecewisePolynomial(prop.pwpolydata, T, out, count);
+            return;
+        case nasa9PiecePolyT:
+            evaluateNasa9(prop.nasapolydata, T, out, count);
+            return;
+        case sutherlandT:
+            if (prop.polydata.coefficients.empty()) {
+                evaluateSutherland(prop.sutherlanddata, T, out, count);
+                return;
+            }
+            break;
+        case powerLawT:
+            if (prop.polydata.coefficients.empty()) {
+                evaluatePowerLaw(prop.powerlawdata, T, out, count);
+                return;
+            }
+            break;
+        case blottnerT:
+            if (prop.polydata.coefficients.empty()) {
+                evaluateBlottner(prop.blottnerdata, T, out, count);
+                return;
+            }
+            break;
+        case userDefinedT:
+            if (prop.userdata.program) {
+                prop.userdata.program->evaluate(T, nullptr, p, out, count);
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = evaluateUncounted(prop, T[i], p);
+    }
+}
+
+Dual evaluatePropertyDerivatives(const MaterialProperty &prop, double T, double p) {
+    evaluationCounter(prop.coeffType, true).add();
+    return evaluateDerivativesUncounted(prop, T, p);
+}
+
+void evaluatePropertyDerivatives(const MaterialProperty &prop, const double *T, double *value, double *dvdT,
+                                 double *dvdp, size_t count, double p) {
+    evaluationCounter(prop.coeffType, true).add(count);
+    // 有批量内核的类型都与压力无关, dv/dp 为 0; 其余类型逐点求值
+    bool batched = true;
+    switch (prop.coeffType) {
+        case polynomialTPieceLinearT:
+            evaluatePiecewiseLinear(prop.ppldata, T, value, dvdT, count);
+            break;
+        case polynomialTPiecePolyT:
+            evaluatePiecewisePolynomial(prop.pwpolydata, T, value, dvdT, count);
+            break;
+        case nasa9PiecePolyT:
+            evaluateNasa9(prop.nasapolydata, T, value, dvdT, count);
+            break;
+        case sutherlandT:
+            if (!prop.polydata.coefficients.empty()) {
+                batched = false;
+                break;
+            }
+            evaluateSutherland(prop.sutherlanddata, T, value, dvdT, count);
+            break;
+        case powerLawT:
+            if (!prop.polydata.coefficients.empty()) {
+                batched = false;
+                break;
+            }
+            evaluatePowerLaw(prop.powerlawdata, T, value, dvdT, count);
+            break;
+        case blottnerT:
+            if (!prop.polydata.coefficients.empty()) {
+                batched = false;
+                break;
+            }
+            evaluateBlottner(prop.blottnerdata, T, value, dvdT, count);
+            break;
+        case userDefinedT:
+            if (prop.userdata.program) {
+                prop.userdata.program->evaluateDual(T, nullptr, p, value, dvdT, dvdp, count);
+                return;
+            }
+            batched = false;
+            break;
+        default:
+            batched = false;
+            break;
+    }
+    if (batched) {
+        if (dvdp) {
+            std::fill(dvdp, dvdp + count, 0.0);
+        }
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        Dual result = evaluateDerivativesUncounted(prop, T[i], p);
+        value[i] = result.value;
+        dvdT[i] = result.dT;
+        if (dvdp) {
+            dvdp[i] = result.dp;
+        }
+    }
+}
+
+double constantPropertyValue(const Material &material, const std::string &key) {
+    if (!material.hasProperty(key) || material.getProperty(key).empty()) {
+        throw std::runtime_error(material.name + " 缺少 " + key);
+    }
+    double value = evaluateProperty(material.getProperty(key).front(), 298.15);
+    if (!std::isfinite(value)) {
+        throw std::runtime_error(material.name + " 的 " + key + " 无法求值");
+    }
+    return value;
+}
+
+void compileUserDefinedProperties(Material &material) {
+    for (auto &entry: material.properties) {
+        for (auto &prop: entry.second) {
+            if (prop.coeffType != userDefinedT || prop.userdata.program) {
+                continue;
+            }
+            try {
+                prop.userdata.program = std::make_shared<const ExpressionProgram>(
+                        compileSchemeLambda(prop.userdata.source));
+            } catch (const std::exception &e) {
+                std::cerr << "编译用户自定义物性失败 (" << material.name << " " << entry.first << "): "
+                          << e.what() << std::endl;
+            }
+        }
+    }
+}
+
+void propertyTemperatureRange(const MaterialProperty &prop, double &t_min, double &t_max) {
+    t_min = kDefaultMinTemperature;
+    t_max = kDefaultMaxTemperature;
+    const std::vector<double> *temps = nullptr;
+    if (prop.coeffType == polynomialTPieceLinearT) {
+        temps = &prop.ppldata.temp_ranges;
+    } else if (prop.coeffType == polynomialTPiecePolyT) {
+        temps = &prop.pwpolydata.temp_ranges;
+    } else if (prop.coeffType == nasa9PiecePolyT) {
+        temps = &prop.nasapolydata.temp_ranges;
+    }
+    // 温度节点必须递增, 否则视为没有范围信息
+    if (temps && temps->size() >= 2 && std::is_sorted(temps->begin(), temps->end())
+        && temps->front() < temps->back()) {
+        t_min = temps->front();
+        t_max = temps->back();
+    }
+}
+
+std::vector<PropertyRangeTile> summarizePropertyRange(const MaterialProperty &prop) {
+    std::vector<PropertyRangeTile> tiles;
+    double t_min, t_max;
+    propertyTemperatureRange(prop, t_min, t_max);
+
+    if (prop.coeffType == CONSTCOEFF || prop.coeffType == compressibleT) {
+        double value = evaluateProperty(prop, t_min);
+        if (std::isfinite(value)) {
+            tiles.push_back({t_min, t_max, value, value});
+        }
+        return tiles;
+    }
+
+    if (prop.coeffType == polynomialTPieceLinearT) {
+        // 线性插值的极值只出现在节点上, 每段直接取节点值
+        const auto &t = prop.ppldata.temp_ranges;
+        const auto &v = prop.ppldata.coefficients;
+        if (t.size() < 2 || t.size() != v.size() || !std::is_sorted(t.begin(), t.end())) {
+            return tiles;
+        }
+        size_t intervals = t.size() - 1;
+        size_t per_tile = (intervals + kMaxRangeTiles - 1) / kMaxRangeTiles;
+        for (size_t begin = 0; begin < intervals; begin += per_tile) {
+            size_t end = std::min(begin + per_tile, intervals);
+            auto range = std::minmax_element(v.begin() + begin, v.begin() + end + 1);
+            tiles.push_back({t[begin], t[end], *range.first, *range.second});
+        }
+        return tiles;
+    }
+
+    // 光滑函数: 宽范围按几何间隔切分, 其余按等间隔切分
+    const int count = 16;
+    bool geometric = t_min > 0.0 && t_max / t_min > 10.0;
+    double previous = t_min;
+    for (int i = 1; i <= count; ++i) {
+        double next = geometric ? t_min * std::pow(t_max / t_min, double(i) / count)
+                                : t_min + (t_max - t_min) * i / count;
+        if (i == count) {
+            next = t_max;
+        }
+        PropertyRangeTile tile;
+        if (!sampleTile(prop, previous, next, tile)) {
+            tiles.clear();
+            return tiles;
+        }
+        tiles.push_back(tile);
+        previous = next;
+    }
+    return tiles;
+}
+
+} // namespace CFD_MaterialDB
@@ -0,0 +1,647 @@
+#include "property_expression.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
+#include "scheme-private.h"
+
+namespace CFD_MaterialDB {
+
+namespace {
+
+// tinyscheme 读出的 S 表达式, 转换成 C++ 结构后再编译, 不必关心解释器的垃圾回收
+struct SExpr {
+    enum Kind { Number, Boolean, Symbol, List } kind = List;
+    double number = 0.0;
+    bool boolean = false;
+    std::string symbol;
+    std::vector<SExpr> items;
+};
+
+std::string describe(const SExpr &expr) {
+    switch (expr.kind) {
+        case SExpr::Number:
+            return std::to_string(expr.number);
+        case SExpr::Boolean:
+            return expr.boolean ? "#t" : "#f";
+        case SExpr::Symbol:
+            return expr.symbol;
+        case SExpr::List:
+            break;
+    }
+    std::string text = "(";
+    for (size_t i = 0; i < expr.items.size(); ++i) {
+        text += (i ? " " : "") + describe(expr.items[i]);
+    }
+    return text + ")";
+}
+
+SExpr convertCell(scheme *sc, pointer cell) {
+    SExpr expr;
+    if (cell == sc->NIL) {
+        return expr;
+    }
+    if (cell == sc->T || cell == sc->F) {
+        expr.kind = SExpr::Boolean;
+        expr.boolean = cell == sc->T;
+        return expr;
+    }
+    if (is_number(cell)) {
+        expr.kind = SExpr::Number;
+        expr.number = rvalue(cell);
+        return expr;
+    }
+    if (is_symbol(cell)) {
+        expr.kind = SExpr::Symbol;
+        expr.symbol = symname(cell);
+        return expr;
+    }
+    if (is_pair(cell)) {
+        for (; is_pair(cell); cell = pair_cdr(cell)) {
+            expr.items.push_back(convertCell(sc, pair_car(cell)));
+        }
+        if (cell != sc->NIL) {
+            throw std::runtime_error("表达式中不支持点对");
+        }
+        return expr;
+    }
+    throw std::runtime_error("表达式中不支持字符串, 字符或向量");
+}
+
+// 用 tinyscheme 的读取器解析源码. 解释器实例全局共享, 编译只在载入时发生, 用互斥锁串行化
+SExpr readExpression(const std::string &source) {
+    static std::mutex mutex;
+    static scheme *sc = nullptr;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!sc) {
+        sc = scheme_init_new();
+        if (!sc) {
+            throw std::runtime_error("初始化 tinyscheme 失败");
+        }
+    }
+
+    // 错误信息写入字符串端口而不是标准输出
+    char errors[512] = {0};
+    scheme_set_output_port_string(sc, errors, errors + sizeof(errors) - 1);
+    // 源码末尾可能是注释, 闭括号另起一行
+    std::string command = "(quote " + source + "\n)";
+    sc->retcode = 0;
+    scheme_load_string(sc, command.c_str());
+    if (sc->retcode != 0) {
+        throw std::runtime_error("无法读取表达式 " + source + ": " + errors);
+    }
+    if (sc->value == sc->EOF_OBJ) {
+        throw std::runtime_error("表达式括号不匹配: " + source);
+    }
+    return convertCell(sc, sc->value);
+}
+
+enum class ValueKind { Number, Boolean };
+
+struct Fragment {
+    std::vector<ExpressionInstruction> code;
+    ValueKind kind = ValueKind::Number;
+};
+
+inline double scalarValue(double value) {
+    return value;
+}
+
+inline double scalarValue(const Dual &value) {
+    return value.value;
+}
+
+// 栈机同时用于 double 求值和 Dual 自动微分; 数学函数按参数类型选择 std:: 或 dual_number.h 中的版本
+template<typename Value>
+Value execute(const ExpressionInstruction *code, size_t size, const Value *arguments) {
+    using std::abs;
+    using std::acos;
+    using std::asin;
+    using std::atan;
+    using std::atan2;
+    using std::ceil;
+    using std::cos;
+    using std::cosh;
+    using std::exp;
+    using std::floor;
+    using std::log;
+    using std::max;
+    using std::min;
+    using std::pow;
+    using std::sin;
+    using std::sinh;
+    using std::sqrt;
+    using std::tan;
+    using std::tanh;
+    Value stack[ExpressionProgram::kMaxStack];
+    Value locals[ExpressionProgram::kMaxLocals];
+    // 比较与逻辑运算的结果是常数, 导数为 0
+    auto truth = [](bool condition) { return Value{condition ? 1.0 : 0.0}; };
+    int top = -1;
+    for (size_t pc = 0; pc < size; ++pc) {
+        const ExpressionInstruction &ins = code[pc];
+        switch (ins.op) {
+            case ExpressionOp::PushConstant: stack[++top] = Value{ins.value}; break;
+            case ExpressionOp::LoadArgument: stack[++top] = arguments[ins.operand]; break;
+            case ExpressionOp::LoadLocal: stack[++top] = locals[ins.operand]; break;
+            case ExpressionOp::StoreLocal: locals[ins.operand] = stack[top--]; break;
+            case ExpressionOp::Add: --top; stack[top] = stack[top] + stack[top + 1]; break;
+            case ExpressionOp::Subtract: --top; stack[top] = stack[top] - stack[top + 1]; break;
+            case ExpressionOp::Multiply: --top; stack[top] = stack[top] * stack[top + 1]; break;
+            case ExpressionOp::Divide: --top; stack[top] = stack[top] / stack[top + 1]; break;
+            case ExpressionOp::Negate: stack[top] = -stack[top]; break;
+            case ExpressionOp::Power: --top; stack[top] = pow(stack[top], stack[top + 1]); break;
+            case ExpressionOp::Exp: stack[top] = exp(stack[top]); break;
+            case ExpressionOp::Log: stack[top] = log(stack[top]); break;
+            case ExpressionOp::Sqrt: stack[top] = sqrt(stack[top]); break;
+            case ExpressionOp::Sin: stack[top] = sin(stack[top]); break;
+            case ExpressionOp::Cos: stack[top] = cos(stack[top]); break;
+            case ExpressionOp::Tan: stack[top] = tan(stack[top]); break;
+            case ExpressionOp::Asin: stack[top] = asin(stack[top]); break;
+            case ExpressionOp::Acos: stack[top] = acos(stack[top]); break;
+            case ExpressionOp::Atan: stack[top] = atan(stack[top]); break;
+            case ExpressionOp::Atan2: --top; stack[top] = atan2(stack[top], stack[top + 1]); break;
+            case ExpressionOp::Sinh: stack[top] = sinh(stack[top]); break;
+            case ExpressionOp::Cosh: stack[top] = cosh(stack[top]); break;
+            case ExpressionOp::Tanh: stack[top] = tanh(stack[top]); break;
+            case ExpressionOp::Abs: stack[top] = abs(stack[top]); break;
+            case ExpressionOp::Floor: stack[top] = floor(stack[top]); break;
+            case ExpressionOp::Ceiling: stack[top] = ceil(stack[top]); break;
+            case ExpressionOp::Min: --top; stack[top] = min(stack[top], stack[top + 1]); break;
+            case ExpressionOp::Max: --top; stack[top] = max(stack[top], stack[top + 1]); break;
+            case ExpressionOp::Less:
+                --top; stack[top] = truth(scalarValue(stack[top]) < scalarValue(stack[top + 1])); break;
+            case ExpressionOp::LessEqual:
+                --top; stack[top] = truth(scalarValue(stack[top]) <= scalarValue(stack[top + 1])); break;
+            case ExpressionOp::Greater:
+                --top; stack[top] = truth(scalarValue(stack[top]) > scalarValue(stack[top + 1])); break;
+            case ExpressionOp::GreaterEqual:
+                --top; stack[top] = truth(scalarValue(stack[top]) >= scalarValue(stack[top + 1])); break;
+            case ExpressionOp::Equal:
+                --top; stack[top] = truth(scalarValue(stack[top]) == scalarValue(stack[top + 1])); break;
+            case ExpressionOp::Not: stack[top] = truth(scalarValue(stack[top]) == 0.0); break;
+            case ExpressionOp::Jump: pc += ins.operand; break;
+            case ExpressionOp::JumpIfFalse:
+                if (scalarValue(stack[top--]) == 0.0) {
+                    pc += ins.operand;
+                }
+                break;
+        }
+    }
+    return stack[0];
+}
+
+// 指令对栈深度的影响
+int stackEffect(ExpressionOp op) {
+    switch (op) {
+        case ExpressionOp::PushConstant:
+        case ExpressionOp::LoadArgument:
+        case ExpressionOp::LoadLocal:
+            return 1;
+        case ExpressionOp::StoreLocal:
+        case ExpressionOp::Add:
+        case ExpressionOp::Subtract:
+        case ExpressionOp::Multiply:
+        case ExpressionOp::Divide:
+        case ExpressionOp::Power:
+        case ExpressionOp::Atan2:
+        case ExpressionOp::Min:
+        case ExpressionOp::Max:
+        case ExpressionOp::Less:
+        case ExpressionOp::LessEqual:
+        case ExpressionOp::Greater:
+        case ExpressionOp::GreaterEqual:
+        case ExpressionOp::Equal:
+        case ExpressionOp::JumpIfFalse:
+            return -1;
+        default:
+            return 0;
+    }
+}
+
+struct UnaryFunction {
+    const char *name;
+    ExpressionOp op;
+};
+
+const UnaryFunction kUnaryFunctions[] = {
+        {"exp", ExpressionOp::Exp}, {"sqrt", ExpressionOp::Sqrt},
+        {"sin", ExpressionOp::Sin}, {"cos", ExpressionOp::Cos}, {"tan", ExpressionOp::Tan},
+        {"asin", ExpressionOp::Asin}, {"acos", ExpressionOp::Acos},
+        {"sinh", ExpressionOp::Sinh}, {"cosh", ExpressionOp::Cosh}, {"tanh", ExpressionOp::Tanh},
+        {"abs", ExpressionOp::Abs}, {"floor", ExpressionOp::Floor}, {"ceiling", ExpressionOp::Ceiling},
+};
+
+struct Comparison {
+    const char *name;
+    ExpressionOp op;
+};
+
+const Comparison kComparisons[] = {
+        {"<", ExpressionOp::Less}, {"<=", ExpressionOp::LessEqual},
+        {">", ExpressionOp::Greater}, {">=", ExpressionOp::GreaterEqual},
+        {"=", ExpressionOp::Equal},
+};
+
+class LambdaCompiler {
+public:
+    explicit LambdaCompiler(const std::vector<std::string> &parameters) : parameters_(parameters) {}
+
+    Fragment compile(const SExpr &expr) {
+        switch (expr.kind) {
+            case SExpr::Number:
+                return constant(expr.number, ValueKind::Number);
+            case SExpr::Boolean:
+                return constant(expr.boolean ? 1.0 : 0.0, ValueKind::Boolean);
+            case SExpr::Symbol:
+                return variable(expr.symbol);
+            case SExpr::List:
+                break;
+        }
+        if (expr.items.empty() || expr.items[0].kind != SExpr::Symbol) {
+            throw std::runtime_error("不支持的表达式: " + describe(expr));
+        }
+        return fold(compileForm(expr.items[0].symbol, expr));
+    }
+
+    int localCount() const { return localCount_; }
+
+private:
+    struct Binding {
+        std::string name;
+        int slot;
+        ValueKind kind;
+    };
+
+    static Fragment constant(double value, ValueKind kind) {
+        Fragment fragment;
+        fragment.code.push_back({ExpressionOp::PushConstant, 0, value});
+        fragment.kind = kind;
+        return fragment;
+    }
+
+    static bool isConstant(const Fragment &fragment) {
+        return fragment.code.size() == 1 && fragment.code[0].op == ExpressionOp::PushConstant;
+    }
+
+    // 不读取参数和局部变量的片段在编译时直接求值
+    static Fragment fold(Fragment fragment) {
+        if (isConstant(fragment)) {
+            return fragment;
+        }
+        for (const auto &ins: fragment.code) {
+            if (ins.op == ExpressionOp::LoadArgument || ins.op == ExpressionOp::LoadLocal
+                || ins.op == ExpressionOp::StoreLocal) {
+                return fragment;
+            }
+        }
+        return constant(execute<double>(fragment.code.data(), fragment.code.size(), nullptr), fragment.kind);
+    }
+
+    static void append(Fragment &target, const Fragment &source) {
+        target.code.insert(target.code.end(), source.code.begin(), source.code.end());
+    }
+
+    Fragment variable(const std::string &name) const {
+        for (auto it = scope_.rbegin(); it != scope_.rend(); ++it) {
+            if (it->name == name) {
+                Fragment fragment;
+                fragment.code.push_back({ExpressionOp::LoadLocal, it->slot});
+                fragment.kind = it->kind;
+                return fragment;
+            }
+        }
+        for (size_t i = 0; i < parameters_.size(); ++i) {
+            if (parameters_[i] == name) {
+                Fragment fragment;
+                fragment.code.push_back({ExpressionOp::LoadArgument, static_cast<int32_t>(i)});
+                return fragment;
+            }
+        }
+        throw std::runtime_error("未绑定的变量: " + name);
+    }
+
+    Fragment expect(const SExpr &expr, ValueKind kind) {
+        Fragment fragment = compile(expr);
+        if (fragment.kind != kind) {
+            throw std::runtime_error((kind == ValueKind::Number ? "需要数值: " : "需要布尔值: ") + describe(expr));
+        }
+        return fragment;
+    }
+
+    static void checkArity(const SExpr &expr, size_t min, size_t max) {
+        size_t count = expr.items.size() - 1;
+        if (count < min || count > max) {
+            throw std::runtime_error("参数个数错误: " + describe(expr));
+        }
+    }
+
+    // 左结合地把数值参数用二元指令串起来
+    Fragment chain(const SExpr &expr, size_t first, ExpressionOp op) {
+        Fragment result = expect(expr.items[first], ValueKind::Number);
+        for (size_t i = first + 1; i < expr.items.size(); ++i) {
+            append(result, expect(expr.items[i], ValueKind::Number));
+            result.code.push_back({op});
+        }
+        return result;
+    }
+
+    static Fragment negate(Fragment fragment) {
+        fragment.code.push_back({ExpressionOp::Not});
+        return fragment;
+    }
+
+    static Fragment conjunction(const std::vector<Fragment> &parts) {
+        if (parts.empty()) {
+            return constant(1.0, ValueKind::Boolean);
+        }
+        // 任一部分为假时跳到末尾的 #f
+        Fragment result;
+        result.kind = ValueKind::Boolean;
+        std::vector<size_t> exits;
+        for (const auto &part: parts) {
+            append(result, part);
+            exits.push_back(result.code.size());
+            result.code.push_back({ExpressionOp::JumpIfFalse});
+        }
+        result.code.push_back({ExpressionOp::PushConstant, 0, 1.0});
+        result.code.push_back({ExpressionOp::Jump, 1});
+        size_t falseLabel = result.code.size();
+        result.code.push_back({ExpressionOp::PushConstant, 0, 0.0});
+        for (size_t exit: exits) {
+            result.code[exit].operand = static_cast<int32_t>(falseLabel - exit - 1);
+        }
+        return result;
+    }
+
+    static Fragment select(const Fragment &condition, const Fragment &consequent, const Fragment &alternative) {
+        if (isConstant(condition)) {
+            return condition.code[0].value != 0.0 ? consequent : alternative;
+        }
+        Fragment result = condition;
+        result.kind = consequent.kind;
+        result.code.push_back({ExpressionOp::JumpIfFalse, static_cast<int32_t>(consequent.code.size() + 1)});
+        append(result, consequent);
+        result.code.push_back({ExpressionOp::Jump, static_cast<int32_t>(alternative.code.size())});
+        append(result, alternative);
+        return result;
+    }
+
+    Fragment conditional(const SExpr &test, const SExpr &consequent, const SExpr &alternative) {
+        Fragment a = compile(consequent);
+        Fragment b = compile(alternative);
+        if (a.kind != b.kind) {
+            throw std::runtime_error("条件分支的类型不一致: " + describe(consequent) + " / " + describe(alternative));
+        }
+        return select(expect(test, ValueKind::Boolean), a, b);
+    }
+
+    Fragment cond(const SExpr &expr, size_t clause) {
+        if (clause >= expr.items.size()) {
+            throw std::runtime_error("cond 缺少 else 分支: " + describe(expr));
+        }
+        const SExpr &current = expr.items[clause];
+        if (current.kind != SExpr::List || current.items.size() != 2) {
+            throw std::runtime_error("cond 分支格式错误: " + describe(current));
+        }
+        if (current.items[0].kind == SExpr::Symbol && current.items[0].symbol == "else") {
+            return compile(current.items[1]);
+        }
+        Fragment a = compile(current.items[1]);
+        Fragment b = cond(expr, clause + 1);
+        if (a.kind != b.kind) {
+            throw std::runtime_error("条件分支的类型不一致: " + describe(expr));
+        }
+        return select(expect(current.items[0], ValueKind::Boolean), a, b);
+    }
+
+    Fragment let(const SExpr &expr, bool sequential) {
+        if (expr.items.size() < 3 || expr.items[1].kind != SExpr::List) {
+            throw std::runtime_error("let 格式错误: " + describe(expr));
+        }
+        Fragment result;
+        size_t scopeSize = scope_.size();
+        std::vector<Binding> pending;
+        for (const auto &binding: expr.items[1].items) {
+            if (binding.kind != SExpr::List || binding.items.size() != 2 || binding.items[0].kind != SExpr::Symbol) {
+                throw std::runtime_error("let 绑定格式错误: " + describe(binding));
+            }
+            if (localCount_ >= ExpressionProgram::kMaxLocals) {
+                throw std::runtime_error("局部变量过多: " + describe(expr));
+            }
+            Fragment init = compile(binding.items[1]);
+            int slot = localCount_++;
+            append(result, init);
+            result.code.push_back({ExpressionOp::StoreLocal, slot});
+            Binding bound{binding.items[0].symbol, slot, init.kind};
+            // let* 的后续初始化表达式可以看到前面的绑定, let 不可以
+            if (sequential) {
+                scope_.push_back(bound);
+            } else {
+                pending.push_back(bound);
+            }
+        }
+        scope_.insert(scope_.end(), pending.begin(), pending.end());
+        // 没有副作用, 只有最后一个表达式的值有意义
+        Fragment body = compile(expr.items.back());
+        scope_.resize(scopeSize);
+        append(result, body);
+        result.kind = body.kind;
+        return result;
+    }
+
+    Fragment compileForm(const std::string &head, const SExpr &expr) {
+        size_t count = expr.items.size() - 1;
+        if (head == "+" || head == "*") {
+            if (count == 0) {
+                return constant(head == "+" ? 0.0 : 1.0, ValueKind::Number);
+            }
+            return chain(expr, 1, head == "+" ? ExpressionOp::Add : ExpressionOp::Multiply);
+        }
+        if (head == "-" || head == "/") {
+            checkArity(expr, 1, SIZE_MAX);
+            if (count == 1) {
+                Fragment operand = expect(expr.items[1], ValueKind::Number);
+                if (head == "-") {
+                    operand.code.push_back({ExpressionOp::Negate});
+                    return operand;
+                }
+                Fragment result = constant(1.0, ValueKind::Number);
+                append(result, operand);
+                result.code.push_back({ExpressionOp::Divide});
+                return result;
+            }
+            return chain(expr, 1, head == "-" ? ExpressionOp::Subtract : ExpressionOp::Divide);
+        }
+        if (head == "min" || head == "max") {
+            checkArity(expr, 1, SIZE_MAX);
+            return chain(expr, 1, head == "min" ? ExpressionOp::Min : ExpressionOp::Max);
+        }
+        if (head == "expt") {
+            checkArity(expr, 2, 2);
+            return chain(expr, 1, ExpressionOp::Power);
+        }
+        if (head == "log") {
+            // (log x b) 为以 b 为底的对数
+            checkArity(expr, 1, 2);
+            Fragment result = expect(expr.items[1], ValueKind::Number);
+            result.code.push_back({ExpressionOp::Log});
+            if (count == 2) {
+                append(result, expect(expr.items[2], ValueKind::Number));
+                result.code.push_back({ExpressionOp::Log});
+                result.code.push_back({ExpressionOp::Divide});
+            }
+            return result;
+        }
+        if (head == "atan") {
+            checkArity(expr, 1, 2);
+            if (count == 2) {
+                return chain(expr, 1, ExpressionOp::Atan2);
+            }
+            Fragment result = expect(expr.items[1], ValueKind::Number);
+            result.code.push_back({ExpressionOp::Atan});
+            return result;
+        }
+        if (head == "exact->inexact" || head == "inexact") {
+            checkArity(expr, 1, 1);
+            return expect(expr.items[1], ValueKind::Number);
+        }
+        for (const auto &function: kUnaryFunctions) {
+            if (head == function.name) {
+                checkArity(expr, 1, 1);
+                Fragment result = expect(expr.items[1], ValueKind::Number);
+                result.code.push_back({function.op});
+                return result;
+            }
+        }
+        for (const auto &comparison: kComparisons) {
+            if (head == comparison.name) {
+                // (< a b c) 等价于 (and (< a b) (< b c))
+                checkArity(expr, 2, SIZE_MAX);
+                std::vector<Fragment> parts;
+                for (size_t i = 1; i < count; ++i) {
+                    Fragment part = expect(expr.items[i], ValueKind::Number);
+                    append(part, expect(expr.items[i + 1], ValueKind::Number));
+                    part.code.push_back({comparison.op});
+                    part.kind = ValueKind::Boolean;
+                    parts.push_back(fold(part));
+                }
+                return parts.size() == 1 ? parts[0] : conjunction(parts);
+            }
+        }
+        if (head == "not") {
+            checkArity(expr, 1, 1);
+            return negate(expect(expr.items[1], ValueKind::Boolean));
+        }
+        if (head == "and" || head == "or") {
+            // (or a b) 按 (not (and (not a) (not b))) 编译
+            std::vector<Fragment> parts;
+            for (size_t i = 1; i < expr.items.size(); ++i) {
+                Fragment part = expect(expr.items[i], ValueKind::Boolean);
+                parts.push_back(head == "and" ? part : fold(negate(part)));
+            }
+            Fragment result = conjunction(parts);
+            return head == "and" ? result : negate(result);
+        }
+        if (head == "if") {
+            checkArity(expr, 3, 3);
+            return conditional(expr.items[1], expr.items[2], expr.items[3]);
+        }
+        if (head == "cond") {
+            return cond(expr, 1);
+        }
+        if (head == "let" || head == "let*") {
+            return let(expr, head == "let*");
+        }
+        if (head == "begin") {
+            checkArity(expr, 1, SIZE_MAX);
+            return compile(expr.items.back());
+        }
+        throw std::runtime_error("不支持的函数或语法: " + head);
+    }
+
+    const std::vector<std::string> &parameters_;
+    std::vector<Binding> scope_;
+    int localCount_ = 0;
+};
+
+} // namespace
+
+double ExpressionProgram::evaluate(double T, double p) const {
+    const double arguments[kMaxArguments] = {T, p};
+    return execute(code_.data(), code_.size(), arguments);
+}
+
+void ExpressionProgram::evaluate(const double *T, const double *p, double pressure, double *out, size_t count) const {
+    double arguments[kMaxArguments] = {0.0, pressure};
+    for (size_t i = 0; i < count; ++i) {
+        arguments[0] = T[i];
+        if (p) {
+            arguments[1] = p[i];
+        }
+        out[i] = execute(code_.data(), code_.size(), arguments);
+    }
+}
+
+Dual ExpressionProgram::evaluateDual(double T, double p) const {
+    const Dual arguments[kMaxArguments] = {{T, 1.0, 0.0}, {p, 0.0, 1.0}};
+    return execute(code_.data(), code_.size(), arguments);
+}
+
+void ExpressionProgram::evaluateDual(const double *T, const double *p, double pressure, double *out, double *dT,
+                                     double *dp, size_t count) const {
+    Dual arguments[kMaxArguments] = {{0.0, 1.0, 0.0}, {pressure, 0.0, 1.0}};
+    for (size_t i = 0; i < count; ++i) {
+        arguments[0].value = T[i];
+        if (p) {
+            arguments[1].value = p[i];
+        }
+        Dual result = execute(code_.data(), code_.size(), arguments);
+        out[i] = result.value;
+        dT[i] = result.dT;
+        if (dp) {
+            dp[i] = result.dp;
+        }
+    }
+}
+
+ExpressionProgram compileSchemeLambda(const std::string &source) {
+    SExpr expr = readExpression(source);
+    if (expr.kind != SExpr::List || expr.items.size() < 3 || expr.items[0].kind != SExpr::Symbol
+        || expr.items[0].symbol != "lambda" || expr.items[1].kind != SExpr::List) {
+        throw std::runtime_error("用户自定义物性必须是 (lambda (T p) ...) 形式: " + source);
+    }
+
+    ExpressionProgram program;
+    program.source_ = source;
+    for (const auto &parameter: expr.items[1].items) {
+        if (parameter.kind != SExpr::Symbol) {
+            throw std::runtime_error("lambda 参数必须是符号: " + describe(parameter));
+        }
+        program.parameters_.push_back(parameter.symbol);
+    }
+    if (program.parameters_.empty() || program.parameters_.size() > ExpressionProgram::kMaxArguments) {
+        throw std::runtime_error("lambda 只能有温度和压力两个参数: " + source);
+    }
+
+    LambdaCompiler compiler(program.parameters_);
+    Fragment body = compiler.compile(expr.items.back());
+    if (body.kind != ValueKind::Number) {
+        throw std::runtime_error("用户自定义物性必须返回数值: " + source);
+    }
+    program.code_ = std::move(body.code);
+    program.localCount_ = compiler.localCount();
+
+    // 按指令顺序累计栈深度; 条件分支会被重复计入, 得到的是上界
+    int depth = 0;
+    for (const auto &ins: program.code_) {
+        depth += stackEffect(ins.op);
+        program.maxStack_ = std::max(program.maxStack_, depth);
+    }
+    if (program.maxStack_ > ExpressionProgram::kMaxStack) {
+        throw std::runtime_error("表达式嵌套过深: " + source);
+    }
+    return program;
+}
+
+} // namespace CFD_MaterialDB
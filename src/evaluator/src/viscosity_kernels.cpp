@@ -0,0 +1,177 @@
+#include "viscosity_kernels.h"
+#include <cmath>
+#include <limits>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define MATERIALDB_AVX2 1
+#endif
+
+namespace CFD_MaterialDB {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+#ifdef MATERIALDB_AVX2
+constexpr double kLn2Hi = 6.93147180369123816490e-01;
+constexpr double kLn2Lo = 1.90821492927058770002e-10;
+constexpr double kLog2e = 1.44269504088896338700;
+constexpr double kSqrt2 = 1.41421356237309504880;
+constexpr double kTwoPow52 = 4503599627370496.0;
+
+// 多项式项数: 完整精度用于 Blottner, 低阶用于 power-law 的 Fast 模式
+constexpr int kLogTermsFull = 11;
+constexpr int kExpDegreeFull = 13;
+constexpr int kLogTermsFast = 5;
+constexpr int kExpDegreeFast = 8;
+
+constexpr double inverseFactorial(int k) {
+    double f = 1.0;
+    for (int i = 2; i <= k; ++i) {
+        f *= i;
+    }
+    return 1.0 / f;
+}
+
+// x = m 2^e, m 在 [sqrt(1/2), sqrt(2)) 内; log m = 2 atanh(s) = 2 (s + s^3/3 + ...), s = (m - 1)/(m + 1).
+// 特殊值与 std::log 一致: 0 得 -inf, +inf 得 +inf, 负数与 NaN 得 NaN; 次正规数先放大为正规数
+template<int Terms>
+inline __m256d vectorLog(__m256d x) {
+    const __m256d magic = _mm256_set1_pd(kTwoPow52);
+    const __m256d subnormal = _mm256_cmp_pd(x, _mm256_set1_pd(std::numeric_limits<double>::min()), _CMP_LT_OQ);
+    const __m256i bits = _mm256_castpd_si256(_mm256_blendv_pd(x, _mm256_mul_pd(x, magic), subnormal));
+    // 指数域放进 2^52 的尾数后相减得到无偏指数, 绕开 AVX2 没有的 int64 -> double 转换
+    __m256d exponent = _mm256_sub_pd(
+            _mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52), _mm256_castpd_si256(magic))),
+            _mm256_set1_pd(kTwoPow52 + 1023.0));
+    exponent = _mm256_sub_pd(exponent, _mm256_and_pd(subnormal, _mm256_set1_pd(52.0)));
+    __m256d m = _mm256_castsi256_pd(
+            _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL)),
+                            _mm256_set1_epi64x(0x3FF0000000000000LL)));
+    __m256d large = _mm256_cmp_pd(m, _mm256_set1_pd(kSqrt2), _CMP_GT_OQ);
+    m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), large);
+    exponent = _mm256_add_pd(exponent, _mm256_and_pd(large, _mm256_set1_pd(1.0)));
+
+    __m256d one = _mm256_set1_pd(1.0);
+    __m256d s = _mm256_div_pd(_mm256_sub_pd(m, one), _mm256_add_pd(m, one));
+    __m256d z = _mm256_mul_pd(s, s);
+    __m256d poly = _mm256_set1_pd(2.0 / (2 * Terms - 1));
+    for (int k = Terms - 2; k >= 0; --k) {
+        poly = _mm256_fmadd_pd(poly, z, _mm256_set1_pd(2.0 / (2 * k + 1)));
+    }
+    __m256d result = _mm256_fmadd_pd(exponent, _mm256_set1_pd(kLn2Hi),
+                                     _mm256_fmadd_pd(exponent, _mm256_set1_pd(kLn2Lo), _mm256_mul_pd(s, poly)));
+    __m256d zero = _mm256_setzero_pd();
+    __m256d infinity = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+    result = _mm256_blendv_pd(result, infinity, _mm256_cmp_pd(x, infinity, _CMP_EQ_OQ));
+    result = _mm256_blendv_pd(result, _mm256_sub_pd(zero, infinity), _mm256_cmp_pd(x, zero, _CMP_EQ_OQ));
+    return _mm256_blendv_pd(result, _mm256_set1_pd(kNaN), _mm256_cmp_pd(x, zero, _CMP_NGE_UQ));
+}
+
+// exp(x) = 2^n exp(r), |r| <= ln2 / 2, exp(r) 取 Degree 阶 Taylor 展开.
+// 超出 [-708, 709] 时分别取 0 与 inf (不处理次正规数), NaN 原样传出
+template<int Degree>
+inline __m256d vectorExp(__m256d input) {
+    // max/min 在任一操作数为 NaN 时返回第二个操作数
+    __m256d x = _mm256_min_pd(_mm256_set1_pd(709.0), _mm256_max_pd(_mm256_set1_pd(-708.0), input));
+    __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(kLog2e)),
+                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(kLn2Hi), x);
+    r = _mm256_fnmadd_pd(n, _mm256_set1_pd(kLn2Lo), r);
+    __m256d poly = _mm256_set1_pd(inverseFactorial(Degree));
+    for (int k = Degree - 1; k >= 0; --k) {
+        poly = _mm256_fmadd_pd(poly, r, _mm256_set1_pd(inverseFactorial(k)));
+    }
+    __m256i biased = _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n)), _mm256_set1_epi64x(1023));
+    __m256d result = _mm256_mul_pd(poly, _mm256_castsi256_pd(_mm256_slli_epi64(biased, 52)));
+    result = _mm256_blendv_pd(result, _mm256_set1_pd(std::numeric_limits<double>::infinity()),
+                              _mm256_cmp_pd(input, _mm256_set1_pd(709.0), _CMP_GT_OQ));
+    return _mm256_blendv_pd(result, _mm256_setzero_pd(), _mm256_cmp_pd(input, _mm256_set1_pd(-708.0), _CMP_LT_OQ));
+}
+#endif
+
+} // namespace
+
+void evaluateSutherland(const sutherlandData &data, const double *T, double *out, size_t count) {
+    size_t i = 0;
+#ifdef MATERIALDB_AVX2
+    __m256d c1 = _mm256_set1_pd(data.C1);
+    __m256d s = _mm256_set1_pd(data.S);
+    for (; i + 4 <= count; i += 4) {
+        __m256d t = _mm256_loadu_pd(T + i);
+        __m256d numerator = _mm256_mul_pd(_mm256_mul_pd(c1, t), _mm256_sqrt_pd(t));
+        _mm256_storeu_pd(out + i, _mm256_div_pd(numerator, _mm256_add_pd(t, s)));
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = evaluateSutherland(data, T[i]);
+    }
+}
+
+void evaluateSutherland(const sutherlandData &data, const double *T, double *out, double *dmudT, size_t count) {
+    evaluateSutherland(data, T, out, count);
+    for (size_t i = 0; i < count; ++i) {
+        dmudT[i] = sutherlandDerivative(data, T[i], out[i]);
+    }
+}
+
+void evaluatePowerLaw(const powerLawData &data, const double *T, double *out, size_t count, PowAccuracy accuracy) {
+    size_t i = 0;
+#ifdef MATERIALDB_AVX2
+    if (accuracy == PowAccuracy::Fast) {
+        // B T^n = exp(n ln T + ln B)
+        __m256d n = _mm256_set1_pd(data.n);
+        __m256d logB = _mm256_set1_pd(std::log(data.B));
+        for (; i + 4 <= count; i += 4) {
+            __m256d t = _mm256_loadu_pd(T + i);
+            __m256d exponent = _mm256_fmadd_pd(n, vectorLog<kLogTermsFast>(t), logB);
+            _mm256_storeu_pd(out + i, vectorExp<kExpDegreeFast>(exponent));
+        }
+    }
+#else
+    (void) accuracy;
+#endif
+    for (; i < count; ++i) {
+        out[i] = evaluatePowerLaw(data, T[i]);
+    }
+}
+
+void evaluatePowerLaw(const powerLawData &data, const double *T, double *out, double *dmudT, size_t count,
+                      PowAccuracy accuracy) {
+    evaluatePowerLaw(data, T, out, count, accuracy);
+    for (size_t i = 0; i < count; ++i) {
+        dmudT[i] = powerLawDerivative(data, T[i], out[i]);
+    }
+}
+
+void evaluateBlottner(const blottnerData &data, const double *T, double *out, size_t count) {
+    evaluateBlottner(data, T, out, nullptr, count);
+}
+
+void evaluateBlottner(const blottnerData &data, const double *T, double *out, double *dmudT, size_t count) {
+    size_t i = 0;
+#ifdef MATERIALDB_AVX2
+    __m256d a = _mm256_set1_pd(data.A);
+    __m256d b = _mm256_set1_pd(data.B);
+    // 0.1 并入常数项: ln 0.1 + C
+    __m256d c = _mm256_set1_pd(data.C + std::log(0.1));
+    __m256d twoA = _mm256_set1_pd(2.0 * data.A);
+    for (; i + 4 <= count; i += 4) {
+        __m256d t = _mm256_loadu_pd(T + i);
+        __m256d lnT = vectorLog<kLogTermsFull>(t);
+        __m256d exponent = _mm256_fmadd_pd(_mm256_fmadd_pd(a, lnT, b), lnT, c);
+        __m256d mu = vectorExp<kExpDegreeFull>(exponent);
+        _mm256_storeu_pd(out + i, mu);
+        if (dmudT) {
+            __m256d slope = _mm256_div_pd(_mm256_fmadd_pd(twoA, lnT, b), t);
+            _mm256_storeu_pd(dmudT + i, _mm256_mul_pd(mu, slope));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = dmudT ? evaluateBlottner(data, T[i], dmudT + i) : evaluateBlottner(data, T[i]);
+    }
+}
+
+} // namespace CFD_MaterialDB
@@ -1,47 +1,680 @@
 //
 // Created by siqi on 2025/4/8.
 //
+// material_db 命令行工具. 用法见 printUsage; 参数一律写成 --名称=值, 布尔参数只写 --名称
+//
 #include "scm_parser.h"
 #include "database_manager.h"
+#include "import_pipeline.h"
+#include "material_daemon.h"
+#include "name_translator.h"
+#include "property_evaluator.h"
+#include "metrics.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
 #include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
 #include <sstream>
+#include <thread>
 // 移除标准SQLite头文件，只保留SQLCipher头文件
 
-int main() {
-    // 解析SCM文件
-    ScmParser parser;
-    auto materials = parser.parse("propdb.scm");
-    // 创建数据库连接
-    if (std::filesystem::exists("materials.db")) {
-        std::filesystem::remove("materials.db");
+using namespace CFD_MaterialDB;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct CommandLine {
+    std::string command;
+    std::vector<std::string> arguments;             // 位置参数
+    std::map<std::string, std::string> flags;       // 不含前导 --
+};
+
+// 抛出此异常时输出用法并以 2 退出
+struct UsageError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+void printUsage(std::ostream &os) {
+    os << "用法: material_db <命令> [参数]\n"
+          "\n"
+          "命令:\n"
+          "  import <文件.scm>        导入 SCM 材料库\n"
+          "      --mode=incremental|bulk   incremental (默认) 保留已有数据库, 已存在的材料更新;\n"
+          "                                bulk 先删除数据库再整体导入\n"
+          "      --queue=N                 流水线阶段之间的队列容量 (默认 256)\n"
+          "      --translators=列表        中文名提供者, 逗号分隔: dictionary, memory, http\n"
+          "                                (默认取环境变量 MATDB_NAME_TRANSLATORS, 否则 memory);\n"
+          "                                http 的凭据取自 MATDB_BAIDU_APPID / MATDB_BAIDU_KEY\n"
+          "      --dictionary=文件         中文名字典库 (默认 materialsDict.db)\n"
+          "      --print-names             逐个输出材料中文名\n"
+          "  get <名称>...              以 JSON 输出材料\n"
+          "  search <关键词>            按名称/中文名/化学式检索\n"
+          "      --limit=N                 最多返回的条数 (默认 20)\n"
+          "  export                     导出数据库, 可在位置参数中列出要导出的材料名\n"
+          "      --format=json|cbor|snapshot   snapshot 为 SQLite 数据库的一致副本\n"
+          "      --output=文件             json 默认写到标准输出, 其余格式必须指定\n"
+          "  eval <材料> <物性>         在温度区间上求物性值, 每个系数一列\n"
+          "      --from=K --to=K           温度区间 (默认 300 到 1500)\n"
+          "      --step=K | --points=N     步长或点数 (默认步长 100)\n"
+          "      --pressure=Pa             压力 (默认 101325)\n"
+          "      --derivatives             同时输出 d/dT\n"
+          "  bench [文件.scm]           导入、查询与批量求值的吞吐量 (默认 propdb.scm, 数据库默认在内存中)\n"
+          "      --repeat=N                查询与求值的重复次数 (默认 3)\n"
+          "  daemon [文件]              常驻服务: 载入 .scm 文件或数据库 (默认 --db), 发布到共享内存,\n"
+          "                             在 socket 上接受 status/load/reload/query/batch/shutdown 请求\n"
+          "      --shm=/名称               共享内存名 (默认 /material_db)\n"
+          "      --socket=路径             控制 socket (默认 material_db.sock)\n"
+          "  ctl <请求>...              向守护进程发送一个请求并输出应答, 例如 ctl query air viscosity 300\n"
+          "      --socket=路径             控制 socket (默认 material_db.sock)\n"
+          "  batch [文件]               把每行 \"材料 物性 T [p]\" 的点 (默认读标准输入) 打包成一个批量请求发给守护进程,\n"
+          "                             按原顺序输出 T, p 与物性值\n"
+          "      --coefficient=N           物性的第几个系数 (默认 0)\n"
+          "      --derivatives             同时输出 d/dT 与 d/dp\n"
+          "      --socket=路径             控制 socket (默认 material_db.sock)\n"
+          "\n"
+          "公共参数:\n"
+          "  --db=文件                  材料数据库 (默认 materials.db)\n"
+          "  --threads=N                工作线程数, 0 表示全部硬件线程 (默认 0);\n"
+          "                             import/bench 为解析线程, eval/bench 为求值线程\n"
+          "  --batch-size=N             import/bench 每个写事务的材料数 (默认 256);\n"
+          "                             eval/bench 每次批量求值的点数 (默认 1024)\n"
+          "  --cache-size=KiB           SQLite 页缓存大小 (默认使用 SQLite 的设置)\n"
+          "\n"
+          "环境变量 MATDB_METRICS_PROM / MATDB_METRICS_JSON / MATDB_TRACE 指定指标与时间线的导出路径\n";
+}
+
+CommandLine parseCommandLine(int argc, char **argv) {
+    CommandLine line;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) == 0) {
+            size_t equals = arg.find('=');
+            line.flags[arg.substr(2, equals == std::string::npos ? std::string::npos : equals - 2)] =
+                    equals == std::string::npos ? "" : arg.substr(equals + 1);
+        } else if (line.command.empty()) {
+            line.command = arg;
+        } else {
+            line.arguments.push_back(arg);
+        }
+    }
+    return line;
+}
+
+// 公共参数之外只接受 allowed 中的参数
+void checkFlags(const CommandLine &line, const std::set<std::string> &allowed) {
+    static const std::set<std::string> common = {"db", "threads", "batch-size", "cache-size"};
+    for (const auto &flag: line.flags) {
+        if (!common.count(flag.first) && !allowed.count(flag.first)) {
+            throw UsageError(line.command + " 不支持参数 --" + flag.first);
+        }
+    }
+}
+
+std::string stringFlag(const CommandLine &line, const std::string &name, const std::string &fallback) {
+    auto it = line.flags.find(name);
+    return it == line.flags.end() ? fallback : it->second;
+}
+
+size_t sizeFlag(const CommandLine &line, const std::string &name, size_t fallback) {
+    auto it = line.flags.find(name);
+    if (it == line.flags.end()) {
+        return fallback;
+    }
+    try {
+        size_t used = 0;
+        unsigned long long value = std::stoull(it->second, &used);
+        if (used == it->second.size()) {
+            return static_cast<size_t>(value);
+        }
+    } catch (const std::exception &) {
+    }
+    throw UsageError("--" + name + " 应为非负整数: " + it->second);
+}
+
+double doubleFlag(const CommandLine &line, const std::string &name, double fallback) {
+    auto it = line.flags.find(name);
+    if (it == line.flags.end()) {
+        return fallback;
     }
-    //sqlite3_key(db, "MyStrongPassword!", 17); // 设置密钥
-    // 使用try-catch块处理可能的异常
     try {
-        CFD_MaterialDB::DatabaseManager matDict("materialsDict.db");
-        // 确保materialsDict.db有正确的表结构
-        matDict.createTables();
-
-        // 插入材料数据
-        CFD_MaterialDB::DatabaseManager dbManager("materials.db");
-        dbManager.createTables();
-        for (auto &material: materials) {
-            try {
-                // 尝试从字典获取中文名
-                material.chinese_name = matDict.getMaterialByName(material.name).chinese_name;
-            } catch (const std::exception &e) {
-                // 如果获取失败，使用翻译API或默认值
-                std::cerr << "获取中文名失败: " << e.what() << std::endl;
-                //material.chinese_name = CFD_MaterialDB::DatabaseManager::TranslateText(material.name);
-                material.chinese_name = material.name; // 临时使用英文名作为中文名
+        size_t used = 0;
+        double value = std::stod(it->second, &used);
+        if (used == it->second.size()) {
+            return value;
+        }
+    } catch (const std::exception &) {
+    }
+    throw UsageError("--" + name + " 应为数值: " + it->second);
+}
+
+unsigned threadCount(const CommandLine &line) {
+    size_t threads = sizeFlag(line, "threads", 0);
+    return threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : static_cast<unsigned>(threads);
+}
+
+std::string databasePath(const CommandLine &line) {
+    return stringFlag(line, "db", "materials.db");
+}
+
+// 查询类命令要求数据库已存在, 避免打开时悄悄创建空库
+void requireDatabase(const std::string &path) {
+    if (path != ":memory:" && !std::filesystem::exists(path)) {
+        throw std::runtime_error("数据库不存在: " + path);
+    }
+}
+
+// 写入类命令 (import, bench) 以读写方式打开并建表; 查询类命令只读打开, 不修改用户的数据库
+std::unique_ptr<DatabaseManager> openDatabase(const CommandLine &line, const std::string &path, bool writable) {
+    auto database = std::make_unique<DatabaseManager>(path, !writable);
+    size_t cacheSize = sizeFlag(line, "cache-size", 0);
+    if (cacheSize > 0) {
+        database->setCacheSize(static_cast<int>(cacheSize));
+    }
+    if (writable) {
+        database->createTables();
+    }
+    return database;
+}
+
+// 删除数据库文件及 SQLite 的旁路文件; 残留的 -wal / -journal 会被应用到同名的新库上
+void removeDatabaseFiles(const std::string &path) {
+    for (const char *suffix: {"", "-wal", "-shm", "-journal"}) {
+        std::filesystem::remove(path + suffix);
+    }
+}
+
+// getMaterialByName 在未找到时返回只有名称的空材料
+bool materialExists(const Material &material) {
+    return !material.properties.empty();
+}
+
+// 把 [0, count) 平均分给 threads 个线程执行 work(begin, end)
+template<typename Work>
+void parallelFor(size_t count, unsigned threads, Work work) {
+    threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, count)));
+    if (threads == 1) {
+        work(size_t(0), count);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        size_t begin = count * t / threads;
+        size_t end = count * (t + 1) / threads;
+        workers.emplace_back([&work, begin, end] { work(begin, end); });
+    }
+    for (auto &worker: workers) {
+        worker.join();
+    }
+}
+
+ImportPipelineStats importFile(const CommandLine &line, DatabaseManager &database, const std::string &scmFile,
+                               bool replaceExisting) {
+    const char *envTranslators = std::getenv("MATDB_NAME_TRANSLATORS");
+    std::string translatorSpec = stringFlag(line, "translators", envTranslators ? envTranslators : "memory");
+    NameTranslatorConfig config;
+    config.dictionaryPath = stringFlag(line, "dictionary", config.dictionaryPath);
+    auto translator = makeNameTranslator(translatorSpec, config);
+
+    ImportPipelineOptions options;
+    options.parserThreads = threadCount(line);
+    options.batchSize = sizeFlag(line, "batch-size", options.batchSize);
+    options.queueCapacity = std::max<size_t>(1, sizeFlag(line, "queue", options.queueCapacity));
+    options.printNames = line.flags.count("print-names") > 0;
+    options.replaceExisting = replaceExisting;
+    ImportPipeline pipeline(database, translator.get(), options);
+    return pipeline.run(scmFile);
+}
+
+int runImport(const CommandLine &line) {
+    checkFlags(line, {"mode", "queue", "translators", "dictionary", "print-names"});
+    if (line.arguments.size() != 1) {
+        throw UsageError("import 需要一个 SCM 文件");
+    }
+    std::string mode = stringFlag(line, "mode", "incremental");
+    if (mode != "incremental" && mode != "bulk") {
+        throw UsageError("--mode 应为 incremental 或 bulk: " + mode);
+    }
+    std::string path = databasePath(line);
+    if (mode == "bulk" && path != ":memory:") {
+        removeDatabaseFiles(path);
+    }
+    auto database = openDatabase(line, path, true);
+    auto stats = importFile(line, *database, line.arguments[0], mode == "incremental");
+    stats.print(std::cout);
+    return stats.insertFailures == 0 ? 0 : 1;
+}
+
+int runGet(const CommandLine &line) {
+    checkFlags(line, {});
+    if (line.arguments.empty()) {
+        throw UsageError("get 需要至少一个材料名");
+    }
+    std::string path = databasePath(line);
+    requireDatabase(path);
+    auto database = openDatabase(line, path, false);
+    int status = 0;
+    for (const auto &name: line.arguments) {
+        Material material = database->getMaterialByName(name);
+        if (!materialExists(material)) {
+            std::cerr << "材料不存在: " << name << std::endl;
+            status = 1;
+            continue;
+        }
+        std::cout << nlohmann::json(material).dump(2) << "\n";
+    }
+    return status;
+}
+
+int runSearch(const CommandLine &line) {
+    checkFlags(line, {"limit"});
+    if (line.arguments.size() != 1) {
+        throw UsageError("search 需要一个关键词");
+    }
+    std::string path = databasePath(line);
+    requireDatabase(path);
+    auto database = openDatabase(line, path, false);
+    auto results = database->searchMaterials(line.arguments[0], static_cast<int>(sizeFlag(line, "limit", 20)));
+    for (const auto &result: results) {
+        std::cout << result.name << "\t" << result.chinese_name << "\t" << result.chemical_formula << "\t"
+                  << result.rank << "\n";
+    }
+    return results.empty() ? 1 : 0;
+}
+
+int runExport(const CommandLine &line) {
+    checkFlags(line, {"format", "output"});
+    std::string format = stringFlag(line, "format", "json");
+    std::string output = stringFlag(line, "output", "");
+    if (format != "json" && format != "cbor" && format != "snapshot") {
+        throw UsageError("--format 应为 json, cbor 或 snapshot: " + format);
+    }
+    if (format != "json" && output.empty()) {
+        throw UsageError(format + " 格式需要 --output");
+    }
+    std::string path = databasePath(line);
+    requireDatabase(path);
+    auto database = openDatabase(line, path, false);
+
+    if (format == "snapshot") {
+        if (!line.arguments.empty()) {
+            throw UsageError("snapshot 总是导出整个数据库, 不能指定材料名");
+        }
+        database->backupTo(output);
+        return 0;
+    }
+
+    std::vector<std::string> names = line.arguments.empty() ? database->getMaterialNames() : line.arguments;
+    nlohmann::json materials = nlohmann::json::array();
+    for (const auto &name: names) {
+        Material material = database->getMaterialByName(name);
+        if (!materialExists(material)) {
+            throw std::runtime_error("材料不存在: " + name);
+        }
+        materials.push_back(material);
+    }
+
+    std::ofstream file;
+    if (!output.empty()) {
+        file.open(output, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("无法写入 " + output);
+        }
+    }
+    std::ostream &out = output.empty() ? std::cout : file;
+    if (format == "json") {
+        out << materials.dump(2) << "\n";
+    } else {
+        std::vector<std::uint8_t> cbor = nlohmann::json::to_cbor(materials);
+        out.write(reinterpret_cast<const char *>(cbor.data()), static_cast<std::streamsize>(cbor.size()));
+    }
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("写入失败");
+    }
+    std::cerr << "导出 " << names.size() << " 个材料" << std::endl;
+    return 0;
+}
+
+std::vector<double> temperatureGrid(const CommandLine &line) {
+    double from = doubleFlag(line, "from", 300.0);
+    double to = doubleFlag(line, "to", 1500.0);
+    if (!(to >= from)) {
+        throw UsageError("--to 应不小于 --from");
+    }
+    std::vector<double> T;
+    if (line.flags.count("points")) {
+        size_t points = std::max<size_t>(1, sizeFlag(line, "points", 2));
+        for (size_t i = 0; i < points; ++i) {
+            T.push_back(points == 1 ? from : from + (to - from) * i / (points - 1));
+        }
+        return T;
+    }
+    double step = doubleFlag(line, "step", 100.0);
+    if (!(step > 0.0)) {
+        throw UsageError("--step 应为正数");
+    }
+    // 按序号计算, 避免累加误差漏掉终点
+    for (size_t i = 0; from + step * i <= to * (1.0 + 1e-12); ++i) {
+        T.push_back(from + step * i);
+    }
+    return T;
+}
+
+int runEval(const CommandLine &line) {
+    checkFlags(line, {"from", "to", "step", "points", "pressure", "derivatives"});
+    if (line.arguments.size() != 2) {
+        throw UsageError("eval 需要材料名和物性名");
+    }
+    std::string path = databasePath(line);
+    requireDatabase(path);
+    auto database = openDatabase(line, path, false);
+    Material material = database->getMaterialByName(line.arguments[0]);
+    if (!materialExists(material)) {
+        throw std::runtime_error("材料不存在: " + line.arguments[0]);
+    }
+    const std::string &key = line.arguments[1];
+    if (!material.hasProperty(key)) {
+        throw std::runtime_error(material.name + " 没有物性 " + key);
+    }
+    const auto &coefficients = material.getProperty(key);
+    const std::vector<double> T = temperatureGrid(line);
+    const double p = doubleFlag(line, "pressure", kReferencePressure);
+    const bool derivatives = line.flags.count("derivatives") > 0;
+    const size_t batchSize = std::max<size_t>(1, sizeFlag(line, "batch-size", 1024));
+
+    // 每个系数一列; 按 batch-size 分块后由多个线程求值
+    std::vector<std::vector<double>> values(coefficients.size(), std::vector<double>(T.size()));
+    std::vector<std::vector<double>> slopes(coefficients.size(), std::vector<double>(derivatives ? T.size() : 0));
+    size_t blocks = (T.size() + batchSize - 1) / batchSize;
+    parallelFor(blocks * coefficients.size(), threadCount(line), [&](size_t begin, size_t end) {
+        for (size_t job = begin; job < end; ++job) {
+            size_t c = job / blocks;
+            size_t offset = (job % blocks) * batchSize;
+            size_t count = std::min(batchSize, T.size() - offset);
+            if (derivatives) {
+                evaluatePropertyDerivatives(coefficients[c], T.data() + offset, values[c].data() + offset,
+                                            slopes[c].data() + offset, nullptr, count, p);
+            } else {
+                evaluateProperty(coefficients[c], T.data() + offset, values[c].data() + offset, count, p);
+            }
+        }
+    });
+
+    std::cout << "T";
+    for (const auto &coefficient: coefficients) {
+        std::string type = nlohmann::json(coefficient.coeffType).is_string()
+                           ? nlohmann::json(coefficient.coeffType).get<std::string>() : "none";
+        std::cout << "\t" << type;
+        if (derivatives) {
+            std::cout << "\td/dT";
+        }
+    }
+    std::cout << "\n" << std::setprecision(10);
+    for (size_t i = 0; i < T.size(); ++i) {
+        std::cout << T[i];
+        for (size_t c = 0; c < coefficients.size(); ++c) {
+            std::cout << "\t" << values[c][i];
+            if (derivatives) {
+                std::cout << "\t" << slopes[c][i];
+            }
+        }
+        std::cout << "\n";
+    }
+    return 0;
+}
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int runBench(const CommandLine &line) {
+    checkFlags(line, {"repeat", "queue", "translators", "dictionary"});
+    if (line.arguments.size() > 1) {
+        throw UsageError("bench 最多接受一个 SCM 文件");
+    }
+    std::string scmFile = line.arguments.empty() ? "propdb.scm" : line.arguments[0];
+    std::string path = stringFlag(line, "db", ":memory:");
+    if (path != ":memory:" && std::filesystem::exists(path)) {
+        throw std::runtime_error("bench 会写入数据库, 请指定不存在的文件: " + path);
+    }
+    const size_t repeat = std::max<size_t>(1, sizeFlag(line, "repeat", 3));
+    const unsigned threads = threadCount(line);
+    std::cout << std::fixed << std::setprecision(3);
+
+    // 导入
+    auto database = openDatabase(line, path, true);
+    auto stats = importFile(line, *database, scmFile, false);
+    stats.print(std::cout);
+    std::cout << std::fixed << std::setprecision(3);
+
+    // 按名称查询, 单连接
+    std::vector<std::string> names = database->getMaterialNames();
+    std::vector<Material> materials;
+    auto start = Clock::now();
+    for (size_t r = 0; r < repeat; ++r) {
+        materials.clear();
+        for (const auto &name: names) {
+            materials.push_back(database->getMaterialByName(name));
+        }
+    }
+    double lookupSeconds = secondsSince(start);
+    size_t lookups = repeat * names.size();
+    std::cout << "get:    " << lookups << " lookups, " << (lookups ? lookupSeconds / lookups * 1e6 : 0.0)
+              << " us/lookup" << std::endl;
+
+    // 所有系数在 300-3000 K 上批量求值
+    std::vector<const MaterialProperty *> coefficients;
+    for (const auto &material: materials) {
+        for (const auto &property: material.properties) {
+            for (const auto &coefficient: property.second) {
+                coefficients.push_back(&coefficient);
+            }
+        }
+    }
+    const size_t batchSize = std::max<size_t>(1, sizeFlag(line, "batch-size", 1024));
+    std::vector<double> T(batchSize);
+    for (size_t i = 0; i < batchSize; ++i) {
+        T[i] = 300.0 + 2700.0 * i / batchSize;
+    }
+    start = Clock::now();
+    parallelFor(coefficients.size(), threads, [&](size_t begin, size_t end) {
+        std::vector<double> out(batchSize);
+        for (size_t r = 0; r < repeat; ++r) {
+            for (size_t i = begin; i < end; ++i) {
+                evaluateProperty(*coefficients[i], T.data(), out.data(), batchSize);
+            }
+        }
+    });
+    double evalSeconds = secondsSince(start);
+    double points = double(repeat) * coefficients.size() * batchSize;
+    std::cout << "eval:   " << coefficients.size() << " coefficients x " << batchSize << " points x " << repeat
+              << ", " << threads << " threads, " << (evalSeconds > 0.0 ? points / evalSeconds / 1e6 : 0.0)
+              << " Mpoints/s" << std::endl;
+    return 0;
+}
+
+MaterialDaemon *gDaemon = nullptr;
+
+void stopDaemon(int) {
+    if (gDaemon != nullptr) {
+        gDaemon->stop();
+    }
+}
+
+int runDaemon(const CommandLine &line) {
+    checkFlags(line, {"shm", "socket"});
+    if (line.arguments.size() > 1) {
+        throw UsageError("daemon 最多接受一个材料来源");
+    }
+    MaterialDaemonOptions options;
+    options.source = line.arguments.empty() ? databasePath(line) : line.arguments[0];
+    options.sharedTableName = stringFlag(line, "shm", options.sharedTableName);
+    options.socketPath = stringFlag(line, "socket", options.socketPath);
+    MaterialDaemon daemon(options);
+    std::cerr << daemon.handleCommand("status") << std::endl;
+
+    gDaemon = &daemon;
+    std::signal(SIGINT, stopDaemon);
+    std::signal(SIGTERM, stopDaemon);
+    daemon.run();
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    gDaemon = nullptr;
+    return 0;
+}
+
+int runControl(const CommandLine &line) {
+    checkFlags(line, {"socket"});
+    if (line.arguments.empty()) {
+        throw UsageError("ctl 需要一个请求, 例如 status");
+    }
+    std::string request;
+    for (const auto &word: line.arguments) {
+        request += (request.empty() ? "" : " ") + word;
+    }
+    std::string reply = sendDaemonCommand(stringFlag(line, "socket", "material_db.sock"), request);
+    std::cout << reply << std::endl;
+    return reply.rfind("ok", 0) == 0 ? 0 : 1;
+}
+
+const char *batchStatusText(BatchKeyStatus status) {
+    switch (status) {
+        case BatchKeyStatus::Ok:
+            return "ok";
+        case BatchKeyStatus::UnknownMaterial:
+            return "材料不存在";
+        case BatchKeyStatus::UnknownProperty:
+            return "物性不存在";
+        case BatchKeyStatus::UnknownCoefficient:
+            return "系数序号越界";
+        default:
+            return "未知的状态";
+    }
+}
+
+int runBatch(const CommandLine &line) {
+    checkFlags(line, {"coefficient", "derivatives", "socket"});
+    if (line.arguments.size() > 1) {
+        throw UsageError("batch 最多接受一个输入文件");
+    }
+    std::ifstream file;
+    if (!line.arguments.empty()) {
+        file.open(line.arguments[0]);
+        if (!file) {
+            throw std::runtime_error("无法打开 " + line.arguments[0]);
+        }
+    }
+    std::istream &in = line.arguments.empty() ? std::cin : file;
+
+    BatchRequest request;
+    request.derivatives = line.flags.count("derivatives") > 0;
+    const auto coefficient = static_cast<uint32_t>(sizeFlag(line, "coefficient", 0));
+    std::map<std::pair<std::string, std::string>, uint32_t> keys;
+    std::string text;
+    for (size_t number = 1; std::getline(in, text); ++number) {
+        std::istringstream fields(text);
+        std::vector<std::string> words;
+        for (std::string word; fields >> word;) {
+            words.push_back(word);
+        }
+        if (words.empty()) {
+            continue;
+        }
+        double T, p = kReferencePressure;
+        try {
+            if (words.size() != 3 && words.size() != 4) {
+                throw std::invalid_argument(text);
+            }
+            T = std::stod(words[2]);
+            if (words.size() == 4) {
+                p = std::stod(words[3]);
             }
+        } catch (const std::exception &) {
+            throw std::runtime_error("第 " + std::to_string(number) + " 行应为 \"材料 物性 T [p]\": " + text);
+        }
+        const std::string &material = words[0], &property = words[1];
+        auto key = keys.emplace(std::make_pair(material, property), static_cast<uint32_t>(keys.size()));
+        if (key.second) {
+            request.keys.push_back({material, property, coefficient});
+        }
+        request.add(key.first->second, T, p);
+    }
 
-            ///< translate name into chinese
-            std::cout << "Chinese name: " << material.chinese_name << std::endl;
-            dbManager.insertMaterial(material);
+    BatchResponse response = sendDaemonBatch(stringFlag(line, "socket", "material_db.sock"), request);
+    if (response.status.size() != request.keys.size() || response.value.size() != request.T.size()) {
+        throw std::runtime_error("批量应答与请求的键数或点数不一致");
+    }
+    int status = 0;
+    for (size_t k = 0; k < request.keys.size(); ++k) {
+        if (response.status[k] != BatchKeyStatus::Ok) {
+            std::cerr << request.keys[k].material << " " << request.keys[k].property << ": "
+                      << batchStatusText(response.status[k]) << std::endl;
+            status = 1;
         }
+    }
+    std::cout << "T\tp\tvalue" << (request.derivatives ? "\td/dT\td/dp" : "") << "\n" << std::setprecision(10);
+    for (size_t i = 0; i < request.T.size(); ++i) {
+        std::cout << request.T[i] << "\t" << request.p[i] << "\t" << response.value[i];
+        if (request.derivatives) {
+            std::cout << "\t" << response.dvdT[i] << "\t" << response.dvdp[i];
+        }
+        std::cout << "\n";
+    }
+    return status;
+}
+
+int dispatch(const CommandLine &line) {
+    static const std::map<std::string, int (*)(const CommandLine &)> commands = {
+            {"import", runImport},
+            {"get",    runGet},
+            {"search", runSearch},
+            {"export", runExport},
+            {"eval",   runEval},
+            {"bench",  runBench},
+            {"daemon", runDaemon},
+            {"ctl",    runControl},
+            {"batch",  runBatch},
+    };
+    if (line.command.empty() || line.command == "help" || line.flags.count("help")) {
+        printUsage(std::cout);
+        return line.command.empty() && !line.flags.count("help") ? 2 : 0;
+    }
+    auto it = commands.find(line.command);
+    if (it == commands.end()) {
+        throw UsageError("未知命令: " + line.command);
+    }
+    return it->second(line);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int status;
+    try {
+        status = dispatch(parseCommandLine(argc, argv));
+    } catch (const UsageError &e) {
+        std::cerr << e.what() << "\n\n";
+        printUsage(std::cerr);
+        status = 2;
     } catch (const std::exception &e) {
         std::cerr << "处理数据库时发生错误: " << e.what() << std::endl;
+        status = 1;
     }
-    return 0;
-}
\ No newline at end of file
+    // MATDB_METRICS_PROM / MATDB_METRICS_JSON / MATDB_TRACE 指定导出路径
+    try {
+        exportMetricsFromEnvironment();
+        writeTraceFromEnvironment();
+    } catch (const std::exception &e) {
+        std::cerr << "导出指标失败: " << e.what() << std::endl;
+    }
+    return status;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace CFD_MaterialDB {
+
+// 线程槽位数. 前 kMetricSlots 个存活线程各自独占一个槽位, 槽内计数只有本线程写, 用普通的读后写更新
+// (带 lock 前缀的原子加约 10 ns, 与一次物性求值相当); 更多的线程共用 kSharedMetricSlot, 用原子加.
+// 线程退出时归还槽位, 槽内已累计的值保留给下一个使用者
+constexpr size_t kMetricSlots = 32;
+constexpr size_t kSharedMetricSlot = kMetricSlots;
+
+constexpr size_t kUnassignedMetricSlot = ~size_t(0);
+
+// 为当前线程分配槽位并登记线程退出时的归还; 归还后 *cache 改为 kSharedMetricSlot
+size_t assignMetricSlot(size_t *cache);
+
+// 当前线程的槽位. 缓存变量是常量初始化的, 访问时不经过 thread_local 的初始化检查
+inline size_t metricSlot() {
+    thread_local size_t slot = kUnassignedMetricSlot;
+    if (slot == kUnassignedMetricSlot) {
+        slot = assignMetricSlot(&slot);
+    }
+    return slot;
+}
+
+inline void addToSlot(std::atomic<uint64_t> &cell, size_t slot, uint64_t n) {
+    if (slot == kSharedMetricSlot) {
+        cell.fetch_add(n, std::memory_order_relaxed);
+    } else {
+        cell.store(cell.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+}
+
+// Prometheus 标签, 按给出的顺序输出
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+// 单调递增计数器
+class Counter {
+public:
+    void add(uint64_t n = 1) {
+        size_t slot = metricSlot();
+        addToSlot(slots_[slot].value, slot, n);
+    }
+
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> value{0};
+    };
+
+    Slot slots_[kMetricSlots + 1];
+};
+
+struct HistogramSnapshot {
+    std::vector<double> bounds;      // 各桶上界 (不含 +Inf)
+    std::vector<uint64_t> counts;    // 落在各桶内的次数, 比 bounds 多一个 +Inf 桶; 非累计
+    uint64_t count = 0;
+    double sum = 0.0;
+};
+
+// 固定桶边界的直方图, 每个槽位各自一套桶计数和总和
+class Histogram {
+public:
+    explicit Histogram(std::vector<double> bounds);
+
+    void observe(double value);
+
+    HistogramSnapshot snapshot() const;
+
+    const std::vector<double> &bounds() const { return bounds_; }
+
+private:
+    struct alignas(64) Slot {
+        std::unique_ptr<std::atomic<uint64_t>[]> counts;
+        std::atomic<double> sum{0.0};
+    };
+
+    std::vector<double> bounds_;
+    Slot slots_[kMetricSlots + 1];
+};
+
+// 1 µs 到约 30 s, 按 ~3.16 倍递增的延迟桶 (秒)
+std::vector<double> defaultLatencyBuckets();
+
+// 作用域计时, 析构时把经过的秒数记入直方图
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram &histogram)
+            : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() {
+        histogram_.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count());
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    Histogram &histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// 进程内的指标注册表. 同名同标签的指标只创建一次, 返回的引用在进程生命周期内有效,
+// 调用方应在热路径外 (例如函数内的 static) 取得引用后反复使用
+class MetricsRegistry {
+public:
+    static MetricsRegistry &global();
+
+    Counter &counter(const std::string &name, const std::string &help, const MetricLabels &labels = {});
+
+    // 同一名称的所有标签组合共用第一次注册时的桶边界
+    Histogram &histogram(const std::string &name, const std::string &help, const MetricLabels &labels = {},
+                         const std::vector<double> &bounds = defaultLatencyBuckets());
+
+    // Prometheus 文本格式 (0.0.4)
+    void writePrometheus(std::ostream &out) const;
+
+    // {"counters": [{name, labels, value}], "histograms": [{name, labels, count, sum, buckets}]}
+    nlohmann::json snapshot() const;
+
+    // 先写临时文件再改名, 采集端不会读到半个文件; 失败时抛出
+    void writePrometheusFile(const std::string &path) const;
+    void writeJsonFile(const std::string &path) const;
+
+private:
+    enum class Kind { Counter, Histogram };
+
+    struct Family {
+        Kind kind;
+        std::string help;
+        std::vector<double> bounds;
+        std::map<std::string, std::pair<MetricLabels, std::unique_ptr<Counter>>> counters;
+        std::map<std::string, std::pair<MetricLabels, std::unique_ptr<Histogram>>> histograms;
+    };
+
+    Family &family(const std::string &name, const std::string &help, Kind kind);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Family> families_;
+};
+
+// 按环境变量 MATDB_METRICS_PROM / MATDB_METRICS_JSON 指定的路径导出全局注册表, 未设置的跳过
+void exportMetricsFromEnvironment();
+
+} // namespace CFD_MaterialDB
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace CFD_MaterialDB {
+
+// Chrome trace 时间线 (chrome://tracing 或 ui.perfetto.dev 打开). 设置环境变量 MATDB_TRACE=文件 时启用.
+// 每个线程把事件追加到自己的缓冲区, 只有本线程写, 追加不加锁; 导出时逐块读取已发布的事件
+
+extern std::atomic<bool> gTracingEnabled;
+
+inline bool tracingEnabled() {
+    return gTracingEnabled.load(std::memory_order_relaxed);
+}
+
+void setTracingEnabled(bool enabled);
+
+// 自进程启动 (追踪时钟起点) 以来的纳秒数
+uint64_t traceClockNs();
+
+// 当前线程在时间线上显示的名称
+void setTraceThreadName(const std::string &name);
+
+// 记录一个完整事件 (Chrome trace 的 "X" 事件). name 和 category 必须是静态字符串, detail 超过 63 字节时截断.
+// 单个线程最多保留 kMaxTraceEventsPerThread 个事件, 超出的丢弃并计数
+constexpr size_t kMaxTraceEventsPerThread = size_t(1) << 20;
+
+void recordTraceEvent(const char *name, const char *category, uint64_t beginNs, uint64_t endNs,
+                      const std::string &detail = std::string());
+
+// 作用域事件; 未启用追踪时只有一次标志读取. 需要拼接的 detail 以返回 std::string 的函数传入,
+// 只在启用追踪时调用, 例如 TraceSpan span("batch", "daemon", [&] { return std::to_string(n) + " points"; });
+class TraceSpan {
+public:
+    TraceSpan(const char *name, const char *category, const std::string &detail = std::string())
+            : name_(name), category_(category) {
+        if (tracingEnabled()) {
+            active_ = true;
+            detail_ = detail;
+            begin_ = traceClockNs();
+        }
+    }
+
+    template<typename MakeDetail,
+             typename = std::enable_if_t<std::is_invocable_r_v<std::string, MakeDetail &>>>
+    TraceSpan(const char *name, const char *category, MakeDetail &&makeDetail)
+            : name_(name), category_(category) {
+        if (tracingEnabled()) {
+            active_ = true;
+            detail_ = makeDetail();
+            begin_ = traceClockNs();
+        }
+    }
+
+    ~TraceSpan() {
+        if (active_) {
+            recordTraceEvent(name_, category_, begin_, traceClockNs(), detail_);
+        }
+    }
+
+    // 结束前补充说明, 例如解析出的材料名
+    void setDetail(const std::string &detail) {
+        if (active_) {
+            detail_ = detail;
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *name_;
+    const char *category_;
+    bool active_ = false;
+    uint64_t begin_ = 0;
+    std::string detail_;
+};
+
+// {"traceEvents": [...]}; 可以在其他线程仍在记录时调用, 只写出已完成的事件
+void writeChromeTrace(std::ostream &out);
+void writeChromeTraceFile(const std::string &path);
+
+// 按环境变量 MATDB_TRACE 指定的路径写出, 未设置时跳过
+void writeTraceFromEnvironment();
+
+} // namespace CFD_MaterialDB
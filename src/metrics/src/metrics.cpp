@@ -0,0 +1,312 @@
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace CFD_MaterialDB {
+
+namespace {
+
+std::string escapeLabelValue(const std::string &value) {
+    std::string escaped;
+    for (char c: value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// {a="1",b="2"}; extra 追加在末尾 (直方图的 le 标签)
+std::string formatLabels(const MetricLabels &labels, const std::string &extra = std::string()) {
+    if (labels.empty() && extra.empty()) {
+        return std::string();
+    }
+    std::string text = "{";
+    for (size_t i = 0; i < labels.size(); ++i) {
+        text += (i ? "," : "") + labels[i].first + "=\"" + escapeLabelValue(labels[i].second) + "\"";
+    }
+    if (!extra.empty()) {
+        text += (labels.empty() ? "" : ",") + extra;
+    }
+    return text + "}";
+}
+
+std::string formatNumber(double value, int precision = 17) {
+    if (std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+    return buffer;
+}
+
+nlohmann::json labelsJson(const MetricLabels &labels) {
+    nlohmann::json object = nlohmann::json::object();
+    for (const auto &label: labels) {
+        object[label.first] = label.second;
+    }
+    return object;
+}
+
+void writeAtomically(const std::string &path, const std::string &content) {
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("无法写入指标文件: " + temporary);
+        }
+        file << content;
+        if (!file.flush()) {
+            throw std::runtime_error("写入指标文件失败: " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("无法替换指标文件: " + path);
+    }
+}
+
+std::mutex &slotMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+// 空闲的独占槽位, 按序号从小到大分配
+std::vector<size_t> &freeSlots() {
+    static std::vector<size_t> slots = [] {
+        std::vector<size_t> list;
+        for (size_t i = kMetricSlots; i > 0; --i) {
+            list.push_back(i - 1);
+        }
+        return list;
+    }();
+    return slots;
+}
+
+// 线程退出时归还独占槽位. 槽位的交接经过互斥锁, 新使用者能看到前一个使用者写入的值
+struct SlotOwner {
+    ~SlotOwner() {
+        if (slot == kSharedMetricSlot) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(slotMutex());
+            freeSlots().push_back(slot);
+        }
+        // 之后的线程析构阶段若仍有计数, 改用共享槽位
+        *cache = kSharedMetricSlot;
+    }
+
+    size_t slot = kSharedMetricSlot;
+    size_t *cache = nullptr;
+};
+
+} // namespace
+
+size_t assignMetricSlot(size_t *cache) {
+    thread_local SlotOwner owner;
+    if (owner.cache == nullptr) {
+        std::lock_guard<std::mutex> lock(slotMutex());
+        auto &slots = freeSlots();
+        if (!slots.empty()) {
+            owner.slot = slots.back();
+            slots.pop_back();
+        }
+        owner.cache = cache;
+    }
+    return owner.slot;
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto &slot: slots_) {
+        total += slot.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+Histogram::Histogram(std::vector<double> bounds) : bounds_(std::move(bounds)) {
+    if (!std::is_sorted(bounds_.begin(), bounds_.end())) {
+        throw std::runtime_error("直方图的桶边界必须递增");
+    }
+    for (auto &slot: slots_) {
+        slot.counts.reset(new std::atomic<uint64_t>[bounds_.size() + 1]);
+        for (size_t i = 0; i <= bounds_.size(); ++i) {
+            slot.counts[i].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void Histogram::observe(double value) {
+    // 桶数很少 (十几个), 线性查找比二分更快
+    size_t bucket = 0;
+    while (bucket < bounds_.size() && value > bounds_[bucket]) {
+        ++bucket;
+    }
+    size_t index = metricSlot();
+    Slot &slot = slots_[index];
+    addToSlot(slot.counts[bucket], index, 1);
+    double sum = slot.sum.load(std::memory_order_relaxed);
+    if (index != kSharedMetricSlot) {
+        slot.sum.store(sum + value, std::memory_order_relaxed);
+        return;
+    }
+    while (!slot.sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed)) {
+    }
+}
+
+HistogramSnapshot Histogram::snapshot() const {
+    HistogramSnapshot snapshot;
+    snapshot.bounds = bounds_;
+    snapshot.counts.assign(bounds_.size() + 1, 0);
+    for (const auto &slot: slots_) {
+        for (size_t i = 0; i <= bounds_.size(); ++i) {
+            snapshot.counts[i] += slot.counts[i].load(std::memory_order_relaxed);
+        }
+        snapshot.sum += slot.sum.load(std::memory_order_relaxed);
+    }
+    for (uint64_t count: snapshot.counts) {
+        snapshot.count += count;
+    }
+    return snapshot;
+}
+
+std::vector<double> defaultLatencyBuckets() {
+    std::vector<double> bounds;
+    for (int exponent = -12; exponent <= 3; ++exponent) {
+        bounds.push_back(std::pow(10.0, exponent * 0.5));
+    }
+    return bounds;
+}
+
+MetricsRegistry &MetricsRegistry::global() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Family &MetricsRegistry::family(const std::string &name, const std::string &help, Kind kind) {
+    auto it = families_.find(name);
+    if (it == families_.end()) {
+        it = families_.emplace(name, Family{kind, help, {}, {}, {}}).first;
+    } else if (it->second.kind != kind) {
+        throw std::runtime_error("指标 " + name + " 已按另一种类型注册");
+    }
+    return it->second;
+}
+
+Counter &MetricsRegistry::counter(const std::string &name, const std::string &help, const MetricLabels &labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Family &f = family(name, help, Kind::Counter);
+    auto &entry = f.counters[formatLabels(labels)];
+    if (!entry.second) {
+        entry.first = labels;
+        entry.second = std::make_unique<Counter>();
+    }
+    return *entry.second;
+}
+
+Histogram &MetricsRegistry::histogram(const std::string &name, const std::string &help, const MetricLabels &labels,
+                                      const std::vector<double> &bounds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Family &f = family(name, help, Kind::Histogram);
+    if (f.histograms.empty()) {
+        f.bounds = bounds;
+    }
+    auto &entry = f.histograms[formatLabels(labels)];
+    if (!entry.second) {
+        entry.first = labels;
+        entry.second = std::make_unique<Histogram>(f.bounds);
+    }
+    return *entry.second;
+}
+
+void MetricsRegistry::writePrometheus(std::ostream &out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &item: families_) {
+        const std::string &name = item.first;
+        const Family &f = item.second;
+        out << "# HELP " << name << " " << f.help << "\n";
+        if (f.kind == Kind::Counter) {
+            out << "# TYPE " << name << " counter\n";
+            for (const auto &series: f.counters) {
+                out << name << series.first << " " << series.second.second->value() << "\n";
+            }
+            continue;
+        }
+        out << "# TYPE " << name << " histogram\n";
+        for (const auto &series: f.histograms) {
+            const MetricLabels &labels = series.second.first;
+            HistogramSnapshot snapshot = series.second.second->snapshot();
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i <= snapshot.bounds.size(); ++i) {
+                cumulative += snapshot.counts[i];
+                double bound = i < snapshot.bounds.size() ? snapshot.bounds[i]
+                                                          : std::numeric_limits<double>::infinity();
+                out << name << "_bucket" << formatLabels(labels, "le=\"" + formatNumber(bound, 6) + "\"") << " "
+                    << cumulative << "\n";
+            }
+            out << name << "_sum" << series.first << " " << formatNumber(snapshot.sum) << "\n";
+            out << name << "_count" << series.first << " " << snapshot.count << "\n";
+        }
+    }
+}
+
+nlohmann::json MetricsRegistry::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    nlohmann::json counters = nlohmann::json::array();
+    nlohmann::json histograms = nlohmann::json::array();
+    for (const auto &item: families_) {
+        const Family &f = item.second;
+        for (const auto &series: f.counters) {
+            counters.push_back({{"name", item.first}, {"labels", labelsJson(series.second.first)},
+                                {"value", series.second.second->value()}});
+        }
+        for (const auto &series: f.histograms) {
+            HistogramSnapshot snapshot = series.second.second->snapshot();
+            nlohmann::json buckets = nlohmann::json::array();
+            for (size_t i = 0; i <= snapshot.bounds.size(); ++i) {
+                // JSON 没有 Infinity, 最后一个桶的上界记为 null
+                nlohmann::json bound = i < snapshot.bounds.size() ? nlohmann::json(snapshot.bounds[i])
+                                                                  : nlohmann::json(nullptr);
+                buckets.push_back({{"le", bound}, {"count", snapshot.counts[i]}});
+            }
+            histograms.push_back({{"name", item.first}, {"labels", labelsJson(series.second.first)},
+                                  {"count", snapshot.count}, {"sum", snapshot.sum}, {"buckets", buckets}});
+        }
+    }
+    return {{"counters", counters}, {"histograms", histograms}};
+}
+
+void MetricsRegistry::writePrometheusFile(const std::string &path) const {
+    std::ostringstream out;
+    writePrometheus(out);
+    writeAtomically(path, out.str());
+}
+
+void MetricsRegistry::writeJsonFile(const std::string &path) const {
+    writeAtomically(path, snapshot().dump(2) + "\n");
+}
+
+void exportMetricsFromEnvironment() {
+    const auto &registry = MetricsRegistry::global();
+    if (const char *path = std::getenv("MATDB_METRICS_PROM")) {
+        registry.writePrometheusFile(path);
+    }
+    if (const char *path = std::getenv("MATDB_METRICS_JSON")) {
+        registry.writeJsonFile(path);
+    }
+}
+
+} // namespace CFD_MaterialDB
@@ -0,0 +1,225 @@
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace CFD_MaterialDB {
+
+std::atomic<bool> gTracingEnabled{std::getenv("MATDB_TRACE") != nullptr};
+
+namespace {
+
+const auto kTraceEpoch = std::chrono::steady_clock::now();
+
+constexpr size_t kTraceBlockEvents = 4096;
+constexpr size_t kTraceDetailBytes = 64;
+
+struct TraceEvent {
+    const char *name;
+    const char *category;
+    uint64_t beginNs;
+    uint64_t endNs;
+    char detail[kTraceDetailBytes];
+};
+
+// 事件先写入块内, 再以 release 发布 count; 读取方以 acquire 读取 count 后只访问已发布的事件
+struct TraceBlock {
+    TraceEvent events[kTraceBlockEvents];
+    std::atomic<size_t> count{0};
+    std::atomic<TraceBlock *> next{nullptr};
+};
+
+// 线程退出后缓冲区仍然保留, 直到进程结束
+struct ThreadTrace {
+    ~ThreadTrace() {
+        for (TraceBlock *block = head ? head->next.load() : nullptr; block != nullptr;) {
+            TraceBlock *next = block->next.load();
+            delete block;
+            block = next;
+        }
+    }
+
+    uint32_t tid = 0;
+    std::string name;               // 受 registryMutex 保护
+    std::unique_ptr<TraceBlock> head;
+    TraceBlock *tail = nullptr;     // 只有所属线程访问
+    size_t recorded = 0;            // 只有所属线程访问
+    std::atomic<size_t> dropped{0};
+};
+
+std::mutex &registryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::vector<std::unique_ptr<ThreadTrace>> &threadTraces() {
+    static std::vector<std::unique_ptr<ThreadTrace>> traces;
+    return traces;
+}
+
+ThreadTrace &currentThreadTrace() {
+    thread_local ThreadTrace *current = nullptr;
+    if (current == nullptr) {
+        auto trace = std::make_unique<ThreadTrace>();
+        trace->head = std::make_unique<TraceBlock>();
+        trace->tail = trace->head.get();
+        std::lock_guard<std::mutex> lock(registryMutex());
+        auto &traces = threadTraces();
+        trace->tid = static_cast<uint32_t>(traces.size() + 1);
+        trace->name = "thread-" + std::to_string(trace->tid);
+        current = trace.get();
+        traces.push_back(std::move(trace));
+    }
+    return *current;
+}
+
+void writeEscaped(std::ostream &out, const char *text) {
+    out << '"';
+    for (const char *c = text; *c; ++c) {
+        unsigned char ch = static_cast<unsigned char>(*c);
+        if (ch == '"' || ch == '\\') {
+            out << '\\' << *c;
+        } else if (ch < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", ch);
+            out << escaped;
+        } else {
+            out << *c;
+        }
+    }
+    out << '"';
+}
+
+// 微秒, 保留到纳秒
+void writeMicroseconds(std::ostream &out, uint64_t ns) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%llu.%03llu", static_cast<unsigned long long>(ns / 1000),
+                  static_cast<unsigned long long>(ns % 1000));
+    out << buffer;
+}
+
+// 截断时不拆开 UTF-8 多字节字符
+void copyDetail(char *target, const std::string &detail) {
+    size_t length = std::min(detail.size(), kTraceDetailBytes - 1);
+    while (length < detail.size() && length > 0 && (static_cast<unsigned char>(detail[length]) & 0xC0) == 0x80) {
+        --length;
+    }
+    std::memcpy(target, detail.data(), length);
+    target[length] = '\0';
+}
+
+} // namespace
+
+void setTracingEnabled(bool enabled) {
+    gTracingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t traceClockNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - kTraceEpoch)
+            .count();
+}
+
+void setTraceThreadName(const std::string &name) {
+    if (!tracingEnabled()) {
+        return;
+    }
+    ThreadTrace &trace = currentThreadTrace();
+    std::lock_guard<std::mutex> lock(registryMutex());
+    trace.name = name;
+}
+
+void recordTraceEvent(const char *name, const char *category, uint64_t beginNs, uint64_t endNs,
+                      const std::string &detail) {
+    ThreadTrace &trace = currentThreadTrace();
+    if (trace.recorded >= kMaxTraceEventsPerThread) {
+        trace.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceBlock *block = trace.tail;
+    size_t index = block->count.load(std::memory_order_relaxed);
+    if (index == kTraceBlockEvents) {
+        auto *next = new TraceBlock();
+        block->next.store(next, std::memory_order_release);
+        trace.tail = block = next;
+        index = 0;
+    }
+    TraceEvent &event = block->events[index];
+    event.name = name;
+    event.category = category;
+    event.beginNs = beginNs;
+    event.endNs = endNs;
+    copyDetail(event.detail, detail);
+    block->count.store(index + 1, std::memory_order_release);
+    ++trace.recorded;
+}
+
+void writeChromeTrace(std::ostream &out) {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&] {
+        out << (first ? "" : ",\n");
+        first = false;
+    };
+    for (const auto &trace: threadTraces()) {
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << trace->tid << ",\"args\":{\"name\":";
+        writeEscaped(out, trace->name.c_str());
+        out << "}}";
+        size_t dropped = trace->dropped.load(std::memory_order_relaxed);
+        if (dropped > 0) {
+            separator();
+            out << "{\"name\":\"dropped_events\",\"ph\":\"M\",\"pid\":1,\"tid\":" << trace->tid
+                << ",\"args\":{\"count\":" << dropped << "}}";
+        }
+        for (const TraceBlock *block = trace->head.get(); block != nullptr;
+             block = block->next.load(std::memory_order_acquire)) {
+            size_t count = block->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; ++i) {
+                const TraceEvent &event = block->events[i];
+                separator();
+                out << "{\"name\":";
+                writeEscaped(out, event.name);
+                out << ",\"cat\":";
+                writeEscaped(out, event.category);
+                out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << trace->tid << ",\"ts\":";
+                writeMicroseconds(out, event.beginNs);
+                out << ",\"dur\":";
+                writeMicroseconds(out, event.endNs - event.beginNs);
+                if (event.detail[0] != '\0') {
+                    out << ",\"args\":{\"detail\":";
+                    writeEscaped(out, event.detail);
+                    out << "}";
+                }
+                out << "}";
+            }
+        }
+    }
+    out << "\n]}\n";
+}
+
+void writeChromeTraceFile(const std::string &path) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("无法写入追踪文件: " + path);
+    }
+    writeChromeTrace(file);
+    if (!file.flush()) {
+        throw std::runtime_error("写入追踪文件失败: " + path);
+    }
+}
+
+void writeTraceFromEnvironment() {
+    if (const char *path = std::getenv("MATDB_TRACE")) {
+        writeChromeTraceFile(path);
+    }
+}
+
+} // namespace CFD_MaterialDB
@@ -9,6 +9,15 @@
 #include <nlohmann/json.hpp>
 #include <sstream>  // For std::istringstream
 #include <optional>
+#include <memory>
+#include <new>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace CFD_MaterialDB {
+class ExpressionProgram;
+}
 
 enum MaterialState {
     INVALID = -1,
@@ -77,27 +86,134 @@ struct MaterialType {
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(MaterialType, state, particle_flags)
 
 
+// 按缓存行对齐分配, 使定长分段系数块各自落在整数个缓存行中
+template<typename T, size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template<typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T *p, size_t) {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const { return true; }
+
+    template<typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment> &) const { return false; }
+};
+
+using AlignedDoubles = std::vector<double, AlignedAllocator<double>>;
+
+// NASA-9 每段 7 个系数: cp = a1 T^-2 + a2 T^-1 + a3 + a4 T + a5 T^2 + a6 T^3 + a7 T^4, 补零到 8 个 (一个缓存行)
+constexpr size_t kNasa9Coefficients = 7;
+constexpr size_t kNasa9Stride = 8;
+
+// NASA-9 分段多项式, 段数不限. 第 i 段的温度区间为 [temp_ranges[i], temp_ranges[i+1]],
+// 系数存放在 coefficients[i * kNasa9Stride, (i + 1) * kNasa9Stride)
 struct NASAPolynomialData {
-    std::array<std::vector<double>, 3> segments;
-    std::array<double, 2> temp_ranges = {0.0, 0.0};
+    std::vector<double> temp_ranges;
+    AlignedDoubles coefficients;
+
+    size_t segmentCount() const { return coefficients.size() / kNasa9Stride; }
+
+    const double *segment(size_t i) const { return coefficients.data() + i * kNasa9Stride; }
+
+    // 追加一段 [tMin, tMax]; 与上一段不衔接时以新段的下界为分界
+    void addSegment(double tMin, double tMax, const double *a) {
+        if (temp_ranges.empty()) {
+            temp_ranges.push_back(tMin);
+        } else {
+            temp_ranges.back() = tMin;
+        }
+        temp_ranges.push_back(tMax);
+        coefficients.insert(coefficients.end(), a, a + kNasa9Coefficients);
+        coefficients.resize(coefficients.size() + kNasa9Stride - kNasa9Coefficients, 0.0);
+    }
 };
 
-NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(NASAPolynomialData, segments, temp_ranges)
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(NASAPolynomialData, temp_ranges, coefficients)
 
+// 点数达到该值时建立均匀分桶索引, 点数更少时直接顺序比较
+constexpr size_t kPiecewiseLinearIndexPoints = 8;
+constexpr size_t kPiecewiseLinearMaxBuckets = 4096;
+
+// 分段线性表 (temp_ranges[i], coefficients[i]), 温度递增. slopes 与分桶索引由 buildIndex() 生成, 不序列化:
+// 桶宽不大于最短区间, buckets[b] 为落在第 b 个桶内的温度所在区间的下界, 查找时至多再前进一两个区间
 struct polyPiecewiseLinearData {
     std::vector<double> temp_ranges;
     std::vector<double> coefficients;
+
+    std::vector<double> slopes;
+    std::vector<uint32_t> buckets;
+    double bucketScale = 0.0;
+
+    // 修改 temp_ranges/coefficients 后调用; 数据不合法 (长度不一致或温度不递增) 时清空索引
+    void buildIndex();
+
+    bool indexed() const { return temp_ranges.size() >= 2 && slopes.size() + 1 == temp_ranges.size(); }
+
+    size_t bucketOf(double T) const {
+        double offset = (T - temp_ranges.front()) * bucketScale;
+        return std::min(static_cast<size_t>(offset > 0.0 ? offset : 0.0), buckets.size() - 1);
+    }
 };
 
-NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(polyPiecewiseLinearData, temp_ranges, coefficients)
+inline void to_json(nlohmann::json &j, const polyPiecewiseLinearData &data) {
+    j = nlohmann::json{{"temp_ranges", data.temp_ranges}, {"coefficients", data.coefficients}};
+}
+
+inline void from_json(const nlohmann::json &j, polyPiecewiseLinearData &data) {
+    data.temp_ranges = j.value("temp_ranges", std::vector<double>());
+    data.coefficients = j.value("coefficients", std::vector<double>());
+    data.buildIndex();
+}
+
 
+// 分段多项式每段最多 8 个系数 (7 次), 按 [Tmin, Tmax, c0..c7] 存放并补零到 16 个 double (两个缓存行)
+constexpr size_t kPiecewisePolyMaxCoefficients = 8;
+constexpr size_t kPiecewisePolyStride = 16;
 
+// 第 i 段为 segments[i * kPiecewisePolyStride, (i + 1) * kPiecewisePolyStride);
+// temp_ranges 另存 N+1 个分段边界, 供连续访问的分段查找使用
 struct PiecewisePolynomialData {
-    std::vector<std::vector<double>> coefficients;
     std::vector<double> temp_ranges;
+    AlignedDoubles segments;
+
+    size_t segmentCount() const { return segments.size() / kPiecewisePolyStride; }
+
+    const double *segment(size_t i) const { return segments.data() + i * kPiecewisePolyStride; }
+
+    // 系数 c0..c(count-1), 高次项补零; 与上一段不衔接时以新段的下界为分界
+    void addSegment(double tMin, double tMax, const double *c, size_t count) {
+        if (temp_ranges.empty()) {
+            temp_ranges.push_back(tMin);
+        } else {
+            temp_ranges.back() = tMin;
+        }
+        temp_ranges.push_back(tMax);
+        size_t base = segments.size();
+        segments.resize(base + kPiecewisePolyStride, 0.0);
+        segments[base] = tMin;
+        segments[base + 1] = tMax;
+        std::copy(c, c + count, segments.begin() + base + 2);
+    }
 };
 
-NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(PiecewisePolynomialData, coefficients, temp_ranges)
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(PiecewisePolynomialData, temp_ranges, segments)
 
 struct PolynomialData {
     std::vector<double> coefficients;
@@ -105,17 +221,105 @@ struct PolynomialData {
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(PolynomialData, coefficients)
 
+// (compressible-liquid p0 rho0 K0 n max-ratio min-ratio):
+// K = K0 + n (p - p0), rho = rho0 (K / K0)^(1/n), rho / rho0 限制在 [minDensityRatio, maxDensityRatio].
+// 比值限制为 0 表示不限制
 struct compressibleLiquidData {
-    std::vector<double> coefficients;
+    double referencePressure = 0.0;   // Pa
+    double referenceDensity = 0.0;    // kg/m^3
+    double bulkModulus = 0.0;         // Pa
+    double densityExponent = 0.0;
+    double maxDensityRatio = 0.0;
+    double minDensityRatio = 0.0;
+
+    bool valid() const { return referenceDensity > 0.0 && bulkModulus > 0.0 && densityExponent != 0.0; }
+
+    // 按 SCM 中的参数顺序; 不足 4 个时返回无效数据
+    static compressibleLiquidData fromCoefficients(const std::vector<double> &c) {
+        compressibleLiquidData data;
+        if (c.size() < 4) {
+            return data;
+        }
+        data.referencePressure = c[0];
+        data.referenceDensity = c[1];
+        data.bulkModulus = c[2];
+        data.densityExponent = c[3];
+        data.maxDensityRatio = c.size() > 4 ? c[4] : 0.0;
+        data.minDensityRatio = c.size() > 5 ? c[5] : 0.0;
+        return data;
+    }
 };
 
-NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(compressibleLiquidData, coefficients)
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(compressibleLiquidData, referencePressure, referenceDensity,
+                                                bulkModulus, densityExponent, maxDensityRatio, minDensityRatio)
+
+// (sutherland mu0 T0 S) 或 (sutherland C1 S), 统一存为 mu = C1 T^1.5 / (T + S);
+// 三参数形式在载入时换算 C1 = mu0 (T0 + S) / T0^1.5
+struct sutherlandData {
+    double C1 = 0.0;
+    double S = 0.0;
+
+    bool valid() const { return C1 > 0.0 && S >= 0.0; }
+
+    static sutherlandData fromCoefficients(const std::vector<double> &c) {
+        sutherlandData data;
+        if (c.size() == 3 && c[1] > 0.0) {
+            data.C1 = c[0] * (c[1] + c[2]) / (c[1] * std::sqrt(c[1]));
+            data.S = c[2];
+        } else if (c.size() == 2) {
+            data.C1 = c[0];
+            data.S = c[1];
+        }
+        return data;
+    }
+};
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(sutherlandData, C1, S)
+
+// (power-law mu0 T0 n) 或 (power-law B n), 统一存为 mu = B T^n; 三参数形式 B = mu0 / T0^n
+struct powerLawData {
+    double B = 0.0;
+    double n = 0.0;
+
+    bool valid() const { return B > 0.0; }
+
+    static powerLawData fromCoefficients(const std::vector<double> &c) {
+        powerLawData data;
+        if (c.size() == 3 && c[1] > 0.0) {
+            data.B = c[0] / std::pow(c[1], c[2]);
+            data.n = c[2];
+        } else if (c.size() == 2) {
+            data.B = c[0];
+            data.n = c[1];
+        }
+        return data;
+    }
+};
 
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(powerLawData, B, n)
+
+// (blottner-curve-fit A B C): mu = 0.1 exp((A ln T + B) ln T + C)
 struct blottnerData {
-    std::vector<double> coefficients;
+    double A = 0.0;
+    double B = 0.0;
+    double C = 0.0;
+    bool present = false;
+
+    bool valid() const { return present; }
+
+    static blottnerData fromCoefficients(const std::vector<double> &c) {
+        blottnerData data;
+        if (c.size() == 3) {
+            data.A = c[0];
+            data.B = c[1];
+            data.C = c[2];
+            data.present = true;
+        }
+        return data;
+    }
 };
 
-NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(blottnerData, coefficients)
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(blottnerData, A, B, C, present)
 
 
 
@@ -129,8 +333,9 @@ enum coefficientType {
     blottnerT,
     polynomialT,
     polynomialTPieceLinearT,                 ///< std::vector<double>
-    polynomialTPiecePolyT,   ///< std::vector<std::array<double, 7>>
-    nasa9PiecePolyT   ///< std::vector<std::array<double, 9>>
+    polynomialTPiecePolyT,   ///< PiecewisePolynomialData, 定长 kPiecewisePolyStride 的分段块
+    nasa9PiecePolyT,   ///< NASAPolynomialData, 定长 kNasa9Stride 的系数块
+    userDefinedT       ///< (lambda (T p) ...)
 };
 
 NLOHMANN_JSON_SERIALIZE_ENUM(coefficientType,
@@ -145,19 +350,39 @@ NLOHMANN_JSON_SERIALIZE_ENUM(coefficientType,
                                  { polynomialT, "polynomial" },
                                  { polynomialTPieceLinearT, "polynomial piecewise-linear" },
                                  { polynomialTPiecePolyT, "polynomial piecewise-polynomial" },
-                                 { nasa9PiecePolyT, "polynomial nasa-9-piecewise-polynomial" }
+                                 { nasa9PiecePolyT, "polynomial nasa-9-piecewise-polynomial" },
+                                 { userDefinedT, "user-defined" }
                              })
 
+// 用户自定义物性: 保存 lambda 源码, 载入时编译成字节码 (只序列化源码)
+struct UserDefinedData {
+    std::string source;
+    std::shared_ptr<const CFD_MaterialDB::ExpressionProgram> program;
+};
+
+inline void to_json(nlohmann::json &j, const UserDefinedData &data) {
+    j = nlohmann::json{{"source", data.source}};
+}
+
+inline void from_json(const nlohmann::json &j, UserDefinedData &data) {
+    data.source = j.value("source", std::string());
+    data.program.reset();
+}
+
 
 struct MaterialProperty {
     std::string name;
-    coefficientType coeffType;
+    coefficientType coeffType = NONET;
     std::string unit;
     double constData = 0.0;
     PolynomialData polydata;
 
     compressibleLiquidData compLiquidData;
 
+    sutherlandData sutherlanddata;
+
+    powerLawData powerlawdata;
+
     blottnerData blottnerdata;
 
     const PolynomialData &getPolydata() const;
@@ -173,10 +398,13 @@ struct MaterialProperty {
     PiecewisePolynomialData pwpolydata;
 
     const PiecewisePolynomialData &getPiecewisePolyData() const;
+
+    UserDefinedData userdata;
 };
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(MaterialProperty, name, coeffType, unit, constData, polydata, ppldata,
-                                                nasapolydata, pwpolydata,blottnerdata,compLiquidData)
+                                                nasapolydata, pwpolydata, sutherlanddata, powerlawdata, blottnerdata,
+                                                compLiquidData, userdata)
 
 
 struct FilmAveragedDiffusivityData {
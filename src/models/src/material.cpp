@@ -1,5 +1,6 @@
 #include "material.h"
 #include <regex>
+#include <cmath>
 
 
 
@@ -45,6 +46,43 @@ const polyPiecewiseLinearData &MaterialProperty::getPolyPiecewiseLinearData() co
     return ppldata;
 }
 
+void polyPiecewiseLinearData::buildIndex() {
+    slopes.clear();
+    buckets.clear();
+    bucketScale = 0.0;
+    size_t n = temp_ranges.size();
+    if (n < 2 || coefficients.size() != n) {
+        return;
+    }
+    double minWidth = temp_ranges[1] - temp_ranges[0];
+    for (size_t i = 0; i + 1 < n; ++i) {
+        double width = temp_ranges[i + 1] - temp_ranges[i];
+        if (!(width > 0.0)) {
+            slopes.clear();
+            return;
+        }
+        minWidth = std::min(minWidth, width);
+        slopes.push_back((coefficients[i + 1] - coefficients[i]) / width);
+    }
+    if (n < kPiecewiseLinearIndexPoints) {
+        return;
+    }
+
+    double range = temp_ranges.back() - temp_ranges.front();
+    size_t count = std::min(static_cast<size_t>(std::ceil(range / minWidth)), kPiecewiseLinearMaxBuckets);
+    count = std::max<size_t>(count, 1);
+    bucketScale = count / range;
+    buckets.resize(count);
+    // 与查找使用同一个 bucketOf: 分界点所在桶在 b 之前时, 桶 b 内的温度都不小于该分界点
+    size_t k = 0;
+    for (size_t b = 0; b < count; ++b) {
+        while (k + 2 < n && bucketOf(temp_ranges[k + 1]) < b) {
+            ++k;
+        }
+        buckets[b] = static_cast<uint32_t>(k);
+    }
+}
+
 const PiecewisePolynomialData &MaterialProperty::getPiecewisePolyData() const {
     return pwpolydata;
 }
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace CFD_MaterialDB {
+
+// 队列满/空时的退避: 先让出时间片, 多次失败后短暂休眠
+class Backoff {
+public:
+    void pause() {
+        if (++spins_ < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    void reset() { spins_ = 0; }
+
+private:
+    unsigned spins_ = 0;
+};
+
+inline size_t roundUpPowerOfTwo(size_t value) {
+    size_t result = 2;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// 单生产者单消费者有界环形队列, 无锁
+template<typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity)
+            : capacity_(roundUpPowerOfTwo(capacity)), mask_(capacity_ - 1),
+              slots_(new T[capacity_]) {}
+
+    bool tryPush(T &&value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - headCache_ == capacity_) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail - headCache_ == capacity_) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T &value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tailCache_) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (head == tailCache_) {
+                return false;
+            }
+        }
+        value = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 队列满时阻塞, 形成反压
+    void push(T &&value) {
+        Backoff backoff;
+        while (!tryPush(std::move(value))) {
+            backoff.pause();
+        }
+    }
+
+    // 队列已关闭且为空时返回 false
+    bool pop(T &value) {
+        Backoff backoff;
+        while (!tryPop(value)) {
+            if (closed_.load(std::memory_order_acquire)) {
+                return tryPop(value);
+            }
+            backoff.pause();
+        }
+        return true;
+    }
+
+    void close() { closed_.store(true, std::memory_order_release); }
+
+    // 近似深度, 仅用于统计
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<T[]> slots_;
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t tailCache_ = 0;   // 消费者持有
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t headCache_ = 0;   // 生产者持有
+    alignas(64) std::atomic<bool> closed_{false};
+};
+
+// 多生产者单消费者有界队列 (Vyukov 序号环), 无锁
+template<typename T>
+class MpscQueue {
+public:
+    explicit MpscQueue(size_t capacity)
+            : capacity_(roundUpPowerOfTwo(capacity)), mask_(capacity_ - 1),
+              cells_(new Cell[capacity_]) {
+        for (size_t i = 0; i < capacity_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool tryPush(T &&value) {
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T &value) {
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        Cell &cell = cells_[pos & mask_];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1) < 0) {
+            return false;
+        }
+        value = std::move(cell.value);
+        cell.sequence.store(pos + capacity_, std::memory_order_release);
+        dequeuePos_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void push(T &&value) {
+        Backoff backoff;
+        while (!tryPush(std::move(value))) {
+            backoff.pause();
+        }
+    }
+
+    // 所有生产者结束后由外部调用 close(); 之后队列排空时返回 false
+    bool pop(T &value) {
+        Backoff backoff;
+        while (!tryPop(value)) {
+            if (closed_.load(std::memory_order_acquire)) {
+                return tryPop(value);
+            }
+            backoff.pause();
+        }
+        return true;
+    }
+
+    void close() { closed_.store(true, std::memory_order_release); }
+
+    size_t size() const {
+        size_t enqueued = enqueuePos_.load(std::memory_order_acquire);
+        size_t dequeued = dequeuePos_.load(std::memory_order_acquire);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> enqueuePos_{0};
+    alignas(64) std::atomic<size_t> dequeuePos_{0};
+    alignas(64) std::atomic<bool> closed_{false};
+};
+
+} // namespace CFD_MaterialDB
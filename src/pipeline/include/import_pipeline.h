@@ -0,0 +1,54 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "database_manager.h"
+#include "name_translator.h"
+#include "scm_parser.h"
+
+namespace CFD_MaterialDB {
+
+struct ImportPipelineOptions {
+    unsigned parserThreads = 0;     // 0 表示使用全部硬件线程
+    size_t queueCapacity = 256;     // 阶段之间队列的容量, 满时上游阻塞
+    size_t batchSize = 256;         // 每个写事务包含的材料数
+    bool printNames = false;        // 逐个输出材料中文名 (旧版 main 的行为)
+    bool replaceExisting = false;   // 增量导入: 已存在的材料更新而不是计为失败
+};
+
+struct PipelineStageStats {
+    std::string name;
+    unsigned threads = 1;
+    size_t items = 0;
+    double busySeconds = 0.0;       // 各线程实际处理时间之和, 不含等待队列
+    size_t maxQueueDepth = 0;       // 本阶段输入队列的最大深度
+    double meanQueueDepth = 0.0;    // 每次出队时采样的平均深度
+};
+
+struct ImportPipelineStats {
+    std::vector<PipelineStageStats> stages;
+    size_t materialsInserted = 0;
+    size_t insertFailures = 0;
+    double wallSeconds = 0.0;
+
+    void print(std::ostream &os) const;
+};
+
+// 导入流水线: 多个解析线程 -> 名称解析 (单线程, 按文件顺序重排) -> 单个批量写入线程.
+// 阶段之间用无锁有界队列连接.
+class ImportPipeline {
+public:
+    // translator 可以为空; 未能翻译的材料直接使用英文名作为中文名
+    ImportPipeline(DatabaseManager &target, NameTranslator *translator,
+                   ImportPipelineOptions options = ImportPipelineOptions());
+
+    ImportPipelineStats run(const std::string &scmFile);
+
+private:
+    DatabaseManager &target_;
+    NameTranslator *translator_;
+    ImportPipelineOptions options_;
+};
+
+} // namespace CFD_MaterialDB
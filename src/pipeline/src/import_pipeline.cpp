@@ -0,0 +1,218 @@
+#include "import_pipeline.h"
+#include "concurrent_queue.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <thread>
+
+using namespace CFD_MaterialDB;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// 解析结果带上材料块在文件中的序号, 名称解析阶段据此恢复文件顺序
+struct ParsedChunk {
+    size_t sequence = 0;
+    std::vector<Material> materials;
+};
+
+struct DepthSampler {
+    size_t samples = 0;
+    size_t total = 0;
+    size_t max = 0;
+
+    void sample(size_t depth) {
+        ++samples;
+        total += depth;
+        max = std::max(max, depth);
+    }
+
+    void store(PipelineStageStats &stats) const {
+        stats.maxQueueDepth = max;
+        stats.meanQueueDepth = samples ? double(total) / samples : 0.0;
+    }
+};
+
+} // namespace
+
+void ImportPipelineStats::print(std::ostream &os) const {
+    os << "Import pipeline: " << materialsInserted << " materials inserted, " << insertFailures
+       << " failed, " << std::fixed << std::setprecision(3) << wallSeconds << " s wall" << std::endl;
+    for (const auto &stage: stages) {
+        double rate = stage.busySeconds > 0.0 ? stage.items / stage.busySeconds : 0.0;
+        os << "  " << std::left << std::setw(10) << stage.name << std::right
+           << " threads=" << stage.threads
+           << " items=" << stage.items
+           << " busy=" << std::setprecision(3) << stage.busySeconds << "s"
+           << " throughput=" << std::setprecision(1) << rate << "/s"
+           << " queue(max=" << stage.maxQueueDepth
+           << ", mean=" << std::setprecision(1) << stage.meanQueueDepth << ")" << std::endl;
+    }
+    os.unsetf(std::ios::floatfield);
+}
+
+ImportPipeline::ImportPipeline(DatabaseManager &target, NameTranslator *translator, ImportPipelineOptions options)
+        : target_(target), translator_(translator), options_(options) {
+    if (options_.parserThreads == 0) {
+        options_.parserThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    options_.batchSize = std::max<size_t>(1, options_.batchSize);
+}
+
+ImportPipelineStats ImportPipeline::run(const std::string &scmFile) {
+    ImportPipelineStats stats;
+    auto wallStart = Clock::now();
+
+    std::ifstream file(scmFile);
+    if (!file.is_open()) {
+        throw std::runtime_error("无法打开SCM文件: " + scmFile);
+    }
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const std::vector<std::string> chunks = ScmParser::splitMaterials(content);
+    content.clear();
+
+    MpscQueue<ParsedChunk> parsedQueue(options_.queueCapacity);
+    SpscQueue<Material> resolvedQueue(options_.queueCapacity);
+
+    // 解析阶段: 各线程通过原子计数领取材料块
+    const unsigned parserThreads = options_.parserThreads;
+    std::atomic<size_t> nextChunk{0};
+    std::vector<double> parserBusy(parserThreads, 0.0);
+    std::vector<size_t> parserItems(parserThreads, 0);
+    std::vector<std::thread> parsers;
+    for (unsigned t = 0; t < parserThreads; ++t) {
+        parsers.emplace_back([&, t] {
+            setTraceThreadName("parse-" + std::to_string(t));
+            ScmParser parser;
+            for (size_t i = nextChunk.fetch_add(1); i < chunks.size(); i = nextChunk.fetch_add(1)) {
+                auto start = Clock::now();
+                ParsedChunk parsed;
+                parsed.sequence = i;
+                parsed.materials = parser.parseContent(chunks[i]);
+                parserItems[t] += parsed.materials.size();
+                parserBusy[t] += secondsSince(start);
+                parsedQueue.push(std::move(parsed));
+            }
+        });
+    }
+
+    // 名称解析阶段: 按序号重排, 已就绪的连续材料块合并成一批翻译
+    PipelineStageStats resolveStats;
+    resolveStats.name = "resolve";
+    DepthSampler resolveDepth;
+    std::thread resolver([&] {
+        setTraceThreadName("resolve");
+        std::map<size_t, std::vector<Material>> pending;
+        size_t nextSequence = 0;
+        ParsedChunk parsed;
+        std::vector<Material> ready;
+        std::vector<std::string> names;
+        while (parsedQueue.pop(parsed)) {
+            resolveDepth.sample(parsedQueue.size());
+            pending.emplace(parsed.sequence, std::move(parsed.materials));
+            for (auto it = pending.find(nextSequence); it != pending.end(); it = pending.find(nextSequence)) {
+                for (auto &material: it->second) {
+                    ready.push_back(std::move(material));
+                }
+                pending.erase(it);
+                ++nextSequence;
+            }
+            if (ready.empty()) {
+                continue;
+            }
+
+            auto start = Clock::now();
+            names.clear();
+            for (const auto &material: ready) {
+                names.push_back(material.name);
+            }
+            std::vector<std::optional<std::string>> translated(names.size());
+            if (translator_) {
+                TraceSpan span("translateBatch", "translate", [&] { return std::to_string(names.size()) + " names"; });
+                try {
+                    translated = translator_->translateBatch(names);
+                } catch (const std::exception &e) {
+                    std::cerr << "获取中文名失败: " << e.what() << std::endl;
+                }
+            }
+            for (size_t i = 0; i < ready.size(); ++i) {
+                ready[i].chinese_name = i < translated.size() && translated[i] ? *translated[i] : ready[i].name;
+                if (options_.printNames) {
+                    std::cout << "Chinese name: " << ready[i].chinese_name << std::endl;
+                }
+            }
+            resolveStats.items += ready.size();
+            resolveStats.busySeconds += secondsSince(start);
+
+            for (auto &material: ready) {
+                resolvedQueue.push(std::move(material));
+            }
+            ready.clear();
+        }
+        resolvedQueue.close();
+    });
+
+    // 写入阶段: 单连接, 每批一个事务
+    PipelineStageStats writeStats;
+    writeStats.name = "write";
+    DepthSampler writeDepth;
+    std::thread writer([&] {
+        setTraceThreadName("write");
+        std::vector<Material> batch;
+        batch.reserve(options_.batchSize);
+        auto flush = [&] {
+            auto start = Clock::now();
+            size_t inserted = 0;
+            try {
+                inserted = target_.insertMaterials(batch, options_.replaceExisting);
+            } catch (const std::exception &e) {
+                std::cerr << e.what() << std::endl;
+            }
+            stats.materialsInserted += inserted;
+            stats.insertFailures += batch.size() - inserted;
+            writeStats.items += batch.size();
+            writeStats.busySeconds += secondsSince(start);
+            batch.clear();
+        };
+        Material material;
+        while (resolvedQueue.pop(material)) {
+            writeDepth.sample(resolvedQueue.size());
+            batch.push_back(std::move(material));
+            if (batch.size() >= options_.batchSize) {
+                flush();
+            }
+        }
+        if (!batch.empty()) {
+            flush();
+        }
+    });
+
+    for (auto &parser: parsers) {
+        parser.join();
+    }
+    parsedQueue.close();
+    resolver.join();
+    writer.join();
+
+    PipelineStageStats parseStats;
+    parseStats.name = "parse";
+    parseStats.threads = parserThreads;
+    for (unsigned t = 0; t < parserThreads; ++t) {
+        parseStats.items += parserItems[t];
+        parseStats.busySeconds += parserBusy[t];
+    }
+    resolveDepth.store(resolveStats);
+    writeDepth.store(writeStats);
+    stats.stages = {parseStats, resolveStats, writeStats};
+    stats.wallSeconds = secondsSince(wallStart);
+    return stats;
+}
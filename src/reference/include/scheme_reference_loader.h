@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "material.h"
+
+namespace CFD_MaterialDB {
+
+// 参考载入器: 用 tinyscheme 的读取器逐个读出 propdb.scm 中的材料, 直接遍历 cons 单元构造 Material.
+// 速度不是目标, 用来给 ScmParser 等快速解析器做语义对照.
+class SchemeReferenceLoader {
+public:
+    std::vector<Material> load(const std::string &filename);
+
+    // 读取过程中遇到的无法识别或无法转换的条目
+    const std::vector<std::string> &warnings() const { return warnings_; }
+
+private:
+    std::vector<std::string> warnings_;
+};
+
+struct MaterialDifference {
+    std::string kind;       // missing-material, extra-material, formula, state, missing-property,
+                            // extra-property, count, coeff-type, payload
+    std::string material;
+    std::string property;   // 材料级差异为空
+    std::string detail;
+};
+
+// 按材料名对比两组材料, 只比较 propertyTypeNames 中的物性; 数值按相对误差 tolerance 比较
+std::vector<MaterialDifference> compareMaterials(const std::vector<Material> &reference,
+                                                 const std::vector<Material> &candidate,
+                                                 double tolerance = 1e-12);
+
+} // namespace CFD_MaterialDB
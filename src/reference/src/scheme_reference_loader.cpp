@@ -0,0 +1,514 @@
+#include "scheme_reference_loader.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include "property_expression.h"
+#include "scm_parser.h"
+#include "scheme-private.h"
+
+namespace CFD_MaterialDB {
+
+namespace {
+
+// cons 单元的 C++ 视图; 只在一次 matdb-emit 回调内使用, 期间解释器不分配内存
+struct Cell {
+    scheme *sc;
+    pointer p;
+
+    bool isList() const { return p == sc->NIL || is_pair(p); }
+    bool isPair() const { return is_pair(p); }
+    bool isNumber() const { return is_number(p); }
+    bool isSymbol() const { return is_symbol(p); }
+    bool isBoolean() const { return p == sc->T || p == sc->F; }
+    double number() const { return rvalue(p); }
+    std::string symbol() const { return symname(p); }
+    Cell car() const { return {sc, pair_car(p)}; }
+    Cell cdr() const { return {sc, pair_cdr(p)}; }
+
+    // 真列表的元素; 点对 (a . b) 返回 false
+    bool items(std::vector<Cell> &out) const {
+        out.clear();
+        pointer q = p;
+        for (; is_pair(q); q = pair_cdr(q)) {
+            out.push_back({sc, pair_car(q)});
+        }
+        return q == sc->NIL;
+    }
+
+    bool isSymbolNamed(const char *name) const { return isSymbol() && symbol() == name; }
+};
+
+std::string writeDatum(const Cell &cell) {
+    if (cell.isNumber()) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.17g", cell.number());
+        return buffer;
+    }
+    if (cell.isSymbol()) {
+        return cell.symbol();
+    }
+    if (cell.isBoolean()) {
+        return cell.p == cell.sc->T ? "#t" : "#f";
+    }
+    if (!cell.isList()) {
+        return "?";
+    }
+    std::string text = "(";
+    pointer q = cell.p;
+    for (bool first = true; is_pair(q); q = pair_cdr(q), first = false) {
+        text += (first ? "" : " ") + writeDatum({cell.sc, pair_car(q)});
+    }
+    if (q != cell.sc->NIL) {
+        text += " . " + writeDatum({cell.sc, q});
+    }
+    return text + ")";
+}
+
+std::vector<double> numbers(const std::vector<Cell> &cells, size_t first, const std::string &context) {
+    std::vector<double> values;
+    for (size_t i = first; i < cells.size(); ++i) {
+        if (!cells[i].isNumber()) {
+            throw std::runtime_error("需要数值: " + context);
+        }
+        values.push_back(cells[i].number());
+    }
+    return values;
+}
+
+struct LoaderState {
+    std::vector<Material> materials;
+    std::vector<std::string> warnings;
+};
+
+// (coeff-type . value) 或 (coeff-type args ...) 转换成一个 MaterialProperty; 无法识别时返回 false
+bool convertParameter(const Cell &param, const std::string &key, MaterialProperty &mp, LoaderState &state,
+                      const std::string &materialName) {
+    mp = MaterialProperty();
+    mp.name = key;
+    std::string context = materialName + " " + key + " " + writeDatum(param);
+    if (!param.isPair() || !param.car().isSymbol()) {
+        state.warnings.push_back("无法识别的参数: " + context);
+        return false;
+    }
+    std::string type = param.car().symbol();
+
+    std::vector<Cell> cells;
+    if (!param.items(cells)) {
+        // 点对, 只有 (constant . x) 有意义
+        Cell value = param.cdr();
+        if (type != "constant" || !value.isNumber()) {
+            state.warnings.push_back("无法识别的点对参数: " + context);
+            return false;
+        }
+        mp.coeffType = CONSTCOEFF;
+        mp.constData = value.number();
+        return true;
+    }
+
+    if (type == "polynomial") {
+        if (cells.size() >= 2 && cells[1].isSymbol()) {
+            std::string kind = cells[1].symbol();
+            std::vector<Cell> piece;
+            if (kind == "piecewise-linear") {
+                mp.coeffType = polynomialTPieceLinearT;
+                for (size_t i = 2; i < cells.size(); ++i) {
+                    if (!cells[i].isPair() || cells[i].items(piece) || !cells[i].car().isNumber()
+                        || !cells[i].cdr().isNumber()) {
+                        throw std::runtime_error("piecewise-linear 需要 (T . value) 点对: " + context);
+                    }
+                    mp.ppldata.temp_ranges.push_back(cells[i].car().number());
+                    mp.ppldata.coefficients.push_back(cells[i].cdr().number());
+                }
+                mp.ppldata.buildIndex();
+                return true;
+            }
+            if (kind == "piecewise-polynomial") {
+                mp.coeffType = polynomialTPiecePolyT;
+                for (size_t i = 2; i < cells.size(); ++i) {
+                    if (!cells[i].items(piece) || piece.size() < 3
+                        || piece.size() > 2 + kPiecewisePolyMaxCoefficients) {
+                        throw std::runtime_error("piecewise-polynomial 分段格式错误: " + context);
+                    }
+                    auto values = numbers(piece, 0, context);
+                    mp.pwpolydata.addSegment(values[0], values[1], values.data() + 2, values.size() - 2);
+                }
+                return true;
+            }
+            if (kind == "nasa-9-piecewise-polynomial") {
+                mp.coeffType = nasa9PiecePolyT;
+                for (size_t i = 2; i < cells.size(); ++i) {
+                    if (!cells[i].items(piece) || piece.size() != 2 + kNasa9Coefficients) {
+                        throw std::runtime_error("nasa-9 分段格式错误: " + context);
+                    }
+                    auto values = numbers(piece, 0, context);
+                    mp.nasapolydata.addSegment(values[0], values[1], values.data() + 2);
+                }
+                return true;
+            }
+            state.warnings.push_back("未知的多项式类型: " + context);
+            return false;
+        }
+        mp.coeffType = polynomialT;
+        mp.polydata.coefficients = numbers(cells, 1, context);
+        return true;
+    }
+
+    if (type == "compressible-liquid") {
+        mp.coeffType = compressibleT;
+        mp.compLiquidData = compressibleLiquidData::fromCoefficients(numbers(cells, 1, context));
+        if (!mp.compLiquidData.valid()) {
+            throw std::runtime_error("compressible-liquid 参数无效: " + context);
+        }
+        return true;
+    }
+
+    if (type == "sutherland") {
+        mp.coeffType = sutherlandT;
+        mp.sutherlanddata = sutherlandData::fromCoefficients(numbers(cells, 1, context));
+        if (!mp.sutherlanddata.valid()) {
+            throw std::runtime_error("sutherland 参数无效: " + context);
+        }
+        return true;
+    }
+    if (type == "power-law") {
+        mp.coeffType = powerLawT;
+        mp.powerlawdata = powerLawData::fromCoefficients(numbers(cells, 1, context));
+        if (!mp.powerlawdata.valid()) {
+            throw std::runtime_error("power-law 参数无效: " + context);
+        }
+        return true;
+    }
+    if (type == "blottner-curve-fit") {
+        mp.coeffType = blottnerT;
+        mp.blottnerdata = blottnerData::fromCoefficients(numbers(cells, 1, context));
+        if (!mp.blottnerdata.valid()) {
+            throw std::runtime_error("blottner-curve-fit 参数无效: " + context);
+        }
+        return true;
+    }
+
+    if (type == "user-defined" && cells.size() == 2) {
+        mp.coeffType = userDefinedT;
+        mp.userdata.source = writeDatum(cells[1]);
+        mp.userdata.program = std::make_shared<const ExpressionProgram>(compileSchemeLambda(mp.userdata.source));
+        return true;
+    }
+
+    state.warnings.push_back("未知的系数类型: " + context);
+    return false;
+}
+
+Material convertMaterial(const Cell &datum, LoaderState &state) {
+    std::vector<Cell> items;
+    if (!datum.items(items) || items.empty() || !items[0].isSymbol()) {
+        throw std::runtime_error("材料必须是以名称开头的列表: " + writeDatum(datum).substr(0, 60));
+    }
+    Material material;
+    material.name = items[0].symbol();
+    // 只有粒子类型没有 fluid/solid/mixture 时状态未定义
+    material.type.state = INVALID;
+
+    auto setState = [&material](const std::string &type) {
+        if (type == "fluid") {
+            material.type.state = FLUID;
+        } else if (type == "solid") {
+            material.type.state = SOLID;
+        } else if (type == "mixture") {
+            material.type.state = MIXTURE;
+        } else {
+            return false;
+        }
+        return true;
+    };
+
+    std::vector<Cell> entry;
+    for (size_t i = 1; i < items.size(); ++i) {
+        const Cell &item = items[i];
+        if (item.isSymbol()) {
+            setState(item.symbol());
+            continue;
+        }
+        if (!item.isPair() || !item.car().isSymbol()) {
+            state.warnings.push_back("无法识别的条目: " + material.name + " " + writeDatum(item));
+            continue;
+        }
+        std::string key = item.car().symbol();
+        // (fluid particle-type ...) 形式的材料类型
+        if (setState(key)) {
+            continue;
+        }
+        if (key == "chemical-formula") {
+            Cell value = item.cdr();
+            if (value.isSymbol()) {
+                material.chemical_formula = value.symbol();
+            }
+            continue;
+        }
+        if (propertyTypeNames.count(key) == 0) {
+            continue;
+        }
+        if (!item.items(entry)) {
+            state.warnings.push_back("物性必须是列表: " + material.name + " " + writeDatum(item));
+            continue;
+        }
+        auto &list = material.properties[key];
+        for (size_t j = 1; j < entry.size(); ++j) {
+            MaterialProperty mp;
+            if (convertParameter(entry[j], key, mp, state, material.name)) {
+                list.push_back(std::move(mp));
+            }
+        }
+    }
+    return material;
+}
+
+// (matdb-emit datum): 把一个顶层材料转换后追加到载入结果; C++ 异常不能穿过解释器
+pointer emitMaterial(scheme *sc, pointer args) {
+    auto *state = static_cast<LoaderState *>(sc->ext_data);
+    try {
+        state->materials.push_back(convertMaterial({sc, pair_car(args)}, *state));
+    } catch (const std::exception &e) {
+        state->warnings.push_back(std::string("跳过材料: ") + e.what());
+    }
+    return sc->T;
+}
+
+struct SchemeDeleter {
+    void operator()(scheme *sc) const {
+        scheme_deinit(sc);
+        std::free(sc);
+    }
+};
+
+std::string quoteString(const std::string &text) {
+    std::string quoted = "\"";
+    for (char c: text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+bool sameValue(double a, double b, double tolerance) {
+    if (std::isnan(a) || std::isnan(b)) {
+        return std::isnan(a) && std::isnan(b);
+    }
+    return std::abs(a - b) <= tolerance * std::max(std::abs(a), std::abs(b));
+}
+
+bool sameValues(const std::vector<double> &a, const std::vector<double> &b, double tolerance) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (!sameValue(a[i], b[i], tolerance)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string formatValues(const std::vector<double> &values) {
+    std::ostringstream oss;
+    oss << "[";
+    for (size_t i = 0; i < values.size() && i < 8; ++i) {
+        oss << (i ? " " : "") << values[i];
+    }
+    if (values.size() > 8) {
+        oss << " ... (" << values.size() << ")";
+    }
+    oss << "]";
+    return oss.str();
+}
+
+// 系数内容的差异描述, 相同时返回空
+std::string comparePayload(const MaterialProperty &a, const MaterialProperty &b, double tolerance) {
+    switch (a.coeffType) {
+        case CONSTCOEFF:
+            return sameValue(a.constData, b.constData, tolerance)
+                   ? "" : std::to_string(a.constData) + " vs " + std::to_string(b.constData);
+        case compressibleT: {
+            const auto &x = a.compLiquidData;
+            const auto &y = b.compLiquidData;
+            std::vector<double> u = {x.referencePressure, x.referenceDensity, x.bulkModulus, x.densityExponent,
+                                     x.maxDensityRatio, x.minDensityRatio};
+            std::vector<double> v = {y.referencePressure, y.referenceDensity, y.bulkModulus, y.densityExponent,
+                                     y.maxDensityRatio, y.minDensityRatio};
+            return sameValues(u, v, tolerance) ? "" : formatValues(u) + " vs " + formatValues(v);
+        }
+        case sutherlandT: {
+            std::vector<double> u = {a.sutherlanddata.C1, a.sutherlanddata.S};
+            std::vector<double> v = {b.sutherlanddata.C1, b.sutherlanddata.S};
+            return sameValues(u, v, tolerance) ? "" : formatValues(u) + " vs " + formatValues(v);
+        }
+        case powerLawT: {
+            std::vector<double> u = {a.powerlawdata.B, a.powerlawdata.n};
+            std::vector<double> v = {b.powerlawdata.B, b.powerlawdata.n};
+            return sameValues(u, v, tolerance) ? "" : formatValues(u) + " vs " + formatValues(v);
+        }
+        case blottnerT: {
+            std::vector<double> u = {a.blottnerdata.A, a.blottnerdata.B, a.blottnerdata.C};
+            std::vector<double> v = {b.blottnerdata.A, b.blottnerdata.B, b.blottnerdata.C};
+            return sameValues(u, v, tolerance) ? "" : formatValues(u) + " vs " + formatValues(v);
+        }
+        case polynomialT:
+            return sameValues(a.polydata.coefficients, b.polydata.coefficients, tolerance)
+                   ? "" : formatValues(a.polydata.coefficients) + " vs " + formatValues(b.polydata.coefficients);
+        case polynomialTPieceLinearT:
+            if (!sameValues(a.ppldata.temp_ranges, b.ppldata.temp_ranges, tolerance)) {
+                return "temperatures " + formatValues(a.ppldata.temp_ranges) + " vs "
+                       + formatValues(b.ppldata.temp_ranges);
+            }
+            return sameValues(a.ppldata.coefficients, b.ppldata.coefficients, tolerance)
+                   ? "" : "values " + formatValues(a.ppldata.coefficients) + " vs "
+                          + formatValues(b.ppldata.coefficients);
+        case polynomialTPiecePolyT: {
+            std::vector<double> sa(a.pwpolydata.segments.begin(), a.pwpolydata.segments.end());
+            std::vector<double> sb(b.pwpolydata.segments.begin(), b.pwpolydata.segments.end());
+            if (!sameValues(a.pwpolydata.temp_ranges, b.pwpolydata.temp_ranges, tolerance)) {
+                return "ranges " + formatValues(a.pwpolydata.temp_ranges) + " vs "
+                       + formatValues(b.pwpolydata.temp_ranges);
+            }
+            return sameValues(sa, sb, tolerance) ? "" : "segments " + formatValues(sa) + " vs " + formatValues(sb);
+        }
+        case nasa9PiecePolyT: {
+            const auto &na = a.nasapolydata;
+            const auto &nb = b.nasapolydata;
+            if (!sameValues(na.temp_ranges, nb.temp_ranges, tolerance)) {
+                return "ranges " + formatValues(na.temp_ranges) + " vs " + formatValues(nb.temp_ranges);
+            }
+            std::vector<double> ca(na.coefficients.begin(), na.coefficients.end());
+            std::vector<double> cb(nb.coefficients.begin(), nb.coefficients.end());
+            return sameValues(ca, cb, tolerance) ? "" : "coefficients " + formatValues(ca) + " vs " + formatValues(cb);
+        }
+        case userDefinedT: {
+            // 源码格式可能不同, 比较几个温度下的求值结果
+            for (double T: {200.0, 300.0, 1000.0, 3000.0}) {
+                double va = a.userdata.program ? a.userdata.program->evaluate(T, 101325.0) : NAN;
+                double vb = b.userdata.program ? b.userdata.program->evaluate(T, 101325.0) : NAN;
+                if (!sameValue(va, vb, tolerance)) {
+                    return "user-defined at T=" + std::to_string(T) + ": " + std::to_string(va) + " vs "
+                           + std::to_string(vb);
+                }
+            }
+            return "";
+        }
+        default:
+            return "";
+    }
+}
+
+std::string coeffName(coefficientType type) {
+    nlohmann::json j = type;
+    return j.is_string() ? j.get<std::string>() : std::to_string(static_cast<int>(type));
+}
+
+} // namespace
+
+std::vector<Material> SchemeReferenceLoader::load(const std::string &filename) {
+    warnings_.clear();
+    if (!std::filesystem::exists(filename)) {
+        throw std::runtime_error("无法打开文件: " + filename);
+    }
+    std::unique_ptr<scheme, SchemeDeleter> sc(scheme_init_new());
+    if (!sc) {
+        throw std::runtime_error("初始化 tinyscheme 失败");
+    }
+
+    LoaderState state;
+    scheme_set_external_data(sc.get(), &state);
+    scheme_define(sc.get(), sc->global_env, mk_symbol(sc.get(), "matdb-emit"), mk_foreign_func(sc.get(), emitMaterial));
+    char errors[1024] = {0};
+    scheme_set_output_port_string(sc.get(), errors, errors + sizeof(errors) - 1);
+
+    // 整个文件的 cons 单元超出 tinyscheme 的默认堆, 因此逐个读取材料并立即转换, 旧材料随后被回收
+    std::string program =
+            "(let ((port (open-input-file " + quoteString(filename) + ")))"
+            "  (let loop ((datum (read port)))"
+            "    (if (not (eof-object? datum))"
+            "        (begin (matdb-emit datum) (loop (read port)))))"
+            "  (close-input-port port))";
+    scheme_load_string(sc.get(), program.c_str());
+    if (sc->retcode != 0) {
+        throw std::runtime_error("tinyscheme 读取 " + filename + " 失败: " + errors);
+    }
+    warnings_ = std::move(state.warnings);
+    return std::move(state.materials);
+}
+
+std::vector<MaterialDifference> compareMaterials(const std::vector<Material> &reference,
+                                                 const std::vector<Material> &candidate,
+                                                 double tolerance) {
+    std::vector<MaterialDifference> differences;
+    std::map<std::string, const Material *> candidates;
+    for (const auto &material: candidate) {
+        candidates.emplace(material.name, &material);
+    }
+
+    std::map<std::string, bool> seen;
+    for (const auto &ref: reference) {
+        seen[ref.name] = true;
+        auto found = candidates.find(ref.name);
+        if (found == candidates.end()) {
+            differences.push_back({"missing-material", ref.name, "", ""});
+            continue;
+        }
+        const Material &cand = *found->second;
+        if (ref.chemical_formula != cand.chemical_formula) {
+            differences.push_back({"formula", ref.name, "", ref.chemical_formula + " vs " + cand.chemical_formula});
+        }
+        if (ref.type.state != cand.type.state) {
+            differences.push_back({"state", ref.name, "", std::to_string(ref.type.state) + " vs "
+                                                          + std::to_string(cand.type.state)});
+        }
+
+        for (const auto &key: propertyTypeNames) {
+            bool inRef = ref.hasProperty(key) && !ref.getProperty(key).empty();
+            bool inCand = cand.hasProperty(key) && !cand.getProperty(key).empty();
+            if (!inRef && !inCand) {
+                continue;
+            }
+            if (!inCand) {
+                differences.push_back({"missing-property", ref.name, key, ""});
+                continue;
+            }
+            if (!inRef) {
+                differences.push_back({"extra-property", ref.name, key, ""});
+                continue;
+            }
+            const auto &a = ref.getProperty(key);
+            const auto &b = cand.getProperty(key);
+            if (a.size() != b.size()) {
+                differences.push_back({"count", ref.name, key, std::to_string(a.size()) + " vs "
+                                                                + std::to_string(b.size())});
+            }
+            for (size_t i = 0; i < std::min(a.size(), b.size()); ++i) {
+                if (a[i].coeffType != b[i].coeffType) {
+                    differences.push_back({"coeff-type", ref.name, key,
+                                           coeffName(a[i].coeffType) + " vs " + coeffName(b[i].coeffType)});
+                    continue;
+                }
+                std::string detail = comparePayload(a[i], b[i], tolerance);
+                if (!detail.empty()) {
+                    differences.push_back({"payload", ref.name, key, coeffName(a[i].coeffType) + ": " + detail});
+                }
+            }
+        }
+    }
+    for (const auto &material: candidate) {
+        if (!seen.count(material.name)) {
+            differences.push_back({"extra-material", material.name, "", ""});
+        }
+    }
+    return differences;
+}
+
+} // namespace CFD_MaterialDB
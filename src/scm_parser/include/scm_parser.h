@@ -22,11 +22,12 @@ const static std::unordered_set<std::string> propertyTypeNames =
         {
         "density", "specific-heat", "thermal-conductivity", "viscosity", "molecular-weight",
         "absorption-coefficient", "formation-enthalpy", "reference-temperature", "formation-entropy",
-        "critical-pressure","latent-heat","vaporization-temperature","boiling-point",
+        "critical-pressure","latent-heat","vaporization-temperature","boiling-point","vapor-pressure",
         "binary-diffusivity","volatile-fraction","combustible-fraction",
         "swelling-coefficient","emissivity","scattering-factor",
         "critical-temperature", "critical-volume", "acentric-factor",
-        "struct-youngs-modulus", "struct-poisson-ratio"
+        "struct-youngs-modulus", "struct-poisson-ratio",
+        "lennard-jones-length", "lennard-jones-energy"
 };
 
 void init_symbols();
@@ -72,6 +73,12 @@ class ScmParser {
 public:
     std::vector<Material> parse(const std::string &filename);
 
+    // 解析内存中的 SCM 文本; 可在多个线程中并发调用
+    std::vector<Material> parseContent(std::string content);
+
+    // 按括号层级把文件内容切分成顶层材料块 (忽略注释和字符串中的括号)
+    static std::vector<std::string> splitMaterials(const std::string &content);
+
 private:
     void processProperties(Material &material, const MaterialData &mat_data);
 };
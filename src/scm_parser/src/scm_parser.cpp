@@ -4,38 +4,55 @@
 #include <boost/spirit/include/qi.hpp>
 #include <boost/spirit/home/x3/support/utility/error_reporting.hpp>
 #include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <iostream> // For cerr
 #include <boost/spirit/home/x3/support/utility/annotate_on_success.hpp>
 #include <boost/fusion/include/at_c.hpp>
+#include <mutex>
 #include "material.h"
+#include "property_expression.h"
+#include "metrics.h"
+#include "trace.h"
 
 namespace x3 = boost::spirit::x3;
 
+// 逐条解析日志. 每行都以 std::endl 刷新, 曾是解析的主要开销, 默认关闭; 设置环境变量 MATDB_SCM_TRACE 时输出到标准输出
+static bool scmTraceEnabled() {
+    static const bool enabled = std::getenv("MATDB_SCM_TRACE") != nullptr;
+    return enabled;
+}
+
+#define SCM_TRACE if (!scmTraceEnabled()) {} else std::cout
+
 // Define coefficient_type_symbols
 x3::symbols<coefficientType> coefficient_type_symbols;
 x3::symbols<binaryDiffusModelType> binDiff_type_symbols;
 x3::symbols<binaryDiffusModelParam> binDiff_param_symbols;
 
 void init_symbols() {
-    coefficient_type_symbols.add
-            ("constant", CONSTCOEFF)
-            ("polynomial", polynomialT)
-            ("polynomial piecewise-linear", polynomialTPieceLinearT)
-            ("polynomial piecewise-polynomial", polynomialTPiecePolyT)
-            ("polynomial nasa-9-piecewise-polynomial", nasa9PiecePolyT)
-            ("compressible-liquid", compressibleT)
-            ("sutherland", sutherlandT)
-            ("power-law", powerLawT)
-            ("blottner-curve-fit", blottnerT)
-            ("averaging-coefficient", AVERAGING_COEFF);
-
-    binDiff_type_symbols.add
-            ("constant", CONSTANT_DIFFUSION)
-            ("film-averaged", FILM_AVERAGED_DIFFUSION);
-
-    binDiff_param_symbols.add
-            ("film-diffusivity", FILM_DIFFUSIVITY);
+    // 符号表是全局的, 只能初始化一次, 之后多个解析线程只读共享
+    static std::once_flag once;
+    std::call_once(once, [] {
+        coefficient_type_symbols.add
+                ("constant", CONSTCOEFF)
+                ("polynomial", polynomialT)
+                ("polynomial piecewise-linear", polynomialTPieceLinearT)
+                ("polynomial piecewise-polynomial", polynomialTPiecePolyT)
+                ("polynomial nasa-9-piecewise-polynomial", nasa9PiecePolyT)
+                ("compressible-liquid", compressibleT)
+                ("sutherland", sutherlandT)
+                ("power-law", powerLawT)
+                ("blottner-curve-fit", blottnerT)
+                ("averaging-coefficient", AVERAGING_COEFF);
+
+        binDiff_type_symbols.add
+                ("constant", CONSTANT_DIFFUSION)
+                ("film-averaged", FILM_AVERAGED_DIFFUSION);
+
+        binDiff_param_symbols.add
+                ("film-diffusivity", FILM_DIFFUSIVITY);
+    });
 }
 
 BOOST_FUSION_ADAPT_STRUCT(
@@ -74,7 +91,7 @@ struct error_handler {
 struct debug_handler {
     template<typename Iterator, typename Context>
     void on_success(Iterator const &first, Iterator const &last, Context const &context) {
-        std::cout << "Parsed: \"" << std::string(first, last) << "\"" << std::endl;
+        SCM_TRACE << "Parsed: \"" << std::string(first, last) << "\"" << std::endl;
     }
 };
 
@@ -134,7 +151,7 @@ auto const species_property = x3::rule<class species_property_, Property>{"speci
             }
 
             prop.parameters.push_back(param);
-            std::cout << "Parsed species property with " << species_names.size() << " species" << std::endl;
+            SCM_TRACE << "Parsed species property with " << species_names.size() << " species" << std::endl;
         })];
 
 
@@ -156,7 +173,7 @@ auto const poly_piece = x3::rule<class poly_piece_, std::vector<double>>{}
                     auto pair_attr = x3::_attr(ctx);
                     // Convert pair to vector<double> for poly_piece attribute
                     x3::_val(ctx) = {pair_attr.first, pair_attr.second};
-                    std::cout << "Parsed poly_piece as temp-value pair: (" << pair_attr.first << " . "
+                    SCM_TRACE << "Parsed poly_piece as temp-value pair: (" << pair_attr.first << " . "
                               << pair_attr.second << ")" << std::endl;
                 })]
                 |
@@ -165,7 +182,7 @@ auto const poly_piece = x3::rule<class poly_piece_, std::vector<double>>{}
                 [([](auto &ctx) {
                     // Attribute from +x3::double_ is already std::vector<double>
                     x3::_val(ctx) = x3::_attr(ctx);
-                    std::cout << "Parsed poly_piece as list of doubles with " << x3::_val(ctx).size() << " elements"
+                    SCM_TRACE << "Parsed poly_piece as list of doubles with " << x3::_val(ctx).size() << " elements"
                               << std::endl;
                 })]
         );
@@ -178,7 +195,7 @@ auto const parameter = x3::rule<parameter_class, Parameter>{"parameter"}
                 >> coefficient_type_symbols[([](auto &ctx) {
                     auto &param = x3::_val(ctx);
                     param.coeff = x3::_attr(ctx);
-                    std::cout << "Parsed parameter with coefficient type: " << static_cast<int>(param.coeff)
+                    SCM_TRACE << "Parsed parameter with coefficient type: " << static_cast<int>(param.coeff)
                               << std::endl;
                 })]
                 >> (
@@ -186,17 +203,17 @@ auto const parameter = x3::rule<parameter_class, Parameter>{"parameter"}
                         ('.' >> (x3::double_[([](auto &ctx) {
                             auto &param = x3::_val(ctx);
                             param.values = {{x3::_attr(ctx)}};
-                            std::cout << "Parsed parameter with double value: " << x3::_attr(ctx) << std::endl;
+                            SCM_TRACE << "Parsed parameter with double value: " << x3::_attr(ctx) << std::endl;
                         })] | symbol[([](auto &ctx) {
                             auto &param = x3::_val(ctx);
                             param.values = {{-999.0}};
                             param.string_value = x3::_attr(ctx);
-                            std::cout << "Parsed parameter with symbol value: " << x3::_attr(ctx) << std::endl;
+                            SCM_TRACE << "Parsed parameter with symbol value: " << x3::_attr(ctx) << std::endl;
                         })] | boolean[([](auto &ctx) {
                             auto &param = x3::_val(ctx);
                             param.string_value = x3::_attr(ctx) ? "#t" : "#f";
                             param.values = {{x3::_attr(ctx) ? 1.0 : 0.0}};
-                            std::cout << "Parsed parameter with boolean value: " << (x3::_attr(ctx) ? "#t" : "#f")
+                            SCM_TRACE << "Parsed parameter with boolean value: " << (x3::_attr(ctx) ? "#t" : "#f")
                                       << std::endl;
                         })]))
                         // 处理普通数值列表 - 用于 compressible-liquid 等类型
@@ -204,13 +221,13 @@ auto const parameter = x3::rule<parameter_class, Parameter>{"parameter"}
                             auto &param = x3::_val(ctx);
                             auto values = x3::_attr(ctx);
                             param.values = {values};
-                            std::cout << "Parsed parameter with " << values.size() << " values" << std::endl;
+                            SCM_TRACE << "Parsed parameter with " << values.size() << " values" << std::endl;
                         })]
                         // 处理嵌套的多项式结构 - 不需要子类型关键字
                         | (+poly_piece)[([](auto &ctx) {
                             auto &param = x3::_val(ctx);
                             param.values = x3::_attr(ctx);
-                            std::cout << "######## Parsed nested polynomial structure with " << param.values.size()
+                            SCM_TRACE << "######## Parsed nested polynomial structure with " << param.values.size()
                                       << " pieces"
                                       << std::endl;
                         })]
@@ -223,7 +240,7 @@ auto const parameter = x3::rule<parameter_class, Parameter>{"parameter"}
                             if (param.values.empty()) {
                                 param.values.push_back({});
                             }
-                            std::cout << "Parsed complex parameter content: " << content.substr(0, 20) << "..."
+                            SCM_TRACE << "Parsed complex parameter content: " << content.substr(0, 20) << "..."
                                       << std::endl;
                         })])
                 )
@@ -235,7 +252,7 @@ auto const nested_parameter = x3::rule<class nested_parameter_, Parameter>{"nest
                                       = parameter[([](auto &ctx) {
             auto &param = x3::_val(ctx);
             param = x3::_attr(ctx);  // Just copy the parameter data directly
-            std::cout << "Captured nested parameter of type: " << static_cast<int>(param.coeff) << std::endl;
+            SCM_TRACE << "Captured nested parameter of type: " << static_cast<int>(param.coeff) << std::endl;
         })];
 
 
@@ -244,19 +261,19 @@ auto const simple_parameter = x3::rule<simple_parameter_class, Parameter>{"simpl
             auto &param = x3::_val(ctx);
             param.coeff = CONSTCOEFF;
             param.values = {{x3::_attr(ctx)}};
-            std::cout << "Parsed simple parameter with double value: " << x3::_attr(ctx) << std::endl;
+            SCM_TRACE << "Parsed simple parameter with double value: " << x3::_attr(ctx) << std::endl;
         })] | symbol[([](auto &ctx) {
             auto &param = x3::_val(ctx);
             param.coeff = CONSTCOEFF;
             param.values = {{-999.0}};
             param.string_value = x3::_attr(ctx);
-            std::cout << "Parsed simple parameter with symbol value: " << x3::_attr(ctx) << std::endl;
+            SCM_TRACE << "Parsed simple parameter with symbol value: " << x3::_attr(ctx) << std::endl;
         })] | boolean[([](auto &ctx) {
             auto &param = x3::_val(ctx);
             param.coeff = CONSTCOEFF;
             param.string_value = x3::_attr(ctx) ? "#t" : "#f";
             param.values = {{x3::_attr(ctx) ? 1.0 : 0.0}};
-            std::cout << "Parsed simple parameter with boolean value: " << (x3::_attr(ctx) ? "#t" : "#f") << std::endl;
+            SCM_TRACE << "Parsed simple parameter with boolean value: " << (x3::_attr(ctx) ? "#t" : "#f") << std::endl;
         })]))
                                         | ('(' >> coefficient_type_symbols >> *x3::double_ >> ')')[([](auto &ctx) {
             auto &param = x3::_val(ctx);
@@ -271,7 +288,7 @@ auto const simple_parameter = x3::rule<simple_parameter_class, Parameter>{"simpl
             }
 
             param.values = {values}; // Store as a single vector in a vector2d
-            std::cout << "Parsed simple parameter with coefficient type and inline values: "
+            SCM_TRACE << "Parsed simple parameter with coefficient type and inline values: "
                       << static_cast<int>(param.coeff) << std::endl;
         })];
 
@@ -282,7 +299,7 @@ auto const averaging_coefficient_param = x3::rule<class averaging_coefficient_pa
         param.coeff = AVERAGING_COEFF;
         param.string_value = "averaging-coefficient";
         param.values = {{x3::_attr(ctx)}};
-        std::cout << "Parsed averaging coefficient: " << x3::_attr(ctx) << std::endl;
+        SCM_TRACE << "Parsed averaging coefficient: " << x3::_attr(ctx) << std::endl;
     })] >> ')';
 
 auto const film_diffusivity_param = x3::rule<class film_diffusivity_param_, Parameter>{"film_diffusivity_param"}
@@ -294,7 +311,7 @@ auto const film_diffusivity_param = x3::rule<class film_diffusivity_param_, Para
                 param.string_value = "film-diffusivity";
                 param.coeff = x3::_attr(ctx).coeff;
                 param.values = x3::_attr(ctx).values;
-                std::cout << "Parsed film-diffusivity with direct parameter" << std::endl;
+                SCM_TRACE << "Parsed film-diffusivity with direct parameter" << std::endl;
             })]
             |
             // Multiple parameters inside parentheses
@@ -317,7 +334,7 @@ auto const film_diffusivity_param = x3::rule<class film_diffusivity_param_, Para
                     }
                 }
 
-                std::cout << "Parsed film-diffusivity with " << nested_params.size() << " nested parameters" << std::endl;
+                SCM_TRACE << "Parsed film-diffusivity with " << nested_params.size() << " nested parameters" << std::endl;
             })]
         ) >> ')';
 
@@ -357,7 +374,7 @@ auto const film_averaged_param = x3::rule<class film_averaged_param_, Parameter>
                 }
             }
 
-            std::cout << "Parsed film-averaged with " << params.size() << " parameters" << std::endl;
+            SCM_TRACE << "Parsed film-averaged with " << params.size() << " parameters" << std::endl;
         })] >> ')' >> ')';
 
 // Rule for constant binary diffusivity
@@ -367,7 +384,7 @@ auto const constant_binary_diffusivity = x3::rule<class constant_binary_diffusiv
             auto &param = x3::_val(ctx);
             param.coeff = CONSTCOEFF;
             param.values = {{x3::_attr(ctx)}};
-            std::cout << "Parsed constant binary diffusivity: " << x3::_attr(ctx) << std::endl;
+            SCM_TRACE << "Parsed constant binary diffusivity: " << x3::_attr(ctx) << std::endl;
         })] >> ')';
 
 // 定义化学式属性规则
@@ -376,7 +393,7 @@ auto const chemical_formula_property = x3::rule<chemical_formula_property_class,
             auto &prop = x3::_val(ctx);
             prop.name = "chemical-formula";
             prop.parameters.push_back(x3::_attr(ctx));
-            std::cout << "Parsed chemical formula property with parameter: " << prop.parameters[0].string_value
+            SCM_TRACE << "Parsed chemical formula property with parameter: " << prop.parameters[0].string_value
                       << std::endl;
         })];
 
@@ -385,17 +402,17 @@ auto const general_property = x3::rule<general_property_class, Property>{"genera
                                       = symbol[([](auto &ctx) {
             auto &prop = x3::_val(ctx);
             prop.name = x3::_attr(ctx);
-            std::cout << "Setting property name: " << prop.name << std::endl;
+            SCM_TRACE << "Setting property name: " << prop.name << std::endl;
         })] >> (
                 // 处理任意数量和类型的参数，包括简单参数和复杂参数
                 *(simple_parameter[([](auto &ctx) {
                     auto &prop = x3::_val(ctx);
                     prop.parameters.push_back(x3::_attr(ctx));
-                    std::cout << "Added simple parameter to property " << prop.name << std::endl;
+                    SCM_TRACE << "Added simple parameter to property " << prop.name << std::endl;
                 })] | parameter[([](auto &ctx) {
                     auto &prop = x3::_val(ctx);
                     prop.parameters.push_back(x3::_attr(ctx));
-                    std::cout << "Added parameter to property " << prop.name << std::endl;
+                    SCM_TRACE << "Added parameter to property " << prop.name << std::endl;
                 })])
         );
 
@@ -429,7 +446,7 @@ auto const fluid_property = x3::rule<class fluid_property_, Property>{"fluid_pro
             }
 
             prop.parameters.push_back(param);
-            std::cout << "Parsed fluid property with " << (types ? types->size() : 0) << " particle types" << std::endl;
+            SCM_TRACE << "Parsed fluid property with " << (types ? types->size() : 0) << " particle types" << std::endl;
         })];
 
 // Define a rule for parsing a material type property enclosed in parentheses
@@ -441,7 +458,7 @@ auto const material_type_property = x3::rule<class material_type_property_, Prop
             // Only handle known material types
             if (type == "solid" || type == "fluid" || type == "mixture") {
                 prop.name = type;
-                std::cout << "Parsed material type property: " << type << std::endl;
+                SCM_TRACE << "Parsed material type property: " << type << std::endl;
             } else {
                 // If not a known material type, set to empty (will be ignored later)
                 prop.name = "";
@@ -467,7 +484,7 @@ auto const material_type_property = x3::rule<class material_type_property_, Prop
                 }
                 param.string_value += particle_type;
 
-                std::cout << "Added particle type: " << particle_type << " to " << prop.name << std::endl;
+                SCM_TRACE << "Added particle type: " << particle_type << " to " << prop.name << std::endl;
             }
         })] >> ')';
 
@@ -484,7 +501,7 @@ auto const binary_diffus_param = x3::rule<class binary_diffus_param_, Parameter>
                                                                       auto simple_param = x3::_attr(ctx);
                                                                       param.values = simple_param.values;
 
-                                                                      std::cout
+                                                                      SCM_TRACE
                                                                               << "Parsed averaging-coefficient parameter with value: "
                                                                               << param.values[0][0] << std::endl;
                                                                   })] |
@@ -516,7 +533,7 @@ auto const binary_diffus_param = x3::rule<class binary_diffus_param_, Parameter>
                                                                                                     param.particleTypes.insert(
                                                                                                             param_info);
 
-                                                                                                    std::cout
+                                                                                                    SCM_TRACE
                                                                                                             << "Added nested parameter to film-diffusivity"
                                                                                                             << std::endl;
                                                                                                 })]) >> ')')[([](
@@ -528,7 +545,7 @@ auto const binary_diffus_param = x3::rule<class binary_diffus_param_, Parameter>
                                                                            // 创建一个占位符值
                                                                            param.values.push_back({-999.0});
                                                                        }
-                                                                       std::cout
+                                                                       SCM_TRACE
                                                                                << "Parsed film-diffusivity parameter with nested structure"
                                                                                << std::endl;
                                                                    })]));
@@ -559,7 +576,7 @@ auto const film_averaged_diffusivity = x3::rule<class film_averaged_diffusivity_
                 }
             }
 
-            std::cout << "Parsed film-averaged diffusivity with " << sub_params.size() << " parameters" << std::endl;
+            SCM_TRACE << "Parsed film-averaged diffusivity with " << sub_params.size() << " parameters" << std::endl;
         })];
 
 // 定义binary-diffusivity属性规则
@@ -580,26 +597,44 @@ auto const binary_diffusivity_property = x3::rule<class binary_diffusivity_prope
                 prop.parameters.push_back(p);
             }
 
-            std::cout << "Parsed binary-diffusivity with " << prop.parameters.size() << " parameters" << std::endl;
+            SCM_TRACE << "Parsed binary-diffusivity with " << prop.parameters.size() << " parameters" << std::endl;
         })] >> ')';
 
 
 // 定义属性规则
 // Update the property rule to include the fluid_property
+// 括号配对的 S 表达式 (跳过字符串和注释中的括号), 只做匹配不产生属性; 用于原样捕获 user-defined 的 lambda 源码
+x3::rule<class balanced_sexpr_> const balanced_sexpr = "balanced_sexpr";
+auto const balanced_sexpr_def = '(' >> *(balanced_sexpr
+                                         | ('"' >> *(('\\' >> x3::char_) | ~x3::char_('"')) >> '"')
+                                         | (';' >> *(x3::char_ - x3::eol))
+                                         | ~x3::char_("()\";")) >> ')';
+BOOST_SPIRIT_DEFINE(balanced_sexpr);
+
+auto const user_defined_parameter = x3::rule<class user_defined_parameter_, Parameter>{"user_defined_parameter"}
+                                            = ('(' >> x3::lit("user-defined")
+                                                   >> x3::raw[x3::lexeme[balanced_sexpr]] >> ')')[([](auto &ctx) {
+            auto &param = x3::_val(ctx);
+            auto range = x3::_attr(ctx);
+            param.coeff = userDefinedT;
+            param.string_value.assign(range.begin(), range.end());
+            SCM_TRACE << "Parsed user-defined parameter: " << param.string_value.substr(0, 40) << std::endl;
+        })];
+
 auto const property = x3::rule<property_class, Property>{"property"}
                               = '(' >> (
                 (x3::lit("chemical-formula") >> simple_parameter)[([](auto &ctx) {
                     auto &prop = x3::_val(ctx);
                     prop.name = "chemical-formula";
                     prop.parameters.push_back(x3::_attr(ctx));
-                    std::cout << "Parsed chemical formula property with parameter" << std::endl;
+                    SCM_TRACE << "Parsed chemical formula property with parameter" << std::endl;
                 })]
                 | species_property[([](auto &ctx) {
                     auto &prop = x3::_val(ctx);
                     const Property &parsed = x3::_attr(ctx);
                     prop.name = parsed.name;
                     prop.parameters = parsed.parameters;
-                    std::cout << "Parsed species property with " << prop.parameters.size() << " parameters"
+                    SCM_TRACE << "Parsed species property with " << prop.parameters.size() << " parameters"
                               << std::endl;
                 })]
                 | fluid_property[([](auto &ctx) {
@@ -607,7 +642,7 @@ auto const property = x3::rule<property_class, Property>{"property"}
                     const Property &parsed = x3::_attr(ctx);
                     prop.name = parsed.name;
                     prop.parameters = parsed.parameters;
-                    std::cout << "Parsed fluid property with " << prop.parameters.size() << " parameters" << std::endl;
+                    SCM_TRACE << "Parsed fluid property with " << prop.parameters.size() << " parameters" << std::endl;
                 })]
                 | material_type_property[([](auto &ctx) {
                     auto &prop = x3::_val(ctx);
@@ -615,7 +650,7 @@ auto const property = x3::rule<property_class, Property>{"property"}
                     if (!parsed.name.empty()) {
                         prop.name = parsed.name;
                         prop.parameters = parsed.parameters;
-                        std::cout << "Parsed material type property with " << prop.parameters.size() << " parameters"
+                        SCM_TRACE << "Parsed material type property with " << prop.parameters.size() << " parameters"
                                   << std::endl;
                     }
                 })]
@@ -624,9 +659,18 @@ auto const property = x3::rule<property_class, Property>{"property"}
                     const Property &parsed = x3::_attr(ctx);
                     prop.name = parsed.name;
                     prop.parameters = parsed.parameters;
-                    std::cout << "Parsed binary-diffusivity property with " << prop.parameters.size() << " parameters"
+                    SCM_TRACE << "Parsed binary-diffusivity property with " << prop.parameters.size() << " parameters"
                               << std::endl;
                 })]
+                | (symbol >> +user_defined_parameter)[([](auto &ctx) {
+                    auto &prop = x3::_val(ctx);
+                    auto &attr = x3::_attr(ctx);
+                    prop.name = boost::fusion::at_c<0>(attr);
+                    for (const auto &param: boost::fusion::at_c<1>(attr)) {
+                        prop.parameters.push_back(param);
+                    }
+                    SCM_TRACE << "Parsed user-defined property: " << prop.name << std::endl;
+                })]
                 | (symbol >> *parameter)[([](auto &ctx) {
                     auto &prop = x3::_val(ctx);
                     auto &attr = x3::_attr(ctx);
@@ -635,7 +679,7 @@ auto const property = x3::rule<property_class, Property>{"property"}
                     for (auto it = params.begin(); it != params.end(); ++it) {
                         prop.parameters.push_back(*it);
                     }
-                    std::cout << "Parsed property: " << prop.name
+                    SCM_TRACE << "Parsed property: " << prop.name
                               << " with " << prop.parameters.size() << " parameters" << std::endl;
                 })]
         ) >> ')';
@@ -661,7 +705,7 @@ auto const standalone_material_type = x3::rule<class standalone_material_type_,
             // 只处理已知的材料类型
             if (type == "solid" || type == "fluid" || type == "mixture") {
                 prop.name = type;
-                std::cout << "Parsed standalone material type: " << type << std::endl;
+                SCM_TRACE << "Parsed standalone material type: " << type << std::endl;
             } else {
                 // 如果不是已知的材料类型，则设置为空，后续会被忽略
                 prop.name = "";
@@ -687,7 +731,7 @@ auto const standalone_material_type = x3::rule<class standalone_material_type_,
                 }
                 param.string_value += particle_type;
 
-                std::cout << "Added particle type: " << particle_type << " to " << prop.name << std::endl;
+                SCM_TRACE << "Added particle type: " << particle_type << " to " << prop.name << std::endl;
             }
         })];
 
@@ -697,7 +741,7 @@ auto const material = x3::rule<material_class, MaterialData>{"material"}
                               = '(' >> symbol[([](auto &ctx) {
             auto &mat = x3::_val(ctx);
             mat.name = x3::_attr(ctx);
-            std::cout << "Parsed material name: " << mat.name << std::endl;
+            SCM_TRACE << "Parsed material name: " << mat.name << std::endl;
         })] >>
                                     // 确保材料类型在材料名称之后立即解析
                                     (
@@ -709,7 +753,7 @@ auto const material = x3::rule<material_class, MaterialData>{"material"}
                                                 // 设置材料类型
                                                 if (type == "solid" || type == "fluid" || type == "mixture") {
                                                     mat.type = type;
-                                                    std::cout << "Parsed material type in parentheses: " << type
+                                                    SCM_TRACE << "Parsed material type in parentheses: " << type
                                                               << std::endl;
                                                     // 创建属性
                                                     Property prop;
@@ -738,7 +782,7 @@ auto const material = x3::rule<material_class, MaterialData>{"material"}
                                                             param.string_value += " ";
                                                         }
                                                         param.particleTypes.emplace(particle_type);
-                                                        std::cout << "Added particle type: " << particle_type << " to "
+                                                        SCM_TRACE << "Added particle type: " << particle_type << " to "
                                                                   << prop.name << std::endl;
                                                     }
                                                 }
@@ -752,13 +796,13 @@ auto const material = x3::rule<material_class, MaterialData>{"material"}
                                                 // 设置材料类型
                                                 if (type == "solid" || type == "fluid" || type == "mixture") {
                                                     mat.type = type;
-                                                    std::cout << "Parsed direct material type: " << type << std::endl;
+                                                    SCM_TRACE << "Parsed direct material type: " << type << std::endl;
 
                                                     // 创建属性
                                                     Property prop;
                                                     prop.name = type;
                                                     mat.properties.push_back(prop);
-                                                    std::cout << "Added standalone material type property: "
+                                                    SCM_TRACE << "Added standalone material type property: "
                                                               << prop.name << std::endl;
                                                 }
                                             })] >> *symbol[([](auto &ctx) {
@@ -785,7 +829,7 @@ auto const material = x3::rule<material_class, MaterialData>{"material"}
                                                         }
                                                         param.string_value += particle_type;
 
-                                                        std::cout << "Added particle type: " << particle_type << " to "
+                                                        SCM_TRACE << "Added particle type: " << particle_type << " to "
                                                                   << prop.name << std::endl;
                                                     }
                                                 }
@@ -795,7 +839,7 @@ auto const material = x3::rule<material_class, MaterialData>{"material"}
                     auto &mat = x3::_val(ctx);
                     const Property &prop = x3::_attr(ctx);
                     mat.properties.push_back(prop);
-                    std::cout << "Added property " << prop.name << " to material " << mat.name << std::endl;
+                    SCM_TRACE << "Added property " << prop.name << " to material " << mat.name << std::endl;
                 })]
                 | comment
         ) >> ')';
@@ -807,44 +851,104 @@ auto const scm_file = x3::rule<scm_file_class, std::vector<MaterialData>>{"scm_f
 // 将定义与声明关联起来
 
 std::vector<Material> ScmParser::parse(const std::string &filename) {
-    std::vector<Material> materials_out;
-    init_symbols(); // Initialize symbol table
-
     std::ifstream file(filename);
     if (!file.is_open()) {
         std::cerr << "Error: Could not open file " << filename << std::endl;
-        return materials_out;
+        return {};
     }
     std::string content((std::istreambuf_iterator<char>(file)),
                         std::istreambuf_iterator<char>());
+    SCM_TRACE << "Parsing file: " << filename << std::endl;
+    return parseContent(std::move(content));
+}
+
+std::vector<std::string> ScmParser::splitMaterials(const std::string &content) {
+    std::vector<std::string> chunks;
+    int depth = 0;
+    size_t start = 0;
+    bool in_string = false;
+    for (size_t i = 0; i < content.size(); ++i) {
+        char c = content[i];
+        if (in_string) {
+            if (c == '\\') {
+                ++i;
+            } else if (c == '"') {
+                in_string = false;
+            }
+            continue;
+        }
+        if (c == ';') {
+            // 注释到行尾
+            while (i < content.size() && content[i] != '\n') {
+                ++i;
+            }
+        } else if (c == '"') {
+            in_string = true;
+        } else if (c == '(') {
+            if (depth++ == 0) {
+                start = i;
+            }
+        } else if (c == ')' && depth > 0) {
+            if (--depth == 0) {
+                chunks.emplace_back(content, start, i + 1 - start);
+            }
+        }
+    }
+    return chunks;
+}
+
+std::vector<Material> ScmParser::parseContent(std::string content) {
+    using CFD_MaterialDB::MetricsRegistry;
+    static auto &parseSeconds = MetricsRegistry::global().histogram(
+            "material_db_scm_parse_seconds", "ScmParser::parseContent 耗时 (秒)");
+    static auto &parsedBytes = MetricsRegistry::global().counter(
+            "material_db_scm_parsed_bytes_total", "ScmParser 处理的输入字节数");
+    static auto &parsedMaterials = MetricsRegistry::global().counter(
+            "material_db_scm_parsed_materials_total", "ScmParser 输出的材料数");
+    static auto &parseFailures = MetricsRegistry::global().counter(
+            "material_db_scm_parse_failures_total", "ScmParser 解析失败次数");
+    CFD_MaterialDB::ScopedTimer timer(parseSeconds);
+    CFD_MaterialDB::TraceSpan span("parse", "scm");
+    parsedBytes.add(content.size());
+
+    std::vector<Material> materials_out;
+    init_symbols(); // Initialize symbol table
+
     std::vector<MaterialData> parsed_materials;
     auto iter = content.begin();
     auto end = content.end();
     try {
         // 添加日志，输出文件内容前几行
-        std::cout << "Parsing file: " << filename << std::endl;
         std::string preview = content.substr(0, std::min(size_t(200), content.size()));
-        std::cout << "File preview: " << std::endl << preview << "..." << std::endl;
+        SCM_TRACE << "File preview: " << std::endl << preview << "..." << std::endl;
 
-        bool success = x3::phrase_parse(iter, end, scm_file, x3::space, parsed_materials);
+        bool success;
+        {
+            CFD_MaterialDB::TraceSpan grammarSpan("phrase_parse", "scm");
+            success = x3::phrase_parse(iter, end, scm_file, x3::space, parsed_materials);
+        }
+        if (!parsed_materials.empty()) {
+            span.setDetail(parsed_materials.front().name);
+        }
 
         // 添加日志，输出解析结果
-        std::cout << "Parse success: " << success << std::endl;
-        std::cout << "Parsed materials count: " << parsed_materials.size() << std::endl;
-        std::cout << "Remaining unparsed: " << (iter != end) << std::endl;
+        SCM_TRACE << "Parse success: " << success << std::endl;
+        SCM_TRACE << "Parsed materials count: " << parsed_materials.size() << std::endl;
+        SCM_TRACE << "Remaining unparsed: " << (iter != end) << std::endl;
         if (iter != end) {
-            std::cout << "Remaining text: '" << std::string(iter, std::min(iter + 50, end)) << "...'" << std::endl;
+            SCM_TRACE << "Remaining text: '" << std::string(iter, std::min(iter + 50, end)) << "...'" << std::endl;
         }
 
         if (!success || iter != end) {
             std::cerr << "解析失败 at: '" << std::string(iter, std::min(iter + 20, end)) << "...'"
                       << std::endl;
+            parseFailures.add();
             return materials_out;
         }
 
         // 添加日志，输出每个解析到的材料
         for (size_t i = 0; i < parsed_materials.size(); ++i) {
-            std::cout << "Material " << i << ": " << parsed_materials[i].name
+            SCM_TRACE << "Material " << i << ": " << parsed_materials[i].name
                       << ", Type: " << parsed_materials[i].type
                       << ", Properties count: " << parsed_materials[i].properties.size() << std::endl;
         }
@@ -861,18 +965,27 @@ std::vector<Material> ScmParser::parse(const std::string &filename) {
                 material.type.state = MaterialState::SOLID;
             } else if (typeStr == "MIXTURE") {
                 material.type.state = MaterialState::MIXTURE;
+            } else {
+                // 只有粒子类型 (如 anthracite 的 combusting-particle) 时状态未定义, 与参考载入器一致
+                material.type.state = MaterialState::INVALID;
+            }
+            {
+                CFD_MaterialDB::TraceSpan propertiesSpan("processProperties", "scm", material.name);
+                processProperties(material, mat_data);
             }
-            processProperties(material, mat_data);
             materials_out.push_back(material);
         }
     } catch (const x3::expectation_failure<std::string::iterator> &e) {
         std::cerr << "Parse expectation failure near '"
                   << std::string(e.where(), std::min(e.where() + 20, content.end())) << "': Expected "
                   << e.which() << std::endl;
+        parseFailures.add();
     } catch (const std::exception &e) {
         std::cerr << "解析异常: " << e.what() << std::endl;
+        parseFailures.add();
     }
 
+    parsedMaterials.add(materials_out.size());
     return materials_out;
 }
 
@@ -890,7 +1003,7 @@ void ScmParser::processProperties(Material &material, const MaterialData &mat_da
                     case coefficientType::CONSTCOEFF: {
 
                         mp.constData = param.values[0][0];
-                        std::cout << "Set property: " << key << " = " << param.values[0][0] << std::endl;
+                        SCM_TRACE << "Set property: " << key << " = " << param.values[0][0] << std::endl;
                         break;
                     }
                     case polynomialTPieceLinearT:
@@ -904,40 +1017,45 @@ void ScmParser::processProperties(Material &material, const MaterialData &mat_da
                             piecewiseData.temp_ranges[i] = param.values[i][0];
                             piecewiseData.coefficients[i] = param.values[i][1];
                         }
+                        piecewiseData.buildIndex();
                         mp.ppldata = piecewiseData;
-                        std::cout << "Created piecewise polynomial data with "
+                        SCM_TRACE << "Created piecewise polynomial data with "
                                   << piecewiseData.temp_ranges.size() << " temperature points" << std::endl;
 
                         break;
                     }
                     case polynomialTPiecePolyT:
-                        // 使用 MaterialProperty 结构
                     {
+                        // 每段 (Tmin Tmax c0 c1 ...), 最多 8 个系数
                         PiecewisePolynomialData piecewiseData;
-                        // For piecewise-linear, we expect two vectors: temperatures and values
-                        if (param.values.size() == 2) {
-                            // First vector contains temperatures, second contains values
-                            piecewiseData.temp_ranges = param.values[0];
-                            // Create coefficients for each temperature point (just the value as a constant)
-                            for (size_t i = 0; i < param.values[1].size(); ++i) {
-                                piecewiseData.coefficients.push_back({param.values[1][i]});
+                        for (const auto &segment: param.values) {
+                            if (segment.size() < 3 || segment.size() > 2 + kPiecewisePolyMaxCoefficients) {
+                                std::cerr << "忽略格式错误的分段多项式: " << material.name << " " << key
+                                          << " (" << segment.size() << " 个数值)" << std::endl;
+                                continue;
                             }
-                            mp.pwpolydata = piecewiseData;
-                            std::cout << "Created piecewise polynomial data with "
-                                      << piecewiseData.temp_ranges.size() << " temperature points" << std::endl;
+                            piecewiseData.addSegment(segment[0], segment[1], segment.data() + 2, segment.size() - 2);
                         }
+                        mp.pwpolydata = piecewiseData;
+                        SCM_TRACE << "Created piecewise polynomial data with "
+                                  << piecewiseData.segmentCount() << " segments" << std::endl;
                         break;
                     }
 
                     case nasa9PiecePolyT:
-                        // 使用 MaterialProperty 结构
                     {
+                        // 每段 (Tlo Thi a1 ... a7), 段数不限
                         NASAPolynomialData nasaData;
-                        if (param.values.size() == 2) {
-
-                            std::cout << "Created piecewise polynomial data with "
-                                      << " temperature points" << std::endl;
+                        for (const auto &segment: param.values) {
+                            if (segment.size() != 2 + kNasa9Coefficients) {
+                                std::cerr << "忽略格式错误的 NASA-9 分段: " << material.name << " " << key
+                                          << " (" << segment.size() << " 个数值)" << std::endl;
+                                continue;
+                            }
+                            nasaData.addSegment(segment[0], segment[1], segment.data() + 2);
                         }
+                        SCM_TRACE << "Created NASA-9 polynomial data with " << nasaData.segmentCount()
+                                  << " segments" << std::endl;
                         mp.nasapolydata = nasaData;
                         break;
                     }
@@ -948,31 +1066,51 @@ void ScmParser::processProperties(Material &material, const MaterialData &mat_da
                         break;
                     }
                     case compressibleT: {
-                        PolynomialData dat;
-                        dat.coefficients = param.values[0];
-                        mp.polydata = dat;
+                        mp.compLiquidData = compressibleLiquidData::fromCoefficients(param.values[0]);
+                        if (!mp.compLiquidData.valid()) {
+                            std::cerr << "跳过参数无效的 compressible-liquid " << material.name << " " << key
+                                      << std::endl;
+                            continue;
+                        }
                         break;
                     }
-                    case sutherlandT: {
-                        PolynomialData dat;
-                        dat.coefficients = param.values[0];
-                        mp.polydata = dat;
+                    case sutherlandT:
+                        mp.sutherlanddata = sutherlandData::fromCoefficients(param.values[0]);
+                        if (!mp.sutherlanddata.valid()) {
+                            std::cerr << "跳过参数无效的 sutherland " << material.name << " " << key << std::endl;
+                            continue;
+                        }
                         break;
-                    }
-                    case powerLawT: {
-                        PolynomialData dat;
-                        dat.coefficients = param.values[0];
-                        mp.polydata = dat;
+                    case powerLawT:
+                        mp.powerlawdata = powerLawData::fromCoefficients(param.values[0]);
+                        if (!mp.powerlawdata.valid()) {
+                            std::cerr << "跳过参数无效的 power-law " << material.name << " " << key << std::endl;
+                            continue;
+                        }
                         break;
-                    }
-                    case blottnerT: {
-                        PolynomialData dat;
-                        dat.coefficients = param.values[0];
-                        mp.polydata = dat;
+                    case blottnerT:
+                        mp.blottnerdata = blottnerData::fromCoefficients(param.values[0]);
+                        if (!mp.blottnerdata.valid()) {
+                            std::cerr << "跳过参数无效的 blottner-curve-fit " << material.name << " " << key
+                                      << std::endl;
+                            continue;
+                        }
+                        break;
+                    case userDefinedT: {
+                        // 载入时编译一次, 之后求值不再经过 Scheme 解释器
+                        mp.userdata.source = param.string_value;
+                        try {
+                            mp.userdata.program = std::make_shared<const CFD_MaterialDB::ExpressionProgram>(
+                                    CFD_MaterialDB::compileSchemeLambda(param.string_value));
+                        } catch (const std::exception &e) {
+                            std::cerr << "跳过无法编译的用户自定义物性 " << material.name << " " << key << ": "
+                                      << e.what() << std::endl;
+                            continue;
+                        }
                         break;
                     }
                     default:
-                        std::cout << "Unsupported coefficient type: " << param.coeff << std::endl;
+                        SCM_TRACE << "Unsupported coefficient type: " << param.coeff << std::endl;
                 }
                 material.properties[key].push_back(mp);
             }
@@ -1001,7 +1139,7 @@ void ScmParser::processProperties(Material &material, const MaterialData &mat_da
                         material.properties["fluid"].push_back(mp);
 
                         // Set the particle flags in the material's type
-                        std::cout << "Added " << particle_types.size() << " particle types to material" << std::endl;
+                        SCM_TRACE << "Added " << particle_types.size() << " particle types to material" << std::endl;
                     }
                 } else {
                     // If there are no parameters, just set the material state to FLUID
@@ -1079,7 +1217,7 @@ void ScmParser::processProperties(Material &material, const MaterialData &mat_da
                         material.properties["binary-diffusivity"].push_back(mp);
                         material.properties["film-diffusivity"].push_back(film_diff_prop);
 
-                        std::cout << "Processed film-averaged binary-diffusivity with averaging coefficient: "
+                        SCM_TRACE << "Processed film-averaged binary-diffusivity with averaging coefficient: "
                                   << averaging_coeff << std::endl;
                     } else {
                         // 处理常规binary-diffusivity参数
@@ -1093,7 +1231,7 @@ void ScmParser::processProperties(Material &material, const MaterialData &mat_da
                         }
 
                         material.properties["binary-diffusivity"].push_back(mp);
-                        std::cout << "Processed regular binary-diffusivity parameter" << std::endl;
+                        SCM_TRACE << "Processed regular binary-diffusivity parameter" << std::endl;
                     }
                 }
                 continue;
@@ -1104,7 +1242,7 @@ void ScmParser::processProperties(Material &material, const MaterialData &mat_da
                 if (!param.string_value.empty() && (param.string_value != "#f") && (param.string_value != "#t")) {
                     // 设置 chemical_formula 字段
                     material.chemical_formula = param.string_value;
-                    std::cout << "Set chemical formula to: " << param.string_value << std::endl;
+                    SCM_TRACE << "Set chemical formula to: " << param.string_value << std::endl;
                 }
             }
 
@@ -0,0 +1,372 @@
+//
+// 基准测试: SCM 解析 (ScmParser 与 tinyscheme 参考载入器), 数据库写入与查询, Material 的 JSON 编解码, 各系数类型的物性求值.
+// 用法: material_db_bench [google benchmark 参数]; SCM 文件由环境变量 MATDB_BENCH_SCM 指定, 默认 propdb.scm.
+// 未指定 --benchmark_format 时以 JSON 输出, 便于跨版本对比
+//
+#include "database_manager.h"
+#include "property_evaluator.h"
+#include "property_expression.h"
+#include "scheme_reference_loader.h"
+#include "scm_parser.h"
+#include "typed_evaluator.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+
+using namespace CFD_MaterialDB;
+
+namespace {
+
+// 批量求值每次的温度个数
+constexpr size_t kBatchSize = 1024;
+
+// ScmParser 会输出大量调试信息, 计时期间丢弃标准输出
+class SilenceStdout {
+public:
+    SilenceStdout() : saved_(std::cout.rdbuf(sink_.rdbuf())) {}
+    ~SilenceStdout() { std::cout.rdbuf(saved_); }
+
+private:
+    std::ostringstream sink_;
+    std::streambuf *saved_;
+};
+
+const std::string &scmPath() {
+    static const std::string path = [] {
+        const char *env = std::getenv("MATDB_BENCH_SCM");
+        return std::string(env ? env : "propdb.scm");
+    }();
+    return path;
+}
+
+const std::string &scmContent() {
+    static const std::string content = [] {
+        std::ifstream file(scmPath(), std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("无法打开 " + scmPath());
+        }
+        std::ostringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    }();
+    return content;
+}
+
+const std::vector<Material> &baseMaterials() {
+    static const std::vector<Material> materials = [] {
+        SilenceStdout silence;
+        ScmParser parser;
+        auto parsed = parser.parseContent(scmContent());
+        for (auto &material: parsed) {
+            compileUserDefinedProperties(material);
+        }
+        return parsed;
+    }();
+    return materials;
+}
+
+// 把原文件的材料块重复 copies 次, 第 k 份 (k > 0) 的材料名加后缀 -k 以免重名
+std::string syntheticContent(int copies) {
+    auto chunks = ScmParser::splitMaterials(scmContent());
+    std::string content;
+    for (int k = 0; k < copies; ++k) {
+        for (const auto &chunk: chunks) {
+            if (k == 0) {
+                content += chunk;
+            } else {
+                size_t begin = chunk.find_first_not_of(" \t\r\n", 1);
+                size_t end = chunk.find_first_of(" \t\r\n()", begin);
+                content.append(chunk, 0, end);
+                content += "-" + std::to_string(k);
+                content.append(chunk, end, std::string::npos);
+            }
+            content += "\n\n";
+        }
+    }
+    return content;
+}
+
+const std::string &syntheticCache(int copies) {
+    static std::map<int, std::string> cache;
+    auto it = cache.find(copies);
+    if (it == cache.end()) {
+        it = cache.emplace(copies, syntheticContent(copies)).first;
+    }
+    return it->second;
+}
+
+std::string benchDatabasePath(const char *name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// 新建一个空数据库 (删除同名旧文件)
+std::unique_ptr<DatabaseManager> freshDatabase(const std::string &path) {
+    std::filesystem::remove(path);
+    auto database = std::make_unique<DatabaseManager>(path);
+    database->createTables();
+    return database;
+}
+
+// 查询用的数据库, 只建一次
+const std::string &populatedDatabase() {
+    static const std::string path = [] {
+        std::string file = benchDatabasePath("material_db_bench_lookup.db");
+        auto database = freshDatabase(file);
+        database->insertMaterials(baseMaterials());
+        return file;
+    }();
+    return path;
+}
+
+void BM_ParseFile(benchmark::State &state) {
+    size_t materials = 0;
+    for (auto _: state) {
+        SilenceStdout silence;
+        ScmParser parser;
+        materials = parser.parse(scmPath()).size();
+    }
+    state.SetItemsProcessed(state.iterations() * materials);
+    state.SetBytesProcessed(state.iterations() * scmContent().size());
+}
+
+// 同一文件用 tinyscheme 参考载入器读取, 与 BM_ParseFile 对比
+void BM_ReferenceLoad(benchmark::State &state) {
+    size_t materials = 0;
+    for (auto _: state) {
+        SilenceStdout silence;
+        SchemeReferenceLoader loader;
+        materials = loader.load(scmPath()).size();
+    }
+    state.SetItemsProcessed(state.iterations() * materials);
+    state.SetBytesProcessed(state.iterations() * scmContent().size());
+}
+
+// 参数为原文件的重复倍数
+void BM_ParseSynthetic(benchmark::State &state) {
+    const std::string &content = syntheticCache(static_cast<int>(state.range(0)));
+    size_t materials = 0;
+    for (auto _: state) {
+        SilenceStdout silence;
+        ScmParser parser;
+        materials = parser.parseContent(content).size();
+    }
+    state.SetItemsProcessed(state.iterations() * materials);
+    state.SetBytesProcessed(state.iterations() * content.size());
+}
+
+// 逐条插入, 每条一个保存点; 材料名加序号以免违反唯一约束
+void BM_InsertMaterial(benchmark::State &state) {
+    const auto &materials = baseMaterials();
+    std::string path = benchDatabasePath("material_db_bench_insert.db");
+    auto database = freshDatabase(path);
+    size_t next = 0;
+    for (auto _: state) {
+        state.PauseTiming();
+        Material material = materials[next % materials.size()];
+        material.name += "-" + std::to_string(next++);
+        state.ResumeTiming();
+        database->insertMaterial(material);
+    }
+    state.SetItemsProcessed(state.iterations());
+    database.reset();
+    std::filesystem::remove(path);
+}
+
+// 整个文件在一个事务内批量插入
+void BM_InsertMaterials(benchmark::State &state) {
+    const auto &materials = baseMaterials();
+    std::string path = benchDatabasePath("material_db_bench_bulk.db");
+    for (auto _: state) {
+        state.PauseTiming();
+        auto database = freshDatabase(path);
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(database->insertMaterials(materials));
+        state.PauseTiming();
+        database.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * materials.size());
+    std::filesystem::remove(path);
+}
+
+// 热缓存: 同一连接反复查询, SQLite 页缓存已命中
+void BM_GetMaterialByNameWarm(benchmark::State &state) {
+    const auto &materials = baseMaterials();
+    DatabaseManager database(populatedDatabase());
+    size_t next = 0;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(database.getMaterialByName(materials[next++ % materials.size()].name));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// 冷缓存: 每次查询都打开新连接, SQLite 页缓存为空 (操作系统的文件缓存仍是热的)
+void BM_GetMaterialByNameCold(benchmark::State &state) {
+    const auto &materials = baseMaterials();
+    const std::string &path = populatedDatabase();
+    size_t next = 0;
+    for (auto _: state) {
+        DatabaseManager database(path);
+        benchmark::DoNotOptimize(database.getMaterialByName(materials[next++ % materials.size()].name));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_MaterialToJson(benchmark::State &state) {
+    const auto &materials = baseMaterials();
+    size_t bytes = 0;
+    for (auto _: state) {
+        for (const auto &material: materials) {
+            std::string text = nlohmann::json(material).dump();
+            bytes += text.size();
+            benchmark::DoNotOptimize(text);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * materials.size());
+    state.SetBytesProcessed(bytes);
+}
+
+void BM_MaterialFromJson(benchmark::State &state) {
+    std::vector<std::string> texts;
+    size_t total = 0;
+    for (const auto &material: baseMaterials()) {
+        texts.push_back(nlohmann::json(material).dump());
+        total += texts.back().size();
+    }
+    for (auto _: state) {
+        for (const auto &text: texts) {
+            Material material = nlohmann::json::parse(text);
+            benchmark::DoNotOptimize(material);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * texts.size());
+    state.SetBytesProcessed(state.iterations() * total);
+}
+
+// 温度覆盖 200-3000 K, 乱序, 避免只测到某一段
+std::vector<double> sampleTemperatures(size_t count) {
+    std::vector<double> T(count);
+    for (size_t i = 0; i < count; ++i) {
+        T[i] = 200.0 + 2800.0 * ((i * 7919) % count) / count;
+    }
+    return T;
+}
+
+void evaluateScalar(benchmark::State &state, const MaterialProperty &prop) {
+    auto T = sampleTemperatures(kBatchSize);
+    for (auto _: state) {
+        for (double t: T) {
+            benchmark::DoNotOptimize(evaluateProperty(prop, t));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * T.size());
+}
+
+// 逐点求值, 但按类型分派只在循环外做一次 (typed_evaluator.h)
+void evaluateTyped(benchmark::State &state, const MaterialProperty &prop) {
+    auto T = sampleTemperatures(kBatchSize);
+    withEvaluator(prop, [&](const auto &evaluate) {
+        for (auto _: state) {
+            for (double t: T) {
+                benchmark::DoNotOptimize(evaluate(t));
+            }
+        }
+    });
+    state.SetItemsProcessed(state.iterations() * T.size());
+}
+
+void evaluateBatch(benchmark::State &state, const MaterialProperty &prop) {
+    auto T = sampleTemperatures(kBatchSize);
+    std::vector<double> out(T.size());
+    for (auto _: state) {
+        evaluateProperty(prop, T.data(), out.data(), T.size());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * T.size());
+}
+
+// 每种系数类型取数据文件中第一个能在 300 K 求值的系数, 分别注册标量, 按类型特化和批量求值
+void registerEvaluationBenchmarks() {
+    std::map<coefficientType, const MaterialProperty *> samples;
+    for (const auto &material: baseMaterials()) {
+        for (const auto &entry: material.properties) {
+            for (const auto &prop: entry.second) {
+                if (!samples.count(prop.coeffType) && std::isfinite(evaluateProperty(prop, 300.0))) {
+                    samples[prop.coeffType] = &prop;
+                }
+            }
+        }
+    }
+    // 数据文件中没有 user-defined 物性, 用一个 Sutherland 形式的 lambda 代替
+    static MaterialProperty userDefined;
+    if (!samples.count(userDefinedT)) {
+        userDefined.coeffType = userDefinedT;
+        userDefined.userdata.source = "(lambda (T p) (* 1.716e-5 (expt (/ T 273.11) 1.5) (/ 383.67 (+ T 110.56))))";
+        userDefined.userdata.program = std::make_shared<const ExpressionProgram>(
+                compileSchemeLambda(userDefined.userdata.source));
+        samples[userDefinedT] = &userDefined;
+    }
+    for (const auto &sample: samples) {
+        // 类型名中的空格换成 '-', 便于 --benchmark_filter 匹配
+        std::string type = nlohmann::json(sample.first).get<std::string>();
+        std::replace(type.begin(), type.end(), ' ', '-');
+        const MaterialProperty *prop = sample.second;
+        benchmark::RegisterBenchmark(("BM_Evaluate/" + type + "/scalar").c_str(),
+                                     [prop](benchmark::State &state) { evaluateScalar(state, *prop); });
+        benchmark::RegisterBenchmark(("BM_Evaluate/" + type + "/typed").c_str(),
+                                     [prop](benchmark::State &state) { evaluateTyped(state, *prop); });
+        benchmark::RegisterBenchmark(("BM_Evaluate/" + type + "/batch").c_str(),
+                                     [prop](benchmark::State &state) { evaluateBatch(state, *prop); });
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_ParseFile)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReferenceLoad)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ParseSynthetic)->Arg(10)->Arg(100)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_InsertMaterial)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_InsertMaterials)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_GetMaterialByNameWarm)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_GetMaterialByNameCold)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_MaterialToJson)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MaterialFromJson)->Unit(benchmark::kMillisecond);
+
+int main(int argc, char **argv) {
+    // 默认输出 JSON; 命令行给出 --benchmark_format 时以命令行为准
+    std::vector<char *> args(argv, argv + argc);
+    bool formatGiven = false;
+    for (int i = 1; i < argc; ++i) {
+        formatGiven = formatGiven || std::strncmp(argv[i], "--benchmark_format", 18) == 0;
+    }
+    static char jsonFormat[] = "--benchmark_format=json";
+    if (!formatGiven) {
+        args.insert(args.begin() + 1, jsonFormat);
+    }
+    int count = static_cast<int>(args.size());
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data())) {
+        return 1;
+    }
+
+    try {
+        benchmark::AddCustomContext("scm_file", scmPath());
+        benchmark::AddCustomContext("scm_materials", std::to_string(baseMaterials().size()));
+        registerEvaluationBenchmarks();
+    } catch (const std::exception &e) {
+        std::cerr << "准备基准数据失败: " << e.what() << std::endl;
+        return 2;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,292 @@
+//
+// 把 SCM 材料库编译成 constexpr 材料表头文件 (格式见 embedded_material.h), 由 CMake 在构建时对 propdb.scm 调用.
+// 用法: material_db_embed <propdb.scm> <输出头文件>
+//
+#include "embedded_material.h"
+#include "scm_parser.h"
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+
+using namespace CFD_MaterialDB;
+
+namespace {
+
+// ScmParser 会输出大量调试信息, 生成期间丢弃标准输出
+class SilenceStdout {
+public:
+    SilenceStdout() : saved_(std::cout.rdbuf(sink_.rdbuf())) {}
+    ~SilenceStdout() { std::cout.rdbuf(saved_); }
+
+private:
+    std::ostringstream sink_;
+    std::streambuf *saved_;
+};
+
+const char *typeName(coefficientType type) {
+    switch (type) {
+        case CONSTCOEFF:
+            return "CONSTCOEFF";
+        case polynomialT:
+            return "polynomialT";
+        case polynomialTPieceLinearT:
+            return "polynomialTPieceLinearT";
+        case polynomialTPiecePolyT:
+            return "polynomialTPiecePolyT";
+        case nasa9PiecePolyT:
+            return "nasa9PiecePolyT";
+        case sutherlandT:
+            return "sutherlandT";
+        case powerLawT:
+            return "powerLawT";
+        case blottnerT:
+            return "blottnerT";
+        case compressibleT:
+            return "compressibleT";
+        default:
+            return "NONET";
+    }
+}
+
+// 按 embedded_material.h 中的布局展开的系数
+struct Coefficient {
+    coefficientType type = NONET;
+    size_t count = 0;
+    std::vector<double> data;
+};
+
+// 与 evaluateProperty 取相同的数据, 早期数据库中存放在 polydata 里的参数同样换算; 无效的系数记为 NONET
+Coefficient flatten(const MaterialProperty &prop) {
+    Coefficient c;
+    const auto &legacy = prop.polydata.coefficients;
+    switch (prop.coeffType) {
+        case CONSTCOEFF:
+            c.data = {prop.constData};
+            break;
+        case polynomialT:
+            c.count = legacy.size();
+            c.data = legacy;
+            break;
+        case polynomialTPieceLinearT: {
+            PiecewiseLinearView view = piecewiseLinearView(prop.ppldata);
+            if (view.points < 2) {
+                return c;
+            }
+            c.count = view.points;
+            c.data.assign(view.temps, view.temps + view.points);
+            c.data.insert(c.data.end(), view.values, view.values + view.points);
+            c.data.insert(c.data.end(), view.slopes, view.slopes + view.points - 1);
+            break;
+        }
+        case polynomialTPiecePolyT:
+        case nasa9PiecePolyT: {
+            bool nasa = prop.coeffType == nasa9PiecePolyT;
+            SegmentedView view = nasa ? nasa9View(prop.nasapolydata) : piecewisePolynomialView(prop.pwpolydata);
+            if (view.segments == 0) {
+                return c;
+            }
+            size_t stride = nasa ? kNasa9Stride : kPiecewisePolyStride;
+            c.count = view.segments;
+            c.data.assign(view.blocks, view.blocks + view.segments * stride);
+            c.data.insert(c.data.end(), view.bounds, view.bounds + view.segments + 1);
+            break;
+        }
+        case sutherlandT: {
+            sutherlandData data = legacy.empty() ? prop.sutherlanddata : sutherlandData::fromCoefficients(legacy);
+            c.data = {data.C1, data.S};
+            break;
+        }
+        case powerLawT: {
+            powerLawData data = legacy.empty() ? prop.powerlawdata : powerLawData::fromCoefficients(legacy);
+            c.data = {data.B, data.n};
+            break;
+        }
+        case blottnerT: {
+            blottnerData data = legacy.empty() ? prop.blottnerdata : blottnerData::fromCoefficients(legacy);
+            c.data = {data.A, data.B, data.C};
+            break;
+        }
+        case compressibleT: {
+            compressibleLiquidData data = prop.compLiquidData.valid()
+                                          ? prop.compLiquidData
+                                          : compressibleLiquidData::fromCoefficients(legacy);
+            c.data = {data.referencePressure, data.referenceDensity, data.bulkModulus, data.densityExponent,
+                      data.maxDensityRatio, data.minDensityRatio};
+            break;
+        }
+        default:
+            return c;
+    }
+    c.type = prop.coeffType;
+    return c;
+}
+
+// 精确还原的 double 字面量
+std::string literal(double value) {
+    if (std::isnan(value)) {
+        return "kLawNaN";
+    }
+    if (std::isinf(value)) {
+        return value > 0 ? "std::numeric_limits<double>::infinity()" : "-std::numeric_limits<double>::infinity()";
+    }
+    // 取能还原出同一个值的最短写法
+    char buffer[32];
+    for (int precision = 15; precision <= 17; ++precision) {
+        std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+        if (std::strtod(buffer, nullptr) == value) {
+            break;
+        }
+    }
+    std::string text = buffer;
+    if (text.find_first_of(".e") == std::string::npos) {
+        text += ".0";
+    }
+    return text;
+}
+
+std::string quoted(const std::string &text) {
+    std::string out = "\"";
+    for (char c: text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+// 名称转成标识符, 在 used 中去重
+std::string identifier(const std::string &name, std::set<std::string> &used) {
+    static const std::set<std::string> keywords = {
+            "and", "auto", "bool", "break", "case", "char", "class", "const", "default", "delete", "do", "double",
+            "else", "enum", "float", "for", "if", "int", "long", "new", "not", "or", "short", "signed", "static",
+            "struct", "switch", "this", "union", "unsigned", "void", "while", "xor"};
+    std::string id;
+    for (unsigned char c: name) {
+        id += std::isalnum(c) ? static_cast<char>(c) : '_';
+    }
+    if (id.empty() || std::isdigit(static_cast<unsigned char>(id[0])) || keywords.count(id)) {
+        id = "m_" + id;
+    }
+    while (!used.insert(id).second) {
+        id += '_';
+    }
+    return id;
+}
+
+void writeHeader(std::ostream &out, const std::vector<Material> &parsed, const std::string &source) {
+    // 同名材料只保留最后一个; 材料与物性都按名称排序
+    std::map<std::string, const Material *> materials;
+    for (const auto &material: parsed) {
+        materials[material.name] = &material;
+    }
+
+    std::ostringstream laws, coefficients, properties, table;
+    std::set<std::string> namespaces = {"kCoefficients", "kProperties", "kMaterials"};
+    size_t propertyCount = 0;
+    size_t coefficientCount = 0;
+    for (const auto &entry: materials) {
+        const Material &material = *entry.second;
+        std::string ns = identifier(material.name, namespaces);
+        std::map<std::string, const std::vector<MaterialProperty> *> sorted;
+        for (const auto &prop: material.properties) {
+            sorted[prop.first] = &prop.second;
+        }
+        table << "        {" << quoted(material.name) << ", " << propertyCount << ", " << sorted.size() << "},\n";
+        laws << "\n// " << material.name << "\nnamespace " << ns << " {\n";
+        std::set<std::string> names;
+        for (const auto &prop: sorted) {
+            properties << "        {" << quoted(prop.first) << ", " << coefficientCount << ", " << prop.second->size()
+                       << "},\n";
+            ++propertyCount;
+            for (size_t i = 0; i < prop.second->size(); ++i) {
+                const MaterialProperty &coefficient = (*prop.second)[i];
+                Coefficient c = flatten(coefficient);
+                std::string name = identifier(i == 0 ? prop.first : prop.first + "_" + std::to_string(i), names);
+                laws << "inline constexpr EmbeddedLaw<" << typeName(c.type);
+                if (c.count > 0) {
+                    laws << ", " << c.count;
+                }
+                laws << "> " << name << "{{";
+                // 较长的数组每行 4 个
+                bool wrap = c.data.size() > 4;
+                for (size_t j = 0; j < c.data.size(); ++j) {
+                    laws << (j % 4 == 0 ? (wrap ? (j == 0 ? "\n        " : ",\n        ") : "") : ", ")
+                         << literal(c.data[j]);
+                }
+                laws << "}};\n";
+                coefficients << "        {" << typeName(c.type) << ", " << c.count << ", " << ns << "::" << name
+                             << ".data, " << quoted(coefficient.unit) << "},\n";
+                ++coefficientCount;
+            }
+        }
+        laws << "} // namespace " << ns << "\n";
+    }
+    if (coefficientCount == 0) {
+        throw std::runtime_error(source + " 中没有任何系数");
+    }
+
+    out << "// 由 material_db_embed 从 " << std::filesystem::path(source).filename().string()
+        << " 生成, 不要手工修改.\n"
+        << "// " << materials.size() << " 个材料, " << propertyCount << " 个物性, " << coefficientCount
+        << " 个系数\n"
+        << "#pragma once\n\n"
+        << "#include <limits>\n"
+        << "#include \"embedded_material.h\"\n\n"
+        << "namespace CFD_MaterialDB {\n"
+        << "namespace embedded {\n"
+        << laws.str()
+        << "\ninline constexpr EmbeddedCoefficient kCoefficients[] = {\n" << coefficients.str() << "};\n"
+        << "\ninline constexpr EmbeddedProperty kProperties[] = {\n" << properties.str() << "};\n"
+        << "\ninline constexpr EmbeddedMaterial kMaterials[] = {\n" << table.str() << "};\n\n"
+        << "} // namespace embedded\n\n"
+        << "inline constexpr EmbeddedMaterialDatabase kEmbeddedMaterialDatabase{\n"
+        << "        embedded::kMaterials, " << materials.size()
+        << ", embedded::kProperties, embedded::kCoefficients};\n\n"
+        << "} // namespace CFD_MaterialDB\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        std::cerr << "用法: material_db_embed <propdb.scm> <输出头文件>" << std::endl;
+        return 2;
+    }
+    try {
+        std::vector<Material> materials;
+        {
+            SilenceStdout silence;
+            ScmParser parser;
+            materials = parser.parse(argv[1]);
+        }
+        if (materials.empty()) {
+            throw std::runtime_error(std::string("没有从 ") + argv[1] + " 读到任何材料");
+        }
+        // 先写临时文件再改名, 中断的构建不会留下半个头文件
+        std::filesystem::path output = argv[2];
+        if (output.has_parent_path()) {
+            std::filesystem::create_directories(output.parent_path());
+        }
+        std::filesystem::path temporary = output.string() + ".tmp";
+        {
+            std::ofstream out(temporary);
+            writeHeader(out, materials, argv[1]);
+            if (!out) {
+                throw std::runtime_error("无法写入 " + temporary.string());
+            }
+        }
+        std::filesystem::rename(temporary, output);
+    } catch (const std::exception &e) {
+        std::cerr << "生成嵌入材料表失败: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+//
+// 对照编译期嵌入的材料表 (embedded_propdb.h) 与运行时解析同一个 SCM 文件的求值结果.
+// 用法: material_db_embedcheck [propdb.scm]; 文件应与生成头文件时使用的相同. 存在差异时返回 1
+//
+#include "embedded_propdb.h"
+#include "scm_parser.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+using namespace CFD_MaterialDB;
+
+namespace {
+
+// 每个系数在有效温度范围内的采样点数
+constexpr int kSamples = 64;
+
+// 公式相同, 但编译器对内联后的公式可能做不同的 FMA 收缩; 高次拟合 (如 diesel-1-fuel 的粘度) 在相消严重处
+// 相对差可到 1e-10 量级
+constexpr double kRelativeTolerance = 1e-9;
+
+// scale 为误差的参考量级; 导数在极值附近因相消而很小, 以 |v| / T 为参考
+bool close(double a, double b, double scale = 0.0) {
+    if (std::isnan(a) || std::isnan(b)) {
+        return std::isnan(a) && std::isnan(b);
+    }
+    return a == b || std::abs(a - b) <= kRelativeTolerance * std::max({std::abs(a), std::abs(b), scale});
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string file = argc > 1 ? argv[1] : "propdb.scm";
+    try {
+        std::vector<Material> materials;
+        {
+            std::ostringstream sink;
+            std::streambuf *saved = std::cout.rdbuf(sink.rdbuf());
+            ScmParser parser;
+            materials = parser.parse(file);
+            std::cout.rdbuf(saved);
+        }
+
+        const EmbeddedMaterialDatabase &database = kEmbeddedMaterialDatabase;
+        size_t points = 0, identical = 0, differences = 0, missing = 0;
+        for (const auto &material: materials) {
+            for (const auto &property: material.properties) {
+                for (size_t i = 0; i < property.second.size(); ++i) {
+                    const MaterialProperty &prop = property.second[i];
+                    const EmbeddedCoefficient *embedded = database.find(material.name, property.first, i);
+                    if (embedded == nullptr) {
+                        if (++missing <= 3) {
+                            std::cout << "  缺少 " << material.name << " " << property.first << " #" << i << std::endl;
+                        }
+                        continue;
+                    }
+                    double t_min, t_max;
+                    propertyTemperatureRange(prop, t_min, t_max);
+                    for (int k = 0; k < kSamples; ++k) {
+                        double T = t_min + (t_max - t_min) * k / (kSamples - 1);
+                        double p = kReferencePressure * (1 + k % 4);
+                        double expected = evaluateProperty(prop, T, p);
+                        double actual = evaluateEmbedded(*embedded, T, p);
+                        Dual expectedDual = evaluatePropertyDerivatives(prop, T, p);
+                        Dual actualDual = evaluateEmbeddedDerivatives(*embedded, T, p);
+                        ++points;
+                        if (std::memcmp(&expected, &actual, sizeof(double)) == 0) {
+                            ++identical;
+                        }
+                        if (!close(expected, actual) || !close(expectedDual.value, actualDual.value) ||
+                            !close(expectedDual.dT, actualDual.dT, std::abs(expected) / T) ||
+                            !close(expectedDual.dp, actualDual.dp, std::abs(expected) / p)) {
+                            if (++differences <= 3) {
+                                std::cout << "  " << material.name << " " << property.first << " #" << i
+                                          << " T=" << T << ": " << expected << " / " << actual << std::endl;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        std::cout << database.materialCount << " embedded materials, " << points << " points, " << identical
+                  << " bitwise identical, " << differences << " differences, " << missing << " missing"
+                  << std::endl;
+        return differences == 0 && missing == 0 ? 0 : 1;
+    } catch (const std::exception &e) {
+        std::cerr << "对照失败: " << e.what() << std::endl;
+        return 1;
+    }
+}
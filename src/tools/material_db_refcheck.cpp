@@ -0,0 +1,94 @@
+//
+// 用 tinyscheme 参考载入器对照 ScmParser: 比较两者的解析结果并统计耗时.
+// 用法: material_db_refcheck [propdb.scm] [重复次数]
+// 存在差异时返回 1
+//
+#include "scm_parser.h"
+#include "scheme_reference_loader.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+using namespace CFD_MaterialDB;
+
+namespace {
+
+// ScmParser 会输出大量调试信息, 计时期间丢弃标准输出
+class SilenceStdout {
+public:
+    SilenceStdout() : saved_(std::cout.rdbuf(sink_.rdbuf())) {}
+    ~SilenceStdout() { std::cout.rdbuf(saved_); }
+
+private:
+    std::ostringstream sink_;
+    std::streambuf *saved_;
+};
+
+template<typename F>
+double medianSeconds(int repeat, F &&run) {
+    std::vector<double> samples;
+    for (int i = 0; i < repeat; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        samples.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string file = argc > 1 ? argv[1] : "propdb.scm";
+    int repeat = argc > 2 ? std::max(1, std::atoi(argv[2])) : 3;
+
+    try {
+        std::vector<Material> fast;
+        std::vector<Material> reference;
+        SchemeReferenceLoader loader;
+
+        double fastSeconds = medianSeconds(repeat, [&] {
+            SilenceStdout silence;
+            ScmParser parser;
+            fast = parser.parse(file);
+        });
+        double referenceSeconds = medianSeconds(repeat, [&] { reference = loader.load(file); });
+
+        std::cout << "ScmParser:        " << fast.size() << " materials, median " << fastSeconds * 1e3 << " ms"
+                  << std::endl;
+        std::cout << "tinyscheme 参考:  " << reference.size() << " materials, median " << referenceSeconds * 1e3
+                  << " ms" << std::endl;
+        for (const auto &warning: loader.warnings()) {
+            std::cout << "  参考载入器警告: " << warning << std::endl;
+        }
+
+        auto differences = compareMaterials(reference, fast);
+        std::map<std::string, std::vector<const MaterialDifference *>> groups;
+        for (const auto &difference: differences) {
+            std::string key = difference.kind;
+            if (!difference.property.empty()) {
+                key += " " + difference.property;
+            }
+            groups[key].push_back(&difference);
+        }
+
+        std::cout << differences.size() << " differences" << std::endl;
+        for (const auto &group: groups) {
+            std::cout << "  " << group.first << ": " << group.second.size() << std::endl;
+            for (size_t i = 0; i < group.second.size() && i < 3; ++i) {
+                const auto *difference = group.second[i];
+                std::cout << "      " << difference->material;
+                if (!difference->detail.empty()) {
+                    std::cout << ": " << difference->detail;
+                }
+                std::cout << std::endl;
+            }
+        }
+        return differences.empty() ? 0 : 1;
+    } catch (const std::exception &e) {
+        std::cerr << "对照失败: " << e.what() << std::endl;
+        return 2;
+    }
+}
@@ -0,0 +1,151 @@
+//
+// MaterialRegistry 的并发压力检查: 若干读者线程不停地读取快照并校验, 同时后台反复 reloadAsync,
+// 在各个来源之间轮换. 建议分别用 -fsanitize=address 和 -fsanitize=thread 编译后运行.
+// 用法: material_db_registrycheck [--readers=N] [--reloads=N] [来源...]
+// 来源为 .scm 文件或材料数据库, 默认 propdb.scm; 发现不一致时返回 1
+//
+#include "material_registry.h"
+#include "property_evaluator.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace CFD_MaterialDB;
+
+namespace {
+
+// ScmParser 会输出大量调试信息, 检查期间丢弃标准输出
+class SilenceStdout {
+public:
+    SilenceStdout() : saved_(std::cout.rdbuf(sink_.rdbuf())) {}
+    ~SilenceStdout() { std::cout.rdbuf(saved_); }
+
+private:
+    std::ostringstream sink_;
+    std::streambuf *saved_;
+};
+
+// 快照内容的摘要: 材料数与前若干个材料第一个系数在 300 K 的值之和. 持有快照期间前后两次计算必须相同
+double digest(const MaterialSnapshot &snapshot) {
+    double sum = static_cast<double>(snapshot.materials().size());
+    size_t count = std::min<size_t>(snapshot.materials().size(), 32);
+    for (size_t i = 0; i < count; ++i) {
+        const Material &material = snapshot.materials()[i];
+        if (snapshot.find(material.name) == nullptr) {
+            return std::nan("");
+        }
+        for (const auto &property: material.properties) {
+            if (!property.second.empty()) {
+                double value = evaluateProperty(property.second.front(), 300.0);
+                sum += std::isfinite(value) ? value : 0.0;
+            }
+        }
+    }
+    return sum;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int readers = 8;
+    int reloads = 6;
+    std::vector<std::string> sources;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 10, "--readers=") == 0) {
+            readers = std::max(1, std::atoi(arg.c_str() + 10));
+        } else if (arg.compare(0, 10, "--reloads=") == 0) {
+            reloads = std::max(1, std::atoi(arg.c_str() + 10));
+        } else {
+            sources.push_back(arg);
+        }
+    }
+    if (sources.empty()) {
+        sources.push_back("propdb.scm");
+    }
+
+    try {
+        SilenceStdout silence;
+        MaterialRegistry registry(sources.front());
+        std::atomic<bool> done{false};
+        std::atomic<size_t> reads{0};
+        std::atomic<size_t> failures{0};
+        std::mutex errorMutex;
+        std::vector<std::string> errors;
+        auto fail = [&](const std::string &message) {
+            failures.fetch_add(1);
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (errors.size() < 5) {
+                errors.push_back(message);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (int r = 0; r < readers; ++r) {
+            threads.emplace_back([&] {
+                uint64_t last = 0;
+                while (!done.load(std::memory_order_acquire)) {
+                    MaterialRegistry::Reader snapshot = registry.read();
+                    uint64_t generation = snapshot->generation();
+                    if (generation < last) {
+                        fail("代号回退: " + std::to_string(last) + " -> " + std::to_string(generation));
+                    }
+                    last = generation;
+                    double before = digest(*snapshot);
+                    std::this_thread::yield();
+                    double after = digest(*snapshot);
+                    if (std::isnan(before) || before != after || snapshot->generation() != generation) {
+                        fail("快照 " + std::to_string(generation) + " 在读取期间发生变化");
+                    }
+                    reads.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+
+        // 同一来源的快照内容应相同
+        std::map<std::string, double> expected;
+        for (int i = 1; i <= reloads; ++i) {
+            const std::string &source = sources[i % sources.size()];
+            uint64_t generation = registry.reloadAsync(source).get();
+            MaterialRegistry::Reader snapshot = registry.read();
+            double value = digest(*snapshot);
+            auto inserted = expected.emplace(source, value);
+            if (snapshot->generation() < generation || (!inserted.second && inserted.first->second != value)) {
+                fail("第 " + std::to_string(i) + " 次载入 " + source + " 的快照与之前不同");
+            }
+        }
+        done.store(true, std::memory_order_release);
+        for (auto &thread: threads) {
+            thread.join();
+        }
+        registry.synchronize();
+
+        // 发布时仍被持有的旧快照留待回收; 读者离开后 reclaim() 即可释放, 不必再次发布
+        {
+            MaterialRegistry::Reader held = registry.read();
+            registry.reload();
+        }
+        size_t held = registry.pendingReclamation();
+        size_t reclaimed = registry.reclaim();
+        if (held != 1 || reclaimed != 1) {
+            fail("读者离开后 reclaim 释放了 " + std::to_string(reclaimed) + " 个快照, 应为 1");
+        }
+
+        std::cerr << readers << " readers, " << reloads << " reloads, " << reads.load() << " snapshot reads, "
+                  << registry.pendingReclamation() << " pending, " << failures.load() << " failures" << std::endl;
+        for (const auto &error: errors) {
+            std::cerr << "  " << error << std::endl;
+        }
+        return failures.load() == 0 && registry.pendingReclamation() == 0 ? 0 : 1;
+    } catch (const std::exception &e) {
+        std::cerr << "检查失败: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,279 @@
+//
+// 生成仿照 propdb.scm 结构的合成 SCM 数据库, 用于在 10 万到百万材料规模下测量 ScmParser,
+// DatabaseManager 和导入流水线.
+// 用法: material_db_synth [--materials=N] [--mixtures=M] [--species=K] [--seed=S]
+//                         [--mix=nasa9:4,piecewise-polynomial:3,piecewise-linear:2,sutherland:1] [--output=文件]
+// 未给出 --output 时写到标准输出
+//
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 命令行参数错误, 输出用法后以状态 2 退出
+struct UsageError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// 比热的系数形式; 权重由 --mix 指定
+enum class HeatCapacityForm {
+    Nasa9,
+    PiecewisePolynomial,
+    PiecewiseLinear,
+    Sutherland   // 比热取常数, 粘度用 sutherland
+};
+
+const std::map<std::string, HeatCapacityForm> kFormNames = {
+        {"nasa9", HeatCapacityForm::Nasa9},
+        {"piecewise-polynomial", HeatCapacityForm::PiecewisePolynomial},
+        {"piecewise-linear", HeatCapacityForm::PiecewiseLinear},
+        {"sutherland", HeatCapacityForm::Sutherland},
+};
+
+// 系数模板取自 propdb.scm 中的 air, 生成时整体乘以随机因子, 保持曲线形状
+const double kNasa9Low[] = {2.898903e+06, -5.649626e+04, 1.437799e+03, -1.653609e+00, 3.062254e-03, -2.279138e-06,
+                            6.272365e-10};
+const double kNasa9High[] = {6.932494e+07, -3.610532e+05, 1.476665e+03, -6.138349e-02, 2.027963e-05, -3.075525e-09,
+                             1.888054e-13};
+const double kPolyLow[] = {1161.48214452351, -2.36881890191577, 1.48551108358867E-02, -5.03490927522584E-05,
+                           9.9285695564579E-08, -1.11109658897742E-10, 6.54019600406048E-14, -1.57358768447275E-17};
+const double kPolyHigh[] = {-7069.81410143802, 33.7060506468204, -5.81275953375815E-02, 5.42161532229608E-05,
+                            -2.936678858119E-08, 9.23753316956768E-12, -1.56555339604519E-15, 1.11233485020759E-19};
+
+struct Options {
+    size_t materials = 100000;
+    size_t mixtures = 0;          // 默认为 materials / 100
+    size_t species = 8;
+    unsigned long long seed = 1;
+    std::vector<std::pair<HeatCapacityForm, double>> mix = {
+            {HeatCapacityForm::Nasa9, 4.0},
+            {HeatCapacityForm::PiecewisePolynomial, 3.0},
+            {HeatCapacityForm::PiecewiseLinear, 2.0},
+            {HeatCapacityForm::Sutherland, 1.0},
+    };
+    std::string output;
+};
+
+std::string number(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    return buffer;
+}
+
+std::vector<std::pair<HeatCapacityForm, double>> parseMix(const std::string &spec) {
+    std::vector<std::pair<HeatCapacityForm, double>> mix;
+    double total = 0.0;
+    std::stringstream stream(spec);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        size_t colon = item.find(':');
+        auto form = kFormNames.find(item.substr(0, colon));
+        if (form == kFormNames.end()) {
+            throw UsageError("未知的系数形式: " + item);
+        }
+        double weight = colon == std::string::npos ? 1.0 : std::stod(item.substr(colon + 1));
+        if (!(weight >= 0.0)) {
+            throw UsageError("权重不能为负: " + item);
+        }
+        mix.emplace_back(form->second, weight);
+        total += weight;
+    }
+    if (mix.empty()) {
+        throw UsageError("--mix 为空");
+    }
+    // std::discrete_distribution 要求权重之和为正的有限值
+    if (!(total > 0.0) || !std::isfinite(total)) {
+        throw UsageError("--mix 的权重之和应为正的有限值: " + spec);
+    }
+    return mix;
+}
+
+const char *kUsage =
+        "用法: material_db_synth [--materials=N] [--mixtures=M] [--species=K] [--seed=S]\n"
+        "                        [--mix=nasa9:4,piecewise-polynomial:3,piecewise-linear:2,sutherland:1] [--output=文件]\n"
+        "未给出 --output 时写到标准输出\n";
+
+Options parseOptions(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t equals = arg.find('=');
+        std::string key = arg.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+        if (key == "--help" || key == "-h") {
+            std::cout << kUsage;
+            std::exit(0);
+        } else if (key == "--materials") {
+            options.materials = std::stoull(value);
+        } else if (key == "--mixtures") {
+            options.mixtures = std::stoull(value);
+        } else if (key == "--species") {
+            options.species = std::stoull(value);
+        } else if (key == "--seed") {
+            options.seed = std::stoull(value);
+        } else if (key == "--mix") {
+            options.mix = parseMix(value);
+        } else if (key == "--output") {
+            options.output = value;
+        } else {
+            throw UsageError("未知参数: " + arg);
+        }
+    }
+    if (options.mixtures == 0) {
+        options.mixtures = options.materials / 100;
+    }
+    if (options.mixtures > 0 && (options.species == 0 || options.species > options.materials)) {
+        throw UsageError("混合物的组分数应在 1 到材料数之间");
+    }
+    return options;
+}
+
+class Generator {
+public:
+    explicit Generator(const Options &options) : options_(options), random_(options.seed) {
+        std::vector<double> weights;
+        for (const auto &entry: options.mix) {
+            weights.push_back(entry.second);
+        }
+        forms_ = std::discrete_distribution<size_t>(weights.begin(), weights.end());
+    }
+
+    static std::string speciesName(size_t i) { return "synthetic-species-" + std::to_string(i); }
+
+    void writeSpecies(std::ostream &out, size_t i) {
+        HeatCapacityForm form = options_.mix[forms_(random_)].first;
+        double scale = uniform(0.6, 1.6);
+        double molecularWeight = uniform(2.0, 300.0);
+
+        out << " (" << speciesName(i) << "\n  fluid\n  (chemical-formula . s" << i << ")\n";
+        out << "  (density (constant . " << number(uniform(0.1, 2000.0)) << "))\n";
+        out << "  (specific-heat (constant . " << number(1000.0 * scale) << ")";
+        switch (form) {
+            case HeatCapacityForm::Nasa9:
+                out << " (polynomial nasa-9-piecewise-polynomial " << segment(200.0, 1000.0, kNasa9Low, 7, scale)
+                    << " " << segment(1000.0, 6000.0, kNasa9High, 7, scale) << ")";
+                break;
+            case HeatCapacityForm::PiecewisePolynomial:
+                out << " (polynomial piecewise-polynomial " << segment(100.0, 1000.0, kPolyLow, 8, scale) << " "
+                    << segment(1000.0, 3000.0, kPolyHigh, 8, scale) << ")";
+                break;
+            case HeatCapacityForm::PiecewiseLinear:
+                out << " " << piecewiseLinear(scale);
+                break;
+            case HeatCapacityForm::Sutherland:
+                break;
+        }
+        out << ")\n";
+        out << "  (thermal-conductivity (constant . " << number(uniform(0.005, 0.5)) << "))\n";
+        if (form == HeatCapacityForm::Sutherland) {
+            out << "  (viscosity (constant . " << number(1.8e-5 * scale) << ") (sutherland "
+                << number(1.716e-5 * scale) << " 273.11 " << number(uniform(80.0, 250.0)) << "))\n";
+        } else {
+            out << "  (viscosity (constant . " << number(1.8e-5 * scale) << "))\n";
+        }
+        out << "  (molecular-weight (constant . " << number(molecularWeight) << "))\n";
+        out << "  (formation-enthalpy (constant . " << number(uniform(-1e9, 5e8)) << "))\n";
+        out << "  (reference-temperature (constant . 298.15))\n";
+        out << "  (critical-pressure (constant . " << number(uniform(1e6, 2e7)) << "))\n";
+        out << "  (critical-temperature (constant . " << number(uniform(30.0, 900.0)) << "))\n";
+        out << "  (acentric-factor (constant . " << number(uniform(-0.2, 0.8)) << "))\n";
+        out << "  (lennard-jones-length (constant . " << number(uniform(2.5, 7.0)) << "))\n";
+        out << "  (lennard-jones-energy (constant . " << number(uniform(10.0, 600.0)) << "))\n";
+        out << "  )\n\n";
+    }
+
+    // 组分从已生成的物种中随机抽取, 不重复
+    void writeMixture(std::ostream &out, size_t i) {
+        out << " (synthetic-mixture-" << i << "\n  mixture\n  (chemical-formula . #f)\n  (species (names";
+        std::vector<size_t> chosen;
+        while (chosen.size() < options_.species) {
+            size_t candidate = std::uniform_int_distribution<size_t>(0, options_.materials - 1)(random_);
+            bool duplicate = false;
+            for (size_t existing: chosen) {
+                duplicate = duplicate || existing == candidate;
+            }
+            if (!duplicate) {
+                chosen.push_back(candidate);
+                out << " " << speciesName(candidate);
+            }
+        }
+        out << "))\n  )\n\n";
+    }
+
+private:
+    double uniform(double low, double high) { return std::uniform_real_distribution<double>(low, high)(random_); }
+
+    static std::string segment(double tMin, double tMax, const double *coefficients, size_t count, double scale) {
+        std::string text = "(" + number(tMin) + " " + number(tMax);
+        for (size_t i = 0; i < count; ++i) {
+            text += " " + number(coefficients[i] * scale);
+        }
+        return text + ")";
+    }
+
+    // 4-64 个递增温度点, 比热随温度单调上升
+    std::string piecewiseLinear(double scale) {
+        size_t points = std::uniform_int_distribution<size_t>(4, 64)(random_);
+        double step = 2800.0 / points;
+        std::string text = "(polynomial piecewise-linear";
+        double T = 200.0;
+        double cp = 900.0 * scale;
+        for (size_t i = 0; i < points; ++i) {
+            text += " (" + number(T) + " . " + number(cp) + ")";
+            T += step * uniform(0.5, 1.5);
+            cp += uniform(0.0, 20.0) * scale;
+        }
+        return text + ")";
+    }
+
+    const Options &options_;
+    std::mt19937_64 random_;
+    std::discrete_distribution<size_t> forms_;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+    try {
+        Options options = parseOptions(argc, argv);
+        std::ofstream file;
+        if (!options.output.empty()) {
+            file.open(options.output, std::ios::binary);
+            if (!file) {
+                throw std::runtime_error("无法写入 " + options.output);
+            }
+        }
+        std::ostream &out = options.output.empty() ? std::cout : file;
+
+        Generator generator(options);
+        out << "; 合成材料库: " << options.materials << " 个物种, " << options.mixtures << " 个混合物 ("
+            << options.species << " 组分), seed " << options.seed << "\n\n";
+        for (size_t i = 0; i < options.materials; ++i) {
+            generator.writeSpecies(out, i);
+        }
+        for (size_t i = 0; i < options.mixtures; ++i) {
+            generator.writeMixture(out, i);
+        }
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("写入失败");
+        }
+        std::cerr << "生成 " << options.materials + options.mixtures << " 个材料" << std::endl;
+        return 0;
+    } catch (const UsageError &e) {
+        std::cerr << e.what() << "\n\n" << kUsage;
+        return 2;
+    } catch (const std::exception &e) {
+        std::cerr << "生成失败: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,159 @@
+//
+// 用不访问网络的 StubTranslateBackend 检查 TranslationService: 分批, 持久缓存, 失败重试, 以及并发调用
+// 不会在网络请求期间互相等待. 用法: material_db_translatecheck [propdb.scm]; 发现问题时返回 1
+//
+#include "scm_parser.h"
+#include "translation_service.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace CFD_MaterialDB;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 检查用的选项: 不限速, 由调用方决定是否使用缓存
+TranslationOptions checkOptions(const std::string &cachePath) {
+    TranslationOptions options;
+    options.cachePath = cachePath;
+    options.requestsPerSecond = 0.0;
+    return options;
+}
+
+// 与 TranslationService 相同的分批规则, 得到不出错时应发送的请求数
+size_t expectedBatches(const std::vector<std::string> &names, size_t maxBatchBytes) {
+    size_t batches = 0;
+    size_t bytes = 0;
+    for (const auto &name: names) {
+        if (batches == 0 || bytes + name.size() + 1 > maxBatchBytes) {
+            ++batches;
+            bytes = 0;
+        }
+        bytes += name.size() + 1;
+    }
+    return batches;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string file = argc > 1 ? argv[1] : "propdb.scm";
+    std::string cachePath = (std::filesystem::temp_directory_path() / "material_db_translatecheck.db").string();
+    int failures = 0;
+    auto check = [&](bool ok, const std::string &what) {
+        std::cout << (ok ? "  ok    " : "  FAIL  ") << what << std::endl;
+        failures += ok ? 0 : 1;
+    };
+    try {
+        std::vector<std::string> names;
+        {
+            std::ostringstream sink;
+            std::streambuf *saved = std::cout.rdbuf(sink.rdbuf());
+            ScmParser parser;
+            std::unordered_set<std::string> seen;
+            for (const auto &material: parser.parse(file)) {
+                if (seen.insert(material.name).second) {
+                    names.push_back(material.name);
+                }
+            }
+            std::cout.rdbuf(saved);
+        }
+        if (names.size() < 4) {
+            throw std::runtime_error("材料太少: " + file);
+        }
+        std::cout << names.size() << " unique names" << std::endl;
+        auto allTranslated = [&](const std::vector<std::optional<std::string>> &results) {
+            for (size_t i = 0; i < names.size(); ++i) {
+                if (!results[i] || *results[i] != "译:" + names[i]) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        // 首次翻译按字节数分批, 结果写入持久缓存; 第二个服务实例全部从缓存读取
+        std::filesystem::remove(cachePath);
+        TranslationOptions options = checkOptions(cachePath);
+        size_t batches = expectedBatches(names, options.maxBatchBytes);
+        {
+            auto backend = std::make_unique<StubTranslateBackend>();
+            StubTranslateBackend *stub = backend.get();
+            TranslationService service(std::move(backend), options);
+            check(allTranslated(service.translate(names)), "all names translated");
+            check(stub->requests() == batches, std::to_string(stub->requests()) + " requests for "
+                                               + std::to_string(batches) + " batches");
+        }
+        {
+            auto backend = std::make_unique<StubTranslateBackend>();
+            StubTranslateBackend *stub = backend.get();
+            TranslationService service(std::move(backend), options);
+            check(allTranslated(service.translate(names)), "second run translated");
+            check(stub->requests() == 0 && service.stats().cacheHits == names.size(),
+                  "second run served from cache (" + std::to_string(service.stats().cacheHits) + " hits)");
+        }
+        std::filesystem::remove(cachePath);
+
+        // 每三个请求失败一个, 重试后仍应全部取得译文
+        {
+            auto backend = std::make_unique<StubTranslateBackend>(std::unordered_map<std::string, std::string>(),
+                                                                  "译:", 3);
+            StubTranslateBackend *stub = backend.get();
+            TranslationOptions retrying = checkOptions("");
+            retrying.maxBatchBytes = 1000;
+            retrying.maxRetries = 4;
+            TranslationService service(std::move(backend), retrying);
+            check(allTranslated(service.translate(names)), "failed requests retried");
+            check(stub->requests() > expectedBatches(names, retrying.maxBatchBytes),
+                  std::to_string(stub->requests()) + " requests including retries");
+        }
+
+        // 四个线程同时逐个翻译各自的一份名称, 每个请求延迟 latency;
+        // 网络请求期间持有锁时总耗时约为各线程之和, 否则约为单个线程的耗时
+        {
+            const auto latency = std::chrono::milliseconds(40);
+            const int threads = 4;
+            const size_t requestsPerThread = 4;
+            TranslationService service(std::make_unique<StubTranslateBackend>(
+                    std::unordered_map<std::string, std::string>(), "译:", 0, latency), checkOptions(""));
+            std::vector<std::vector<std::string>> parts(threads);
+            for (size_t i = 0; i < names.size(); ++i) {
+                parts[i % threads].push_back(names[i]);
+            }
+            size_t total = 0;
+            for (auto &part: parts) {
+                part.resize(std::min(part.size(), requestsPerThread));
+                total += part.size();
+            }
+            auto start = Clock::now();
+            std::vector<std::thread> workers;
+            for (const auto &part: parts) {
+                workers.emplace_back([&service, &part] {
+                    for (const auto &name: part) {
+                        service.translate(name);
+                    }
+                });
+            }
+            for (auto &worker: workers) {
+                worker.join();
+            }
+            double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+            double serialized = std::chrono::duration<double>(latency).count() * total;
+            check(service.stats().translated == total
+                  && elapsed < 0.6 * serialized,
+                  "concurrent calls overlap: " + std::to_string(elapsed) + " s, serialized would take "
+                  + std::to_string(serialized) + " s");
+        }
+    } catch (const std::exception &e) {
+        std::filesystem::remove(cachePath);
+        std::cerr << "检查失败: " << e.what() << std::endl;
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+//
+// 对照按类型特化的求值器 (withEvaluator) 与 evaluateProperty / evaluatePropertyDerivatives 的结果,
+// 逐点与批量接口都检查. 用法: material_db_typedcheck [propdb.scm]; 存在差异时返回 1
+//
+#include "scm_parser.h"
+#include "typed_evaluator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace CFD_MaterialDB;
+
+namespace {
+
+// 每个系数在有效温度范围内的采样点数
+constexpr size_t kSamples = 64;
+
+// 编译器对内联后的公式可能做不同的 FMA 收缩, 与 material_db_embedcheck 使用相同的容差
+constexpr double kRelativeTolerance = 1e-9;
+
+// scale 为误差的参考量级; 导数在极值附近因相消而很小, 以 |v| / T 为参考
+bool close(double a, double b, double scale = 0.0) {
+    if (std::isnan(a) || std::isnan(b)) {
+        return std::isnan(a) && std::isnan(b);
+    }
+    return a == b || std::abs(a - b) <= kRelativeTolerance * std::max({std::abs(a), std::abs(b), scale});
+}
+
+// 未预先编译的 user-defined 物性, 覆盖 Evaluator 构造时编译的路径
+MaterialProperty uncompiledUserDefined(const std::string &source) {
+    MaterialProperty prop;
+    prop.coeffType = userDefinedT;
+    prop.userdata.source = source;
+    return prop;
+}
+
+// f 应当抛出; 没有抛出时返回 false
+template<typename F>
+bool throws(F &&f) {
+    try {
+        f();
+    } catch (const std::exception &) {
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string file = argc > 1 ? argv[1] : "propdb.scm";
+    try {
+        std::vector<Material> materials;
+        {
+            std::ostringstream sink;
+            std::streambuf *saved = std::cout.rdbuf(sink.rdbuf());
+            ScmParser parser;
+            materials = parser.parse(file);
+            std::cout.rdbuf(saved);
+        }
+        Material extra;
+        extra.name = "typedcheck-user-defined";
+        extra.properties["viscosity"].push_back(uncompiledUserDefined(
+                "(lambda (T p) (* 1.716e-5 (expt (/ T 273.11) 1.5) (/ 383.67 (+ T 110.56)) (/ p 101325)))"));
+        materials.push_back(extra);
+
+        size_t points = 0, identical = 0, differences = 0;
+        auto report = [&](const Material &material, const std::string &name, size_t i, const char *what, double T,
+                          double expected, double actual) {
+            if (++differences <= 3) {
+                std::cout << "  " << material.name << " " << name << " #" << i << " " << what << " T=" << T << ": "
+                          << expected << " / " << actual << std::endl;
+            }
+        };
+
+        std::vector<double> T(kSamples), expected(kSamples), expectedDT(kSamples), expectedDp(kSamples);
+        std::vector<double> value(kSamples), dvdT(kSamples), dvdp(kSamples);
+        for (const auto &material: materials) {
+            for (const auto &property: material.properties) {
+                for (size_t i = 0; i < property.second.size(); ++i) {
+                    const MaterialProperty &prop = property.second[i];
+                    double t_min, t_max;
+                    propertyTemperatureRange(prop, t_min, t_max);
+                    for (size_t k = 0; k < kSamples; ++k) {
+                        T[k] = t_min + (t_max - t_min) * k / (kSamples - 1);
+                    }
+                    // 批量接口共用一个压力, 取非参考值以检查压力的传递
+                    double p = 2 * kReferencePressure;
+                    withEvaluator(prop, [&](const auto &evaluator) {
+                        for (size_t k = 0; k < kSamples; ++k) {
+                            double reference = evaluateProperty(prop, T[k], p);
+                            double actual = evaluator(T[k], p);
+                            Dual referenceDual = evaluatePropertyDerivatives(prop, T[k], p);
+                            Dual actualDual = evaluator.derivatives(T[k], p);
+                            ++points;
+                            if (std::memcmp(&reference, &actual, sizeof(double)) == 0) {
+                                ++identical;
+                            }
+                            if (!close(reference, actual) || !close(referenceDual.value, actualDual.value)) {
+                                report(material, property.first, i, "value", T[k], reference, actual);
+                            } else if (!close(referenceDual.dT, actualDual.dT, std::abs(reference) / T[k]) ||
+                                       !close(referenceDual.dp, actualDual.dp, std::abs(reference) / p)) {
+                                report(material, property.first, i, "dT/dp", T[k], referenceDual.dT, actualDual.dT);
+                            }
+                        }
+
+                        evaluateProperty(prop, T.data(), expected.data(), kSamples, p);
+                        evaluator(T.data(), value.data(), kSamples, p);
+                        for (size_t k = 0; k < kSamples; ++k) {
+                            if (!close(expected[k], value[k])) {
+                                report(material, property.first, i, "batch value", T[k], expected[k], value[k]);
+                            }
+                        }
+
+                        evaluatePropertyDerivatives(prop, T.data(), expected.data(), expectedDT.data(),
+                                                    expectedDp.data(), kSamples, p);
+                        evaluator.derivatives(T.data(), value.data(), dvdT.data(), dvdp.data(), kSamples, p);
+                        for (size_t k = 0; k < kSamples; ++k) {
+                            if (!close(expected[k], value[k]) ||
+                                !close(expectedDT[k], dvdT[k], std::abs(expected[k]) / T[k]) ||
+                                !close(expectedDp[k], dvdp[k], std::abs(expected[k]) / p)) {
+                                report(material, property.first, i, "batch derivatives", T[k], expectedDT[k],
+                                       dvdT[k]);
+                            }
+                        }
+                    });
+                }
+            }
+        }
+
+        // 构造时的校验: 类型不符, 多项式系数个数不符, lambda 无法编译, 都应抛出
+        size_t unchecked = 0;
+        MaterialProperty polynomial;
+        polynomial.coeffType = polynomialT;
+        polynomial.polydata.coefficients = {1.0, 2.0};
+        if (!throws([&] { Evaluator<sutherlandT> evaluator(polynomial); })) {
+            std::cout << "  类型不符时没有抛出" << std::endl;
+            ++unchecked;
+        }
+        if (!throws([&] { Evaluator<polynomialT, 3> evaluator(polynomial); })) {
+            std::cout << "  多项式系数个数不符时没有抛出" << std::endl;
+            ++unchecked;
+        }
+        if (!throws([&] { Evaluator<userDefinedT> evaluator(uncompiledUserDefined("(lambda (T p) (+ T")); })) {
+            std::cout << "  lambda 无法编译时没有抛出" << std::endl;
+            ++unchecked;
+        }
+
+        std::cout << points << " points, " << identical << " bitwise identical, " << differences << " differences, "
+                  << unchecked << " unchecked constructors" << std::endl;
+        return differences == 0 && unchecked == 0 ? 0 : 1;
+    } catch (const std::exception &e) {
+        std::cerr << "对照失败: " << e.what() << std::endl;
+        return 1;
+    }
+}
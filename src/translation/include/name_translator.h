@@ -0,0 +1,93 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "database_manager.h"
+#include "translation_service.h"
+
+namespace CFD_MaterialDB {
+
+// 材料英文名 -> 中文名. 未能解析时返回空, 由调用方决定回退值
+class NameTranslator {
+public:
+    virtual ~NameTranslator() = default;
+
+    virtual std::string name() const = 0;
+    virtual std::optional<std::string> translate(const std::string &materialName) = 0;
+
+    // 默认逐个调用 translate; HTTP 实现把整批合并成少量请求
+    virtual std::vector<std::optional<std::string>> translateBatch(const std::vector<std::string> &names);
+};
+
+// 逐条查询 materialsDict.db; 与 InMemoryDictionaryTranslator 一样只读打开, 字典缺失时所有名称都未解析
+class DictionaryDbTranslator : public NameTranslator {
+public:
+    explicit DictionaryDbTranslator(const std::string &dbPath);
+
+    std::string name() const override { return "dictionary"; }
+    std::optional<std::string> translate(const std::string &materialName) override;
+
+private:
+    std::unique_ptr<DatabaseManager> dictionary_;
+};
+
+// 启动时把字典整体载入哈希表, 之后查询不再访问 SQLite
+class InMemoryDictionaryTranslator : public NameTranslator {
+public:
+    explicit InMemoryDictionaryTranslator(const std::string &dbPath);
+    explicit InMemoryDictionaryTranslator(std::unordered_map<std::string, std::string> entries);
+
+    std::string name() const override { return "memory"; }
+    std::optional<std::string> translate(const std::string &materialName) override;
+
+    size_t size() const { return entries_.size(); }
+
+private:
+    std::unordered_map<std::string, std::string> entries_;
+};
+
+// 通过在线翻译服务翻译 (带持久缓存和批量请求)
+class HttpNameTranslator : public NameTranslator {
+public:
+    explicit HttpNameTranslator(std::shared_ptr<TranslationService> service);
+
+    std::string name() const override { return "http"; }
+    std::optional<std::string> translate(const std::string &materialName) override;
+    std::vector<std::optional<std::string>> translateBatch(const std::vector<std::string> &names) override;
+
+private:
+    std::shared_ptr<TranslationService> service_;
+};
+
+// 依次尝试各个提供者, 前一个未解析的名称整批交给下一个
+class ChainTranslator : public NameTranslator {
+public:
+    explicit ChainTranslator(std::vector<std::unique_ptr<NameTranslator>> providers);
+
+    std::string name() const override;
+    std::optional<std::string> translate(const std::string &materialName) override;
+    std::vector<std::optional<std::string>> translateBatch(const std::vector<std::string> &names) override;
+
+private:
+    std::vector<std::unique_ptr<NameTranslator>> providers_;
+};
+
+// baiduAppId / baiduKey 为空时取环境变量 MATDB_BAIDU_APPID / MATDB_BAIDU_KEY;
+// 仍然没有凭据时 http 提供者被禁用 (给出警告后跳过)
+struct NameTranslatorConfig {
+    std::string dictionaryPath = "materialsDict.db";
+    std::string baiduAppId;
+    std::string baiduKey;
+    std::string translateEndpoint = "https://fanyi-api.baidu.com/api/trans/vip/translate";
+    TranslationOptions translation;
+};
+
+// spec 为逗号分隔的提供者列表, 可选 dictionary, memory, http, 例如 "memory,http";
+// 多于一个时组成 ChainTranslator
+std::unique_ptr<NameTranslator> makeNameTranslator(const std::string &spec,
+                                                   const NameTranslatorConfig &config = NameTranslatorConfig());
+
+} // namespace CFD_MaterialDB
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <curl/curl.h>
+#include "sqlcipher/sqlite3.h"
+
+namespace CFD_MaterialDB {
+
+struct HttpRequest {
+    std::string url;
+    std::string postFields;     // 为空时发送 GET
+};
+
+// 翻译接口的协议适配层: 构造批量请求并解析响应. 测试时可指向本地桩服务, 或使用不访问网络的 StubTranslateBackend
+class TranslationBackend {
+public:
+    virtual ~TranslationBackend() = default;
+
+    // 不经网络直接给出响应体的后端 (桩) 覆盖此函数; 返回空时通过 HTTP 发送 request
+    virtual std::optional<std::string> respond(const HttpRequest &) const { return std::nullopt; }
+
+    virtual HttpRequest buildRequest(const std::vector<std::string> &texts,
+                                     const std::string &from, const std::string &to) const = 0;
+
+    // 返回与 texts 一一对应的译文, 缺失的条目为空
+    virtual std::vector<std::optional<std::string>> parseResponse(const std::vector<std::string> &texts,
+                                                                  const std::string &body) const = 0;
+};
+
+// 百度翻译 API 的凭据, 不写在源码中; 由调用方的配置或环境变量 MATDB_BAIDU_APPID / MATDB_BAIDU_KEY 提供
+struct BaiduCredentials {
+    std::string appid;
+    std::string key;
+
+    bool valid() const { return !appid.empty() && !key.empty(); }
+
+    // 读取环境变量, 未设置的字段为空
+    static BaiduCredentials fromEnvironment();
+};
+
+// 百度通用翻译 API, 多条文本以换行拼接后在一次请求中发送; appid 或 key 为空时抛出
+class BaiduTranslateBackend : public TranslationBackend {
+public:
+    BaiduTranslateBackend(std::string appid, std::string key,
+                          std::string endpoint = "https://fanyi-api.baidu.com/api/trans/vip/translate");
+
+    HttpRequest buildRequest(const std::vector<std::string> &texts,
+                             const std::string &from, const std::string &to) const override;
+
+    std::vector<std::optional<std::string>> parseResponse(const std::vector<std::string> &texts,
+                                                          const std::string &body) const override;
+
+private:
+    std::string appid_;
+    std::string key_;
+    std::string endpoint_;
+};
+
+// 不访问网络的桩后端, 用于在没有凭据和网络时检查 TranslationService 的分批, 缓存, 重试与并发.
+// 译文取 dictionary 中的条目, 其余文本为 prefix + 原文; 每个请求先等待 latency 模拟网络延迟,
+// failEvery > 0 时每 failEvery 个请求中有一个返回空结果 (整批失败, 触发重试). 文本中不能含换行
+class StubTranslateBackend : public TranslationBackend {
+public:
+    explicit StubTranslateBackend(std::unordered_map<std::string, std::string> dictionary = {},
+                                  std::string prefix = "译:", size_t failEvery = 0,
+                                  std::chrono::milliseconds latency = std::chrono::milliseconds(0));
+
+    std::optional<std::string> respond(const HttpRequest &request) const override;
+
+    HttpRequest buildRequest(const std::vector<std::string> &texts,
+                             const std::string &from, const std::string &to) const override;
+
+    std::vector<std::optional<std::string>> parseResponse(const std::vector<std::string> &texts,
+                                                          const std::string &body) const override;
+
+    // 已应答的请求数 (含故意失败的)
+    size_t requests() const { return requests_.load(); }
+
+private:
+    std::unordered_map<std::string, std::string> dictionary_;
+    std::string prefix_;
+    size_t failEvery_;
+    std::chrono::milliseconds latency_;
+    mutable std::atomic<size_t> requests_{0};
+};
+
+// 按源文本持久化的翻译缓存 (SQLite 文件), 打开时整体载入内存
+class TranslationCache {
+public:
+    TranslationCache(const std::string &path, std::string from, std::string to);
+    ~TranslationCache();
+
+    std::optional<std::string> get(const std::string &source) const;
+    // 在一个事务内写入; 失败时回滚并抛出, 内存中的条目不变
+    void put(const std::vector<std::pair<std::string, std::string>> &entries);
+
+private:
+    sqlite3 *db = nullptr;
+    std::string from_;
+    std::string to_;
+    std::unordered_map<std::string, std::string> entries_;
+};
+
+// 令牌桶限速
+class RateLimiter {
+public:
+    RateLimiter(double requestsPerSecond, double burst);
+
+    bool tryAcquire();
+    // 距离下一个令牌可用的时间
+    std::chrono::milliseconds waitTime() const;
+
+private:
+    void refill();
+
+    double rate_;
+    double burst_;
+    double tokens_;
+    std::chrono::steady_clock::time_point last_;
+};
+
+struct TranslationOptions {
+    std::string from = "en";
+    std::string to = "zh";
+    std::string cachePath = "translationCache.db";  // 为空时不使用持久缓存
+    double requestsPerSecond = 1.0;
+    double burst = 1.0;
+    size_t maxBatchBytes = 5000;        // 单次请求拼接后的最大字节数
+    int maxConcurrentRequests = 4;
+    int maxRetries = 2;
+    long timeoutMs = 10000;
+};
+
+struct TranslationStats {
+    size_t cacheHits = 0;
+    size_t translated = 0;
+    size_t failed = 0;
+    size_t requests = 0;
+};
+
+// 批量, 带缓存的翻译服务. 缓存未命中的文本按字节数分批,
+// 通过一个 curl multi 句柄并发发送并复用连接. 可以从多个线程调用, 网络请求期间不持有锁,
+// 并发的调用各自从池中取一个 curl 会话; 限速和 maxConcurrentRequests 按单次调用计
+class TranslationService {
+public:
+    explicit TranslationService(std::unique_ptr<TranslationBackend> backend,
+                                TranslationOptions options = TranslationOptions());
+    ~TranslationService();
+
+    TranslationService(const TranslationService &) = delete;
+    TranslationService &operator=(const TranslationService &) = delete;
+
+    // 结果与 texts 一一对应, 翻译失败的条目为空
+    std::vector<std::optional<std::string>> translate(const std::vector<std::string> &texts);
+    std::optional<std::string> translate(const std::string &text);
+    std::future<std::vector<std::optional<std::string>>> translateAsync(std::vector<std::string> texts);
+
+    TranslationStats stats() const;
+
+private:
+    // 一个 curl multi 句柄及其空闲的 easy 句柄; 用完放回池中, 以便后续调用复用连接
+    struct CurlSession {
+        CURLM *multi = nullptr;
+        std::vector<CURL *> idleHandles;
+
+        ~CurlSession();
+    };
+
+    void fetch(const std::vector<std::vector<std::string>> &batches,
+               std::unordered_map<std::string, std::string> &translations);
+    std::unique_ptr<CurlSession> takeSession();
+    void returnSession(std::unique_ptr<CurlSession> session);
+    bool acquireToken();
+    std::chrono::milliseconds tokenWaitTime() const;
+
+    std::unique_ptr<TranslationBackend> backend_;
+    TranslationOptions options_;
+    // 以下成员由 mutex_ 保护
+    std::unique_ptr<TranslationCache> cache_;
+    RateLimiter limiter_;
+    std::vector<std::unique_ptr<CurlSession>> sessions_;
+    TranslationStats stats_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace CFD_MaterialDB
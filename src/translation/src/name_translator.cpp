@@ -0,0 +1,184 @@
+#include "name_translator.h"
+#include "trace.h"
+#include "sqlcipher/sqlite3.h"
+#include <iostream>
+#include <sstream>
+
+using namespace CFD_MaterialDB;
+
+std::vector<std::optional<std::string>> NameTranslator::translateBatch(const std::vector<std::string> &names) {
+    std::vector<std::optional<std::string>> results;
+    results.reserve(names.size());
+    for (const auto &name: names) {
+        results.push_back(translate(name));
+    }
+    return results;
+}
+
+DictionaryDbTranslator::DictionaryDbTranslator(const std::string &dbPath) {
+    // 只读打开, 不存在时不创建; 打开后查询一次以确认 materials 表存在
+    try {
+        dictionary_ = std::make_unique<DatabaseManager>(dbPath, true);
+        dictionary_->materialExists("");
+    } catch (const std::exception &e) {
+        std::cerr << "警告: 无法读取名称字典 " << dbPath << " (" << e.what() << "), 使用英文名" << std::endl;
+        dictionary_.reset();
+    }
+}
+
+std::optional<std::string> DictionaryDbTranslator::translate(const std::string &materialName) {
+    if (!dictionary_) {
+        return std::nullopt;
+    }
+    TraceSpan span("dictionary lookup", "translate", materialName);
+    return dictionary_->getChineseName(materialName);
+}
+
+InMemoryDictionaryTranslator::InMemoryDictionaryTranslator(const std::string &dbPath) {
+    // 只读打开, 不存在时不创建; 字典缺失或没有 materials 表时以空表工作, 所有名称回退为英文名
+    sqlite3 *db = nullptr;
+    sqlite3_stmt *stmt = nullptr;
+    const char *sql = "SELECT name, chinese_name FROM materials WHERE chinese_name IS NOT NULL;";
+    if (sqlite3_open_v2(dbPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK
+        || sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "警告: 无法读取名称字典 " << dbPath << " (" << (db ? sqlite3_errmsg(db) : "out of memory")
+                  << "), 使用英文名" << std::endl;
+        sqlite3_close(db);
+        return;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        entries_.emplace(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)),
+                         reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1)));
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+}
+
+InMemoryDictionaryTranslator::InMemoryDictionaryTranslator(std::unordered_map<std::string, std::string> entries)
+        : entries_(std::move(entries)) {}
+
+std::optional<std::string> InMemoryDictionaryTranslator::translate(const std::string &materialName) {
+    auto it = entries_.find(materialName);
+    if (it == entries_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+HttpNameTranslator::HttpNameTranslator(std::shared_ptr<TranslationService> service)
+        : service_(std::move(service)) {}
+
+std::optional<std::string> HttpNameTranslator::translate(const std::string &materialName) {
+    return service_->translate(materialName);
+}
+
+std::vector<std::optional<std::string>> HttpNameTranslator::translateBatch(const std::vector<std::string> &names) {
+    return service_->translate(names);
+}
+
+ChainTranslator::ChainTranslator(std::vector<std::unique_ptr<NameTranslator>> providers)
+        : providers_(std::move(providers)) {}
+
+std::string ChainTranslator::name() const {
+    std::string joined;
+    for (const auto &provider: providers_) {
+        if (!joined.empty()) {
+            joined += ",";
+        }
+        joined += provider->name();
+    }
+    return joined;
+}
+
+std::optional<std::string> ChainTranslator::translate(const std::string &materialName) {
+    return translateBatch({materialName})[0];
+}
+
+std::vector<std::optional<std::string>> ChainTranslator::translateBatch(const std::vector<std::string> &names) {
+    std::vector<std::optional<std::string>> results(names.size());
+    std::vector<size_t> unresolved(names.size());
+    for (size_t i = 0; i < names.size(); ++i) {
+        unresolved[i] = i;
+    }
+
+    for (const auto &provider: providers_) {
+        if (unresolved.empty()) {
+            break;
+        }
+        std::vector<std::string> pending;
+        pending.reserve(unresolved.size());
+        for (size_t index: unresolved) {
+            pending.push_back(names[index]);
+        }
+
+        std::vector<std::optional<std::string>> partial;
+        TraceSpan span("provider", "translate", [&] { return provider->name(); });
+        try {
+            partial = provider->translateBatch(pending);
+        } catch (const std::exception &e) {
+            // 某个提供者不可用时继续尝试下一个
+            std::cerr << "名称翻译失败 (" << provider->name() << "): " << e.what() << std::endl;
+            continue;
+        }
+
+        std::vector<size_t> stillUnresolved;
+        for (size_t i = 0; i < unresolved.size(); ++i) {
+            if (i < partial.size() && partial[i]) {
+                results[unresolved[i]] = std::move(partial[i]);
+            } else {
+                stillUnresolved.push_back(unresolved[i]);
+            }
+        }
+        unresolved.swap(stillUnresolved);
+    }
+    return results;
+}
+
+std::unique_ptr<NameTranslator> CFD_MaterialDB::makeNameTranslator(const std::string &spec,
+                                                                   const NameTranslatorConfig &config) {
+    std::vector<std::unique_ptr<NameTranslator>> providers;
+    std::shared_ptr<TranslationService> service;
+    BaiduCredentials credentials{config.baiduAppId, config.baiduKey};
+    if (!credentials.valid()) {
+        credentials = BaiduCredentials::fromEnvironment();
+    }
+    bool httpDisabled = false;
+    std::istringstream iss(spec);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+        if (item == "dictionary") {
+            providers.push_back(std::make_unique<DictionaryDbTranslator>(config.dictionaryPath));
+        } else if (item == "memory") {
+            providers.push_back(std::make_unique<InMemoryDictionaryTranslator>(config.dictionaryPath));
+        } else if (item == "http") {
+            if (!credentials.valid()) {
+                if (!httpDisabled) {
+                    std::cerr << "警告: 未配置百度翻译凭据 (MATDB_BAIDU_APPID / MATDB_BAIDU_KEY), 跳过 http 提供者"
+                              << std::endl;
+                    httpDisabled = true;
+                }
+                continue;
+            }
+            if (!service) {
+                service = std::make_shared<TranslationService>(
+                        std::make_unique<BaiduTranslateBackend>(credentials.appid, credentials.key,
+                                                                config.translateEndpoint),
+                        config.translation);
+            }
+            providers.push_back(std::make_unique<HttpNameTranslator>(service));
+        } else {
+            throw std::runtime_error("未知的名称翻译提供者: " + item);
+        }
+    }
+    if (providers.empty()) {
+        throw std::runtime_error(httpDisabled ? "没有可用的名称翻译提供者: http 需要百度翻译凭据"
+                                              : "没有指定名称翻译提供者");
+    }
+    if (providers.size() == 1) {
+        return std::move(providers.front());
+    }
+    return std::make_unique<ChainTranslator>(std::move(providers));
+}
@@ -0,0 +1,535 @@
+#include "translation_service.h"
+#include "trace.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+#include <nlohmann/json.hpp>
+#include <openssl/md5.h>
+
+using namespace CFD_MaterialDB;
+
+namespace {
+
+std::string percentEncode(const std::string &text) {
+    std::ostringstream oss;
+    oss << std::hex << std::uppercase << std::setfill('0');
+    for (unsigned char c: text) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            oss << c;
+        } else {
+            oss << '%' << std::setw(2) << static_cast<int>(c);
+        }
+    }
+    return oss.str();
+}
+
+std::string md5Hex(const std::string &text) {
+    unsigned char digest[MD5_DIGEST_LENGTH];
+    MD5(reinterpret_cast<const unsigned char *>(text.c_str()), text.size(), digest);
+    std::ostringstream oss;
+    for (unsigned char byte: digest) {
+        oss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte);
+    }
+    return oss.str();
+}
+
+size_t writeCallback(void *contents, size_t size, size_t nmemb, std::string *s) {
+    s->append(static_cast<char *>(contents), size * nmemb);
+    return size * nmemb;
+}
+
+} // namespace
+
+BaiduCredentials BaiduCredentials::fromEnvironment() {
+    BaiduCredentials credentials;
+    if (const char *appid = std::getenv("MATDB_BAIDU_APPID")) {
+        credentials.appid = appid;
+    }
+    if (const char *key = std::getenv("MATDB_BAIDU_KEY")) {
+        credentials.key = key;
+    }
+    return credentials;
+}
+
+BaiduTranslateBackend::BaiduTranslateBackend(std::string appid, std::string key, std::string endpoint)
+        : appid_(std::move(appid)), key_(std::move(key)), endpoint_(std::move(endpoint)) {
+    if (appid_.empty() || key_.empty()) {
+        throw std::runtime_error("百度翻译凭据未配置 (MATDB_BAIDU_APPID / MATDB_BAIDU_KEY)");
+    }
+}
+
+HttpRequest BaiduTranslateBackend::buildRequest(const std::vector<std::string> &texts,
+                                                const std::string &from, const std::string &to) const {
+    std::string q;
+    for (const auto &text: texts) {
+        if (!q.empty()) {
+            q += '\n';
+        }
+        q += text;
+    }
+    static thread_local std::mt19937 rng(std::random_device{}());
+    std::string salt = std::to_string(rng());
+    // 签名 = md5(appid + q + salt + key), q 为编码前的原文
+    std::string sign = md5Hex(appid_ + q + salt + key_);
+
+    HttpRequest request;
+    request.url = endpoint_;
+    request.postFields = "q=" + percentEncode(q) + "&from=" + from + "&to=" + to + "&appid=" + appid_ +
+                         "&salt=" + salt + "&sign=" + sign;
+    return request;
+}
+
+std::vector<std::optional<std::string>> BaiduTranslateBackend::parseResponse(const std::vector<std::string> &texts,
+                                                                             const std::string &body) const {
+    std::vector<std::optional<std::string>> results(texts.size());
+    try {
+        auto json = nlohmann::json::parse(body);
+        if (!json.contains("trans_result")) {
+            std::cerr << "Translation failed: " << json.value("error_msg", body) << std::endl;
+            return results;
+        }
+        std::unordered_map<std::string, std::string> bySource;
+        const auto &entries = json["trans_result"];
+        for (const auto &entry: entries) {
+            bySource[entry.value("src", "")] = entry.value("dst", "");
+        }
+        for (size_t i = 0; i < texts.size(); ++i) {
+            auto it = bySource.find(texts[i]);
+            if (it != bySource.end()) {
+                results[i] = it->second;
+            } else if (entries.size() == texts.size()) {
+                // 服务端可能裁剪了原文两端的空白, 按行号对应
+                results[i] = entries[i].value("dst", "");
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Translation failed: " << e.what() << std::endl;
+    }
+    return results;
+}
+
+StubTranslateBackend::StubTranslateBackend(std::unordered_map<std::string, std::string> dictionary,
+                                           std::string prefix, size_t failEvery, std::chrono::milliseconds latency)
+        : dictionary_(std::move(dictionary)), prefix_(std::move(prefix)), failEvery_(failEvery), latency_(latency) {}
+
+HttpRequest StubTranslateBackend::buildRequest(const std::vector<std::string> &texts, const std::string &,
+                                               const std::string &) const {
+    HttpRequest request;
+    request.url = "stub:";
+    for (const auto &text: texts) {
+        request.postFields += text;
+        request.postFields += '\n';
+    }
+    return request;
+}
+
+std::optional<std::string> StubTranslateBackend::respond(const HttpRequest &request) const {
+    if (latency_.count() > 0) {
+        std::this_thread::sleep_for(latency_);
+    }
+    size_t index = requests_.fetch_add(1) + 1;
+    nlohmann::json results = nlohmann::json::array();
+    if (failEvery_ > 0 && index % failEvery_ == 0) {
+        return results.dump();
+    }
+    std::istringstream lines(request.postFields);
+    std::string text;
+    while (std::getline(lines, text)) {
+        auto it = dictionary_.find(text);
+        results.push_back(it != dictionary_.end() ? it->second : prefix_ + text);
+    }
+    return results.dump();
+}
+
+std::vector<std::optional<std::string>> StubTranslateBackend::parseResponse(const std::vector<std::string> &texts,
+                                                                            const std::string &body) const {
+    std::vector<std::optional<std::string>> results(texts.size());
+    auto json = nlohmann::json::parse(body);
+    for (size_t i = 0; i < texts.size() && i < json.size(); ++i) {
+        results[i] = json[i].get<std::string>();
+    }
+    return results;
+}
+
+TranslationCache::TranslationCache(const std::string &path, std::string from, std::string to)
+        : from_(std::move(from)), to_(std::move(to)) {
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+        std::string error = sqlite3_errmsg(db);
+        sqlite3_close(db);
+        throw std::runtime_error("无法打开翻译缓存: " + error);
+    }
+    const char *createSql =
+            "CREATE TABLE IF NOT EXISTS translations ("
+            "source TEXT NOT NULL,"
+            "from_lang TEXT NOT NULL,"
+            "to_lang TEXT NOT NULL,"
+            "target TEXT NOT NULL,"
+            "PRIMARY KEY (source, from_lang, to_lang));";
+    char *errMsg = nullptr;
+    if (sqlite3_exec(db, createSql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::string error = errMsg;
+        sqlite3_free(errMsg);
+        sqlite3_close(db);
+        throw std::runtime_error("初始化翻译缓存失败: " + error);
+    }
+
+    sqlite3_stmt *stmt;
+    const char *selectSql = "SELECT source, target FROM translations WHERE from_lang = ? AND to_lang = ?;";
+    if (sqlite3_prepare_v2(db, selectSql, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, from_.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, to_.c_str(), -1, SQLITE_TRANSIENT);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            entries_.emplace(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)),
+                             reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1)));
+        }
+    }
+    sqlite3_finalize(stmt);
+}
+
+TranslationCache::~TranslationCache() {
+    sqlite3_close(db);
+}
+
+std::optional<std::string> TranslationCache::get(const std::string &source) const {
+    auto it = entries_.find(source);
+    if (it == entries_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void TranslationCache::put(const std::vector<std::pair<std::string, std::string>> &entries) {
+    if (entries.empty()) {
+        return;
+    }
+    sqlite3_stmt *stmt;
+    const char *insertSql = "INSERT OR REPLACE INTO translations (source, from_lang, to_lang, target) "
+                            "VALUES (?, ?, ?, ?);";
+    if (sqlite3_prepare_v2(db, insertSql, -1, &stmt, nullptr) != SQLITE_OK) {
+        throw std::runtime_error("准备SQL语句失败: " + std::string(sqlite3_errmsg(db)));
+    }
+    if (sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::string error = sqlite3_errmsg(db);
+        sqlite3_finalize(stmt);
+        throw std::runtime_error("写入翻译缓存失败: " + error);
+    }
+    // 任一条写入或提交失败时整批回滚, 内存中的条目只在提交成功后更新
+    auto rollback = [&](const std::string &what) {
+        std::string error = sqlite3_errmsg(db);
+        sqlite3_finalize(stmt);
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        throw std::runtime_error(what + error);
+    };
+    for (const auto &entry: entries) {
+        sqlite3_reset(stmt);
+        sqlite3_bind_text(stmt, 1, entry.first.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, from_.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 3, to_.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 4, entry.second.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            rollback("写入翻译缓存失败: ");
+        }
+    }
+    if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        rollback("提交翻译缓存失败: ");
+    }
+    sqlite3_finalize(stmt);
+    for (const auto &entry: entries) {
+        entries_[entry.first] = entry.second;
+    }
+}
+
+RateLimiter::RateLimiter(double requestsPerSecond, double burst)
+        : rate_(requestsPerSecond), burst_(std::max(1.0, burst)), tokens_(burst_),
+          last_(std::chrono::steady_clock::now()) {}
+
+void RateLimiter::refill() {
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - last_).count();
+    last_ = now;
+    tokens_ = rate_ > 0.0 ? std::min(burst_, tokens_ + elapsed * rate_) : burst_;
+}
+
+bool RateLimiter::tryAcquire() {
+    refill();
+    if (tokens_ < 1.0) {
+        return false;
+    }
+    tokens_ -= 1.0;
+    return true;
+}
+
+std::chrono::milliseconds RateLimiter::waitTime() const {
+    if (rate_ <= 0.0 || tokens_ >= 1.0) {
+        return std::chrono::milliseconds(0);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - last_).count();
+    double seconds = std::max(0.0, (1.0 - tokens_) / rate_ - elapsed);
+    return std::chrono::milliseconds(static_cast<long>(std::ceil(seconds * 1000.0)));
+}
+
+TranslationService::TranslationService(std::unique_ptr<TranslationBackend> backend, TranslationOptions options)
+        : backend_(std::move(backend)), options_(std::move(options)),
+          limiter_(options_.requestsPerSecond, options_.burst) {
+    static std::once_flag curlInit;
+    std::call_once(curlInit, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+    if (!options_.cachePath.empty()) {
+        cache_ = std::make_unique<TranslationCache>(options_.cachePath, options_.from, options_.to);
+    }
+}
+
+TranslationService::~TranslationService() = default;
+
+TranslationService::CurlSession::~CurlSession() {
+    for (CURL *handle: idleHandles) {
+        curl_easy_cleanup(handle);
+    }
+    curl_multi_cleanup(multi);
+}
+
+std::unique_ptr<TranslationService::CurlSession> TranslationService::takeSession() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!sessions_.empty()) {
+            std::unique_ptr<CurlSession> session = std::move(sessions_.back());
+            sessions_.pop_back();
+            return session;
+        }
+    }
+    auto session = std::make_unique<CurlSession>();
+    session->multi = curl_multi_init();
+    if (!session->multi) {
+        throw std::runtime_error("CURL failed");
+    }
+    curl_multi_setopt(session->multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+                      static_cast<long>(options_.maxConcurrentRequests));
+    return session;
+}
+
+void TranslationService::returnSession(std::unique_ptr<CurlSession> session) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sessions_.push_back(std::move(session));
+}
+
+bool TranslationService::acquireToken() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return limiter_.tryAcquire();
+}
+
+std::chrono::milliseconds TranslationService::tokenWaitTime() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return limiter_.waitTime();
+}
+
+std::optional<std::string> TranslationService::translate(const std::string &text) {
+    return translate(std::vector<std::string>{text})[0];
+}
+
+std::future<std::vector<std::optional<std::string>>> TranslationService::translateAsync(std::vector<std::string> texts) {
+    return std::async(std::launch::async, [this, texts = std::move(texts)] { return translate(texts); });
+}
+
+TranslationStats TranslationService::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+std::vector<std::optional<std::string>> TranslationService::translate(const std::vector<std::string> &texts) {
+    std::unordered_map<std::string, std::string> translations;
+
+    // 去重并查询缓存, 未命中的文本按字节数分批
+    std::vector<std::vector<std::string>> batches;
+    size_t batchBytes = 0;
+    std::unordered_set<std::string> queued;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &text: texts) {
+            if (text.empty() || translations.count(text) || queued.count(text)) {
+                continue;
+            }
+            if (cache_) {
+                if (auto cached = cache_->get(text)) {
+                    translations.emplace(text, *cached);
+                    ++stats_.cacheHits;
+                    continue;
+                }
+            }
+            if (batches.empty() || batchBytes + text.size() + 1 > options_.maxBatchBytes) {
+                batches.emplace_back();
+                batchBytes = 0;
+            }
+            batches.back().push_back(text);
+            batchBytes += text.size() + 1;
+            queued.insert(text);
+        }
+    }
+
+    if (!batches.empty()) {
+        // 网络请求期间不持有 mutex_, 其他线程的缓存命中不必等待
+        std::unordered_map<std::string, std::string> fetched;
+        {
+            TraceSpan span("http fetch", "translate", [&] { return std::to_string(batches.size()) + " requests"; });
+            fetch(batches, fetched);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cache_) {
+            // 缓存写入失败不影响本次结果, 下次调用会重新请求
+            try {
+                cache_->put(std::vector<std::pair<std::string, std::string>>(fetched.begin(), fetched.end()));
+            } catch (const std::exception &e) {
+                std::cerr << "警告: " << e.what() << std::endl;
+            }
+        }
+        stats_.translated += fetched.size();
+        stats_.failed += queued.size() - fetched.size();
+        translations.insert(fetched.begin(), fetched.end());
+    }
+
+    std::vector<std::optional<std::string>> results(texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+        if (texts[i].empty()) {
+            results[i] = std::string();
+            continue;
+        }
+        auto it = translations.find(texts[i]);
+        if (it != translations.end()) {
+            results[i] = it->second;
+        }
+    }
+    return results;
+}
+
+void TranslationService::fetch(const std::vector<std::vector<std::string>> &batches,
+                               std::unordered_map<std::string, std::string> &translations) {
+    struct Transfer {
+        size_t batch;
+        int attempts;
+        std::string body;
+    };
+    std::deque<std::pair<size_t, int>> pending;
+    for (size_t i = 0; i < batches.size(); ++i) {
+        pending.emplace_back(i, 0);
+    }
+    std::unordered_map<CURL *, Transfer> active;
+
+    // 处理一个请求的结果; 没有取得任何译文时重试, 超过次数后放弃
+    auto complete = [&](size_t batchIndex, int attempts, bool ok, const std::string &body, const std::string &error) {
+        bool translatedAny = false;
+        const auto &batch = batches[batchIndex];
+        if (ok) {
+            auto results = backend_->parseResponse(batch, body);
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (results[i]) {
+                    translations[batch[i]] = *results[i];
+                    translatedAny = true;
+                }
+            }
+        }
+        if (!translatedAny) {
+            if (attempts < options_.maxRetries) {
+                pending.emplace_back(batchIndex, attempts + 1);
+            } else {
+                std::cerr << "Translation request failed: " << error << std::endl;
+            }
+        }
+    };
+
+    std::unique_ptr<CurlSession> session = takeSession();
+    try {
+        while (!pending.empty() || !active.empty()) {
+            // 在并发数和限速允许的范围内发起新请求
+            while (!pending.empty() && static_cast<int>(active.size()) < options_.maxConcurrentRequests
+                   && acquireToken()) {
+                auto next = pending.front();
+                pending.pop_front();
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    ++stats_.requests;
+                }
+
+                HttpRequest request = backend_->buildRequest(batches[next.first], options_.from, options_.to);
+                if (std::optional<std::string> body = backend_->respond(request)) {
+                    complete(next.first, next.second, true, *body, "empty response");
+                    continue;
+                }
+
+                CURL *easy;
+                if (session->idleHandles.empty()) {
+                    easy = curl_easy_init();
+                    if (!easy) {
+                        throw std::runtime_error("CURL failed");
+                    }
+                } else {
+                    easy = session->idleHandles.back();
+                    session->idleHandles.pop_back();
+                }
+                Transfer &transfer = active[easy];
+                transfer.batch = next.first;
+                transfer.attempts = next.second;
+                transfer.body.clear();
+
+                curl_easy_setopt(easy, CURLOPT_URL, request.url.c_str());
+                if (request.postFields.empty()) {
+                    curl_easy_setopt(easy, CURLOPT_HTTPGET, 1L);
+                } else {
+                    curl_easy_setopt(easy, CURLOPT_COPYPOSTFIELDS, request.postFields.c_str());
+                }
+                curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, writeCallback);
+                curl_easy_setopt(easy, CURLOPT_WRITEDATA, &transfer.body);
+                curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, options_.timeoutMs);
+                curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+                curl_multi_add_handle(session->multi, easy);
+            }
+
+            int running = 0;
+            curl_multi_perform(session->multi, &running);
+
+            CURLMsg *msg;
+            int remaining;
+            while ((msg = curl_multi_info_read(session->multi, &remaining))) {
+                if (msg->msg != CURLMSG_DONE) {
+                    continue;
+                }
+                CURL *easy = msg->easy_handle;
+                CURLcode result = msg->data.result;
+                curl_multi_remove_handle(session->multi, easy);
+                Transfer transfer = std::move(active[easy]);
+                active.erase(easy);
+                session->idleHandles.push_back(easy);
+
+                long status = 0;
+                curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &status);
+                complete(transfer.batch, transfer.attempts, result == CURLE_OK && status == 200, transfer.body,
+                         result == CURLE_OK ? "HTTP " + std::to_string(status) : curl_easy_strerror(result));
+            }
+
+            if (pending.empty() && active.empty()) {
+                break;
+            }
+            // 等待网络事件, 或者等到下一个令牌可用
+            long waitMs = 100;
+            if (!pending.empty() && static_cast<int>(active.size()) < options_.maxConcurrentRequests) {
+                waitMs = std::min<long>(waitMs, tokenWaitTime().count());
+            }
+            curl_multi_poll(session->multi, nullptr, 0, static_cast<int>(waitMs), nullptr);
+        }
+    } catch (...) {
+        // 未完成的传输不能留在放回池中的会话里
+        for (auto &entry: active) {
+            curl_multi_remove_handle(session->multi, entry.first);
+            curl_easy_cleanup(entry.first);
+        }
+        returnSession(std::move(session));
+        throw;
+    }
+    returnSession(std::move(session));
+}